@@ -5,7 +5,12 @@
 #include <glm/glm.hpp>
 #include <assimp/scene.h>
 #include <learnopengl/bone.h>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <functional>
+#include <unordered_map>
+#include <learnopengl/animation_compression.h>
 #include <learnopengl/animdata.h>
 #include <learnopengl/model_animation.h>
 
@@ -17,13 +22,36 @@ struct AssimpNodeData
 	std::vector<AssimpNodeData> children;
 };
 
+// one node of the hierarchy baked into a flat array in depth first order, so parents always come before their children
+struct AnimationNode
+{
+	std::string name;
+	glm::mat4 transformation; // local transform when no channel animates the node
+	BoneTransform bind;       // the same transform as translation, rotation and scale, for blending
+	glm::mat4 offset;         // inverse bind matrix, only meaningful when boneID >= 0
+	int parent;               // index of the parent node, -1 for the root
+	int channel;              // index of the Bone animating the node, -1 if it isn't animated
+	int boneID;               // slot in the final bone matrices, -1 if no vertex is skinned to the node
+};
+
+// A clip: the keys of every bone channel and the baked node hierarchy. Nothing in it changes after loading, so one
+// Animation can be shared by any number of characters, each playing it through its own AnimationInstance.
+// With compression enabled the keys are compressed at import. With storeClip as well the clip is stored next to the
+// source file (see GetClipPath), later loads read that file instead of running the importer.
 class Animation
 {
 public:
 	Animation() = default;
 
-	Animation(const std::string& animationPath, Model* model)
+	Animation(const std::string& animationPath, Model* model, const AnimationCompressionSettings& compression = AnimationCompressionSettings())
 	{
+		const std::string clipPath = GetClipPath(animationPath);
+		if (compression.enabled && compression.storeClip && ReadClip(clipPath, animationPath, compression, *model))
+		{
+			BakeHierarchy();
+			return;
+		}
+
 		Assimp::Importer importer;
 		const aiScene* scene = importer.ReadFile(animationPath, aiProcess_Triangulate);
 		assert(scene && scene->mRootNode);
@@ -34,13 +62,43 @@ public:
 		globalTransformation = globalTransformation.Inverse();
 		ReadHierarchyData(m_RootNode, scene->mRootNode);
 		ReadMissingBones(animation, *model);
+		if (compression.enabled)
+		{
+			for (Bone& bone : m_Bones)
+				bone.Compress(compression, m_CompressionStats);
+			if (compression.storeClip)
+				WriteClip(clipPath, animationPath, compression);
+		}
+		BakeHierarchy();
+	}
+
+	// a clip put together in memory rather than imported (tests, benchmarks, procedural motion). boneInfoMap holds the
+	// IDs and offsets of the skinned nodes, channels of other nodes animate the hierarchy without a bone slot
+	Animation(const aiNode* rootNode, const aiAnimation* animation, const std::map<std::string, BoneInfo>& boneInfoMap)
+	{
+		m_Duration = animation->mDuration;
+		m_TicksPerSecond = animation->mTicksPerSecond;
+		ReadHierarchyData(m_RootNode, rootNode);
+		m_BoneInfoMap = boneInfoMap;
+		for (unsigned int i = 0; i < animation->mNumChannels; i++)
+		{
+			const aiNodeAnim* channel = animation->mChannels[i];
+			auto boneInfo = m_BoneInfoMap.find(channel->mNodeName.data);
+			m_Bones.push_back(Bone(channel->mNodeName.data, boneInfo != m_BoneInfoMap.end() ? boneInfo->second.id : -1, channel));
+		}
+		BakeHierarchy();
+	}
+
+	static std::string GetClipPath(const std::string& animationPath)
+	{
+		return animationPath + ".animclip";
 	}
 
 	~Animation()
 	{
 	}
 
-	Bone* FindBone(const std::string& name)
+	const Bone* FindBone(const std::string& name) const
 	{
 		auto iter = std::find_if(m_Bones.begin(), m_Bones.end(),
 			[&](const Bone& Bone)
@@ -53,13 +111,36 @@ public:
 	}
 
 	
-	inline float GetTicksPerSecond() { return m_TicksPerSecond; }
-	inline float GetDuration() { return m_Duration;}
-	inline const AssimpNodeData& GetRootNode() { return m_RootNode; }
-	inline const std::map<std::string,BoneInfo>& GetBoneIDMap() 
+	inline float GetTicksPerSecond() const { return m_TicksPerSecond; }
+	inline float GetDuration() const { return m_Duration;}
+	inline const AssimpNodeData& GetRootNode() const { return m_RootNode; }
+	inline const std::map<std::string,BoneInfo>& GetBoneIDMap() const
 	{ 
 		return m_BoneInfoMap;
 	}
+	inline const std::vector<AnimationNode>& GetNodes() const { return m_Nodes; }
+	inline const std::vector<Bone>& GetBones() const { return m_Bones; }
+	// index of the baked node with that name, -1 if the hierarchy has none
+	int FindNode(const std::string& name) const
+	{
+		for (int i = 0; i < (int)m_Nodes.size(); i++)
+			if (m_Nodes[i].name == name)
+				return i;
+		return -1;
+	}
+	// number of final bone matrices a pose of this clip fills, one past the highest bone ID
+	inline int GetBoneSlotCount() const { return m_BoneSlotCount; }
+	// key sizes and errors of the compression, all zero for an uncompressed clip
+	inline const AnimationCompressionStats& GetCompressionStats() const { return m_CompressionStats; }
+
+	// heap memory of every bone's keys, in bytes
+	size_t GetKeyMemoryUsage() const
+	{
+		size_t total = 0;
+		for (const Bone& bone : m_Bones)
+			total += bone.GetMemoryUsage();
+		return total;
+	}
 
 private:
 	void ReadMissingBones(const aiAnimation* animation, Model& model)
@@ -67,7 +148,6 @@ private:
 		int size = animation->mNumChannels;
 
 		auto& boneInfoMap = model.GetBoneInfoMap();//getting m_BoneInfoMap from Model class
-		int& boneCount = model.GetBoneCount(); //getting the m_BoneCounter from Model class
 
 		//reading channels(bones engaged in an animation and their keyframes)
 		for (int i = 0; i < size; i++)
@@ -75,18 +155,26 @@ private:
 			auto channel = animation->mChannels[i];
 			std::string boneName = channel->mNodeName.data;
 
-			if (boneInfoMap.find(boneName) == boneInfoMap.end())
-			{
-				boneInfoMap[boneName].id = boneCount;
-				boneCount++;
-			}
 			m_Bones.push_back(Bone(channel->mNodeName.data,
-				boneInfoMap[channel->mNodeName.data].id, channel));
+				RegisterBone(boneName, model), channel));
 		}
 
 		m_BoneInfoMap = boneInfoMap;
 	}
 
+	// the bone's ID in the model, bones only the animation knows get the next free one
+	static int RegisterBone(const std::string& boneName, Model& model)
+	{
+		auto& boneInfoMap = model.GetBoneInfoMap();
+		int& boneCount = model.GetBoneCount();
+		if (boneInfoMap.find(boneName) == boneInfoMap.end())
+		{
+			boneInfoMap[boneName].id = boneCount;
+			boneCount++;
+		}
+		return boneInfoMap[boneName].id;
+	}
+
 	void ReadHierarchyData(AssimpNodeData& dest, const aiNode* src)
 	{
 		assert(src);
@@ -102,10 +190,226 @@ private:
 			dest.children.push_back(newData);
 		}
 	}
+	// flattens the node tree and resolves every node's channel and bone slot once, so Animator never looks up names
+	void BakeHierarchy()
+	{
+		std::unordered_map<std::string, int> channels;
+		for (int i = 0; i < (int)m_Bones.size(); i++)
+			channels.emplace(m_Bones[i].GetBoneName(), i);
+
+		m_BoneSlotCount = 0;
+		for (const auto& boneInfo : m_BoneInfoMap)
+			m_BoneSlotCount = std::max(m_BoneSlotCount, boneInfo.second.id + 1);
+
+		m_Nodes.clear();
+		std::vector<std::pair<const AssimpNodeData*, int>> stack = { { &m_RootNode, -1 } };
+		while (!stack.empty())
+		{
+			const AssimpNodeData* src = stack.back().first;
+			AnimationNode node;
+			node.name = src->name;
+			node.transformation = src->transformation;
+			node.bind = BoneTransform::FromMatrix(src->transformation);
+			node.offset = glm::mat4(1.0f);
+			node.parent = stack.back().second;
+			stack.pop_back();
+
+			auto channel = channels.find(src->name);
+			node.channel = channel != channels.end() ? channel->second : -1;
+			auto boneInfo = m_BoneInfoMap.find(src->name);
+			node.boneID = boneInfo != m_BoneInfoMap.end() ? boneInfo->second.id : -1;
+			if (node.boneID >= 0)
+				node.offset = boneInfo->second.offset;
+
+			// pushed in reverse so children are visited in their original order
+			int index = (int)m_Nodes.size();
+			m_Nodes.push_back(node);
+			for (int i = (int)src->children.size() - 1; i >= 0; i--)
+				stack.push_back({ &src->children[i], index });
+		}
+	}
+
+	// Clip file layout: AnimationClipHeader, the node tree in depth first order (uint32 nameLength, name, mat4,
+	// uint32 childCount), then per bone: uint32 nameLength, name, float timeStep and its position, rotation and scale
+	// QuantizedTracks. It is only read when the source's modification time and the tolerances match
+	static bool MakeClipHeader(const std::string& animationPath, const AnimationCompressionSettings& compression, AnimationClipHeader& header)
+	{
+		std::error_code error;
+		auto modified = std::filesystem::last_write_time(animationPath, error);
+		if (error)
+			return false;
+		std::memset(&header, 0, sizeof(header));
+		std::memcpy(header.magic, "LGAC", 4);
+		header.version = ANIMATION_CLIP_VERSION;
+		header.sourceModifiedTime = static_cast<int64_t>(modified.time_since_epoch().count());
+		header.tolerances[0] = compression.positionTolerance;
+		header.tolerances[1] = compression.rotationTolerance;
+		header.tolerances[2] = compression.scaleTolerance;
+		return true;
+	}
+
+	bool WriteClip(const std::string& clipPath, const std::string& animationPath, const AnimationCompressionSettings& compression) const
+	{
+		AnimationClipHeader header;
+		if (!MakeClipHeader(animationPath, compression, header))
+			return false;
+		header.duration = m_Duration;
+		header.ticksPerSecond = m_TicksPerSecond;
+		header.nodeCount = CountNodes(m_RootNode);
+		header.boneCount = (uint32_t)m_Bones.size();
+		header.rawBytes = m_CompressionStats.rawBytes;
+		header.rawKeys = m_CompressionStats.rawKeys;
+		header.maxErrors[0] = m_CompressionStats.maxPositionError;
+		header.maxErrors[1] = m_CompressionStats.maxRotationError;
+		header.maxErrors[2] = m_CompressionStats.maxScaleError;
+
+		// written to a temporary file and renamed so a crash never leaves a half written clip
+		const std::string tempPath = clipPath + ".tmp";
+		{
+			std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+			if (!file)
+				return false;
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			WriteNode(file, m_RootNode);
+			for (const Bone& bone : m_Bones)
+			{
+				WriteString(file, bone.GetBoneName());
+				float timeStep = bone.GetTimeStep();
+				file.write(reinterpret_cast<const char*>(&timeStep), sizeof(timeStep));
+				bone.GetPositionTrack().Write(file);
+				bone.GetRotationTrack().Write(file);
+				bone.GetScaleTrack().Write(file);
+			}
+			if (!file)
+				return false;
+		}
+		std::error_code error;
+		std::filesystem::rename(tempPath, clipPath, error);
+		if (error)
+		{
+			std::filesystem::remove(tempPath, error);
+			return false;
+		}
+		return true;
+	}
+
+	bool ReadClip(const std::string& clipPath, const std::string& animationPath, const AnimationCompressionSettings& compression, Model& model)
+	{
+		AnimationClipHeader expected, header;
+		if (!MakeClipHeader(animationPath, compression, expected))
+			return false;
+		std::ifstream file(clipPath, std::ios::binary);
+		if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+			return false;
+		if (std::memcmp(header.magic, expected.magic, 4) != 0 || header.version != expected.version ||
+			header.sourceModifiedTime != expected.sourceModifiedTime ||
+			std::memcmp(header.tolerances, expected.tolerances, sizeof(header.tolerances)) != 0)
+			return false;
+
+		uint32_t nodesLeft = header.nodeCount;
+		std::vector<Bone> bones;
+		std::vector<std::string> names;
+		bool valid = ReadNode(file, m_RootNode, nodesLeft) && nodesLeft == 0;
+		for (uint32_t i = 0; valid && i < header.boneCount; i++)
+		{
+			std::string name;
+			float timeStep = 0.0f;
+			QuantizedTrack positions, rotations, scales;
+			valid = ReadString(file, name) && file.read(reinterpret_cast<char*>(&timeStep), sizeof(timeStep)) &&
+				positions.Read(file) && rotations.Read(file) && scales.Read(file) && timeStep > 0.0f;
+			if (valid)
+			{
+				bones.push_back(Bone(name, -1, timeStep, std::move(positions), std::move(rotations), std::move(scales)));
+				names.push_back(name);
+			}
+		}
+		if (!valid)
+		{
+			m_RootNode = AssimpNodeData();
+			return false;
+		}
+
+		// bone IDs are the model's, so they are resolved now rather than stored
+		for (size_t i = 0; i < bones.size(); i++)
+		{
+			const Bone& bone = bones[i];
+			m_Bones.push_back(Bone(names[i], RegisterBone(names[i], model), bone.GetTimeStep(),
+				bone.GetPositionTrack(), bone.GetRotationTrack(), bone.GetScaleTrack()));
+		}
+		m_BoneInfoMap = model.GetBoneInfoMap();
+		m_Duration = header.duration;
+		m_TicksPerSecond = header.ticksPerSecond;
+		m_CompressionStats.rawBytes = header.rawBytes;
+		m_CompressionStats.rawKeys = header.rawKeys;
+		m_CompressionStats.compressedBytes = GetKeyMemoryUsage();
+		for (const Bone& bone : m_Bones)
+			m_CompressionStats.keptKeys += bone.GetPositionTrack().Size() + bone.GetRotationTrack().Size() + bone.GetScaleTrack().Size();
+		m_CompressionStats.maxPositionError = header.maxErrors[0];
+		m_CompressionStats.maxRotationError = header.maxErrors[1];
+		m_CompressionStats.maxScaleError = header.maxErrors[2];
+		return true;
+	}
+
+	static uint32_t CountNodes(const AssimpNodeData& node)
+	{
+		uint32_t count = 1;
+		for (const AssimpNodeData& child : node.children)
+			count += CountNodes(child);
+		return count;
+	}
+
+	static void WriteNode(std::ofstream& file, const AssimpNodeData& node)
+	{
+		WriteString(file, node.name);
+		file.write(reinterpret_cast<const char*>(&node.transformation), sizeof(node.transformation));
+		uint32_t childCount = (uint32_t)node.children.size();
+		file.write(reinterpret_cast<const char*>(&childCount), sizeof(childCount));
+		for (const AssimpNodeData& child : node.children)
+			WriteNode(file, child);
+	}
+
+	// nodesLeft guards against a corrupt tree claiming more nodes than the header
+	static bool ReadNode(std::ifstream& file, AssimpNodeData& node, uint32_t& nodesLeft)
+	{
+		uint32_t childCount = 0;
+		if (nodesLeft == 0 || !ReadString(file, node.name) ||
+			!file.read(reinterpret_cast<char*>(&node.transformation), sizeof(node.transformation)) ||
+			!file.read(reinterpret_cast<char*>(&childCount), sizeof(childCount)))
+			return false;
+		nodesLeft--;
+		if (childCount > nodesLeft)
+			return false;
+		node.childrenCount = (int)childCount;
+		node.children.resize(childCount);
+		for (AssimpNodeData& child : node.children)
+			if (!ReadNode(file, child, nodesLeft))
+				return false;
+		return true;
+	}
+
+	static void WriteString(std::ofstream& file, const std::string& str)
+	{
+		uint32_t length = (uint32_t)str.size();
+		file.write(reinterpret_cast<const char*>(&length), sizeof(length));
+		file.write(str.data(), length);
+	}
+
+	static bool ReadString(std::ifstream& file, std::string& str)
+	{
+		uint32_t length = 0;
+		if (!file.read(reinterpret_cast<char*>(&length), sizeof(length)) || length > 4096)
+			return false;
+		str.resize(length);
+		return (bool)file.read(&str[0], length);
+	}
+
 	float m_Duration;
 	int m_TicksPerSecond;
 	std::vector<Bone> m_Bones;
 	AssimpNodeData m_RootNode;
 	std::map<std::string, BoneInfo> m_BoneInfoMap;
+	std::vector<AnimationNode> m_Nodes;
+	int m_BoneSlotCount = 0;
+	AnimationCompressionStats m_CompressionStats;
 };
 
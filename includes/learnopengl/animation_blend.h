@@ -0,0 +1,482 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/quaternion.hpp>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <learnopengl/animation.h>
+#include <learnopengl/bone.h>
+
+// A pose is one BoneTransform per baked node of a skeleton (an Animation whose hierarchy defines the layout), in local
+// space. Poses are blended as translation, rotation and scale and only turned into matrices once, at the very end.
+
+// Scratch memory for the poses of one frame. Allocate hands out consecutive slices of a block, Reset frees them all at
+// once. A frame that needs more than the block gets extra blocks and the next Reset merges them into one, so after the
+// largest frame has been seen no more heap allocations happen.
+class PoseArena
+{
+public:
+	BoneTransform* Allocate(size_t count)
+	{
+		if (m_Blocks.empty() || m_Used + count > m_Blocks.back().size())
+		{
+			size_t size = std::max(count, m_Blocks.empty() ? size_t(0) : m_Blocks.back().size() * 2);
+			m_Blocks.emplace_back(size);
+			m_Used = 0;
+			m_BlockAllocations++;
+		}
+		BoneTransform* pose = m_Blocks.back().data() + m_Used;
+		m_Used += count;
+		return pose;
+	}
+
+	void Reset()
+	{
+		if (m_Blocks.size() > 1)
+		{
+			size_t total = 0;
+			for (const std::vector<BoneTransform>& block : m_Blocks)
+				total += block.size();
+			m_Blocks.clear();
+			m_Blocks.emplace_back(total);
+			m_BlockAllocations++;
+		}
+		m_Used = 0;
+	}
+
+	// in transforms
+	size_t GetCapacity() const
+	{
+		size_t total = 0;
+		for (const std::vector<BoneTransform>& block : m_Blocks)
+			total += block.size();
+		return total;
+	}
+
+	// number of blocks allocated so far, stops growing once the arena is warm
+	unsigned int GetBlockAllocations() const { return m_BlockAllocations; }
+
+private:
+	std::vector<std::vector<BoneTransform>> m_Blocks; // moving a block keeps its storage, so slices stay valid
+	size_t m_Used = 0;                                // in the last block
+	unsigned int m_BlockAllocations = 0;
+};
+
+// Per node weights of a layer, 1 where the layer applies fully and 0 where it leaves the pose underneath alone
+struct BlendMask
+{
+	std::vector<float> weights; // per baked node of the skeleton
+
+	// weight for the named node and everything below it, 0 elsewhere (e.g. "Spine" for an upper body layer)
+	static BlendMask FromSubtree(const Animation& skeleton, const std::string& rootName, float weight = 1.0f)
+	{
+		const std::vector<AnimationNode>& nodes = skeleton.GetNodes();
+		BlendMask mask;
+		mask.weights.assign(nodes.size(), 0.0f);
+		int root = skeleton.FindNode(rootName);
+		if (root < 0)
+			return mask;
+		// parents come before their children, so one pass marks the whole subtree
+		mask.weights[root] = weight;
+		for (size_t i = root + 1; i < nodes.size(); i++)
+			if (nodes[i].parent >= root && mask.weights[nodes[i].parent] != 0.0f)
+				mask.weights[i] = weight;
+		return mask;
+	}
+};
+
+// The operations poses are built from. All of them work on caller provided memory and may write over one of their inputs.
+class PoseBlend
+{
+public:
+	// for every node of skeleton, the index of the clip node with the same name or -1
+	static std::vector<int> MapNodes(const Animation& skeleton, const Animation& clip)
+	{
+		std::unordered_map<std::string, int> clipNodes;
+		for (int i = 0; i < (int)clip.GetNodes().size(); i++)
+			clipNodes.emplace(clip.GetNodes()[i].name, i);
+		std::vector<int> map;
+		for (const AnimationNode& node : skeleton.GetNodes())
+		{
+			auto found = clipNodes.find(node.name);
+			map.push_back(found != clipNodes.end() ? found->second : -1);
+		}
+		return map;
+	}
+
+	static void Bind(const Animation& skeleton, BoneTransform* out)
+	{
+		const std::vector<AnimationNode>& nodes = skeleton.GetNodes();
+		for (size_t i = 0; i < nodes.size(); i++)
+			out[i] = nodes[i].bind;
+	}
+
+	// clip at time in the layout of skeleton. Nodes the clip doesn't animate keep the clip's bind transform, nodes it
+	// doesn't have the skeleton's
+	static void Sample(const Animation& skeleton, const Animation& clip, const std::vector<int>& nodeMap, float time, BoneCursor* cursors, BoneTransform* out)
+	{
+		const std::vector<AnimationNode>& nodes = skeleton.GetNodes();
+		const std::vector<AnimationNode>& clipNodes = clip.GetNodes();
+		const std::vector<Bone>& bones = clip.GetBones();
+		for (size_t i = 0; i < nodes.size(); i++)
+		{
+			int source = nodeMap[i];
+			if (source < 0)
+				out[i] = nodes[i].bind;
+			else if (clipNodes[source].channel < 0)
+				out[i] = clipNodes[source].bind;
+			else
+				out[i] = bones[clipNodes[source].channel].SampleTransform(time, cursors[clipNodes[source].channel]);
+		}
+	}
+
+	// out = a towards b by t, scaled per node by mask (may be null). Rotations are normalized lerps along the shorter arc
+	static void Blend(const BoneTransform* a, const BoneTransform* b, float t, const float* mask, size_t count, BoneTransform* out)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			float weight = mask ? t * mask[i] : t;
+			if (weight <= 0.0f)
+			{
+				out[i] = a[i];
+				continue;
+			}
+			out[i].translation = glm::mix(a[i].translation, b[i].translation, weight);
+			out[i].rotation = Nlerp(a[i].rotation, b[i].rotation, weight);
+			out[i].scale = glm::mix(a[i].scale, b[i].scale, weight);
+		}
+	}
+
+	// n-way blends: Clear the sum, Accumulate every pose with its weight, then Normalize by the total weight
+	static void Clear(BoneTransform* sum, size_t count)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			sum[i].translation = glm::vec3(0.0f);
+			sum[i].rotation = glm::quat(0.0f, 0.0f, 0.0f, 0.0f);
+			sum[i].scale = glm::vec3(0.0f);
+		}
+	}
+
+	static void Accumulate(const BoneTransform* pose, float weight, size_t count, BoneTransform* sum)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			// q and -q are the same rotation, add the one on the side of what is summed so far
+			float sign = glm::dot(sum[i].rotation, pose[i].rotation) < 0.0f ? -weight : weight;
+			sum[i].translation += pose[i].translation * weight;
+			sum[i].rotation.x += pose[i].rotation.x * sign;
+			sum[i].rotation.y += pose[i].rotation.y * sign;
+			sum[i].rotation.z += pose[i].rotation.z * sign;
+			sum[i].rotation.w += pose[i].rotation.w * sign;
+			sum[i].scale += pose[i].scale * weight;
+		}
+	}
+
+	static void Normalize(BoneTransform* sum, float totalWeight, size_t count)
+	{
+		float inverse = 1.0f / totalWeight;
+		for (size_t i = 0; i < count; i++)
+		{
+			sum[i].translation *= inverse;
+			sum[i].scale *= inverse;
+			float length = glm::length(sum[i].rotation);
+			sum[i].rotation = length > 0.0f ? sum[i].rotation / length : glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+		}
+	}
+
+	// out = base plus the difference of pose from reference, scaled by weight and mask (may be null)
+	static void ApplyAdditive(const BoneTransform* base, const BoneTransform* pose, const BoneTransform* reference, float weight, const float* mask, size_t count, BoneTransform* out)
+	{
+		const glm::quat identity(1.0f, 0.0f, 0.0f, 0.0f);
+		for (size_t i = 0; i < count; i++)
+		{
+			float w = mask ? weight * mask[i] : weight;
+			if (w <= 0.0f)
+			{
+				out[i] = base[i];
+				continue;
+			}
+			glm::quat delta = glm::conjugate(reference[i].rotation) * pose[i].rotation;
+			out[i].translation = base[i].translation + (pose[i].translation - reference[i].translation) * w;
+			out[i].rotation = glm::normalize(base[i].rotation * Nlerp(identity, delta, w));
+			out[i].scale = base[i].scale * glm::mix(glm::vec3(1.0f), pose[i].scale / reference[i].scale, w);
+		}
+	}
+
+	// the only step that builds matrices: local pose to global transforms to the final bone matrices of skeleton
+	static void ToBoneMatrices(const Animation& skeleton, const BoneTransform* pose, glm::mat4* globalTransforms, glm::mat4* finalBoneMatrices)
+	{
+		const std::vector<AnimationNode>& nodes = skeleton.GetNodes();
+		for (size_t i = 0; i < nodes.size(); i++)
+		{
+			const AnimationNode& node = nodes[i];
+			glm::mat4 nodeTransform = pose[i].ToMatrix();
+			globalTransforms[i] = node.parent >= 0 ? globalTransforms[node.parent] * nodeTransform : nodeTransform;
+			if (node.boneID >= 0)
+				finalBoneMatrices[node.boneID] = globalTransforms[i] * node.offset;
+		}
+	}
+
+	static glm::quat Nlerp(const glm::quat& a, const glm::quat& b, float t)
+	{
+		glm::quat to = glm::dot(a, b) < 0.0f ? -b : b;
+		return glm::normalize(glm::quat(
+			a.w + (to.w - a.w) * t,
+			a.x + (to.x - a.x) * t,
+			a.y + (to.y - a.y) * t,
+			a.z + (to.z - a.z) * t));
+	}
+};
+
+// Plays several clips on one character and blends them. The base layer is an n-way blend of clips whose weights can
+// fade over time, which also gives cross-fades. Layers on top either override the pose underneath (e.g. an upper body
+// clip through a mask) or add a clip's difference from its first frame to it (additive). Every clip must share the
+// bone names of the skeleton, nodes are matched by name once when a clip starts.
+// Intermediate poses live in a PoseArena, so a warm blender doesn't allocate per frame; starting a clip allocates its
+// key cursors.
+class AnimationBlender
+{
+public:
+	enum class LayerMode
+	{
+		Override,
+		Additive
+	};
+
+	explicit AnimationBlender(const Animation* skeleton = nullptr)
+	{
+		SetSkeleton(skeleton);
+	}
+
+	// drops every clip and layer
+	void SetSkeleton(const Animation* skeleton)
+	{
+		m_Skeleton = skeleton;
+		m_Clips.clear();
+		m_Layers.clear();
+		if (!m_Skeleton)
+			return;
+		m_GlobalTransforms.resize(m_Skeleton->GetNodes().size());
+		m_FinalBoneMatrices.assign(std::max(m_Skeleton->GetBoneSlotCount(), 1), glm::mat4(1.0f));
+	}
+
+	// fades the base layer weight of clip to weight over fadeSeconds (0 sets it right away). A clip not playing yet
+	// starts at startTime (in ticks), clips that faded out to 0 are dropped. Does nothing without a skeleton
+	void SetWeight(const Animation* clip, float weight, float fadeSeconds = 0.0f, float startTime = 0.0f)
+	{
+		if (!m_Skeleton || !clip)
+			return;
+		ClipState* state = FindClip(clip);
+		if (!state)
+		{
+			m_Clips.push_back(ClipState());
+			state = &m_Clips.back();
+			Start(*state, clip, startTime);
+		}
+		SetTarget(state->weight, weight, fadeSeconds);
+	}
+
+	// fades clip in to weight 1 and every other base clip out to 0 over fadeSeconds
+	void CrossFade(const Animation* clip, float fadeSeconds, float startTime = 0.0f)
+	{
+		if (!m_Skeleton || !clip)
+			return;
+		for (ClipState& state : m_Clips)
+			if (state.clip != clip)
+				SetTarget(state.weight, 0.0f, fadeSeconds);
+		SetWeight(clip, 1.0f, fadeSeconds, startTime);
+	}
+
+	// a layer above the base clips, mask must outlive the layer and may be null. Returns the layer index, needs a skeleton
+	size_t AddLayer(const Animation* clip, LayerMode mode, float weight, const BlendMask* mask = nullptr)
+	{
+		assert(m_Skeleton && clip);
+		assert(!mask || mask->weights.size() == m_Skeleton->GetNodes().size());
+		m_Layers.push_back(Layer());
+		Layer& layer = m_Layers.back();
+		Start(layer.state, clip, 0.0f);
+		layer.state.weight.value = layer.state.weight.target = weight;
+		layer.mode = mode;
+		layer.mask = mask ? mask->weights.data() : nullptr;
+		if (mode == LayerMode::Additive)
+		{
+			// the first frame is the reference the clip's motion is measured from
+			std::vector<BoneCursor> cursors(clip->GetBones().size());
+			layer.reference.resize(m_Skeleton->GetNodes().size());
+			PoseBlend::Sample(*m_Skeleton, *clip, layer.state.nodeMap, 0.0f, cursors.data(), layer.reference.data());
+		}
+		return m_Layers.size() - 1;
+	}
+
+	void SetLayerWeight(size_t layer, float weight, float fadeSeconds = 0.0f)
+	{
+		SetTarget(m_Layers[layer].state.weight, weight, fadeSeconds);
+	}
+
+	// advances times and fades by dt seconds and evaluates the pose
+	void Update(float dt)
+	{
+		if (!m_Skeleton)
+			return;
+		for (ClipState& state : m_Clips)
+			Advance(state, dt);
+		for (Layer& layer : m_Layers)
+			Advance(layer.state, dt);
+		m_Clips.erase(std::remove_if(m_Clips.begin(), m_Clips.end(), [](const ClipState& state)
+		{
+			return state.weight.value <= 0.0f && state.weight.target <= 0.0f;
+		}), m_Clips.end());
+		Evaluate();
+	}
+
+	void Evaluate()
+	{
+		if (!m_Skeleton)
+			return;
+		const size_t count = m_Skeleton->GetNodes().size();
+		m_Arena.Reset();
+		BoneTransform* pose = m_Arena.Allocate(count);
+		BoneTransform* sample = nullptr;
+
+		float totalWeight = 0.0f;
+		int weighted = 0;
+		for (const ClipState& state : m_Clips)
+			if (state.weight.value > 0.0f)
+			{
+				totalWeight += state.weight.value;
+				weighted++;
+			}
+
+		if (weighted == 0)
+			PoseBlend::Bind(*m_Skeleton, pose);
+		else if (weighted == 1)
+		{
+			for (ClipState& state : m_Clips)
+				if (state.weight.value > 0.0f)
+					SampleClip(state, pose);
+		}
+		else
+		{
+			sample = m_Arena.Allocate(count);
+			PoseBlend::Clear(pose, count);
+			for (ClipState& state : m_Clips)
+				if (state.weight.value > 0.0f)
+				{
+					SampleClip(state, sample);
+					PoseBlend::Accumulate(sample, state.weight.value, count, pose);
+				}
+			PoseBlend::Normalize(pose, totalWeight, count);
+		}
+
+		for (Layer& layer : m_Layers)
+		{
+			if (layer.state.weight.value <= 0.0f)
+				continue;
+			if (!sample)
+				sample = m_Arena.Allocate(count);
+			SampleClip(layer.state, sample);
+			if (layer.mode == LayerMode::Override)
+				PoseBlend::Blend(pose, sample, layer.state.weight.value, layer.mask, count, pose);
+			else
+				PoseBlend::ApplyAdditive(pose, sample, layer.reference.data(), layer.state.weight.value, layer.mask, count, pose);
+		}
+
+		PoseBlend::ToBoneMatrices(*m_Skeleton, pose, m_GlobalTransforms.data(), m_FinalBoneMatrices.data());
+	}
+
+	const std::vector<glm::mat4>& GetFinalBoneMatrices() const { return m_FinalBoneMatrices; }
+	const Animation* GetSkeleton() const { return m_Skeleton; }
+	const PoseArena& GetArena() const { return m_Arena; }
+	size_t GetClipCount() const { return m_Clips.size(); }
+
+	// current base layer weight of clip, 0 if it isn't playing
+	float GetWeight(const Animation* clip) const
+	{
+		for (const ClipState& state : m_Clips)
+			if (state.clip == clip)
+				return state.weight.value;
+		return 0.0f;
+	}
+
+private:
+	struct FadingWeight
+	{
+		float value = 0.0f;
+		float target = 0.0f;
+		float speed = 0.0f; // per second
+	};
+
+	struct ClipState
+	{
+		const Animation* clip = nullptr;
+		std::vector<int> nodeMap;
+		std::vector<BoneCursor> cursors;
+		float time = 0.0f;
+		FadingWeight weight;
+	};
+
+	struct Layer
+	{
+		ClipState state;
+		LayerMode mode = LayerMode::Override;
+		const float* mask = nullptr;
+		std::vector<BoneTransform> reference; // additive layers only
+	};
+
+	const Animation* m_Skeleton = nullptr;
+	std::vector<ClipState> m_Clips;
+	std::vector<Layer> m_Layers;
+	PoseArena m_Arena;
+	std::vector<glm::mat4> m_GlobalTransforms; // per baked node of the skeleton
+	std::vector<glm::mat4> m_FinalBoneMatrices;
+
+	ClipState* FindClip(const Animation* clip)
+	{
+		for (ClipState& state : m_Clips)
+			if (state.clip == clip)
+				return &state;
+		return nullptr;
+	}
+
+	void Start(ClipState& state, const Animation* clip, float startTime)
+	{
+		assert(m_Skeleton && clip);
+		state.clip = clip;
+		state.nodeMap = PoseBlend::MapNodes(*m_Skeleton, *clip);
+		state.cursors.assign(clip->GetBones().size(), BoneCursor());
+		state.time = fmod(startTime, clip->GetDuration());
+	}
+
+	static void SetTarget(FadingWeight& weight, float target, float fadeSeconds)
+	{
+		weight.target = target;
+		if (fadeSeconds <= 0.0f)
+			weight.value = target;
+		else
+			weight.speed = std::abs(target - weight.value) / fadeSeconds;
+	}
+
+	static void Advance(ClipState& state, float dt)
+	{
+		state.time += state.clip->GetTicksPerSecond() * dt;
+		state.time = fmod(state.time, state.clip->GetDuration());
+
+		FadingWeight& weight = state.weight;
+		float step = weight.speed * dt;
+		if (weight.value < weight.target)
+			weight.value = std::min(weight.value + step, weight.target);
+		else
+			weight.value = std::max(weight.value - step, weight.target);
+	}
+
+	void SampleClip(ClipState& state, BoneTransform* out)
+	{
+		PoseBlend::Sample(*m_Skeleton, *state.clip, state.nodeMap, state.time, state.cursors.data(), out);
+	}
+};
@@ -0,0 +1,343 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Keyframe compression for animation clips, applied to every Bone at import.
+// Keys that interpolation between their neighbours already reproduces within a tolerance are dropped, the rest are
+// quantized: rotations to 48 bits (the three smallest components at 15 bits each plus the index of the largest),
+// translations and scales to 16 bits per component within the range of their track, key times to 16 bits.
+// A translation or scale track whose range is too wide for 16 bit steps to stay within the tolerance keeps its
+// values as floats.
+
+struct AnimationCompressionSettings
+{
+	bool enabled = true;
+	bool storeClip = false;           // keep the compressed clip next to the source file, see Animation::GetClipPath
+	float positionTolerance = 0.001f; // model units
+	float rotationTolerance = 0.001f; // radians
+	float scaleTolerance = 0.001f;
+};
+
+#define ANIMATION_CLIP_VERSION 2
+
+struct AnimationClipHeader
+{
+	char magic[4];
+	uint32_t version;
+	int64_t sourceModifiedTime;
+	float tolerances[3]; // position, rotation, scale
+	float duration;
+	int32_t ticksPerSecond;
+	uint32_t nodeCount;
+	uint32_t boneCount;
+	uint64_t rawBytes;   // statistics of the compression, kept so they survive loading from the file
+	uint64_t rawKeys;
+	float maxErrors[3];
+};
+
+// summed over all compressed bones of a clip
+struct AnimationCompressionStats
+{
+	size_t rawBytes = 0;        // key times and values before compression
+	size_t compressedBytes = 0;
+	size_t rawKeys = 0;
+	size_t keptKeys = 0;
+	float maxPositionError = 0.0f; // at the original key times, in model units
+	float maxRotationError = 0.0f; // radians
+	float maxScaleError = 0.0f;
+};
+
+// one track of a bone (its positions, rotations or scales) after key reduction and quantization
+struct QuantizedTrack
+{
+	std::vector<uint16_t> times;  // key times in steps of the bone's time step
+	std::vector<uint16_t> values; // three per key: smallest three for rotations, range quantized xyz otherwise
+	std::vector<float> rawValues; // three per key instead of values, for vector tracks too wide to quantize
+	glm::vec3 rangeMin = glm::vec3(0.0f);
+	glm::vec3 rangeExtent = glm::vec3(0.0f);
+
+	size_t Size() const { return times.size(); }
+	bool IsRaw() const { return !rawValues.empty(); }
+
+	size_t GetMemoryUsage() const
+	{
+		return times.capacity() * sizeof(uint16_t) + values.capacity() * sizeof(uint16_t) + rawValues.capacity() * sizeof(float) +
+			2 * sizeof(glm::vec3);
+	}
+
+	void Write(std::ofstream& file) const
+	{
+		uint32_t count = (uint32_t)times.size();
+		uint32_t raw = IsRaw() ? 1 : 0;
+		file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+		file.write(reinterpret_cast<const char*>(&raw), sizeof(raw));
+		file.write(reinterpret_cast<const char*>(&rangeMin), sizeof(rangeMin));
+		file.write(reinterpret_cast<const char*>(&rangeExtent), sizeof(rangeExtent));
+		file.write(reinterpret_cast<const char*>(times.data()), times.size() * sizeof(uint16_t));
+		if (raw)
+			file.write(reinterpret_cast<const char*>(rawValues.data()), rawValues.size() * sizeof(float));
+		else
+			file.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(uint16_t));
+	}
+
+	// false on a truncated file or an empty track
+	bool Read(std::ifstream& file)
+	{
+		uint32_t count = 0;
+		uint32_t raw = 0;
+		file.read(reinterpret_cast<char*>(&count), sizeof(count));
+		file.read(reinterpret_cast<char*>(&raw), sizeof(raw));
+		file.read(reinterpret_cast<char*>(&rangeMin), sizeof(rangeMin));
+		file.read(reinterpret_cast<char*>(&rangeExtent), sizeof(rangeExtent));
+		if (!file || count == 0 || count > 65536 || raw > 1)
+			return false;
+		times.resize(count);
+		file.read(reinterpret_cast<char*>(times.data()), times.size() * sizeof(uint16_t));
+		if (raw)
+		{
+			values.clear();
+			rawValues.resize(count * 3);
+			file.read(reinterpret_cast<char*>(rawValues.data()), rawValues.size() * sizeof(float));
+		}
+		else
+		{
+			rawValues.clear();
+			values.resize(count * 3);
+			file.read(reinterpret_cast<char*>(values.data()), values.size() * sizeof(uint16_t));
+		}
+		return (bool)file;
+	}
+};
+
+class AnimationCodec
+{
+public:
+	// ticks per stored time step: 1 when every key lies on a whole tick (the usual case, then times are exact),
+	// otherwise the longest track is spread over the 16 bit range
+	static float ChooseTimeStep(const std::vector<const std::vector<float>*>& tracks)
+	{
+		float maxTime = 0.0f;
+		bool wholeTicks = true;
+		for (const std::vector<float>* times : tracks)
+			for (float time : *times)
+			{
+				maxTime = std::max(maxTime, time);
+				wholeTicks = wholeTicks && time >= 0.0f && time == std::floor(time);
+			}
+		if ((wholeTicks && maxTime <= 65535.0f) || maxTime <= 0.0f)
+			return 1.0f;
+		return maxTime / 65535.0f;
+	}
+
+	static void PackRotation(const glm::quat& rotation, uint16_t* out)
+	{
+		glm::quat q = glm::normalize(rotation);
+		float components[4] = { q.x, q.y, q.z, q.w };
+		int largest = 0;
+		for (int i = 1; i < 4; i++)
+			if (std::abs(components[i]) > std::abs(components[largest]))
+				largest = i;
+		// q and -q are the same rotation, flipping to a positive largest component lets it be rebuilt from the others
+		float sign = components[largest] < 0.0f ? -1.0f : 1.0f;
+		uint64_t bits = (uint64_t)largest;
+		int shift = 2;
+		for (int i = 0; i < 4; i++)
+		{
+			if (i == largest)
+				continue;
+			// the other components lie within +-1/sqrt(2)
+			float normalized = components[i] * sign * 0.70710678f + 0.5f;
+			uint64_t quantized = (uint64_t)std::min(32767.0f, std::max(0.0f, std::round(normalized * 32767.0f)));
+			bits |= quantized << shift;
+			shift += 15;
+		}
+		out[0] = (uint16_t)(bits & 0xffff);
+		out[1] = (uint16_t)((bits >> 16) & 0xffff);
+		out[2] = (uint16_t)((bits >> 32) & 0xffff);
+	}
+
+	static glm::quat UnpackRotation(const uint16_t* in)
+	{
+		uint64_t bits = (uint64_t)in[0] | ((uint64_t)in[1] << 16) | ((uint64_t)in[2] << 32);
+		int largest = (int)(bits & 3);
+		float components[4];
+		float sum = 0.0f;
+		int shift = 2;
+		for (int i = 0; i < 4; i++)
+		{
+			if (i == largest)
+				continue;
+			float normalized = (float)((bits >> shift) & 0x7fff) / 32767.0f;
+			components[i] = (normalized - 0.5f) * 1.41421356f;
+			sum += components[i] * components[i];
+			shift += 15;
+		}
+		components[largest] = std::sqrt(std::max(0.0f, 1.0f - sum));
+		return glm::normalize(glm::quat(components[3], components[0], components[1], components[2]));
+	}
+
+	static void PackVector(const glm::vec3& value, const glm::vec3& rangeMin, const glm::vec3& rangeExtent, uint16_t* out)
+	{
+		for (int c = 0; c < 3; c++)
+		{
+			float normalized = rangeExtent[c] > 0.0f ? (value[c] - rangeMin[c]) / rangeExtent[c] : 0.0f;
+			out[c] = (uint16_t)std::min(65535.0f, std::max(0.0f, std::round(normalized * 65535.0f)));
+		}
+	}
+
+	static glm::vec3 UnpackVector(const uint16_t* in, const glm::vec3& rangeMin, const glm::vec3& rangeExtent)
+	{
+		return rangeMin + rangeExtent * glm::vec3(in[0], in[1], in[2]) * (1.0f / 65535.0f);
+	}
+
+	// value of key of a translation or scale track, quantized or raw
+	static glm::vec3 GetVector(const QuantizedTrack& track, size_t key)
+	{
+		if (track.IsRaw())
+			return glm::vec3(track.rawValues[key * 3], track.rawValues[key * 3 + 1], track.rawValues[key * 3 + 2]);
+		return UnpackVector(&track.values[key * 3], track.rangeMin, track.rangeExtent);
+	}
+
+	// angle between two rotations in radians
+	static float RotationError(const glm::quat& a, const glm::quat& b)
+	{
+		glm::quat difference = glm::conjugate(a) * b;
+		return 2.0f * std::atan2(glm::length(glm::vec3(difference.x, difference.y, difference.z)), std::abs(difference.w));
+	}
+
+	static QuantizedTrack CompressVectors(const std::vector<float>& times, const std::vector<glm::vec3>& values, float tolerance, float timeStep, float& maxError)
+	{
+		QuantizedTrack track;
+		track.rangeMin = values[0];
+		glm::vec3 rangeMax = values[0];
+		for (const glm::vec3& value : values)
+		{
+			track.rangeMin = glm::min(track.rangeMin, value);
+			rangeMax = glm::max(rangeMax, value);
+		}
+		track.rangeExtent = rangeMax - track.rangeMin;
+		// rounding to 16 bit steps moves a value by up to half a step per component, that must leave at least half
+		// the tolerance to key reduction; wider tracks (about 65 units at the default tolerance) keep their floats
+		const bool raw = glm::length(track.rangeExtent) > tolerance * 65535.0f;
+
+		std::vector<glm::vec3> decoded(values.size());
+		for (size_t i = 0; i < values.size(); i++)
+		{
+			uint16_t packed[3];
+			PackVector(values[i], track.rangeMin, track.rangeExtent, packed);
+			decoded[i] = raw ? values[i] : UnpackVector(packed, track.rangeMin, track.rangeExtent);
+		}
+		auto lerp = [](const glm::vec3& a, const glm::vec3& b, float t) { return glm::mix(a, b, t); };
+		auto error = [](const glm::vec3& a, const glm::vec3& b) { return glm::length(a - b); };
+		std::vector<int> kept = ReduceKeys(times, values, decoded, timeStep, tolerance, lerp, error, maxError);
+
+		for (int key : kept)
+		{
+			track.times.push_back(QuantizeTime(times[key], timeStep));
+			if (raw)
+			{
+				track.rawValues.insert(track.rawValues.end(), { values[key].x, values[key].y, values[key].z });
+				continue;
+			}
+			uint16_t packed[3];
+			PackVector(values[key], track.rangeMin, track.rangeExtent, packed);
+			track.values.insert(track.values.end(), packed, packed + 3);
+		}
+		return track;
+	}
+
+	static QuantizedTrack CompressRotations(const std::vector<float>& times, const std::vector<glm::quat>& values, float tolerance, float timeStep, float& maxError)
+	{
+		QuantizedTrack track;
+		std::vector<glm::quat> decoded(values.size());
+		for (size_t i = 0; i < values.size(); i++)
+		{
+			uint16_t packed[3];
+			PackRotation(values[i], packed);
+			decoded[i] = UnpackRotation(packed);
+		}
+		// the same interpolation Bone uses
+		auto lerp = [](const glm::quat& a, const glm::quat& b, float t) { return glm::normalize(glm::slerp(a, b, t)); };
+		std::vector<int> kept = ReduceKeys(times, values, decoded, timeStep, tolerance, lerp, RotationError, maxError);
+
+		for (int key : kept)
+		{
+			track.times.push_back(QuantizeTime(times[key], timeStep));
+			uint16_t packed[3];
+			PackRotation(values[key], packed);
+			track.values.insert(track.values.end(), packed, packed + 3);
+		}
+		return track;
+	}
+
+private:
+	static uint16_t QuantizeTime(float time, float timeStep)
+	{
+		return (uint16_t)std::min(65535.0f, std::max(0.0f, std::round(time / timeStep)));
+	}
+
+	// a segment spans at most this many keys, which bounds the work of checking it
+	static constexpr int MAX_SEGMENT_KEYS = 64;
+
+	// Indices of the keys to keep. Walks the keys once, stretching every segment from the last kept key for as long as
+	// interpolating between the quantized end keys stays within tolerance of every original key it spans. Both
+	// curves are piecewise interpolations, so their largest difference lies at a key. Every extension checks the whole
+	// segment again, so segments end after MAX_SEGMENT_KEYS keys to keep the reduction linear in the key count.
+	// maxError receives the largest error at any original key, quantization included
+	template<typename Value, typename Lerp, typename Error>
+	static std::vector<int> ReduceKeys(const std::vector<float>& times, const std::vector<Value>& values, const std::vector<Value>& decoded,
+		float timeStep, float tolerance, Lerp lerp, Error error, float& maxError)
+	{
+		const int count = (int)values.size();
+		std::vector<float> quantizedTimes(count);
+		for (int i = 0; i < count; i++)
+			quantizedTimes[i] = QuantizeTime(times[i], timeStep);
+
+		// a single key holds the track constant
+		float constantError = 0.0f;
+		for (int i = 0; i < count; i++)
+			constantError = std::max(constantError, error(decoded[0], values[i]));
+		if (constantError <= tolerance)
+		{
+			maxError = std::max(maxError, constantError);
+			return { 0 };
+		}
+
+		auto segmentError = [&](int first, int last)
+		{
+			float segment = 0.0f;
+			for (int k = first; k <= last; k++)
+			{
+				float t = (quantizedTimes[k] - quantizedTimes[first]) / (quantizedTimes[last] - quantizedTimes[first]);
+				segment = std::max(segment, error(lerp(decoded[first], decoded[last], t), values[k]));
+			}
+			return segment;
+		};
+
+		std::vector<int> kept = { 0 };
+		int start = 0;
+		while (start < count - 1)
+		{
+			// keys that land on the same time step as the segment start can't be kept apart from it
+			int end = start + 1;
+			while (end < count - 1 && quantizedTimes[end] <= quantizedTimes[start])
+				end++;
+			if (quantizedTimes[end] <= quantizedTimes[start])
+				break;
+			while (end + 1 < count && end + 1 - start <= MAX_SEGMENT_KEYS && quantizedTimes[end + 1] > quantizedTimes[end] &&
+				segmentError(start, end + 1) <= tolerance)
+				end++;
+			maxError = std::max(maxError, segmentError(start, end));
+			kept.push_back(end);
+			start = end;
+		}
+		return kept;
+	}
+};
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cmath>
+#include <vector>
+#include <learnopengl/animation.h>
+#include <learnopengl/bone.h>
+
+// Playback of a shared Animation by one character: the time, the key cursors and the resulting pose.
+// Everything here is per character and small, the clip itself is only read.
+class AnimationInstance
+{
+public:
+	AnimationInstance(const Animation* animation = nullptr)
+	{
+		Play(animation);
+	}
+
+	// starts animation from the beginning
+	void Play(const Animation* animation)
+	{
+		m_Animation = animation;
+		m_Time = 0.0f;
+		if (!m_Animation)
+			return;
+		m_Cursors.assign(m_Animation->GetBones().size(), BoneCursor());
+		m_GlobalTransforms.resize(m_Animation->GetNodes().size());
+		m_FinalBoneMatrices.assign(std::max(m_Animation->GetBoneSlotCount(), 1), glm::mat4(1.0f));
+	}
+
+	// advances the time by dt seconds, looping over the clip, and evaluates the pose
+	void Update(float dt)
+	{
+		if (!m_Animation)
+			return;
+		Advance(dt);
+		Evaluate();
+	}
+
+	// only moves the time, for callers that evaluate the pose elsewhere (see AnimationSystem)
+	void Advance(float dt)
+	{
+		m_Time += m_Animation->GetTicksPerSecond() * dt;
+		m_Time = fmod(m_Time, m_Animation->GetDuration());
+	}
+
+	// jumps to a time in ticks and evaluates the pose there
+	void Seek(float ticks)
+	{
+		if (!m_Animation)
+			return;
+		m_Time = fmod(ticks, m_Animation->GetDuration());
+		Evaluate();
+	}
+
+	void Evaluate()
+	{
+		EvaluateInto(m_FinalBoneMatrices.data());
+	}
+
+	// walks the baked hierarchy of the clip, parents are always evaluated before their children. Writes the bone slots
+	// the hierarchy reaches, GetBoneSlotCount() matrices starting at finalBoneMatrices
+	void EvaluateInto(glm::mat4* finalBoneMatrices)
+	{
+		const std::vector<AnimationNode>& nodes = m_Animation->GetNodes();
+		const std::vector<Bone>& bones = m_Animation->GetBones();
+		for (size_t i = 0; i < nodes.size(); i++)
+		{
+			const AnimationNode& node = nodes[i];
+			glm::mat4 nodeTransform = node.channel >= 0 ? bones[node.channel].Sample(m_Time, m_Cursors[node.channel]) : node.transformation;
+
+			m_GlobalTransforms[i] = node.parent >= 0 ? m_GlobalTransforms[node.parent] * nodeTransform : nodeTransform;
+
+			if (node.boneID >= 0)
+				finalBoneMatrices[node.boneID] = m_GlobalTransforms[i] * node.offset;
+		}
+	}
+
+	const Animation* GetAnimation() const { return m_Animation; }
+	float GetTime() const { return m_Time; }
+	const std::vector<glm::mat4>& GetFinalBoneMatrices() const { return m_FinalBoneMatrices; }
+
+	// heap memory owned by this instance, in bytes
+	size_t GetMemoryUsage() const
+	{
+		return m_Cursors.capacity() * sizeof(BoneCursor) + (m_GlobalTransforms.capacity() + m_FinalBoneMatrices.capacity()) * sizeof(glm::mat4);
+	}
+
+private:
+	const Animation* m_Animation = nullptr;
+	float m_Time = 0.0f;
+	std::vector<BoneCursor> m_Cursors;         // key search state, per bone channel
+	std::vector<glm::mat4> m_GlobalTransforms; // per baked node
+	std::vector<glm::mat4> m_FinalBoneMatrices;
+};
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <vector>
+#include <learnopengl/animation_instance.h>
+#include <learnopengl/job_system.h>
+
+// Updates every registered AnimationInstance on a JobSystem and writes all their final bone matrices into one
+// contiguous buffer per frame, instance after instance. Instance i's matrices start at GetBoneOffset(i), so the whole
+// crowd is uploaded at once (see BonePaletteBuffer) and each draw only needs its offset.
+class AnimationSystem
+{
+public:
+	explicit AnimationSystem(JobSystem& jobs) : m_Jobs(jobs) {}
+
+	// the instance must stay alive until it is removed, returns its index
+	size_t Add(AnimationInstance* instance)
+	{
+		m_Instances.push_back(instance);
+		return m_Instances.size() - 1;
+	}
+
+	// later instances move down one index
+	void Remove(AnimationInstance* instance)
+	{
+		m_Instances.erase(std::remove(m_Instances.begin(), m_Instances.end(), instance), m_Instances.end());
+	}
+
+	void Clear() { m_Instances.clear(); }
+
+	// advances and evaluates every instance, grain is the number of instances per job
+	void Update(float dt, size_t grain = 16)
+	{
+		Layout();
+		m_Jobs.ParallelFor(m_Instances.size(), grain, [this, dt](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				AnimationInstance& instance = *m_Instances[i];
+				if (!instance.GetAnimation())
+					continue;
+				instance.Advance(dt);
+				instance.EvaluateInto(m_BoneMatrices.data() + m_Slots[i].offset);
+			}
+		});
+	}
+
+	const std::vector<glm::mat4>& GetBoneMatrices() const { return m_BoneMatrices; }
+	unsigned int GetBoneOffset(size_t index) const { return m_Slots[index].offset; }
+	size_t Size() const { return m_Instances.size(); }
+
+private:
+	struct Slot
+	{
+		const Animation* animation = nullptr;
+		unsigned int offset = 0;
+	};
+
+	JobSystem& m_Jobs;
+	std::vector<AnimationInstance*> m_Instances;
+	std::vector<Slot> m_Slots;             // where each instance's matrices were placed
+	std::vector<glm::mat4> m_BoneMatrices; // every instance's final bone matrices
+
+	// assigns every instance its range of the buffer. Ranges that moved or changed clip start out as identity, because
+	// bone slots the hierarchy doesn't reach are never written by EvaluateInto
+	void Layout()
+	{
+		m_Slots.resize(m_Instances.size());
+		unsigned int total = 0;
+		for (size_t i = 0; i < m_Instances.size(); i++)
+		{
+			const Animation* animation = m_Instances[i]->GetAnimation();
+			unsigned int count = animation ? (unsigned int)animation->GetBoneSlotCount() : 0;
+			bool moved = m_Slots[i].animation != animation || m_Slots[i].offset != total;
+			m_Slots[i].animation = animation;
+			m_Slots[i].offset = total;
+			total += count;
+			if (m_BoneMatrices.size() < total)
+				m_BoneMatrices.resize(total, glm::mat4(1.0f));
+			if (moved)
+				std::fill(m_BoneMatrices.begin() + m_Slots[i].offset, m_BoneMatrices.begin() + total, glm::mat4(1.0f));
+		}
+		m_BoneMatrices.resize(total);
+	}
+};
+
+// Bone matrices of many characters in a texture buffer (four RGBA32F texels per matrix), read in the vertex shader as
+//   uniform samplerBuffer boneMatrices;
+//   uniform int boneOffset; // AnimationSystem::GetBoneOffset of the character being drawn
+//   int base = (boneOffset + boneID) * 4;
+//   mat4 bone = mat4(texelFetch(boneMatrices, base), texelFetch(boneMatrices, base + 1),
+//                    texelFetch(boneMatrices, base + 2), texelFetch(boneMatrices, base + 3));
+// A uniform buffer only holds a few dozen characters' matrices on GL 3.3, a texture buffer takes the whole crowd in one upload.
+class BonePaletteBuffer
+{
+public:
+	unsigned int ID = 0;        // buffer object
+	unsigned int TextureID = 0; // texture viewing the buffer
+
+	BonePaletteBuffer() = default;
+	BonePaletteBuffer(const BonePaletteBuffer&) = delete;
+	BonePaletteBuffer& operator=(const BonePaletteBuffer&) = delete;
+	~BonePaletteBuffer()
+	{
+		if (TextureID != 0)
+			glDeleteTextures(1, &TextureID);
+		if (ID != 0)
+			glDeleteBuffers(1, &ID);
+	}
+
+	// replaces the contents, orphaning the storage first like InstanceBuffer::Upload
+	void Upload(const std::vector<glm::mat4>& matrices)
+	{
+		if (ID == 0)
+		{
+			glGenBuffers(1, &ID);
+			glGenTextures(1, &TextureID);
+		}
+		glBindBuffer(GL_TEXTURE_BUFFER, ID);
+		bool grown = matrices.size() > m_Capacity || m_Capacity == 0;
+		if (grown)
+			m_Capacity = std::max(std::max<size_t>(matrices.size(), 1), m_Capacity * 2);
+		glBufferData(GL_TEXTURE_BUFFER, m_Capacity * sizeof(glm::mat4), nullptr, GL_STREAM_DRAW);
+		if (!matrices.empty())
+			glBufferSubData(GL_TEXTURE_BUFFER, 0, matrices.size() * sizeof(glm::mat4), matrices.data());
+		if (grown)
+		{
+			glBindTexture(GL_TEXTURE_BUFFER, TextureID);
+			glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, ID);
+			glBindTexture(GL_TEXTURE_BUFFER, 0);
+		}
+		glBindBuffer(GL_TEXTURE_BUFFER, 0);
+	}
+
+	void Bind(unsigned int unit) const
+	{
+		glActiveTexture(GL_TEXTURE0 + unit);
+		glBindTexture(GL_TEXTURE_BUFFER, TextureID);
+		glActiveTexture(GL_TEXTURE0);
+	}
+
+private:
+	size_t m_Capacity = 0; // in matrices
+};
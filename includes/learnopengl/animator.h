@@ -6,75 +6,62 @@
 #include <assimp/scene.h>
 #include <assimp/Importer.hpp>
 #include <learnopengl/animation.h>
+#include <learnopengl/animation_blend.h>
+#include <learnopengl/animation_instance.h>
 #include <learnopengl/bone.h>
 
+// plays animations for one character, see AnimationInstance for sharing a clip between many characters. A single clip
+// runs on an AnimationInstance, CrossFade switches to an AnimationBlender until the next PlayAnimation
 class Animator
 {
 public:
 	Animator(Animation* animation)
+		: m_Blender(animation)
 	{
-		m_CurrentTime = 0.0;
-		m_CurrentAnimation = animation;
-
-		m_FinalBoneMatrices.reserve(100);
-
-		for (int i = 0; i < 100; i++)
-			m_FinalBoneMatrices.push_back(glm::mat4(1.0f));
+		m_Instance.Play(animation);
 	}
 
 	void UpdateAnimation(float dt)
 	{
-		m_DeltaTime = dt;
-		if (m_CurrentAnimation)
-		{
-			m_CurrentTime += m_CurrentAnimation->GetTicksPerSecond() * dt;
-			m_CurrentTime = fmod(m_CurrentTime, m_CurrentAnimation->GetDuration());
-			CalculateBoneTransform(&m_CurrentAnimation->GetRootNode(), glm::mat4(1.0f));
-		}
+		if (m_Blending)
+			m_Blender.Update(dt);
+		else
+			m_Instance.Update(dt);
 	}
 
+	// switches instantly
 	void PlayAnimation(Animation* pAnimation)
 	{
-		m_CurrentAnimation = pAnimation;
-		m_CurrentTime = 0.0f;
+		m_Blending = false;
+		m_Instance.Play(pAnimation);
 	}
 
-	void CalculateBoneTransform(const AssimpNodeData* node, glm::mat4 parentTransform)
+	// fades from what is playing to pAnimation over seconds. The animations must share the bone names of the one
+	// the Animator was created with; an Animator created without one takes pAnimation's hierarchy
+	void CrossFade(Animation* pAnimation, float seconds)
 	{
-		std::string nodeName = node->name;
-		glm::mat4 nodeTransform = node->transformation;
-
-		Bone* Bone = m_CurrentAnimation->FindBone(nodeName);
-
-		if (Bone)
+		if (!pAnimation)
+			return;
+		if (!m_Blending)
 		{
-			Bone->Update(m_CurrentTime);
-			nodeTransform = Bone->GetLocalTransform();
+			m_Blender.SetSkeleton(m_Blender.GetSkeleton() ? m_Blender.GetSkeleton() : pAnimation);
+			if (m_Instance.GetAnimation())
+				m_Blender.SetWeight(m_Instance.GetAnimation(), 1.0f, 0.0f, m_Instance.GetTime());
+			m_Blending = true;
 		}
-
-		glm::mat4 globalTransformation = parentTransform * nodeTransform;
-
-		auto boneInfoMap = m_CurrentAnimation->GetBoneIDMap();
-		if (boneInfoMap.find(nodeName) != boneInfoMap.end())
-		{
-			int index = boneInfoMap[nodeName].id;
-			glm::mat4 offset = boneInfoMap[nodeName].offset;
-			m_FinalBoneMatrices[index] = globalTransformation * offset;
-		}
-
-		for (int i = 0; i < node->childrenCount; i++)
-			CalculateBoneTransform(&node->children[i], globalTransformation);
+		m_Blender.CrossFade(pAnimation, seconds);
 	}
 
-	std::vector<glm::mat4> GetFinalBoneMatrices()
+	const std::vector<glm::mat4>& GetFinalBoneMatrices() const
 	{
-		return m_FinalBoneMatrices;
+		return m_Blending ? m_Blender.GetFinalBoneMatrices() : m_Instance.GetFinalBoneMatrices();
 	}
 
-private:
-	std::vector<glm::mat4> m_FinalBoneMatrices;
-	Animation* m_CurrentAnimation;
-	float m_CurrentTime;
-	float m_DeltaTime;
+	AnimationInstance& GetInstance() { return m_Instance; }
+	AnimationBlender& GetBlender() { return m_Blender; }
 
+private:
+	AnimationInstance m_Instance;
+	AnimationBlender m_Blender;
+	bool m_Blending = false;
 };
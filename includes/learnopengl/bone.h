@@ -2,6 +2,7 @@
 
 /* Container for bone data */
 
+#include <algorithm>
 #include <vector>
 #include <assimp/scene.h>
 #include <list>
@@ -9,23 +10,50 @@
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/quaternion.hpp>
 #include <learnopengl/assimp_glm_helpers.h>
+#include <learnopengl/animation_compression.h>
 
-struct KeyPosition
+// local transform of a node as translation, rotation and scale, the space poses are blended in
+struct BoneTransform
 {
-	glm::vec3 position;
-	float timeStamp;
-};
+	glm::vec3 translation = glm::vec3(0.0f);
+	glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+	glm::vec3 scale = glm::vec3(1.0f);
 
-struct KeyRotation
-{
-	glm::quat orientation;
-	float timeStamp;
+	// translation * rotation * scale
+	glm::mat4 ToMatrix() const
+	{
+		glm::mat4 matrix = glm::toMat4(rotation);
+		matrix[0] *= scale.x;
+		matrix[1] *= scale.y;
+		matrix[2] *= scale.z;
+		matrix[3] = glm::vec4(translation, 1.0f);
+		return matrix;
+	}
+
+	// the inverse of ToMatrix for matrices without shear
+	static BoneTransform FromMatrix(const glm::mat4& matrix)
+	{
+		BoneTransform transform;
+		transform.translation = glm::vec3(matrix[3]);
+		transform.scale = glm::vec3(glm::length(glm::vec3(matrix[0])), glm::length(glm::vec3(matrix[1])), glm::length(glm::vec3(matrix[2])));
+		glm::mat3 rotation(glm::vec3(matrix[0]) / transform.scale.x, glm::vec3(matrix[1]) / transform.scale.y, glm::vec3(matrix[2]) / transform.scale.z);
+		if (glm::determinant(rotation) < 0.0f)
+		{
+			// mirrored, keep the rotation proper and the sign in the scale
+			transform.scale.x = -transform.scale.x;
+			rotation[0] = -rotation[0];
+		}
+		transform.rotation = glm::normalize(glm::quat_cast(rotation));
+		return transform;
+	}
 };
 
-struct KeyScale
+// last key segment used by a playback of a bone, so the next lookup usually only steps forward a key or two
+struct BoneCursor
 {
-	glm::vec3 scale;
-	float timeStamp;
+	int position = 0;
+	int rotation = 0;
+	int scale = 0;
 };
 
 class Bone
@@ -34,91 +62,172 @@ public:
 	Bone(const std::string& name, int ID, const aiNodeAnim* channel)
 		:
 		m_Name(name),
-		m_ID(ID),
-		m_LocalTransform(1.0f)
+		m_ID(ID)
 	{
+		// each track is kept as separate time and value arrays, key searches only touch the times
 		m_NumPositions = channel->mNumPositionKeys;
-
+		m_PositionTimes.reserve(m_NumPositions);
+		m_Positions.reserve(m_NumPositions);
 		for (int positionIndex = 0; positionIndex < m_NumPositions; ++positionIndex)
 		{
 			aiVector3D aiPosition = channel->mPositionKeys[positionIndex].mValue;
-			float timeStamp = channel->mPositionKeys[positionIndex].mTime;
-			KeyPosition data;
-			data.position = AssimpGLMHelpers::GetGLMVec(aiPosition);
-			data.timeStamp = timeStamp;
-			m_Positions.push_back(data);
+			m_PositionTimes.push_back((float)channel->mPositionKeys[positionIndex].mTime);
+			m_Positions.push_back(AssimpGLMHelpers::GetGLMVec(aiPosition));
 		}
 
 		m_NumRotations = channel->mNumRotationKeys;
+		m_RotationTimes.reserve(m_NumRotations);
+		m_Rotations.reserve(m_NumRotations);
 		for (int rotationIndex = 0; rotationIndex < m_NumRotations; ++rotationIndex)
 		{
 			aiQuaternion aiOrientation = channel->mRotationKeys[rotationIndex].mValue;
-			float timeStamp = channel->mRotationKeys[rotationIndex].mTime;
-			KeyRotation data;
-			data.orientation = AssimpGLMHelpers::GetGLMQuat(aiOrientation);
-			data.timeStamp = timeStamp;
-			m_Rotations.push_back(data);
+			m_RotationTimes.push_back((float)channel->mRotationKeys[rotationIndex].mTime);
+			m_Rotations.push_back(AssimpGLMHelpers::GetGLMQuat(aiOrientation));
 		}
 
 		m_NumScalings = channel->mNumScalingKeys;
+		m_ScaleTimes.reserve(m_NumScalings);
+		m_Scales.reserve(m_NumScalings);
 		for (int keyIndex = 0; keyIndex < m_NumScalings; ++keyIndex)
 		{
 			aiVector3D scale = channel->mScalingKeys[keyIndex].mValue;
-			float timeStamp = channel->mScalingKeys[keyIndex].mTime;
-			KeyScale data;
-			data.scale = AssimpGLMHelpers::GetGLMVec(scale);
-			data.timeStamp = timeStamp;
-			m_Scales.push_back(data);
+			m_ScaleTimes.push_back((float)channel->mScalingKeys[keyIndex].mTime);
+			m_Scales.push_back(AssimpGLMHelpers::GetGLMVec(scale));
 		}
 	}
-	
-	void Update(float animationTime)
+
+	// a bone read back from a compressed clip file
+	Bone(const std::string& name, int ID, float timeStep, QuantizedTrack positions, QuantizedTrack rotations, QuantizedTrack scales)
+		:
+		m_PositionTrack(std::move(positions)),
+		m_RotationTrack(std::move(rotations)),
+		m_ScaleTrack(std::move(scales)),
+		m_TimeStep(timeStep),
+		m_Compressed(true),
+		m_Name(name),
+		m_ID(ID)
 	{
-		glm::mat4 translation = InterpolatePosition(animationTime);
-		glm::mat4 rotation = InterpolateRotation(animationTime);
-		glm::mat4 scale = InterpolateScaling(animationTime);
-		m_LocalTransform = translation * rotation * scale;
+		m_NumPositions = (int)m_PositionTrack.Size();
+		m_NumRotations = (int)m_RotationTrack.Size();
+		m_NumScalings = (int)m_ScaleTrack.Size();
 	}
-	glm::mat4 GetLocalTransform() { return m_LocalTransform; }
-	std::string GetBoneName() const { return m_Name; }
-	int GetBoneID() { return m_ID; }
-	
 
+	// replaces the keys by their reduced and quantized form (see AnimationCodec), the float keys are freed
+	void Compress(const AnimationCompressionSettings& settings, AnimationCompressionStats& stats)
+	{
+		if (m_Compressed)
+			return;
+		stats.rawBytes += GetMemoryUsage();
+		stats.rawKeys += m_NumPositions + m_NumRotations + m_NumScalings;
+
+		m_TimeStep = AnimationCodec::ChooseTimeStep({ &m_PositionTimes, &m_RotationTimes, &m_ScaleTimes });
+		m_PositionTrack = AnimationCodec::CompressVectors(m_PositionTimes, m_Positions, settings.positionTolerance, m_TimeStep, stats.maxPositionError);
+		m_RotationTrack = AnimationCodec::CompressRotations(m_RotationTimes, m_Rotations, settings.rotationTolerance, m_TimeStep, stats.maxRotationError);
+		m_ScaleTrack = AnimationCodec::CompressVectors(m_ScaleTimes, m_Scales, settings.scaleTolerance, m_TimeStep, stats.maxScaleError);
+		m_NumPositions = (int)m_PositionTrack.Size();
+		m_NumRotations = (int)m_RotationTrack.Size();
+		m_NumScalings = (int)m_ScaleTrack.Size();
+		m_Compressed = true;
+
+		std::vector<float>().swap(m_PositionTimes);
+		std::vector<glm::vec3>().swap(m_Positions);
+		std::vector<float>().swap(m_RotationTimes);
+		std::vector<glm::quat>().swap(m_Rotations);
+		std::vector<float>().swap(m_ScaleTimes);
+		std::vector<glm::vec3>().swap(m_Scales);
+
+		stats.compressedBytes += GetMemoryUsage();
+		stats.keptKeys += m_NumPositions + m_NumRotations + m_NumScalings;
+	}
+
+	bool IsCompressed() const { return m_Compressed; }
+	float GetTimeStep() const { return m_TimeStep; }
+	const QuantizedTrack& GetPositionTrack() const { return m_PositionTrack; }
+	const QuantizedTrack& GetRotationTrack() const { return m_RotationTrack; }
+	const QuantizedTrack& GetScaleTrack() const { return m_ScaleTrack; }
 
-	int GetPositionIndex(float animationTime)
+	// heap memory of the keys, in bytes
+	size_t GetMemoryUsage() const
 	{
-		for (int index = 0; index < m_NumPositions - 1; ++index)
-		{
-			if (animationTime < m_Positions[index + 1].timeStamp)
-				return index;
-		}
-		assert(0);
+		if (m_Compressed)
+			return m_PositionTrack.GetMemoryUsage() + m_RotationTrack.GetMemoryUsage() + m_ScaleTrack.GetMemoryUsage();
+		return (m_PositionTimes.capacity() + m_RotationTimes.capacity() + m_ScaleTimes.capacity()) * sizeof(float) +
+			(m_Positions.capacity() + m_Scales.capacity()) * sizeof(glm::vec3) + m_Rotations.capacity() * sizeof(glm::quat);
 	}
 
-	int GetRotationIndex(float animationTime)
+	// local transform of the bone at animationTime. The keys are never modified, so any number of playbacks can
+	// sample one Bone; cursor is the playback's own record of where its previous sample was
+	glm::mat4 Sample(float animationTime, BoneCursor& cursor) const
 	{
-		for (int index = 0; index < m_NumRotations - 1; ++index)
-		{
-			if (animationTime < m_Rotations[index + 1].timeStamp)
-				return index;
-		}
-		assert(0);
+		return SampleTransform(animationTime, cursor).ToMatrix();
+	}
+
+	BoneTransform SampleTransform(float animationTime, BoneCursor& cursor) const
+	{
+		BoneTransform transform;
+		transform.translation = InterpolatePosition(animationTime, cursor.position);
+		transform.rotation = InterpolateRotation(animationTime, cursor.rotation);
+		transform.scale = InterpolateScaling(animationTime, cursor.scale);
+		return transform;
+	}
+
+	glm::mat4 Sample(float animationTime) const
+	{
+		BoneCursor cursor;
+		return Sample(animationTime, cursor);
+	}
+
+	const std::string& GetBoneName() const { return m_Name; }
+	int GetBoneID() const { return m_ID; }
+	int GetPositionIndex(float animationTime) const
+	{
+		int cursor = 0;
+		if (m_Compressed)
+			return FindKey(m_PositionTrack.times, animationTime / m_TimeStep, cursor);
+		return FindKey(m_PositionTimes, animationTime, cursor);
+	}
+
+	int GetRotationIndex(float animationTime) const
+	{
+		int cursor = 0;
+		if (m_Compressed)
+			return FindKey(m_RotationTrack.times, animationTime / m_TimeStep, cursor);
+		return FindKey(m_RotationTimes, animationTime, cursor);
+	}
+
+	int GetScaleIndex(float animationTime) const
+	{
+		int cursor = 0;
+		if (m_Compressed)
+			return FindKey(m_ScaleTrack.times, animationTime / m_TimeStep, cursor);
+		return FindKey(m_ScaleTimes, animationTime, cursor);
 	}
 
-	int GetScaleIndex(float animationTime)
+	// index of the key that starts the segment containing animationTime: the last key at or before it, at most the
+	// second to last key. Playback moves forward in small steps, so the cursor is first advanced linearly and only
+	// a jump (seek, loop, large time step) falls back to a binary search. Compressed tracks search their 16 bit times
+	// with animationTime in time steps
+	template<typename Time>
+	static int FindKey(const std::vector<Time>& times, float animationTime, int& cursor)
 	{
-		for (int index = 0; index < m_NumScalings - 1; ++index)
+		const int last = (int)times.size() - 2;
+		if (cursor > last || cursor < 0)
+			cursor = 0;
+		if (animationTime >= times[cursor])
 		{
-			if (animationTime < m_Scales[index + 1].timeStamp)
-				return index;
+			for (int step = 0; step < 4 && cursor < last && animationTime >= times[cursor + 1]; step++)
+				cursor++;
+			if (cursor < last && animationTime >= times[cursor + 1])
+				cursor = (int)(std::upper_bound(times.begin() + cursor + 1, times.begin() + last + 1, animationTime) - times.begin()) - 1;
 		}
-		assert(0);
+		else
+			cursor = std::max(0, (int)(std::upper_bound(times.begin(), times.begin() + cursor, animationTime) - times.begin()) - 1);
+		return cursor;
 	}
 
-
 private:
 
-	float GetScaleFactor(float lastTimeStamp, float nextTimeStamp, float animationTime)
+	float GetScaleFactor(float lastTimeStamp, float nextTimeStamp, float animationTime) const
 	{
 		float scaleFactor = 0.0f;
 		float midWayLength = animationTime - lastTimeStamp;
@@ -127,62 +236,97 @@ private:
 		return scaleFactor;
 	}
 
-	glm::mat4 InterpolatePosition(float animationTime)
+	glm::vec3 InterpolatePosition(float animationTime, int& cursor) const
 	{
+		if (m_Compressed)
+			return InterpolateQuantized(m_PositionTrack, animationTime, cursor);
 		if (1 == m_NumPositions)
-			return glm::translate(glm::mat4(1.0f), m_Positions[0].position);
+			return m_Positions[0];
 
-		int p0Index = GetPositionIndex(animationTime);
+		int p0Index = FindKey(m_PositionTimes, animationTime, cursor);
 		int p1Index = p0Index + 1;
-		float scaleFactor = GetScaleFactor(m_Positions[p0Index].timeStamp,
-			m_Positions[p1Index].timeStamp, animationTime);
-		glm::vec3 finalPosition = glm::mix(m_Positions[p0Index].position, m_Positions[p1Index].position
+		float scaleFactor = GetScaleFactor(m_PositionTimes[p0Index],
+			m_PositionTimes[p1Index], animationTime);
+		glm::vec3 finalPosition = glm::mix(m_Positions[p0Index], m_Positions[p1Index]
 			, scaleFactor);
-		return glm::translate(glm::mat4(1.0f), finalPosition);
+		return finalPosition;
 	}
 
-	glm::mat4 InterpolateRotation(float animationTime)
+	glm::quat InterpolateRotation(float animationTime, int& cursor) const
 	{
+		if (m_Compressed)
+			return InterpolateQuantizedRotation(animationTime, cursor);
 		if (1 == m_NumRotations)
-		{
-			auto rotation = glm::normalize(m_Rotations[0].orientation);
-			return glm::toMat4(rotation);
-		}
+			return glm::normalize(m_Rotations[0]);
 
-		int p0Index = GetRotationIndex(animationTime);
+		int p0Index = FindKey(m_RotationTimes, animationTime, cursor);
 		int p1Index = p0Index + 1;
-		float scaleFactor = GetScaleFactor(m_Rotations[p0Index].timeStamp,
-			m_Rotations[p1Index].timeStamp, animationTime);
-		glm::quat finalRotation = glm::slerp(m_Rotations[p0Index].orientation, m_Rotations[p1Index].orientation
+		float scaleFactor = GetScaleFactor(m_RotationTimes[p0Index],
+			m_RotationTimes[p1Index], animationTime);
+		glm::quat finalRotation = glm::slerp(m_Rotations[p0Index], m_Rotations[p1Index]
 			, scaleFactor);
 		finalRotation = glm::normalize(finalRotation);
-		return glm::toMat4(finalRotation);
+		return finalRotation;
 
 	}
 
-	glm::mat4 InterpolateScaling(float animationTime)
+	glm::vec3 InterpolateScaling(float animationTime, int& cursor) const
 	{
+		if (m_Compressed)
+			return InterpolateQuantized(m_ScaleTrack, animationTime, cursor);
 		if (1 == m_NumScalings)
-			return glm::scale(glm::mat4(1.0f), m_Scales[0].scale);
+			return m_Scales[0];
 
-		int p0Index = GetScaleIndex(animationTime);
+		int p0Index = FindKey(m_ScaleTimes, animationTime, cursor);
 		int p1Index = p0Index + 1;
-		float scaleFactor = GetScaleFactor(m_Scales[p0Index].timeStamp,
-			m_Scales[p1Index].timeStamp, animationTime);
-		glm::vec3 finalScale = glm::mix(m_Scales[p0Index].scale, m_Scales[p1Index].scale
+		float scaleFactor = GetScaleFactor(m_ScaleTimes[p0Index],
+			m_ScaleTimes[p1Index], animationTime);
+		glm::vec3 finalScale = glm::mix(m_Scales[p0Index], m_Scales[p1Index]
 			, scaleFactor);
-		return glm::scale(glm::mat4(1.0f), finalScale);
+		return finalScale;
+	}
+
+	glm::vec3 InterpolateQuantized(const QuantizedTrack& track, float animationTime, int& cursor) const
+	{
+		if (1 == track.Size())
+			return AnimationCodec::GetVector(track, 0);
+
+		float time = animationTime / m_TimeStep;
+		int p0Index = FindKey(track.times, time, cursor);
+		float scaleFactor = GetScaleFactor(track.times[p0Index], track.times[p0Index + 1], time);
+		glm::vec3 p0 = AnimationCodec::GetVector(track, p0Index);
+		glm::vec3 p1 = AnimationCodec::GetVector(track, p0Index + 1);
+		return glm::mix(p0, p1, scaleFactor);
+	}
+
+	glm::quat InterpolateQuantizedRotation(float animationTime, int& cursor) const
+	{
+		if (1 == m_RotationTrack.Size())
+			return AnimationCodec::UnpackRotation(&m_RotationTrack.values[0]);
+
+		float time = animationTime / m_TimeStep;
+		int p0Index = FindKey(m_RotationTrack.times, time, cursor);
+		float scaleFactor = GetScaleFactor(m_RotationTrack.times[p0Index], m_RotationTrack.times[p0Index + 1], time);
+		glm::quat r0 = AnimationCodec::UnpackRotation(&m_RotationTrack.values[p0Index * 3]);
+		glm::quat r1 = AnimationCodec::UnpackRotation(&m_RotationTrack.values[p0Index * 3 + 3]);
+		return glm::normalize(glm::slerp(r0, r1, scaleFactor));
 	}
 
-	std::vector<KeyPosition> m_Positions;
-	std::vector<KeyRotation> m_Rotations;
-	std::vector<KeyScale> m_Scales;
+	std::vector<float> m_PositionTimes;
+	std::vector<glm::vec3> m_Positions;
+	std::vector<float> m_RotationTimes;
+	std::vector<glm::quat> m_Rotations;
+	std::vector<float> m_ScaleTimes;
+	std::vector<glm::vec3> m_Scales;
 	int m_NumPositions;
 	int m_NumRotations;
 	int m_NumScalings;
+	QuantizedTrack m_PositionTrack;
+	QuantizedTrack m_RotationTrack;
+	QuantizedTrack m_ScaleTrack;
+	float m_TimeStep = 1.0f; // ticks per quantized time step
+	bool m_Compressed = false;
 
-	glm::mat4 m_LocalTransform;
 	std::string m_Name;
 	int m_ID;
 };
-
@@ -0,0 +1,771 @@
+#ifndef BOUNDING_VOLUME_HIERARCHY_H
+#define BOUNDING_VOLUME_HIERARCHY_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/entity.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <utility>
+#include <vector>
+
+// Dynamic AABB tree over world space bounding boxes, for culling, picking and proximity queries that are logarithmic
+// instead of linear in the number of objects.
+// Every object is a proxy with its exact box and a leaf whose box is the exact one grown by a margin. Objects that move
+// within their margin leave the tree untouched; Move takes an object that left it (or shrank well inside it) out and
+// inserts it again where it adds the least surface area, and Refit instead fits the boxes on the way to the root,
+// cheaper but slowly worse for queries. Build and Rebuild make a fresh tree with binned surface area heuristic (SAH) splits.
+// Queries test the leaves with the exact boxes, so their results match testing every box on its own.
+class BoundingVolumeHierarchy
+{
+public:
+    typedef uint32_t Proxy;
+    static const Proxy Invalid = ~0u;
+
+    struct RayHit
+    {
+        Proxy proxy = Invalid;
+        uint32_t userData = 0;
+        float distance = 0.0f; // in lengths of the ray direction
+    };
+
+    explicit BoundingVolumeHierarchy(float margin = 0.1f) : m_Margin(margin) {}
+
+    // replaces the tree with boxes, proxy i gets user data i
+    void Build(const std::vector<AABB>& boxes)
+    {
+        Clear();
+        m_Proxies.reserve(boxes.size());
+        for (size_t i = 0; i < boxes.size(); i++)
+            m_Proxies.push_back(ProxyData{ boxes[i].center, boxes[i].extents, Invalid, static_cast<uint32_t>(i) });
+        Rebuild();
+    }
+
+    // builds the tree again from the current proxies, after many Move or Refit calls made it worse
+    void Rebuild()
+    {
+        m_Nodes.clear();
+        m_FreeNodes.clear();
+        m_Root = Invalid;
+        std::vector<bool> isFree(m_Proxies.size(), false);
+        for (Proxy proxy : m_FreeProxies)
+            isFree[proxy] = true;
+        std::vector<Proxy> items;
+        items.reserve(m_Proxies.size());
+        for (Proxy proxy = 0; proxy < m_Proxies.size(); proxy++)
+            if (!isFree[proxy])
+                items.push_back(proxy);
+        m_Nodes.reserve(items.empty() ? 0 : 2 * items.size() - 1);
+        if (!items.empty())
+            m_Root = BuildRange(items.data(), items.size(), Invalid);
+    }
+
+    void Clear()
+    {
+        m_Nodes.clear();
+        m_FreeNodes.clear();
+        m_Proxies.clear();
+        m_FreeProxies.clear();
+        m_Root = Invalid;
+    }
+
+    Proxy Insert(const glm::vec3& center, const glm::vec3& extents, uint32_t userData)
+    {
+        Proxy proxy;
+        if (!m_FreeProxies.empty())
+        {
+            proxy = m_FreeProxies.back();
+            m_FreeProxies.pop_back();
+        }
+        else
+        {
+            proxy = static_cast<Proxy>(m_Proxies.size());
+            m_Proxies.emplace_back();
+        }
+        m_Proxies[proxy] = ProxyData{ center, extents, Invalid, userData };
+        const uint32_t leaf = CreateLeaf(proxy);
+        InsertLeaf(leaf);
+        return proxy;
+    }
+
+    void Remove(Proxy proxy)
+    {
+        if (!IsAlive(proxy))
+            return;
+        const uint32_t leaf = m_Proxies[proxy].node;
+        RemoveLeaf(leaf);
+        FreeNode(leaf);
+        m_Proxies[proxy].node = Invalid;
+        m_FreeProxies.push_back(proxy);
+    }
+
+    // Sets the exact box of proxy. If it left the leaf box, or shrank so that the leaf box is more than two margins
+    // too large on an axis, the leaf is inserted again; returns whether it was. Removed proxies are ignored.
+    bool Move(Proxy proxy, const glm::vec3& center, const glm::vec3& extents)
+    {
+        if (!IsAlive(proxy))
+            return false;
+        ProxyData& data = m_Proxies[proxy];
+        data.center = center;
+        data.extents = extents;
+        const uint32_t leaf = data.node;
+        if (Fits(m_Nodes[leaf], center - extents, center + extents))
+            return false;
+
+        RemoveLeaf(leaf);
+        SetLeafBounds(leaf);
+        InsertLeaf(leaf);
+        return true;
+    }
+
+    // Sets the exact box of proxy without changing the structure of the tree. When the leaf box no longer fits it (see
+    // Move) the leaf and its ancestors grow or shrink to fit. Returns whether any box changed.
+    bool Refit(Proxy proxy, const glm::vec3& center, const glm::vec3& extents)
+    {
+        if (!IsAlive(proxy))
+            return false;
+        ProxyData& data = m_Proxies[proxy];
+        data.center = center;
+        data.extents = extents;
+        const uint32_t leaf = data.node;
+        if (Fits(m_Nodes[leaf], center - extents, center + extents))
+            return false;
+
+        SetLeafBounds(leaf);
+        for (uint32_t node = m_Nodes[leaf].parent; node != Invalid; node = m_Nodes[node].parent)
+        {
+            const glm::vec3 min = m_Nodes[node].min, max = m_Nodes[node].max;
+            FitToChildren(node);
+            if (m_Nodes[node].min == min && m_Nodes[node].max == max)
+                break;
+        }
+        return true;
+    }
+
+    uint32_t GetUserData(Proxy proxy) const { return m_Proxies[proxy].userData; }
+
+    // Replaces visible with the user data of every proxy that intersects the frustum, with the test of
+    // AABB::isOnOrForwardPlane, in tree order. A node that lies completely in front of a plane doesn't test its
+    // subtree against that plane again, and a node in front of all six accepts its subtree without any tests.
+    void Cull(const Frustum& frustum, std::vector<uint32_t>& visible) const
+    {
+        visible.clear();
+        if (m_Root == Invalid)
+            return;
+        const Plane planes[6] = { frustum.leftFace, frustum.rightFace, frustum.topFace,
+                                  frustum.bottomFace, frustum.nearFace, frustum.farFace };
+        glm::vec3 absNormals[6];
+        for (int p = 0; p < 6; p++)
+            absNormals[p] = glm::abs(planes[p].normal);
+
+        struct Entry
+        {
+            uint32_t node;
+            uint32_t planeMask;
+        };
+        TraversalStack<Entry> stack;
+        stack.Push({ m_Root, 0x3f });
+        while (!stack.Empty())
+        {
+            const Entry entry = stack.Pop();
+            const Node& node = m_Nodes[entry.node];
+            uint32_t planeMask = entry.planeMask;
+
+            const glm::vec3 center = (node.min + node.max) * 0.5f;
+            const glm::vec3 extents = node.max - center;
+            bool outside = false;
+            for (int p = 0; p < 6 && !outside; p++)
+            {
+                if (!(planeMask & (1u << p)))
+                    continue;
+                const float distance = planes[p].getSignedDistanceToPlane(center);
+                const float radius = glm::dot(extents, absNormals[p]);
+                if (distance < -radius)
+                    outside = true;
+                else if (distance >= radius)
+                    planeMask &= ~(1u << p);
+            }
+            if (outside)
+                continue;
+
+            if (planeMask == 0)
+            {
+                AppendLeaves(entry.node, visible);
+                continue;
+            }
+            if (!node.IsLeaf())
+            {
+                stack.Push({ node.child[1], planeMask });
+                stack.Push({ node.child[0], planeMask });
+                continue;
+            }
+
+            // the exact box against the planes the leaf box straddles
+            const ProxyData& data = m_Proxies[node.child[1]];
+            bool inside = true;
+            for (int p = 0; p < 6 && inside; p++)
+                if (planeMask & (1u << p))
+                    inside = -glm::dot(data.extents, absNormals[p]) <= planes[p].getSignedDistanceToPlane(data.center);
+            if (inside)
+                visible.push_back(data.userData);
+        }
+    }
+
+    // Finds the closest proxy along the ray within maxDistance. hitDistance(userData, boxDistance) is called for the
+    // proxies whose exact box the ray hits, nearest box first, and returns the distance of the exact hit, e.g. against
+    // the triangles of the object, or a negative value for a miss. Distances are in lengths of direction.
+    bool RayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RayHit& hit,
+                 const std::function<float(uint32_t, float)>& hitDistance) const
+    {
+        hit = RayHit();
+        if (m_Root == Invalid)
+            return false;
+        const glm::vec3 inverseDirection = 1.0f / direction;
+        float closest = maxDistance;
+
+        struct Entry
+        {
+            uint32_t node;
+            float distance;
+        };
+        TraversalStack<Entry> stack;
+        float rootDistance;
+        if (IntersectRay(m_Nodes[m_Root].min, m_Nodes[m_Root].max, origin, inverseDirection, closest, rootDistance))
+            stack.Push({ m_Root, rootDistance });
+        while (!stack.Empty())
+        {
+            const Entry entry = stack.Pop();
+            // a closer hit was found since the node was pushed
+            if (entry.distance > closest)
+                continue;
+            const Node& node = m_Nodes[entry.node];
+            if (node.IsLeaf())
+            {
+                const ProxyData& data = m_Proxies[node.child[1]];
+                float boxDistance;
+                if (!IntersectRay(data.center - data.extents, data.center + data.extents, origin, inverseDirection, closest, boxDistance))
+                    continue;
+                const float distance = hitDistance ? hitDistance(data.userData, boxDistance) : boxDistance;
+                if (distance >= 0.0f && distance <= closest)
+                {
+                    closest = distance;
+                    hit.proxy = node.child[1];
+                    hit.userData = data.userData;
+                    hit.distance = distance;
+                }
+                continue;
+            }
+
+            // the nearer child goes on top of the stack, so it is searched first and shortens the ray for the other
+            float distances[2];
+            bool hits[2];
+            for (int c = 0; c < 2; c++)
+            {
+                const Node& child = m_Nodes[node.child[c]];
+                hits[c] = IntersectRay(child.min, child.max, origin, inverseDirection, closest, distances[c]);
+            }
+            const int nearer = hits[0] && (!hits[1] || distances[0] <= distances[1]) ? 0 : 1;
+            if (hits[1 - nearer])
+                stack.Push({ node.child[1 - nearer], distances[1 - nearer] });
+            if (hits[nearer])
+                stack.Push({ node.child[nearer], distances[nearer] });
+        }
+        return hit.proxy != Invalid;
+    }
+
+    // the closest exact box along the ray
+    bool RayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RayHit& hit) const
+    {
+        return RayCast(origin, direction, maxDistance, hit, nullptr);
+    }
+
+    // appends the user data of every proxy whose exact box overlaps [min, max]
+    void Query(const glm::vec3& min, const glm::vec3& max, std::vector<uint32_t>& result) const
+    {
+        if (m_Root == Invalid)
+            return;
+        TraversalStack<uint32_t> stack;
+        stack.Push(m_Root);
+        while (!stack.Empty())
+        {
+            const Node& node = m_Nodes[stack.Pop()];
+            if (!Overlaps(node.min, node.max, min, max))
+                continue;
+            if (!node.IsLeaf())
+            {
+                stack.Push(node.child[1]);
+                stack.Push(node.child[0]);
+                continue;
+            }
+            const ProxyData& data = m_Proxies[node.child[1]];
+            if (Overlaps(data.center - data.extents, data.center + data.extents, min, max))
+                result.push_back(data.userData);
+        }
+    }
+
+    size_t Size() const { return m_Proxies.size() - m_FreeProxies.size(); }
+
+    // the longest path from the root to a leaf, 0 when empty
+    int GetHeight() const
+    {
+        if (m_Root == Invalid)
+            return 0;
+        struct Entry
+        {
+            uint32_t node;
+            int depth;
+        };
+        TraversalStack<Entry> stack;
+        stack.Push({ m_Root, 1 });
+        int height = 0;
+        while (!stack.Empty())
+        {
+            const Entry entry = stack.Pop();
+            height = std::max(height, entry.depth);
+            const Node& node = m_Nodes[entry.node];
+            if (!node.IsLeaf())
+            {
+                stack.Push({ node.child[0], entry.depth + 1 });
+                stack.Push({ node.child[1], entry.depth + 1 });
+            }
+        }
+        return height;
+    }
+
+    // the summed surface area of the inner nodes relative to the root's, the expected number of nodes a random ray
+    // visits, lower is better
+    float GetCost() const
+    {
+        if (m_Root == Invalid)
+            return 0.0f;
+        std::vector<bool> isFree(m_Nodes.size(), false);
+        for (uint32_t node : m_FreeNodes)
+            isFree[node] = true;
+        double area = 0.0;
+        for (uint32_t node = 0; node < m_Nodes.size(); node++)
+            if (!isFree[node] && !m_Nodes[node].IsLeaf())
+                area += Area(m_Nodes[node].min, m_Nodes[node].max);
+        return static_cast<float>(area / std::max(Area(m_Nodes[m_Root].min, m_Nodes[m_Root].max), std::numeric_limits<float>::min()));
+    }
+
+    size_t GetMemoryUsage() const
+    {
+        return m_Nodes.capacity() * sizeof(Node) + m_Proxies.capacity() * sizeof(ProxyData) +
+               (m_FreeNodes.capacity() + m_FreeProxies.capacity()) * sizeof(uint32_t) +
+               m_InsertQueue.capacity() * sizeof(std::pair<float, uint32_t>);
+    }
+
+private:
+    struct Node
+    {
+        glm::vec3 min, max;
+        uint32_t parent;
+        uint32_t child[2]; // Invalid and the proxy for leaves
+
+        bool IsLeaf() const { return child[0] == Invalid; }
+    };
+
+    struct ProxyData
+    {
+        glm::vec3 center, extents; // the exact box
+        uint32_t node;             // the leaf, Invalid while the proxy is free
+        uint32_t userData;
+    };
+
+    // a stack on the stack for queries, it only allocates for unusually deep trees
+    template<typename T>
+    class TraversalStack
+    {
+    public:
+        void Push(const T& value)
+        {
+            if (m_Size < LocalSize)
+                m_Local[m_Size] = value;
+            else
+                m_Overflow.push_back(value);
+            m_Size++;
+        }
+
+        T Pop()
+        {
+            m_Size--;
+            if (m_Size < LocalSize)
+                return m_Local[m_Size];
+            T value = m_Overflow.back();
+            m_Overflow.pop_back();
+            return value;
+        }
+
+        bool Empty() const { return m_Size == 0; }
+
+    private:
+        static const size_t LocalSize = 128;
+        T m_Local[LocalSize];
+        std::vector<T> m_Overflow;
+        size_t m_Size = 0;
+    };
+
+    std::vector<Node> m_Nodes;
+    std::vector<uint32_t> m_FreeNodes;
+    std::vector<ProxyData> m_Proxies;
+    std::vector<Proxy> m_FreeProxies;
+    std::vector<std::pair<float, uint32_t>> m_InsertQueue;
+    uint32_t m_Root = Invalid;
+    float m_Margin;
+
+    // half the surface area, the factor doesn't matter for comparing costs
+    static float Area(const glm::vec3& min, const glm::vec3& max)
+    {
+        const glm::vec3 size = max - min;
+        return size.x * size.y + size.y * size.z + size.z * size.x;
+    }
+
+    static bool Contains(const Node& node, const glm::vec3& min, const glm::vec3& max)
+    {
+        return glm::all(glm::lessThanEqual(node.min, min)) && glm::all(glm::lessThanEqual(max, node.max));
+    }
+
+    // whether leaf can keep its box for the exact box [min, max]: it still contains it and isn't more than two
+    // margins larger on any axis than the leaf box SetLeafBounds would give it now
+    bool Fits(const Node& leaf, const glm::vec3& min, const glm::vec3& max) const
+    {
+        return Contains(leaf, min, max) && glm::all(glm::lessThanEqual(leaf.max - leaf.min, max - min + glm::vec3(4.0f * m_Margin)));
+    }
+
+    bool IsAlive(Proxy proxy) const
+    {
+        return proxy < m_Proxies.size() && m_Proxies[proxy].node != Invalid;
+    }
+
+    static bool Overlaps(const glm::vec3& minA, const glm::vec3& maxA, const glm::vec3& minB, const glm::vec3& maxB)
+    {
+        return glm::all(glm::lessThanEqual(minA, maxB)) && glm::all(glm::lessThanEqual(minB, maxA));
+    }
+
+    // slab test, distance receives where the ray enters the box or 0 when it starts inside
+    static bool IntersectRay(const glm::vec3& min, const glm::vec3& max, const glm::vec3& origin, const glm::vec3& inverseDirection,
+                             float maxDistance, float& distance)
+    {
+        const glm::vec3 t1 = (min - origin) * inverseDirection;
+        const glm::vec3 t2 = (max - origin) * inverseDirection;
+        const glm::vec3 entries = glm::min(t1, t2), exits = glm::max(t1, t2);
+        const float enter = std::max(std::max(entries.x, entries.y), std::max(entries.z, 0.0f));
+        const float exit = std::min(std::min(exits.x, exits.y), std::min(exits.z, maxDistance));
+        distance = enter;
+        return enter <= exit;
+    }
+
+    uint32_t AllocateNode()
+    {
+        if (!m_FreeNodes.empty())
+        {
+            const uint32_t node = m_FreeNodes.back();
+            m_FreeNodes.pop_back();
+            return node;
+        }
+        m_Nodes.emplace_back();
+        return static_cast<uint32_t>(m_Nodes.size() - 1);
+    }
+
+    void FreeNode(uint32_t node)
+    {
+        m_FreeNodes.push_back(node);
+    }
+
+    uint32_t CreateLeaf(Proxy proxy)
+    {
+        const uint32_t leaf = AllocateNode();
+        m_Nodes[leaf].parent = Invalid;
+        m_Nodes[leaf].child[0] = Invalid;
+        m_Nodes[leaf].child[1] = proxy;
+        m_Proxies[proxy].node = leaf;
+        SetLeafBounds(leaf);
+        return leaf;
+    }
+
+    void SetLeafBounds(uint32_t leaf)
+    {
+        const ProxyData& data = m_Proxies[m_Nodes[leaf].child[1]];
+        m_Nodes[leaf].min = data.center - data.extents - glm::vec3(m_Margin);
+        m_Nodes[leaf].max = data.center + data.extents + glm::vec3(m_Margin);
+    }
+
+    void FitToChildren(uint32_t node)
+    {
+        const Node& a = m_Nodes[m_Nodes[node].child[0]];
+        const Node& b = m_Nodes[m_Nodes[node].child[1]];
+        m_Nodes[node].min = glm::min(a.min, b.min);
+        m_Nodes[node].max = glm::max(a.max, b.max);
+    }
+
+    // Top down binned SAH build of the proxies in items, nodes are allocated depth first so a subtree is mostly one
+    // contiguous range of nodes
+    uint32_t BuildRange(Proxy* items, size_t count, uint32_t parent)
+    {
+        if (count == 1)
+        {
+            const uint32_t leaf = CreateLeaf(items[0]);
+            m_Nodes[leaf].parent = parent;
+            return leaf;
+        }
+
+        const uint32_t node = AllocateNode();
+        m_Nodes[node].parent = parent;
+
+        glm::vec3 centerMin(std::numeric_limits<float>::max()), centerMax(-std::numeric_limits<float>::max());
+        for (size_t i = 0; i < count; i++)
+        {
+            centerMin = glm::min(centerMin, m_Proxies[items[i]].center);
+            centerMax = glm::max(centerMax, m_Proxies[items[i]].center);
+        }
+
+        const int BinCount = 16;
+        int bestAxis = -1, bestSplit = 0;
+        float bestCost = std::numeric_limits<float>::max();
+        for (int axis = 0; axis < 3; axis++)
+        {
+            const float extent = centerMax[axis] - centerMin[axis];
+            if (!(extent > 0.0f))
+                continue;
+            const float scale = BinCount / extent;
+            glm::vec3 binMin[BinCount], binMax[BinCount];
+            size_t binCounts[BinCount] = {};
+            for (int b = 0; b < BinCount; b++)
+            {
+                binMin[b] = glm::vec3(std::numeric_limits<float>::max());
+                binMax[b] = glm::vec3(-std::numeric_limits<float>::max());
+            }
+            for (size_t i = 0; i < count; i++)
+            {
+                const ProxyData& data = m_Proxies[items[i]];
+                const int b = std::min(BinCount - 1, static_cast<int>((data.center[axis] - centerMin[axis]) * scale));
+                binCounts[b]++;
+                binMin[b] = glm::min(binMin[b], data.center - data.extents);
+                binMax[b] = glm::max(binMax[b], data.center + data.extents);
+            }
+
+            // sweep from the right for the areas of every right side, then from the left
+            float rightAreas[BinCount];
+            size_t rightCounts[BinCount];
+            glm::vec3 sweepMin(std::numeric_limits<float>::max()), sweepMax(-std::numeric_limits<float>::max());
+            size_t sweepCount = 0;
+            for (int b = BinCount - 1; b > 0; b--)
+            {
+                sweepMin = glm::min(sweepMin, binMin[b]);
+                sweepMax = glm::max(sweepMax, binMax[b]);
+                sweepCount += binCounts[b];
+                rightAreas[b] = sweepCount ? Area(sweepMin, sweepMax) : 0.0f;
+                rightCounts[b] = sweepCount;
+            }
+            sweepMin = glm::vec3(std::numeric_limits<float>::max());
+            sweepMax = glm::vec3(-std::numeric_limits<float>::max());
+            sweepCount = 0;
+            for (int split = 1; split < BinCount; split++)
+            {
+                sweepMin = glm::min(sweepMin, binMin[split - 1]);
+                sweepMax = glm::max(sweepMax, binMax[split - 1]);
+                sweepCount += binCounts[split - 1];
+                if (sweepCount == 0 || rightCounts[split] == 0)
+                    continue;
+                const float cost = Area(sweepMin, sweepMax) * sweepCount + rightAreas[split] * rightCounts[split];
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = split;
+                }
+            }
+        }
+
+        size_t middle = count / 2;
+        if (bestAxis >= 0)
+        {
+            const float scale = BinCount / (centerMax[bestAxis] - centerMin[bestAxis]);
+            const float axisMin = centerMin[bestAxis];
+            Proxy* partition = std::partition(items, items + count, [&](Proxy proxy)
+            {
+                return std::min(BinCount - 1, static_cast<int>((m_Proxies[proxy].center[bestAxis] - axisMin) * scale)) < bestSplit;
+            });
+            middle = static_cast<size_t>(partition - items);
+        }
+
+        // the children may reallocate m_Nodes, so no reference to node is held across them
+        const uint32_t first = BuildRange(items, middle, node);
+        const uint32_t second = BuildRange(items + middle, count - middle, node);
+        m_Nodes[node].child[0] = first;
+        m_Nodes[node].child[1] = second;
+        FitToChildren(node);
+        return node;
+    }
+
+    // Puts leaf next to the node where the tree's surface area grows least. A branch and bound search from the root:
+    // the area every ancestor has to grow by is a lower bound for the cost below it, so whole subtrees are skipped.
+    void InsertLeaf(uint32_t leaf)
+    {
+        if (m_Root == Invalid)
+        {
+            m_Root = leaf;
+            m_Nodes[leaf].parent = Invalid;
+            return;
+        }
+
+        const glm::vec3 leafMin = m_Nodes[leaf].min, leafMax = m_Nodes[leaf].max;
+        const float leafArea = Area(leafMin, leafMax);
+        uint32_t best = m_Root;
+        float bestCost = Area(glm::min(m_Nodes[m_Root].min, leafMin), glm::max(m_Nodes[m_Root].max, leafMax));
+
+        // min heap of (area the ancestors grow by, node)
+        auto greater = [](const std::pair<float, uint32_t>& a, const std::pair<float, uint32_t>& b) { return a.first > b.first; };
+        m_InsertQueue.clear();
+        m_InsertQueue.push_back({ 0.0f, m_Root });
+        while (!m_InsertQueue.empty())
+        {
+            std::pop_heap(m_InsertQueue.begin(), m_InsertQueue.end(), greater);
+            const float inherited = m_InsertQueue.back().first;
+            const uint32_t index = m_InsertQueue.back().second;
+            m_InsertQueue.pop_back();
+            if (inherited + leafArea >= bestCost)
+                break;
+
+            const Node& node = m_Nodes[index];
+            const float unionArea = Area(glm::min(node.min, leafMin), glm::max(node.max, leafMax));
+            const float cost = unionArea + inherited;
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                best = index;
+            }
+            const float childInherited = inherited + unionArea - Area(node.min, node.max);
+            if (!node.IsLeaf() && childInherited + leafArea < bestCost)
+                for (uint32_t child : node.child)
+                {
+                    m_InsertQueue.push_back({ childInherited, child });
+                    std::push_heap(m_InsertQueue.begin(), m_InsertQueue.end(), greater);
+                }
+        }
+
+        const uint32_t oldParent = m_Nodes[best].parent;
+        const uint32_t parent = AllocateNode();
+        m_Nodes[parent].parent = oldParent;
+        m_Nodes[parent].child[0] = best;
+        m_Nodes[parent].child[1] = leaf;
+        m_Nodes[best].parent = parent;
+        m_Nodes[leaf].parent = parent;
+        if (oldParent == Invalid)
+            m_Root = parent;
+        else
+            m_Nodes[oldParent].child[m_Nodes[oldParent].child[0] == best ? 0 : 1] = parent;
+
+        RefitAncestors(parent);
+    }
+
+    void RemoveLeaf(uint32_t leaf)
+    {
+        if (leaf == m_Root)
+        {
+            m_Root = Invalid;
+            return;
+        }
+        const uint32_t parent = m_Nodes[leaf].parent;
+        const uint32_t grandParent = m_Nodes[parent].parent;
+        const uint32_t sibling = m_Nodes[parent].child[m_Nodes[parent].child[0] == leaf ? 1 : 0];
+        FreeNode(parent);
+        m_Nodes[sibling].parent = grandParent;
+        m_Nodes[leaf].parent = Invalid;
+        if (grandParent == Invalid)
+        {
+            m_Root = sibling;
+            return;
+        }
+        m_Nodes[grandParent].child[m_Nodes[grandParent].child[0] == parent ? 0 : 1] = sibling;
+        RefitAncestors(grandParent);
+    }
+
+    // refits node and every ancestor, rotating each where that shrinks a child
+    void RefitAncestors(uint32_t node)
+    {
+        for (; node != Invalid; node = m_Nodes[node].parent)
+        {
+            FitToChildren(node);
+            Rotate(node);
+        }
+    }
+
+    // A tree rotation (Kopta et al.): swaps a child of node with a grandchild on the other side when that shrinks the
+    // surface area of the inner child. node's own box stays the same.
+    void Rotate(uint32_t node)
+    {
+        int bestChild = -1, bestGrandChild = 0;
+        float bestDelta = 0.0f;
+        for (int c = 0; c < 2; c++)
+        {
+            const uint32_t inner = m_Nodes[node].child[1 - c];
+            const Node& moved = m_Nodes[m_Nodes[node].child[c]];
+            const Node& innerNode = m_Nodes[inner];
+            if (innerNode.IsLeaf())
+                continue;
+            // the child moves into inner in place of grandchild g, which takes its place under node
+            for (int g = 0; g < 2; g++)
+            {
+                const Node& kept = m_Nodes[innerNode.child[1 - g]];
+                const float delta = Area(glm::min(moved.min, kept.min), glm::max(moved.max, kept.max)) - Area(innerNode.min, innerNode.max);
+                if (delta < bestDelta)
+                {
+                    bestDelta = delta;
+                    bestChild = c;
+                    bestGrandChild = g;
+                }
+            }
+        }
+        if (bestChild < 0)
+            return;
+
+        const uint32_t moved = m_Nodes[node].child[bestChild];
+        const uint32_t inner = m_Nodes[node].child[1 - bestChild];
+        const uint32_t grandChild = m_Nodes[inner].child[bestGrandChild];
+        m_Nodes[node].child[bestChild] = grandChild;
+        m_Nodes[grandChild].parent = node;
+        m_Nodes[inner].child[bestGrandChild] = moved;
+        m_Nodes[moved].parent = inner;
+        FitToChildren(inner);
+    }
+
+    void AppendLeaves(uint32_t root, std::vector<uint32_t>& result) const
+    {
+        TraversalStack<uint32_t> stack;
+        stack.Push(root);
+        while (!stack.Empty())
+        {
+            const Node& node = m_Nodes[stack.Pop()];
+            if (node.IsLeaf())
+            {
+                result.push_back(m_Proxies[node.child[1]].userData);
+                continue;
+            }
+            stack.Push(node.child[1]);
+            stack.Push(node.child[0]);
+        }
+    }
+};
+
+// builds bvh over the world space boxes of root and every entity below it, user data i is entities[i]
+inline void BuildEntityBvh(Entity& root, BoundingVolumeHierarchy& bvh, std::vector<Entity*>& entities)
+{
+    std::vector<AABB> boxes;
+    std::function<void(Entity&)> collect = [&](Entity& entity)
+    {
+        boxes.push_back(entity.getGlobalAABB());
+        entities.push_back(&entity);
+        for (auto&& child : entity.children)
+            collect(*child);
+    };
+    entities.clear();
+    collect(root);
+    bvh.Build(boxes);
+}
+
+#endif
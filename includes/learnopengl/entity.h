@@ -5,6 +5,12 @@
 #include <list> //std::list
 #include <array> //std::array
 #include <memory> //std::unique_ptr
+#include <unordered_map> //std::unordered_map
+#include <utility> //std::pair
+#include <vector> //std::vector
+
+#include <learnopengl/instance_buffer.h>
+#include <learnopengl/transform_hierarchy.h>
 
 class Transform
 {
@@ -348,16 +354,11 @@ AABB generateAABB(const Model& model)
 	glm::vec3 maxAABB = glm::vec3(std::numeric_limits<float>::min());
 	for (auto&& mesh : model.meshes)
 	{
-		for (auto&& vertex : mesh.vertices)
-		{
-			minAABB.x = std::min(minAABB.x, vertex.Position.x);
-			minAABB.y = std::min(minAABB.y, vertex.Position.y);
-			minAABB.z = std::min(minAABB.z, vertex.Position.z);
-
-			maxAABB.x = std::max(maxAABB.x, vertex.Position.x);
-			maxAABB.y = std::max(maxAABB.y, vertex.Position.y);
-			maxAABB.z = std::max(maxAABB.z, vertex.Position.z);
-		}
+		// the mesh bounds are kept even when its vertices aren't
+		if (mesh.vertexCount == 0)
+			continue;
+		minAABB = glm::min(minAABB, mesh.boundsMin);
+		maxAABB = glm::max(maxAABB, mesh.boundsMax);
 	}
 	return AABB(minAABB, maxAABB);
 }
@@ -368,16 +369,10 @@ Sphere generateSphereBV(const Model& model)
 	glm::vec3 maxAABB = glm::vec3(std::numeric_limits<float>::min());
 	for (auto&& mesh : model.meshes)
 	{
-		for (auto&& vertex : mesh.vertices)
-		{
-			minAABB.x = std::min(minAABB.x, vertex.Position.x);
-			minAABB.y = std::min(minAABB.y, vertex.Position.y);
-			minAABB.z = std::min(minAABB.z, vertex.Position.z);
-
-			maxAABB.x = std::max(maxAABB.x, vertex.Position.x);
-			maxAABB.y = std::max(maxAABB.y, vertex.Position.y);
-			maxAABB.z = std::max(maxAABB.z, vertex.Position.z);
-		}
+		if (mesh.vertexCount == 0)
+			continue;
+		minAABB = glm::min(minAABB, mesh.boundsMin);
+		maxAABB = glm::max(maxAABB, mesh.boundsMax);
 	}
 
 	return Sphere((maxAABB + minAABB) * 0.5f, glm::length(minAABB - maxAABB));
@@ -404,6 +399,12 @@ public:
 		//boundingVolume = std::make_unique<Sphere>(generateSphereBV(model));
 	}
 
+	//Replace the model space bounds, e.g. every frame with the skinned bounds of an animated model (see CpuSkinner)
+	void setLocalBounds(const glm::vec3& min, const glm::vec3& max)
+	{
+		*boundingVolume = AABB(min, max);
+	}
+
 	AABB getGlobalAABB()
 	{
 		//Get global scale thanks to our transform
@@ -429,6 +430,26 @@ public:
 		return AABB(globalCenter, newIi, newIj, newIk);
 	}
 
+	//Copy this entity and its children into a flat TransformHierarchy, the Euler angles become quaternions.
+	//Returns the handle of this entity's node, every entity is appended to mapping with its handle if given.
+	TransformHierarchy::Handle appendToHierarchy(TransformHierarchy& hierarchy, TransformHierarchy::Handle parentHandle = TransformHierarchy::Invalid,
+		std::vector<std::pair<Entity*, TransformHierarchy::Handle>>* mapping = nullptr)
+	{
+		const glm::vec3 euler = glm::radians(transform.getLocalRotation());
+		// Y * X * Z, as in Transform::getLocalModelMatrix
+		const glm::quat rotation = glm::angleAxis(euler.y, glm::vec3(0.0f, 1.0f, 0.0f)) *
+			glm::angleAxis(euler.x, glm::vec3(1.0f, 0.0f, 0.0f)) * glm::angleAxis(euler.z, glm::vec3(0.0f, 0.0f, 1.0f));
+		const TransformHierarchy::Handle handle = hierarchy.Create(parentHandle, transform.getLocalPosition(), rotation, transform.getLocalScale());
+		if (mapping)
+			mapping->push_back({ this, handle });
+
+		for (auto&& child : children)
+		{
+			child->appendToHierarchy(hierarchy, handle, mapping);
+		}
+		return handle;
+	}
+
 	//Add child. Argument input is argument of any constructor that you create. By default you can use the default constructor and don't put argument input.
 	template<typename... TArgs>
 	void addChild(TArgs&... args)
@@ -481,5 +502,22 @@ public:
 			child->drawSelfAndChild(frustum, ourShader, display, total);
 		}
 	}
+
+	//Instead of drawing, add the model matrix of every visible entity to the instance list of its model.
+	//Draw each list afterwards with Model::DrawInstanced, one draw per mesh instead of one per entity.
+	void collectSelfAndChild(const Frustum& frustum, std::unordered_map<Model*, InstanceBufferBuilder>& instances, unsigned int& display, unsigned int& total)
+	{
+		if (boundingVolume->isOnFrustum(frustum, transform))
+		{
+			instances[pModel].Add(transform.getModelMatrix());
+			display++;
+		}
+		total++;
+
+		for (auto&& child : children)
+		{
+			child->collectSelfAndChild(frustum, instances, display, total);
+		}
+	}
 };
 #endif
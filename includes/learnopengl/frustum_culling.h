@@ -0,0 +1,267 @@
+#ifndef FRUSTUM_CULLING_H
+#define FRUSTUM_CULLING_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/entity.h>
+#include <learnopengl/job_system.h>
+#include <learnopengl/simd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Frustum culling of many world space bounding volumes at once. The bounds are stored as structure of arrays, so the
+// culler tests SIMD_LANES of them against a plane with a handful of instructions and writes the indices of the
+// visible ones to a compact list. The tests are the ones of AABB::isOnOrForwardPlane and Sphere::isOnOrForwardPlane
+// against the same six Frustum planes, so the lists match calling isOnFrustum on every volume.
+
+// world space axis aligned boxes, as center and half extents
+class PackedAABBs
+{
+public:
+    void Add(const glm::vec3& center, const glm::vec3& extents)
+    {
+        m_CenterX.push_back(center.x);
+        m_CenterY.push_back(center.y);
+        m_CenterZ.push_back(center.z);
+        m_ExtentX.push_back(extents.x);
+        m_ExtentY.push_back(extents.y);
+        m_ExtentZ.push_back(extents.z);
+    }
+
+    void Add(const AABB& box)
+    {
+        Add(box.center, box.extents);
+    }
+
+    // the box around a model space AABB moved by model, as AABB::isOnFrustum(frustum, transform) computes it
+    void AddTransformed(const AABB& box, const glm::mat4& model)
+    {
+        const glm::vec3 center = glm::vec3(model * glm::vec4(box.center, 1.0f));
+        glm::vec3 extents;
+        for (int i = 0; i < 3; i++)
+            extents[i] = std::abs(model[0][i] * box.extents.x) + std::abs(model[1][i] * box.extents.y) +
+                         std::abs(model[2][i] * box.extents.z);
+        Add(center, extents);
+    }
+
+    // replaces box index, e.g. when its object moved
+    void Set(size_t index, const glm::vec3& center, const glm::vec3& extents)
+    {
+        m_CenterX[index] = center.x;
+        m_CenterY[index] = center.y;
+        m_CenterZ[index] = center.z;
+        m_ExtentX[index] = extents.x;
+        m_ExtentY[index] = extents.y;
+        m_ExtentZ[index] = extents.z;
+    }
+
+    void Reserve(size_t count)
+    {
+        for (std::vector<float>* stream : { &m_CenterX, &m_CenterY, &m_CenterZ, &m_ExtentX, &m_ExtentY, &m_ExtentZ })
+            stream->reserve(count);
+    }
+
+    void Clear()
+    {
+        for (std::vector<float>* stream : { &m_CenterX, &m_CenterY, &m_CenterZ, &m_ExtentX, &m_ExtentY, &m_ExtentZ })
+            stream->clear();
+    }
+
+    size_t Size() const { return m_CenterX.size(); }
+
+    glm::vec3 GetCenter(size_t index) const { return glm::vec3(m_CenterX[index], m_CenterY[index], m_CenterZ[index]); }
+    glm::vec3 GetExtents(size_t index) const { return glm::vec3(m_ExtentX[index], m_ExtentY[index], m_ExtentZ[index]); }
+
+private:
+    friend class FrustumCuller;
+
+    std::vector<float> m_CenterX, m_CenterY, m_CenterZ;
+    std::vector<float> m_ExtentX, m_ExtentY, m_ExtentZ;
+};
+
+// world space spheres
+class PackedSpheres
+{
+public:
+    void Add(const glm::vec3& center, float radius)
+    {
+        m_CenterX.push_back(center.x);
+        m_CenterY.push_back(center.y);
+        m_CenterZ.push_back(center.z);
+        m_Radius.push_back(radius);
+    }
+
+    void Add(const Sphere& sphere)
+    {
+        Add(sphere.center, sphere.radius);
+    }
+
+    void Set(size_t index, const glm::vec3& center, float radius)
+    {
+        m_CenterX[index] = center.x;
+        m_CenterY[index] = center.y;
+        m_CenterZ[index] = center.z;
+        m_Radius[index] = radius;
+    }
+
+    void Reserve(size_t count)
+    {
+        for (std::vector<float>* stream : { &m_CenterX, &m_CenterY, &m_CenterZ, &m_Radius })
+            stream->reserve(count);
+    }
+
+    void Clear()
+    {
+        for (std::vector<float>* stream : { &m_CenterX, &m_CenterY, &m_CenterZ, &m_Radius })
+            stream->clear();
+    }
+
+    size_t Size() const { return m_CenterX.size(); }
+
+private:
+    friend class FrustumCuller;
+
+    std::vector<float> m_CenterX, m_CenterY, m_CenterZ;
+    std::vector<float> m_Radius;
+};
+
+class FrustumCuller
+{
+public:
+    explicit FrustumCuller(const Frustum& frustum)
+    {
+        // the order isOnFrustum tests them in
+        const Plane* planes[6] = { &frustum.leftFace, &frustum.rightFace, &frustum.topFace,
+                                   &frustum.bottomFace, &frustum.nearFace, &frustum.farFace };
+        for (int p = 0; p < 6; p++)
+        {
+            m_Planes[p] = *planes[p];
+            m_AbsNormals[p] = glm::abs(planes[p]->normal);
+        }
+    }
+
+    // Replaces visible with the indices of the boxes that intersect the frustum, in increasing order. With jobs the
+    // boxes are split into ranges of grain, every range writes its indices in place and the ranges are packed after.
+    size_t Cull(const PackedAABBs& boxes, std::vector<uint32_t>& visible, JobSystem* jobs = nullptr, size_t grain = 16384) const
+    {
+        return Run(boxes.Size(), visible, jobs, grain, [&](size_t begin, size_t end, uint32_t* out)
+        {
+            size_t i = begin;
+            size_t count = 0;
+            for (; i + SimdFloat::Width <= end; i += SimdFloat::Width)
+                count += CullBoxes<SimdFloat>(boxes, i, out + count);
+            for (; i < end; i++)
+                count += CullBoxes<SimdFloat1>(boxes, i, out + count);
+            return count;
+        });
+    }
+
+    size_t Cull(const PackedSpheres& spheres, std::vector<uint32_t>& visible, JobSystem* jobs = nullptr, size_t grain = 16384) const
+    {
+        return Run(spheres.Size(), visible, jobs, grain, [&](size_t begin, size_t end, uint32_t* out)
+        {
+            size_t i = begin;
+            size_t count = 0;
+            for (; i + SimdFloat::Width <= end; i += SimdFloat::Width)
+                count += CullSpheres<SimdFloat>(spheres, i, out + count);
+            for (; i < end; i++)
+                count += CullSpheres<SimdFloat1>(spheres, i, out + count);
+            return count;
+        });
+    }
+
+private:
+    Plane m_Planes[6];
+    glm::vec3 m_AbsNormals[6];
+
+    template<typename Function>
+    static size_t Run(size_t count, std::vector<uint32_t>& visible, JobSystem* jobs, size_t grain, const Function& cullRange)
+    {
+        visible.resize(count);
+        if (!jobs || count <= grain)
+        {
+            visible.resize(cullRange(0, count, visible.data()));
+            return visible.size();
+        }
+
+        // whole batches per range, so only the last range has a scalar remainder
+        grain = std::max<size_t>(grain / SimdFloat::Width * SimdFloat::Width, SimdFloat::Width);
+        std::vector<size_t> rangeCounts((count + grain - 1) / grain);
+        jobs->ParallelFor(count, grain, [&](size_t begin, size_t end)
+        {
+            rangeCounts[begin / grain] = cullRange(begin, end, visible.data() + begin);
+        });
+
+        size_t total = rangeCounts[0];
+        for (size_t r = 1; r < rangeCounts.size(); r++)
+        {
+            const uint32_t* range = visible.data() + r * grain;
+            std::copy(range, range + rangeCounts[r], visible.data() + total);
+            total += rangeCounts[r];
+        }
+        visible.resize(total);
+        return total;
+    }
+
+    // appends the visible indices among the V::Width boxes from first on to out, returns how many
+    template<typename V>
+    size_t CullBoxes(const PackedAABBs& boxes, size_t first, uint32_t* out) const
+    {
+        const V cx = V::Load(&boxes.m_CenterX[first]), cy = V::Load(&boxes.m_CenterY[first]), cz = V::Load(&boxes.m_CenterZ[first]);
+        const V ex = V::Load(&boxes.m_ExtentX[first]), ey = V::Load(&boxes.m_ExtentY[first]), ez = V::Load(&boxes.m_ExtentZ[first]);
+        int mask = (1 << V::Width) - 1;
+        for (int p = 0; p < 6; p++)
+        {
+            const Plane& plane = m_Planes[p];
+            const V distance = V::Set(plane.normal.x) * cx + V::Set(plane.normal.y) * cy + V::Set(plane.normal.z) * cz - V::Set(plane.distance);
+            // the projection interval radius, see AABB::isOnOrForwardPlane
+            const V radius = ex * V::Set(m_AbsNormals[p].x) + ey * V::Set(m_AbsNormals[p].y) + ez * V::Set(m_AbsNormals[p].z);
+            mask &= V::GreaterEqualMask(distance, V::Set(0.0f) - radius);
+        }
+        return Compact(mask, V::Width, first, out);
+    }
+
+    template<typename V>
+    size_t CullSpheres(const PackedSpheres& spheres, size_t first, uint32_t* out) const
+    {
+        const V cx = V::Load(&spheres.m_CenterX[first]), cy = V::Load(&spheres.m_CenterY[first]), cz = V::Load(&spheres.m_CenterZ[first]);
+        const V negativeRadius = V::Set(0.0f) - V::Load(&spheres.m_Radius[first]);
+        int mask = (1 << V::Width) - 1;
+        for (int p = 0; p < 6; p++)
+        {
+            const Plane& plane = m_Planes[p];
+            const V distance = V::Set(plane.normal.x) * cx + V::Set(plane.normal.y) * cy + V::Set(plane.normal.z) * cz - V::Set(plane.distance);
+            mask &= V::GreaterMask(distance, negativeRadius);
+        }
+        return Compact(mask, V::Width, first, out);
+    }
+
+    // writes every index unconditionally and only advances past the visible ones, no branch per object
+    static size_t Compact(int mask, int width, size_t first, uint32_t* out)
+    {
+        if (mask == 0)
+            return 0;
+        size_t count = 0;
+        for (int lane = 0; lane < width; lane++)
+        {
+            out[count] = (uint32_t)(first + lane);
+            count += (mask >> lane) & 1;
+        }
+        return count;
+    }
+};
+
+// appends the world space box of root and every entity below it, entities[i] receives the entity of box i
+inline void PackEntityBounds(Entity& root, PackedAABBs& boxes, std::vector<Entity*>& entities)
+{
+    const AABB box = root.getGlobalAABB();
+    boxes.Add(box.center, box.extents);
+    entities.push_back(&root);
+    for (auto&& child : root.children)
+        PackEntityBounds(*child, boxes, entities);
+}
+
+#endif
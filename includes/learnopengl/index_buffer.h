@@ -0,0 +1,189 @@
+#ifndef INDEX_BUFFER_H
+#define INDEX_BUFFER_H
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 16-bit index buffers. A triangle list is cut into consecutive ranges whose vertices all lie within 65536 of
+// each other, each range stores its indices relative to its own base vertex and is drawn with
+// glDrawElementsBaseVertex. Meshes with at most 65536 vertices end up as a single range with base vertex 0.
+// A triangle whose own vertices lie further apart can't be expressed that way; such meshes keep 32-bit indices.
+
+#define INDEX_BUFFER_MAX_RANGE_VERTICES 65536u
+
+struct IndexRange
+{
+    unsigned int firstIndex = 0; // offset into the index buffer, in indices
+    unsigned int indexCount = 0;
+    unsigned int baseVertex = 0; // added to every index of the range by the GPU
+};
+
+// a triangle list that doesn't have to live in a std::vector, e.g. one in a memory mapped file
+struct IndexList
+{
+    const unsigned int* data = nullptr;
+    size_t count = 0;
+};
+
+struct SplitIndexBuffer
+{
+    GLenum                  type = GL_UNSIGNED_SHORT;
+    std::vector<uint16_t>   indices;
+    std::vector<uint32_t>   wideIndices; // only used when type is GL_UNSIGNED_INT
+    std::vector<IndexRange> ranges;
+
+    size_t Size() const { return indices.size() * sizeof(uint16_t) + wideIndices.size() * sizeof(uint32_t); }
+    const void* Data() const { return type == GL_UNSIGNED_SHORT ? (const void*)indices.data() : (const void*)wideIndices.data(); }
+
+    // splits a triangle list into 16-bit ranges, trailing indices that don't form a triangle are dropped
+    static SplitIndexBuffer FromTriangles(const unsigned int* source, size_t indexCount)
+    {
+        SplitIndexBuffer buffer;
+        indexCount -= indexCount % 3;
+        if (indexCount == 0)
+            return buffer;
+        buffer.indices.resize(indexCount);
+
+        size_t rangeBegin = 0;
+        unsigned int rangeMin = ~0u, rangeMax = 0;
+        for (size_t i = 0; i < indexCount; i += 3)
+        {
+            unsigned int triangleMin = std::min(source[i], std::min(source[i + 1], source[i + 2]));
+            unsigned int triangleMax = std::max(source[i], std::max(source[i + 1], source[i + 2]));
+            if (triangleMax - triangleMin >= INDEX_BUFFER_MAX_RANGE_VERTICES)
+                return Wide(source, indexCount);
+            unsigned int newMin = std::min(rangeMin, triangleMin);
+            unsigned int newMax = std::max(rangeMax, triangleMax);
+            if (i > rangeBegin && newMax - newMin >= INDEX_BUFFER_MAX_RANGE_VERTICES)
+            {
+                // the triangle doesn't fit, close the current range and start a new one with it
+                buffer.AddRange(source, rangeBegin, i, rangeMin);
+                rangeBegin = i;
+                newMin = triangleMin;
+                newMax = triangleMax;
+            }
+            rangeMin = newMin;
+            rangeMax = newMax;
+        }
+        buffer.AddRange(source, rangeBegin, indexCount, rangeMin);
+        return buffer;
+    }
+
+    // splits several triangle lists over the same vertices (e.g. LODs) into one buffer of a single index type.
+    // Ranges never span two lists, listRanges[i] receives the ranges of lists[i]
+    static SplitIndexBuffer FromTriangleLists(const std::vector<const std::vector<unsigned int>*>& lists, std::vector<std::vector<IndexRange>>& listRanges)
+    {
+        std::vector<IndexList> spans;
+        for (const std::vector<unsigned int>* list : lists)
+            spans.push_back({ list->data(), list->size() });
+        return FromTriangleLists(spans, listRanges);
+    }
+
+    static SplitIndexBuffer FromTriangleLists(const std::vector<IndexList>& lists, std::vector<std::vector<IndexRange>>& listRanges)
+    {
+        std::vector<SplitIndexBuffer> parts;
+        bool wide = false;
+        for (const IndexList& list : lists)
+        {
+            parts.push_back(FromTriangles(list.data, list.count));
+            wide = wide || parts.back().type != GL_UNSIGNED_SHORT;
+        }
+
+        SplitIndexBuffer buffer;
+        buffer.type = wide ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT;
+        listRanges.assign(lists.size(), std::vector<IndexRange>());
+        for (size_t l = 0; l < parts.size(); l++)
+        {
+            if (wide && parts[l].type == GL_UNSIGNED_SHORT)
+                parts[l] = Wide(lists[l].data, lists[l].count - lists[l].count % 3);
+            const unsigned int offset = static_cast<unsigned int>(wide ? buffer.wideIndices.size() : buffer.indices.size());
+            buffer.indices.insert(buffer.indices.end(), parts[l].indices.begin(), parts[l].indices.end());
+            buffer.wideIndices.insert(buffer.wideIndices.end(), parts[l].wideIndices.begin(), parts[l].wideIndices.end());
+            for (IndexRange range : parts[l].ranges)
+            {
+                range.firstIndex += offset;
+                listRanges[l].push_back(range);
+                buffer.ranges.push_back(range);
+            }
+        }
+        return buffer;
+    }
+
+    // number of indices drawn from the given ranges
+    static size_t CountIndices(const std::vector<IndexRange>& ranges)
+    {
+        size_t count = 0;
+        for (const IndexRange& range : ranges)
+            count += range.indexCount;
+        return count;
+    }
+
+    // the original 32-bit index of every entry, for verification and CPU side processing
+    std::vector<unsigned int> Expand() const
+    {
+        std::vector<unsigned int> expanded;
+        expanded.reserve(indices.size());
+        for (const IndexRange& range : ranges)
+            for (unsigned int i = 0; i < range.indexCount; i++)
+                expanded.push_back(range.baseVertex + (type == GL_UNSIGNED_SHORT ? indices[range.firstIndex + i] : wideIndices[range.firstIndex + i]));
+        return expanded;
+    }
+
+    // draws every range from the currently bound VAO and GL_ELEMENT_ARRAY_BUFFER
+    static void Draw(const std::vector<IndexRange>& ranges, GLenum type, GLenum mode = GL_TRIANGLES)
+    {
+        const size_t indexSize = type == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+        for (const IndexRange& range : ranges)
+        {
+            void* offset = (void*)(range.firstIndex * indexSize);
+            if (range.baseVertex == 0)
+                glDrawElements(mode, range.indexCount, type, offset);
+            else
+                glDrawElementsBaseVertex(mode, range.indexCount, type, offset, range.baseVertex);
+        }
+    }
+
+    // instanced version of Draw, per-instance attributes advance once per instance across all ranges
+    static void DrawInstanced(const std::vector<IndexRange>& ranges, GLenum type, unsigned int instanceCount, GLenum mode = GL_TRIANGLES)
+    {
+        const size_t indexSize = type == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+        for (const IndexRange& range : ranges)
+        {
+            void* offset = (void*)(range.firstIndex * indexSize);
+            if (range.baseVertex == 0)
+                glDrawElementsInstanced(mode, range.indexCount, type, offset, instanceCount);
+            else
+                glDrawElementsInstancedBaseVertex(mode, range.indexCount, type, offset, instanceCount, range.baseVertex);
+        }
+    }
+
+private:
+    static SplitIndexBuffer Wide(const unsigned int* source, size_t indexCount)
+    {
+        SplitIndexBuffer buffer;
+        buffer.type = GL_UNSIGNED_INT;
+        buffer.wideIndices.assign(source, source + indexCount);
+        if (indexCount == 0)
+            return buffer;
+        IndexRange range;
+        range.indexCount = static_cast<unsigned int>(indexCount);
+        buffer.ranges.push_back(range);
+        return buffer;
+    }
+
+    void AddRange(const unsigned int* source, size_t begin, size_t end, unsigned int baseVertex)
+    {
+        IndexRange range;
+        range.firstIndex = static_cast<unsigned int>(begin);
+        range.indexCount = static_cast<unsigned int>(end - begin);
+        range.baseVertex = baseVertex;
+        for (size_t i = begin; i < end; i++)
+            indices[i] = static_cast<uint16_t>(source[i] - baseVertex);
+        ranges.push_back(range);
+    }
+};
+#endif
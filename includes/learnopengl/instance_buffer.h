@@ -0,0 +1,102 @@
+#ifndef INSTANCE_BUFFER_H
+#define INSTANCE_BUFFER_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Per-instance model matrices for instanced drawing. The matrix is read by the vertex shader as
+//   layout (location = 7) in mat4 aInstanceMatrix;
+// and takes up the four attribute locations 7 to 10, right after the per-vertex attributes of VertexLayout.
+
+#define INSTANCE_ATTRIBUTE_LOCATION 7
+
+// GL buffer holding the instance matrices, rewritten every frame
+class InstanceBuffer
+{
+public:
+    unsigned int ID = 0;
+
+    InstanceBuffer() = default;
+    InstanceBuffer(const InstanceBuffer&) = delete;
+    InstanceBuffer& operator=(const InstanceBuffer&) = delete;
+    ~InstanceBuffer()
+    {
+        if (ID != 0)
+            glDeleteBuffers(1, &ID);
+    }
+
+    // replaces the contents with count matrices. The storage is orphaned first so the driver doesn't
+    // have to wait for draws still reading last frame's matrices, and only grows (doubling) when needed.
+    void Upload(const glm::mat4* transforms, size_t count)
+    {
+        if (ID == 0)
+        {
+            glGenBuffers(1, &ID);
+            m_Generation = NextGeneration();
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, ID);
+        if (count > m_Capacity)
+            m_Capacity = std::max(count, m_Capacity * 2);
+        glBufferData(GL_ARRAY_BUFFER, m_Capacity * sizeof(glm::mat4), nullptr, GL_STREAM_DRAW);
+        if (count > 0)
+            glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(glm::mat4), transforms);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        m_Count = count;
+    }
+
+    // points the instance attributes of vao at this buffer
+    void AttachTo(unsigned int vao) const
+    {
+        glBindVertexArray(vao);
+        glBindBuffer(GL_ARRAY_BUFFER, ID);
+        for (unsigned int i = 0; i < 4; i++)
+        {
+            glEnableVertexAttribArray(INSTANCE_ATTRIBUTE_LOCATION + i);
+            glVertexAttribPointer(INSTANCE_ATTRIBUTE_LOCATION + i, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(i * sizeof(glm::vec4)));
+            glVertexAttribDivisor(INSTANCE_ATTRIBUTE_LOCATION + i, 1);
+        }
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    size_t Count() const { return m_Count; }
+    size_t Capacity() const { return m_Capacity; }
+    // unique for every GL buffer created by any InstanceBuffer, unlike ID, which GL hands out again once a buffer is
+    // deleted. VAOs remember it to know whether their instance attributes still point at this buffer
+    uint64_t Generation() const { return m_Generation; }
+
+private:
+    size_t m_Count = 0;
+    size_t m_Capacity = 0;
+    uint64_t m_Generation = 0;
+
+    static uint64_t NextGeneration()
+    {
+        static uint64_t generation = 0;
+        return ++generation;
+    }
+};
+
+// collects the matrices of the instances that survived culling this frame, see Entity::collectSelfAndChild
+class InstanceBufferBuilder
+{
+public:
+    std::vector<glm::mat4> transforms;
+
+    void Clear() { transforms.clear(); }
+    void Reserve(size_t count) { transforms.reserve(count); }
+    void Add(const glm::mat4& transform) { transforms.push_back(transform); }
+    size_t Size() const { return transforms.size(); }
+
+    void Upload(InstanceBuffer& buffer) const
+    {
+        buffer.Upload(transforms.data(), transforms.size());
+    }
+};
+#endif
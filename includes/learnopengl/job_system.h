@@ -0,0 +1,160 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent worker threads for data parallel per-frame work. ParallelFor cuts a range into chunks and deals them out
+// to one queue per thread. Every thread works its own queue from the back and, once that is empty, steals from the
+// front of the others, so threads that drew cheap chunks help out the ones that drew expensive ones.
+// The calling thread works along and ParallelFor returns when every chunk has run. Only one thread may call ParallelFor
+// at a time.
+class JobSystem
+{
+public:
+    // threadCount counts the calling thread too, 0 uses every hardware thread
+    explicit JobSystem(unsigned int threadCount = 0)
+    {
+        if (threadCount == 0)
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned int i = 0; i < threadCount; i++)
+            m_Queues.emplace_back(new WorkQueue());
+        for (unsigned int i = 1; i < threadCount; i++)
+            m_Workers.emplace_back([this, i] { WorkerLoop(i); });
+    }
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    ~JobSystem()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_WakeMutex);
+            m_Stop = true;
+        }
+        m_Wake.notify_all();
+        for (std::thread& worker : m_Workers)
+            worker.join();
+    }
+
+    // calls function(begin, end) for chunks of at most grain items covering [0, count)
+    void ParallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& function)
+    {
+        if (count == 0)
+            return;
+        grain = std::max<size_t>(grain, 1);
+        const size_t chunks = (count + grain - 1) / grain;
+        if (chunks == 1 || m_Queues.size() == 1)
+        {
+            function(0, count);
+            return;
+        }
+
+        // counted before they are pushed, so a thread taking one never sees the count go below zero
+        {
+            std::lock_guard<std::mutex> lock(m_WakeMutex);
+            m_Queued += chunks;
+        }
+        std::atomic<size_t> remaining(chunks);
+        for (size_t c = 0; c < chunks; c++)
+        {
+            WorkQueue& queue = *m_Queues[c % m_Queues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.jobs.push_back(Job{ &function, c * grain, std::min(count, (c + 1) * grain), &remaining });
+        }
+        m_Wake.notify_all();
+
+        // help until every chunk is done, the last ones may still be running on other threads
+        Job job;
+        while (remaining.load(std::memory_order_acquire) > 0)
+        {
+            if (TakeJob(0, job))
+                Run(job);
+            else
+                std::this_thread::yield();
+        }
+    }
+
+    unsigned int ThreadCount() const { return static_cast<unsigned int>(m_Queues.size()); }
+
+private:
+    struct Job
+    {
+        const std::function<void(size_t, size_t)>* function = nullptr;
+        size_t begin = 0;
+        size_t end = 0;
+        std::atomic<size_t>* remaining = nullptr;
+    };
+
+    struct WorkQueue
+    {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    std::vector<std::unique_ptr<WorkQueue>> m_Queues; // m_Queues[0] belongs to the thread calling ParallelFor
+    std::vector<std::thread> m_Workers;
+
+    std::mutex m_WakeMutex;
+    std::condition_variable m_Wake;
+    size_t m_Queued = 0; // jobs pushed but not yet taken, guarded by m_WakeMutex
+    bool m_Stop = false;
+
+    // own queue from the back (most recently dealt, still warm), then the other queues from the front
+    bool TakeJob(unsigned int self, Job& job)
+    {
+        for (size_t i = 0; i < m_Queues.size(); i++)
+        {
+            WorkQueue& queue = *m_Queues[(self + i) % m_Queues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.jobs.empty())
+                continue;
+            if (i == 0)
+            {
+                job = queue.jobs.back();
+                queue.jobs.pop_back();
+            }
+            else
+            {
+                job = queue.jobs.front();
+                queue.jobs.pop_front();
+            }
+            std::lock_guard<std::mutex> wakeLock(m_WakeMutex);
+            m_Queued--;
+            return true;
+        }
+        return false;
+    }
+
+    static void Run(const Job& job)
+    {
+        (*job.function)(job.begin, job.end);
+        job.remaining->fetch_sub(1, std::memory_order_release);
+    }
+
+    void WorkerLoop(unsigned int self)
+    {
+        Job job;
+        for (;;)
+        {
+            if (TakeJob(self, job))
+            {
+                Run(job);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(m_WakeMutex);
+            m_Wake.wait(lock, [this] { return m_Stop || m_Queued > 0; });
+            if (m_Stop)
+                return;
+        }
+    }
+};
+#endif
@@ -6,7 +6,12 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <learnopengl/index_buffer.h>
+#include <learnopengl/meshlet.h>
+#include <learnopengl/mesh_simplifier.h>
 #include <learnopengl/shader.h>
+#include <learnopengl/texture_registry.h>
+#include <learnopengl/vertex_layout.h>
 
 #include <string>
 #include <vector>
@@ -35,6 +40,7 @@ struct Texture {
     unsigned int id;
     string type;
     string path;
+    TextureHandle handle; // keeps the shared texture resident in the TextureRegistry
 };
 
 class Mesh {
@@ -43,21 +49,133 @@ public:
     vector<Vertex>       vertices;
     vector<unsigned int> indices;
     vector<Texture>      textures;
+    VertexLayout         layout; // attributes and formats actually uploaded to the GPU
+    vector<IndexRange>   indexRanges; // ranges of the index buffer, see index_buffer.h
+    GLenum               indexType = GL_UNSIGNED_SHORT;
+    uint64_t             instanceBufferGeneration = 0; // InstanceBuffer::Generation the VAO's instance attributes currently point at
+    vector<Meshlet>      meshlets; // clusters for CPU culling, empty unless built (see MeshletBuilder)
+    vector<MeshLod>      lods; // simplified versions sharing the vertex buffer, lods[0] is LOD level 1 (see mesh_simplifier.h)
+    unsigned int         vertexCount = 0; // vertices in the vertex buffer, also when no CPU copy is kept
+    glm::vec3            boundsMin = glm::vec3(0.0f); // model space bounds of the vertex positions
+    glm::vec3            boundsMax = glm::vec3(0.0f);
     unsigned int VAO;
 
     // constructor
-    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures)
+    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures, VertexLayout layout = VertexLayout::Full(), vector<MeshLod> lods = {})
     {
-        this->vertices = vertices;
-        this->indices = indices;
-        this->textures = textures;
+        this->layout = std::move(layout);
+        this->vertices = std::move(vertices);
+        this->indices = std::move(indices);
+        this->textures = std::move(textures);
+        this->lods = std::move(lods);
 
         // now that we have all the required data, set the vertex buffers and its attribute pointers.
-        setupMesh();
+        vector<IndexList> indexLists = { { this->indices.data(), this->indices.size() } };
+        for(const MeshLod& lod : this->lods)
+            indexLists.push_back({ lod.indices.data(), lod.indices.size() });
+        setupMesh(this->vertices.data(), this->vertices.size(), indexLists);
+    }
+
+    // constructor for data that already lives elsewhere (e.g. a memory mapped mesh cache), uploads straight from the given arrays.
+    // lods only carry their errors, lodIndices[i] holds the indices of lods[i]. The arrays are copied into vertices, indices
+    // and the lods' indices only when keepData is set, e.g. for StaticBatch::Merge; bounds and counts are kept either way.
+    Mesh(const Vertex* vertexData, size_t vertexCount, const unsigned int* indexData, size_t indexCount, vector<Texture> textures, VertexLayout layout = VertexLayout::Full(),
+        vector<MeshLod> lods = {}, const vector<IndexList>& lodIndices = {}, bool keepData = false)
+    {
+        this->layout = std::move(layout);
+        this->textures = std::move(textures);
+        this->lods = std::move(lods);
+        vector<IndexList> indexLists = { { indexData, indexCount } };
+        indexLists.insert(indexLists.end(), lodIndices.begin(), lodIndices.end());
+        setupMesh(vertexData, vertexCount, indexLists);
+
+        if(keepData)
+        {
+            this->vertices.assign(vertexData, vertexData + vertexCount);
+            this->indices.assign(indexData, indexData + indexCount);
+            for(size_t i = 0; i < this->lods.size() && i < lodIndices.size(); i++)
+                this->lods[i].indices.assign(lodIndices[i].data, lodIndices[i].data + lodIndices[i].count);
+        }
+    }
+
+    // frees the CPU copies of the vertices and indices once nothing needs them anymore, the GPU buffers stay
+    void ReleaseData()
+    {
+        vector<Vertex>().swap(vertices);
+        vector<unsigned int>().swap(indices);
+        for(MeshLod& lod : lods)
+            vector<unsigned int>().swap(lod.indices);
     }
 
     // render the mesh
     void Draw(Shader &shader) 
+    {
+        BindTextures(shader, textures);
+
+        // draw mesh
+        glBindVertexArray(VAO);
+        SplitIndexBuffer::Draw(indexRanges, indexType);
+        glBindVertexArray(0);
+
+        // always good practice to set everything back to defaults once configured.
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    // render instanceCount copies of the mesh, the instance attributes must already be attached to the VAO (see Model::DrawInstanced)
+    void DrawInstanced(Shader &shader, unsigned int instanceCount)
+    {
+        BindTextures(shader, textures);
+
+        glBindVertexArray(VAO);
+        SplitIndexBuffer::DrawInstanced(indexRanges, indexType, instanceCount);
+        glBindVertexArray(0);
+
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    // render LOD level (0 is full detail, level i is lods[i - 1]), see LodSelection::Select
+    void DrawLod(Shader &shader, unsigned int level)
+    {
+        BindTextures(shader, textures);
+
+        glBindVertexArray(VAO);
+        SplitIndexBuffer::Draw(level == 0 || level > lods.size() ? indexRanges : lods[level - 1].indexRanges, indexType);
+        glBindVertexArray(0);
+
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    unsigned int GetTriangleCount(unsigned int level = 0) const
+    {
+        return static_cast<unsigned int>(SplitIndexBuffer::CountIndices(level == 0 || level > lods.size() ? indexRanges : lods[level - 1].indexRanges) / 3);
+    }
+
+    // render only the given ranges of the index buffer, usually the meshlets that survived MeshletCuller
+    void DrawRanges(Shader &shader, const MeshletDrawList &drawList)
+    {
+        if(drawList.Size() == 0)
+            return;
+        BindTextures(shader, textures);
+
+        glBindVertexArray(VAO);
+        glMultiDrawElementsBaseVertex(GL_TRIANGLES, drawList.counts.data(), indexType, drawList.offsets.data(),
+            static_cast<GLsizei>(drawList.Size()), drawList.baseVertices.data());
+        glBindVertexArray(0);
+
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    // GPU memory used by the vertex and index buffers
+    size_t GetBufferSize() const
+    {
+        size_t indexCount = SplitIndexBuffer::CountIndices(indexRanges);
+        for(const MeshLod& lod : lods)
+            indexCount += SplitIndexBuffer::CountIndices(lod.indexRanges);
+        return vertexCount * layout.stride + indexCount * (indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t));
+    }
+
+    // binds textures to consecutive texture units and points the shader's samplers (texture_diffuseN, ...) at them
+    static void BindTextures(Shader &shader, const vector<Texture> &textures)
     {
         // bind appropriate textures
         unsigned int diffuseNr  = 1;
@@ -84,23 +202,26 @@ public:
             // and finally bind the texture
             glBindTexture(GL_TEXTURE_2D, textures[i].id);
         }
-        
-        // draw mesh
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
-
-        // always good practice to set everything back to defaults once configured.
-        glActiveTexture(GL_TEXTURE0);
     }
 
 private:
     // render data 
     unsigned int VBO, EBO;
 
-    // initializes all the buffer objects/arrays
-    void setupMesh()
+    // initializes all the buffer objects/arrays, indexLists holds the full detail indices followed by those of every LOD
+    void setupMesh(const Vertex* vertexData, size_t vertexCount, const vector<IndexList>& indexLists)
     {
+        this->vertexCount = static_cast<unsigned int>(vertexCount);
+        if(vertexCount > 0)
+        {
+            boundsMin = boundsMax = vertexData[0].Position;
+            for(size_t i = 1; i < vertexCount; i++)
+            {
+                boundsMin = glm::min(boundsMin, vertexData[i].Position);
+                boundsMax = glm::max(boundsMax, vertexData[i].Position);
+            }
+        }
+
         // create buffers/arrays
         glGenVertexArrays(1, &VAO);
         glGenBuffers(1, &VBO);
@@ -109,37 +230,43 @@ private:
         glBindVertexArray(VAO);
         // load data into vertex buffers
         glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        // A great thing about structs is that their memory layout is sequential for all its items.
-        // The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
-        // again translates to 3/2 floats which translates to a byte array.
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);  
+        if (layout.stride == sizeof(Vertex))
+        {
+            // A great thing about structs is that their memory layout is sequential for all its items.
+            // The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
+            // again translates to 3/2 floats which translates to a byte array.
+            glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(Vertex), vertexData, GL_STATIC_DRAW);
+        }
+        else
+        {
+            // slim layout, interleave only the attributes the layout asks for
+            vector<unsigned char> packed = layout.Pack(vertexData, vertexCount);
+            glBufferData(GL_ARRAY_BUFFER, packed.size(), packed.data(), GL_STATIC_DRAW);
+        }
 
+        // 16-bit indices, meshes with more than 65536 vertices are split into ranges with a base vertex.
+        // the LODs follow the full detail indices in the same buffer
+        SplitIndexBuffer indexBuffer;
+        if(indexLists.size() == 1)
+        {
+            indexBuffer = SplitIndexBuffer::FromTriangles(indexLists[0].data, indexLists[0].count);
+            indexRanges = indexBuffer.ranges;
+        }
+        else
+        {
+            vector<vector<IndexRange>> listRanges;
+            indexBuffer = SplitIndexBuffer::FromTriangleLists(indexLists, listRanges);
+            indexRanges = std::move(listRanges[0]);
+            for(size_t i = 0; i < lods.size() && i + 1 < listRanges.size(); i++)
+                lods[i].indexRanges = std::move(listRanges[i + 1]);
+        }
+        indexType = indexBuffer.type;
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
-
-        // set the vertex attribute pointers
-        // vertex Positions
-        glEnableVertexAttribArray(0);	
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-        // vertex normals
-        glEnableVertexAttribArray(1);	
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
-        // vertex texture coords
-        glEnableVertexAttribArray(2);	
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
-        // vertex tangent
-        glEnableVertexAttribArray(3);
-        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Tangent));
-        // vertex bitangent
-        glEnableVertexAttribArray(4);
-        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
-		// ids
-		glEnableVertexAttribArray(5);
-		glVertexAttribIPointer(5, 4, GL_INT, sizeof(Vertex), (void*)offsetof(Vertex, m_BoneIDs));
-
-		// weights
-		glEnableVertexAttribArray(6);
-		glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, m_Weights));
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBuffer.Size(), indexBuffer.Data(), GL_STATIC_DRAW);
+
+        // set the vertex attribute pointers (positions, normals, texture coords, tangent, bitangent, bone ids, weights)
+        // for whichever of them the layout contains
+        layout.Apply();
         glBindVertexArray(0);
     }
 };
@@ -0,0 +1,433 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <learnopengl/mesh.h>
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Binary cache of the final vertex/index arrays and material table of an imported model.
+//
+// File layout (little endian, every block 8 byte aligned):
+//   MeshCacheHeader
+//   source path (pathLength bytes)
+//   MeshCacheRecord[meshCount]
+//   per mesh: texture table (uint32 typeLength, type, uint32 pathLength, path ...)
+//   per mesh: Vertex[vertexCount], unsigned int[indexCount]
+//   per mesh: MeshCacheLod[lodCount], then the indices of every LOD one after the other
+// A cache file is only used when the stored key (path, mtime, import flags, layout flags, vertex size, version) matches.
+
+#define MESH_CACHE_VERSION 4
+
+struct MeshCacheKey
+{
+    string sourcePath;
+    int64_t sourceModifiedTime = 0;
+    uint32_t importFlags = 0;
+    uint32_t layoutFlags = 0; // vertex layout options, they decide each mesh's attributeMask
+};
+
+struct MeshCacheHeader
+{
+    char magic[4];
+    uint32_t version;
+    int64_t sourceModifiedTime;
+    uint32_t importFlags;
+    uint32_t layoutFlags;
+    uint32_t vertexSize;
+    uint32_t meshCount;
+    uint32_t pathLength;
+};
+
+struct MeshCacheRecord
+{
+    uint64_t texturesOffset;
+    uint64_t verticesOffset;
+    uint64_t indicesOffset;
+    uint32_t textureCount;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t attributeMask;
+    uint64_t lodsOffset;
+    uint32_t lodCount;
+    uint32_t lodIndexCount; // summed over all LODs
+};
+
+struct MeshCacheLod
+{
+    uint32_t indexCount;
+    float error;
+};
+
+struct CachedLodView
+{
+    const unsigned int* indices;
+    unsigned int        indexCount;
+    float               error;
+};
+
+// view into a mapped cache file, pointers stay valid as long as the MeshCacheReader is alive
+struct CachedMeshView
+{
+    const Vertex*       vertices;
+    unsigned int        vertexCount;
+    const unsigned int* indices;
+    unsigned int        indexCount;
+    unsigned int        attributeMask; // VertexLayout attributes the mesh was uploaded with
+    vector<Texture>     textures; // only type and path are filled in
+    vector<CachedLodView> lods;
+};
+
+// read-only memory mapping of a whole file
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { Close(); }
+
+    bool Open(const string& path)
+    {
+        Close();
+#ifdef _WIN32
+        m_File = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (m_File == INVALID_HANDLE_VALUE)
+            return false;
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(m_File, &size) || size.QuadPart == 0)
+        {
+            Close();
+            return false;
+        }
+        m_Mapping = CreateFileMappingA(m_File, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (m_Mapping == NULL)
+        {
+            Close();
+            return false;
+        }
+        m_Data = static_cast<const unsigned char*>(MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0));
+        m_Size = static_cast<size_t>(size.QuadPart);
+#else
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0)
+        {
+            close(fd);
+            return false;
+        }
+        void* data = mmap(NULL, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd); // the mapping keeps its own reference to the file
+        if (data == MAP_FAILED)
+            return false;
+        m_Data = static_cast<const unsigned char*>(data);
+        m_Size = static_cast<size_t>(st.st_size);
+#endif
+        if (m_Data == nullptr)
+        {
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    void Close()
+    {
+#ifdef _WIN32
+        if (m_Data) UnmapViewOfFile(m_Data);
+        if (m_Mapping != NULL) CloseHandle(m_Mapping);
+        if (m_File != INVALID_HANDLE_VALUE) CloseHandle(m_File);
+        m_Mapping = NULL;
+        m_File = INVALID_HANDLE_VALUE;
+#else
+        if (m_Data) munmap(const_cast<unsigned char*>(m_Data), m_Size);
+#endif
+        m_Data = nullptr;
+        m_Size = 0;
+    }
+
+    const unsigned char* Data() const { return m_Data; }
+    size_t Size() const { return m_Size; }
+
+private:
+    const unsigned char* m_Data = nullptr;
+    size_t m_Size = 0;
+#ifdef _WIN32
+    HANDLE m_File = INVALID_HANDLE_VALUE;
+    HANDLE m_Mapping = NULL;
+#endif
+};
+
+class MeshCache
+{
+public:
+    // the cache file lives next to the source model
+    static string GetCachePath(const string& sourcePath)
+    {
+        return sourcePath + ".meshcache";
+    }
+
+    static bool MakeKey(const string& sourcePath, uint32_t importFlags, MeshCacheKey& key)
+    {
+        std::error_code error;
+        auto modified = std::filesystem::last_write_time(sourcePath, error);
+        if (error)
+            return false;
+        key.sourcePath = sourcePath;
+        key.sourceModifiedTime = static_cast<int64_t>(modified.time_since_epoch().count());
+        key.importFlags = importFlags;
+        return true;
+    }
+
+    // writes all meshes to the cache file, returns false if the file could not be written
+    static bool Write(const string& cachePath, const MeshCacheKey& key, const vector<Mesh>& meshes)
+    {
+        // lay out the file first so every offset is known before writing
+        uint64_t offset = Align(sizeof(MeshCacheHeader) + key.sourcePath.size());
+        const uint64_t recordsOffset = offset;
+        offset = Align(offset + meshes.size() * sizeof(MeshCacheRecord));
+
+        vector<MeshCacheRecord> records(meshes.size());
+        for (size_t i = 0; i < meshes.size(); i++)
+        {
+            MeshCacheRecord& record = records[i];
+            record.textureCount = static_cast<uint32_t>(meshes[i].textures.size());
+            record.vertexCount = static_cast<uint32_t>(meshes[i].vertices.size());
+            record.indexCount = static_cast<uint32_t>(meshes[i].indices.size());
+            record.attributeMask = meshes[i].layout.attributeMask;
+            record.texturesOffset = offset;
+            for (const Texture& texture : meshes[i].textures)
+                offset += 2 * sizeof(uint32_t) + texture.type.size() + texture.path.size();
+            offset = Align(offset);
+        }
+        for (size_t i = 0; i < meshes.size(); i++)
+        {
+            records[i].verticesOffset = offset;
+            offset = Align(offset + records[i].vertexCount * sizeof(Vertex));
+            records[i].indicesOffset = offset;
+            offset = Align(offset + records[i].indexCount * sizeof(unsigned int));
+            records[i].lodCount = static_cast<uint32_t>(meshes[i].lods.size());
+            records[i].lodIndexCount = 0;
+            for (const MeshLod& lod : meshes[i].lods)
+                records[i].lodIndexCount += static_cast<uint32_t>(lod.indices.size());
+            records[i].lodsOffset = offset;
+            offset = Align(offset + records[i].lodCount * sizeof(MeshCacheLod) + records[i].lodIndexCount * sizeof(unsigned int));
+        }
+
+        // write to a temporary file and rename so a crash never leaves a half written cache
+        const string tempPath = cachePath + ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if (!file)
+                return false;
+
+            MeshCacheHeader header;
+            std::memcpy(header.magic, "LGMC", 4);
+            header.version = MESH_CACHE_VERSION;
+            header.sourceModifiedTime = key.sourceModifiedTime;
+            header.importFlags = key.importFlags;
+            header.layoutFlags = key.layoutFlags;
+            header.vertexSize = sizeof(Vertex);
+            header.meshCount = static_cast<uint32_t>(meshes.size());
+            header.pathLength = static_cast<uint32_t>(key.sourcePath.size());
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(key.sourcePath.data(), key.sourcePath.size());
+            Pad(file, recordsOffset);
+            if (!records.empty())
+                file.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(MeshCacheRecord));
+
+            for (size_t i = 0; i < meshes.size(); i++)
+            {
+                Pad(file, records[i].texturesOffset);
+                for (const Texture& texture : meshes[i].textures)
+                {
+                    WriteString(file, texture.type);
+                    WriteString(file, texture.path);
+                }
+            }
+            for (size_t i = 0; i < meshes.size(); i++)
+            {
+                Pad(file, records[i].verticesOffset);
+                if (!meshes[i].vertices.empty())
+                    file.write(reinterpret_cast<const char*>(meshes[i].vertices.data()), meshes[i].vertices.size() * sizeof(Vertex));
+                Pad(file, records[i].indicesOffset);
+                if (!meshes[i].indices.empty())
+                    file.write(reinterpret_cast<const char*>(meshes[i].indices.data()), meshes[i].indices.size() * sizeof(unsigned int));
+                Pad(file, records[i].lodsOffset);
+                for (const MeshLod& lod : meshes[i].lods)
+                {
+                    MeshCacheLod entry = { static_cast<uint32_t>(lod.indices.size()), lod.error };
+                    file.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+                }
+                for (const MeshLod& lod : meshes[i].lods)
+                {
+                    if (!lod.indices.empty())
+                        file.write(reinterpret_cast<const char*>(lod.indices.data()), lod.indices.size() * sizeof(unsigned int));
+                }
+            }
+            Pad(file, offset);
+            if (!file)
+                return false;
+        }
+
+        std::error_code error;
+        std::filesystem::rename(tempPath, cachePath, error);
+        if (error)
+        {
+            std::filesystem::remove(tempPath, error);
+            return false;
+        }
+        return true;
+    }
+
+private:
+    static uint64_t Align(uint64_t offset)
+    {
+        return (offset + 7) & ~uint64_t(7);
+    }
+
+    static void Pad(std::ofstream& file, uint64_t offset)
+    {
+        static const char zeros[8] = {};
+        uint64_t position = static_cast<uint64_t>(file.tellp());
+        if (offset > position)
+            file.write(zeros, static_cast<std::streamsize>(offset - position));
+    }
+
+    static void WriteString(std::ofstream& file, const string& str)
+    {
+        uint32_t length = static_cast<uint32_t>(str.size());
+        file.write(reinterpret_cast<const char*>(&length), sizeof(length));
+        file.write(str.data(), length);
+    }
+};
+
+// maps a cache file and validates it against a key, meshes point straight into the mapping
+class MeshCacheReader
+{
+public:
+    bool Open(const string& cachePath, const MeshCacheKey& key)
+    {
+        m_Meshes.clear();
+        if (!m_File.Open(cachePath))
+            return false;
+        if (!Parse(key))
+        {
+            m_Meshes.clear();
+            m_File.Close();
+            return false;
+        }
+        return true;
+    }
+
+    const vector<CachedMeshView>& Meshes() const { return m_Meshes; }
+
+private:
+    MappedFile m_File;
+    vector<CachedMeshView> m_Meshes;
+
+    bool Parse(const MeshCacheKey& key)
+    {
+        const unsigned char* data = m_File.Data();
+        const size_t size = m_File.Size();
+        if (size < sizeof(MeshCacheHeader))
+            return false;
+
+        MeshCacheHeader header;
+        std::memcpy(&header, data, sizeof(header));
+        if (std::memcmp(header.magic, "LGMC", 4) != 0 || header.version != MESH_CACHE_VERSION ||
+            header.vertexSize != sizeof(Vertex) || header.importFlags != key.importFlags || header.layoutFlags != key.layoutFlags ||
+            header.sourceModifiedTime != key.sourceModifiedTime || header.pathLength != key.sourcePath.size())
+            return false;
+        if (sizeof(header) + header.pathLength > size ||
+            std::memcmp(data + sizeof(header), key.sourcePath.data(), header.pathLength) != 0)
+            return false;
+
+        uint64_t recordsOffset = (sizeof(header) + header.pathLength + 7) & ~uint64_t(7);
+        if (recordsOffset + uint64_t(header.meshCount) * sizeof(MeshCacheRecord) > size)
+            return false;
+
+        m_Meshes.reserve(header.meshCount);
+        for (uint32_t i = 0; i < header.meshCount; i++)
+        {
+            MeshCacheRecord record;
+            std::memcpy(&record, data + recordsOffset + i * sizeof(MeshCacheRecord), sizeof(record));
+            if (record.verticesOffset + uint64_t(record.vertexCount) * sizeof(Vertex) > size ||
+                record.indicesOffset + uint64_t(record.indexCount) * sizeof(unsigned int) > size ||
+                record.lodsOffset + uint64_t(record.lodCount) * sizeof(MeshCacheLod) + uint64_t(record.lodIndexCount) * sizeof(unsigned int) > size)
+                return false;
+
+            CachedMeshView view;
+            view.vertices = reinterpret_cast<const Vertex*>(data + record.verticesOffset);
+            view.vertexCount = record.vertexCount;
+            view.indices = reinterpret_cast<const unsigned int*>(data + record.indicesOffset);
+            view.indexCount = record.indexCount;
+            view.attributeMask = record.attributeMask;
+
+            uint64_t lodIndices = record.lodsOffset + uint64_t(record.lodCount) * sizeof(MeshCacheLod);
+            uint64_t lodIndexCount = 0;
+            for (uint32_t l = 0; l < record.lodCount; l++)
+            {
+                MeshCacheLod entry;
+                std::memcpy(&entry, data + record.lodsOffset + l * sizeof(MeshCacheLod), sizeof(entry));
+                lodIndexCount += entry.indexCount;
+                if (lodIndexCount > record.lodIndexCount)
+                    return false;
+                CachedLodView lod;
+                lod.indices = reinterpret_cast<const unsigned int*>(data + lodIndices);
+                lod.indexCount = entry.indexCount;
+                lod.error = entry.error;
+                view.lods.push_back(lod);
+                lodIndices += uint64_t(entry.indexCount) * sizeof(unsigned int);
+            }
+
+            uint64_t offset = record.texturesOffset;
+            for (uint32_t t = 0; t < record.textureCount; t++)
+            {
+                Texture texture;
+                texture.id = 0;
+                if (!ReadString(offset, texture.type) || !ReadString(offset, texture.path))
+                    return false;
+                view.textures.push_back(texture);
+            }
+            m_Meshes.push_back(std::move(view));
+        }
+        return true;
+    }
+
+    bool ReadString(uint64_t& offset, string& out) const
+    {
+        uint32_t length;
+        if (offset + sizeof(length) > m_File.Size())
+            return false;
+        std::memcpy(&length, m_File.Data() + offset, sizeof(length));
+        offset += sizeof(length);
+        if (offset + length > m_File.Size())
+            return false;
+        out.assign(reinterpret_cast<const char*>(m_File.Data() + offset), length);
+        offset += length;
+        return true;
+    }
+};
+#endif
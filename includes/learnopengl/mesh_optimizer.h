@@ -0,0 +1,486 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/mesh.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Reorders imported triangle lists for the GPU. Optimize runs, in order:
+//   1. WeldVertices        merges bitwise identical vertices
+//   2. OptimizeVertexCache Forsyth's linear-speed vertex cache optimization
+//   3. OptimizeOverdraw    splits the result into clusters and sorts them front (outward facing) first,
+//                          only where this keeps the cache efficiency within a threshold (Sander et al., Tipsify)
+//   4. OptimizeVertexFetch renumbers vertices in first-use order so the vertex buffer is read linearly
+// AnalyzeVertexCache simulates a FIFO post-transform cache to measure the result:
+//   ACMR = transformed vertices / triangles (0.5 is ideal for a large regular grid, 3 is no reuse at all)
+//   ATVR = transformed vertices / unique vertices (1 is ideal)
+
+struct VertexCacheStatistics
+{
+    size_t vertexCount = 0;      // vertices referenced by the index buffer
+    size_t triangleCount = 0;
+    size_t transformedCount = 0; // cache misses
+
+    float ACMR() const { return triangleCount ? float(transformedCount) / float(triangleCount) : 0.0f; }
+    float ATVR() const { return vertexCount ? float(transformedCount) / float(vertexCount) : 0.0f; }
+
+    void Add(const VertexCacheStatistics& other)
+    {
+        vertexCount += other.vertexCount;
+        triangleCount += other.triangleCount;
+        transformedCount += other.transformedCount;
+    }
+};
+
+struct MeshOptimizationStatistics
+{
+    VertexCacheStatistics before;
+    VertexCacheStatistics after;
+    size_t weldedVertices = 0;   // duplicates removed by WeldVertices
+
+    void Add(const MeshOptimizationStatistics& other)
+    {
+        before.Add(other.before);
+        after.Add(other.after);
+        weldedVertices += other.weldedVertices;
+    }
+};
+
+class MeshOptimizer
+{
+public:
+    // size of the simulated FIFO cache, small enough to be a conservative match for current GPUs
+    static constexpr unsigned int SIMULATED_CACHE_SIZE = 16;
+    // size of the LRU cache Forsyth's scoring models
+    static constexpr unsigned int FORSYTH_CACHE_SIZE = 32;
+
+    // runs every pass, vertices and indices are rewritten in place
+    static MeshOptimizationStatistics Optimize(vector<Vertex>& vertices, vector<unsigned int>& indices, float overdrawThreshold = 1.05f)
+    {
+        MeshOptimizationStatistics stats;
+        stats.before = AnalyzeVertexCache(indices.data(), indices.size(), vertices.size());
+        if (indices.size() < 3 || indices.size() % 3 != 0)
+        {
+            stats.after = stats.before;
+            return stats;
+        }
+
+        stats.weldedVertices = WeldVertices(vertices, indices);
+        OptimizeVertexCache(indices, vertices.size());
+        OptimizeOverdraw(indices, vertices, overdrawThreshold);
+        OptimizeVertexFetch(vertices, indices);
+
+        stats.after = AnalyzeVertexCache(indices.data(), indices.size(), vertices.size());
+        return stats;
+    }
+
+    // simulates a FIFO post-transform cache of cacheSize entries
+    static VertexCacheStatistics AnalyzeVertexCache(const unsigned int* indices, size_t indexCount, size_t vertexCount, unsigned int cacheSize = SIMULATED_CACHE_SIZE)
+    {
+        VertexCacheStatistics stats;
+        stats.triangleCount = indexCount / 3;
+
+        // a vertex is in the cache if it entered less than cacheSize misses ago
+        vector<size_t> enteredAt(vertexCount, 0);
+        vector<bool> referenced(vertexCount, false);
+        size_t timestamp = cacheSize + 1;
+        for (size_t i = 0; i < indexCount; i++)
+        {
+            unsigned int index = indices[i];
+            if (!referenced[index])
+            {
+                referenced[index] = true;
+                stats.vertexCount++;
+            }
+            if (timestamp - enteredAt[index] > cacheSize)
+            {
+                enteredAt[index] = timestamp++;
+                stats.transformedCount++;
+            }
+        }
+        return stats;
+    }
+
+    // merges bitwise identical vertices and rewrites the indices, returns the number of vertices removed.
+    // vertices should be value initialized so unused fields compare equal.
+    static size_t WeldVertices(vector<Vertex>& vertices, vector<unsigned int>& indices)
+    {
+        const vector<unsigned int> first = FindDuplicateVertices(vertices);
+        vector<unsigned int> remap(vertices.size());
+        vector<Vertex> welded;
+        welded.reserve(vertices.size());
+        for (size_t i = 0; i < vertices.size(); i++)
+        {
+            if (first[i] == i)
+            {
+                remap[i] = static_cast<unsigned int>(welded.size());
+                welded.push_back(vertices[i]);
+            }
+            else
+                remap[i] = remap[first[i]];
+        }
+
+        for (unsigned int& index : indices)
+            index = remap[index];
+        size_t removed = vertices.size() - welded.size();
+        vertices.swap(welded);
+        return removed;
+    }
+
+    // for every vertex the index of the first bitwise identical one, itself if it is the first.
+    // Indices rewritten through it reference only those first copies, without changing the vertex buffer
+    static vector<unsigned int> FindDuplicateVertices(const vector<Vertex>& vertices)
+    {
+        size_t tableSize = 1;
+        while (tableSize < vertices.size() * 2)
+            tableSize *= 2;
+        const unsigned int EMPTY = ~0u;
+        vector<unsigned int> table(tableSize, EMPTY);
+
+        vector<unsigned int> first(vertices.size());
+        for (size_t i = 0; i < vertices.size(); i++)
+        {
+            // open addressing with linear probing
+            size_t slot = HashVertex(vertices[i]) & (tableSize - 1);
+            while (table[slot] != EMPTY && std::memcmp(&vertices[table[slot]], &vertices[i], sizeof(Vertex)) != 0)
+                slot = (slot + 1) & (tableSize - 1);
+
+            if (table[slot] == EMPTY)
+                table[slot] = static_cast<unsigned int>(i);
+            first[i] = table[slot];
+        }
+        return first;
+    }
+
+    // Tom Forsyth, "Linear-Speed Vertex Cache Optimisation". Greedily emits the triangle with the highest score,
+    // where vertices score higher the more recently they were used and the fewer triangles they have left.
+    static void OptimizeVertexCache(vector<unsigned int>& indices, size_t vertexCount)
+    {
+        const size_t triangleCount = indices.size() / 3;
+        if (triangleCount == 0)
+            return;
+
+        // triangles adjacent to each vertex, compressed row storage
+        vector<unsigned int> valence(vertexCount, 0);
+        for (unsigned int index : indices)
+            valence[index]++;
+        vector<unsigned int> adjacencyOffset(vertexCount + 1, 0);
+        for (size_t v = 0; v < vertexCount; v++)
+            adjacencyOffset[v + 1] = adjacencyOffset[v] + valence[v];
+        vector<unsigned int> adjacency(indices.size());
+        {
+            vector<unsigned int> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+            for (size_t t = 0; t < triangleCount; t++)
+                for (int k = 0; k < 3; k++)
+                    adjacency[fill[indices[t * 3 + k]]++] = static_cast<unsigned int>(t);
+        }
+
+        // valence now counts the triangles each vertex still has to be emitted with
+        vector<int> cachePosition(vertexCount, -1);
+        vector<float> vertexScore(vertexCount);
+        for (size_t v = 0; v < vertexCount; v++)
+            vertexScore[v] = ForsythVertexScore(-1, valence[v]);
+
+        vector<float> triangleScore(triangleCount);
+        for (size_t t = 0; t < triangleCount; t++)
+            triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+
+        vector<bool> emitted(triangleCount, false);
+        vector<unsigned int> result;
+        result.reserve(indices.size());
+
+        // the cache holds up to FORSYTH_CACHE_SIZE entries plus the 3 vertices of the triangle being added
+        unsigned int cache[FORSYTH_CACHE_SIZE + 3];
+        unsigned int newCache[FORSYTH_CACHE_SIZE + 3];
+        unsigned int cacheCount = 0;
+        size_t inputCursor = 0; // first triangle that might not be emitted yet
+
+        long long best = -1;
+        for (size_t t = 0; t < triangleCount; t++)
+            if (best < 0 || triangleScore[t] > triangleScore[best])
+                best = static_cast<long long>(t);
+
+        while (best >= 0)
+        {
+            const unsigned int* triangle = &indices[best * 3];
+            emitted[best] = true;
+            result.insert(result.end(), triangle, triangle + 3);
+
+            // move the triangle's vertices to the front of the cache
+            unsigned int newCount = 0;
+            for (int k = 0; k < 3; k++)
+                newCache[newCount++] = triangle[k];
+            for (unsigned int i = 0; i < cacheCount; i++)
+            {
+                unsigned int v = cache[i];
+                if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+                    newCache[newCount++] = v;
+            }
+
+            // the triangle no longer counts towards its vertices' valence
+            for (int k = 0; k < 3; k++)
+            {
+                unsigned int v = triangle[k];
+                unsigned int begin = adjacencyOffset[v];
+                unsigned int end = begin + valence[v];
+                for (unsigned int a = begin; a < end; a++)
+                {
+                    if (adjacency[a] == static_cast<unsigned int>(best))
+                    {
+                        std::swap(adjacency[a], adjacency[end - 1]);
+                        break;
+                    }
+                }
+                valence[v]--;
+            }
+
+            // vertices that fell out of the cache lose their recency score
+            for (unsigned int i = FORSYTH_CACHE_SIZE; i < newCount; i++)
+            {
+                cachePosition[newCache[i]] = -1;
+                UpdateVertexScore(newCache[i], -1, valence, vertexScore, adjacencyOffset, adjacency, triangleScore);
+            }
+            cacheCount = std::min(newCount, FORSYTH_CACHE_SIZE);
+            std::memcpy(cache, newCache, cacheCount * sizeof(unsigned int));
+
+            // rescore the cached vertices and pick the best triangle touching them
+            best = -1;
+            float bestScore = 0.0f;
+            for (unsigned int i = 0; i < cacheCount; i++)
+            {
+                unsigned int v = cache[i];
+                cachePosition[v] = static_cast<int>(i);
+                UpdateVertexScore(v, static_cast<int>(i), valence, vertexScore, adjacencyOffset, adjacency, triangleScore);
+            }
+            for (unsigned int i = 0; i < cacheCount; i++)
+            {
+                unsigned int v = cache[i];
+                for (unsigned int a = adjacencyOffset[v]; a < adjacencyOffset[v] + valence[v]; a++)
+                {
+                    unsigned int t = adjacency[a];
+                    if (best < 0 || triangleScore[t] > bestScore)
+                    {
+                        best = t;
+                        bestScore = triangleScore[t];
+                    }
+                }
+            }
+
+            // nothing adjacent to the cache left, continue with the next triangle in input order
+            if (best < 0)
+            {
+                while (inputCursor < triangleCount && emitted[inputCursor])
+                    inputCursor++;
+                if (inputCursor < triangleCount)
+                    best = static_cast<long long>(inputCursor);
+            }
+        }
+
+        indices.swap(result);
+    }
+
+    // Splits the cache optimized triangle order into clusters and sorts them so outward facing clusters far from
+    // the mesh center are drawn first; they tend to occlude the rest. Clusters end where the cache would be
+    // cold anyway (hard boundaries) or where the cluster's running ACMR is already within threshold of the
+    // whole cluster's ACMR (soft boundaries), so the reordering costs at most that factor in vertex cache hits.
+    static void OptimizeOverdraw(vector<unsigned int>& indices, const vector<Vertex>& vertices, float threshold = 1.05f)
+    {
+        const size_t triangleCount = indices.size() / 3;
+        if (triangleCount < 2)
+            return;
+
+        // One simulated cache for every pass below. A vertex is cached if it entered less than SIMULATED_CACHE_SIZE
+        // misses ago, so moving timestamp on by more than that empties the cache without touching the array.
+        vector<size_t> enteredAt(vertices.size(), 0);
+        size_t timestamp = SIMULATED_CACHE_SIZE + 1;
+
+        // hard boundaries: triangles where every vertex misses the simulated cache
+        vector<size_t> hardClusters;
+        for (size_t t = 0; t < triangleCount; t++)
+        {
+            int misses = 0;
+            for (int k = 0; k < 3; k++)
+            {
+                unsigned int v = indices[t * 3 + k];
+                if (timestamp - enteredAt[v] > SIMULATED_CACHE_SIZE)
+                {
+                    enteredAt[v] = timestamp++;
+                    misses++;
+                }
+            }
+            if (t == 0 || misses == 3)
+                hardClusters.push_back(t);
+        }
+        hardClusters.push_back(triangleCount);
+
+        // soft boundaries inside every hard cluster
+        vector<size_t> clusters;
+        for (size_t c = 0; c + 1 < hardClusters.size(); c++)
+        {
+            size_t begin = hardClusters[c], end = hardClusters[c + 1];
+            timestamp += SIMULATED_CACHE_SIZE + 1;
+            size_t clusterMisses = 0;
+            for (size_t i = begin * 3; i < end * 3; i++)
+            {
+                unsigned int v = indices[i];
+                if (timestamp - enteredAt[v] > SIMULATED_CACHE_SIZE)
+                {
+                    enteredAt[v] = timestamp++;
+                    clusterMisses++;
+                }
+            }
+            float clusterACMR = float(clusterMisses) / float(end - begin);
+
+            size_t start = begin;
+            timestamp += SIMULATED_CACHE_SIZE + 1;
+            size_t misses = 0;
+            clusters.push_back(begin);
+            for (size_t t = begin; t < end; t++)
+            {
+                for (int k = 0; k < 3; k++)
+                {
+                    unsigned int v = indices[t * 3 + k];
+                    if (timestamp - enteredAt[v] > SIMULATED_CACHE_SIZE)
+                    {
+                        enteredAt[v] = timestamp++;
+                        misses++;
+                    }
+                }
+                float runningACMR = float(misses) / float(t + 1 - start);
+                if (t + 1 < end && runningACMR <= clusterACMR * threshold)
+                {
+                    // start over with a cold cache, that's what the next cluster sees after sorting
+                    start = t + 1;
+                    timestamp += SIMULATED_CACHE_SIZE + 1;
+                    misses = 0;
+                    clusters.push_back(start);
+                }
+            }
+        }
+        clusters.push_back(triangleCount);
+
+        // area weighted mesh centroid
+        glm::vec3 meshCenter(0.0f);
+        float meshArea = 0.0f;
+        for (size_t t = 0; t < triangleCount; t++)
+        {
+            const glm::vec3& p0 = vertices[indices[t * 3]].Position;
+            const glm::vec3& p1 = vertices[indices[t * 3 + 1]].Position;
+            const glm::vec3& p2 = vertices[indices[t * 3 + 2]].Position;
+            float area = glm::length(glm::cross(p1 - p0, p2 - p0));
+            meshCenter += (p0 + p1 + p2) * (area / 3.0f);
+            meshArea += area;
+        }
+        meshCenter = meshArea > 0.0f ? meshCenter / meshArea : meshCenter;
+
+        // sort key: how far the cluster's centroid lies along its own average normal, seen from the mesh center
+        const size_t clusterCount = clusters.size() - 1;
+        vector<float> sortKey(clusterCount);
+        for (size_t c = 0; c < clusterCount; c++)
+        {
+            glm::vec3 center(0.0f), normal(0.0f);
+            float area = 0.0f;
+            for (size_t t = clusters[c]; t < clusters[c + 1]; t++)
+            {
+                const glm::vec3& p0 = vertices[indices[t * 3]].Position;
+                const glm::vec3& p1 = vertices[indices[t * 3 + 1]].Position;
+                const glm::vec3& p2 = vertices[indices[t * 3 + 2]].Position;
+                glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+                float a = glm::length(n);
+                center += (p0 + p1 + p2) * (a / 3.0f);
+                normal += n;
+                area += a;
+            }
+            center = area > 0.0f ? center / area : center;
+            float length = glm::length(normal);
+            sortKey[c] = length > 0.0f ? glm::dot(center - meshCenter, normal / length) : 0.0f;
+        }
+
+        vector<size_t> order(clusterCount);
+        for (size_t c = 0; c < clusterCount; c++)
+            order[c] = c;
+        std::stable_sort(order.begin(), order.end(), [&sortKey](size_t a, size_t b) { return sortKey[a] > sortKey[b]; });
+
+        vector<unsigned int> result;
+        result.reserve(indices.size());
+        for (size_t c : order)
+            result.insert(result.end(), indices.begin() + clusters[c] * 3, indices.begin() + clusters[c + 1] * 3);
+        indices.swap(result);
+    }
+
+    // renumbers vertices in the order the index buffer first uses them, unreferenced vertices are dropped
+    static void OptimizeVertexFetch(vector<Vertex>& vertices, vector<unsigned int>& indices)
+    {
+        const unsigned int UNUSED = ~0u;
+        vector<unsigned int> remap(vertices.size(), UNUSED);
+        vector<Vertex> reordered;
+        reordered.reserve(vertices.size());
+        for (unsigned int& index : indices)
+        {
+            if (remap[index] == UNUSED)
+            {
+                remap[index] = static_cast<unsigned int>(reordered.size());
+                reordered.push_back(vertices[index]);
+            }
+            index = remap[index];
+        }
+        vertices.swap(reordered);
+    }
+
+private:
+    static uint64_t HashVertex(const Vertex& vertex)
+    {
+        // FNV-1a over the raw bytes
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&vertex);
+        uint64_t hash = 14695981039346656037ull;
+        for (size_t i = 0; i < sizeof(Vertex); i++)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    static float ForsythVertexScore(int cachePosition, unsigned int remainingTriangles)
+    {
+        const float CACHE_DECAY_POWER = 1.5f;
+        const float LAST_TRIANGLE_SCORE = 0.75f;
+        const float VALENCE_BOOST_SCALE = 2.0f;
+        const float VALENCE_BOOST_POWER = 0.5f;
+
+        if (remainingTriangles == 0)
+            return -1.0f; // no triangles left to use it
+
+        float score = 0.0f;
+        if (cachePosition >= 0)
+        {
+            if (cachePosition < 3)
+                score = LAST_TRIANGLE_SCORE; // used by the last triangle, a fixed score so strips aren't favored over fans
+            else
+            {
+                const float scaler = 1.0f / (FORSYTH_CACHE_SIZE - 3);
+                score = std::pow(1.0f - (cachePosition - 3) * scaler, CACHE_DECAY_POWER);
+            }
+        }
+        // bonus for vertices with few triangles left, so lone triangles don't get left behind
+        score += VALENCE_BOOST_SCALE * std::pow(float(remainingTriangles), -VALENCE_BOOST_POWER);
+        return score;
+    }
+
+    static void UpdateVertexScore(unsigned int v, int cachePosition, const vector<unsigned int>& valence, vector<float>& vertexScore,
+        const vector<unsigned int>& adjacencyOffset, const vector<unsigned int>& adjacency, vector<float>& triangleScore)
+    {
+        float score = ForsythVertexScore(cachePosition, valence[v]);
+        float delta = score - vertexScore[v];
+        vertexScore[v] = score;
+        for (unsigned int a = adjacencyOffset[v]; a < adjacencyOffset[v] + valence[v]; a++)
+            triangleScore[adjacency[a]] += delta;
+    }
+};
+#endif
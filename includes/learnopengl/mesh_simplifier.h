@@ -0,0 +1,348 @@
+#ifndef MESH_SIMPLIFIER_H
+#define MESH_SIMPLIFIER_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/index_buffer.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+// Level of detail generation by edge collapse with quadric error metrics (Garland & Heckbert 1997).
+// Every vertex starts with the quadric Q of the planes of its triangles, Q(p) is the sum of squared distances of p to
+// those planes. Collapsing a vertex onto a neighbour adds its quadric to the neighbour's, so sqrt(Q(p)) of the survivor
+// is at least its distance to each (infinite) original plane it now stands for. The largest such value, in model
+// units, is a LOD's error. It is an estimate, not a bound on the distance to the full detail surface: a point can be
+// close to every plane and still away from the triangles that lie in them. On smooth meshes it does stay above the
+// distance measured between a LOD and the full detail surface both ways, which the tests check.
+// Vertices only collapse onto existing vertices, so every LOD indexes the mesh's vertex buffer and just adds indices.
+// Border vertices and vertices sharing their position with another vertex (UV or normal seams) never move, which keeps
+// the outline of open meshes and the seams between attribute islands intact. That also locks vertices that are mere
+// copies of each other, so weld the mesh first (or point the indices at one copy, see MeshOptimizer::FindDuplicateVertices),
+// an unwelded triangle soup has every vertex locked and produces no LODs.
+
+struct MeshLod
+{
+    std::vector<unsigned int> indices;
+    float error = 0.0f;                  // accumulated quadric (vertex to plane) error, in model units
+    std::vector<IndexRange> indexRanges; // where the level lives in the mesh's index buffer, filled in on upload
+};
+
+// picks the coarsest LOD whose error covers less than maxPixelError pixels on screen
+struct LodSelection
+{
+    float pixelsPerUnit = 0.0f; // screen pixels one model unit covers at the mesh's distance
+    float maxPixelError = 1.0f;
+
+    // distance from the camera to the mesh bounds, scale the largest axis scale of the model matrix
+    static LodSelection FromDistance(float distance, float scale, float fovY, float viewportHeight, float maxPixelError = 1.0f)
+    {
+        LodSelection selection;
+        selection.pixelsPerUnit = scale * viewportHeight / (2.0f * std::max(distance, 1e-3f) * std::tan(fovY * 0.5f));
+        selection.maxPixelError = maxPixelError;
+        return selection;
+    }
+
+    // 0 is full detail, level i > 0 is lods[i - 1]. Errors grow along a chain, so the first miss ends the search
+    unsigned int Select(const std::vector<MeshLod>& lods) const
+    {
+        unsigned int level = 0;
+        while (level < lods.size() && lods[level].error * pixelsPerUnit <= maxPixelError)
+            level++;
+        return level;
+    }
+};
+
+class MeshSimplifier
+{
+public:
+    // positions are read as three floats every stride bytes
+    MeshSimplifier(const float* positions, size_t vertexCount, size_t stride, const unsigned int* indices, size_t indexCount)
+        : m_Indices(indices, indices + (indexCount - indexCount % 3)), m_Quadrics(vertexCount), m_Locked(vertexCount, 0)
+    {
+        m_Positions.resize(vertexCount);
+        for (size_t i = 0; i < vertexCount; i++)
+            std::memcpy(&m_Positions[i], reinterpret_cast<const unsigned char*>(positions) + i * stride, sizeof(glm::vec3));
+
+        for (size_t i = 0; i < m_Indices.size(); i += 3)
+        {
+            const glm::vec3& p0 = m_Positions[m_Indices[i]];
+            glm::vec3 normal = glm::cross(m_Positions[m_Indices[i + 1]] - p0, m_Positions[m_Indices[i + 2]] - p0);
+            float length = glm::length(normal);
+            if (length <= 0.0f)
+                continue;
+            Quadric plane = Quadric::FromPlane(normal / length, -glm::dot(normal / length, p0));
+            for (int k = 0; k < 3; k++)
+                m_Quadrics[m_Indices[i + k]].Add(plane);
+        }
+        LockBordersAndSeams();
+    }
+
+    const std::vector<unsigned int>& Indices() const { return m_Indices; }
+    float Error() const { return m_Error; }
+
+    // collapses edges, cheapest first, until at most targetIndexCount indices are left or the next collapse would
+    // exceed maxError. Can be called again with a lower target to continue from the current result
+    void Simplify(size_t targetIndexCount, float maxError)
+    {
+        const size_t targetTriangles = targetIndexCount / 3;
+        while (m_Indices.size() / 3 > targetTriangles)
+        {
+            if (CollapsePass(targetTriangles, maxError) == 0)
+                break;
+        }
+    }
+
+    // every level has about reduction times the triangles of the one before, the chain ends when the error would pass
+    // maxRelativeError times the mesh's bounding box diagonal or a level doesn't get meaningfully smaller
+    static std::vector<MeshLod> BuildLodChain(const float* positions, size_t vertexCount, size_t stride, const std::vector<unsigned int>& indices,
+        unsigned int maxLevels = 4, float reduction = 0.5f, float maxRelativeError = 0.05f)
+    {
+        std::vector<MeshLod> lods;
+        if (vertexCount == 0 || indices.size() < 3)
+            return lods;
+        MeshSimplifier simplifier(positions, vertexCount, stride, indices.data(), indices.size());
+        const float maxError = maxRelativeError * simplifier.Extent();
+
+        size_t previousCount = simplifier.Indices().size();
+        for (unsigned int level = 0; level < maxLevels; level++)
+        {
+            size_t target = static_cast<size_t>(previousCount / 3 * reduction) * 3;
+            simplifier.Simplify(target, maxError);
+            size_t count = simplifier.Indices().size();
+            if (count == 0 || count > previousCount * 0.85f)
+                break;
+            MeshLod lod;
+            lod.indices = simplifier.Indices();
+            lod.error = simplifier.Error();
+            lods.push_back(std::move(lod));
+            previousCount = count;
+        }
+        return lods;
+    }
+
+private:
+    // symmetric 4x4 matrix of the quadric, Q(p) = (p, 1)^T A (p, 1)
+    struct Quadric
+    {
+        double xx = 0, xy = 0, xz = 0, xw = 0, yy = 0, yz = 0, yw = 0, zz = 0, zw = 0, ww = 0;
+
+        static Quadric FromPlane(const glm::vec3& n, float d)
+        {
+            Quadric q;
+            q.xx = double(n.x) * n.x; q.xy = double(n.x) * n.y; q.xz = double(n.x) * n.z; q.xw = double(n.x) * d;
+            q.yy = double(n.y) * n.y; q.yz = double(n.y) * n.z; q.yw = double(n.y) * d;
+            q.zz = double(n.z) * n.z; q.zw = double(n.z) * d;
+            q.ww = double(d) * d;
+            return q;
+        }
+
+        void Add(const Quadric& q)
+        {
+            xx += q.xx; xy += q.xy; xz += q.xz; xw += q.xw;
+            yy += q.yy; yz += q.yz; yw += q.yw;
+            zz += q.zz; zw += q.zw;
+            ww += q.ww;
+        }
+
+        double Evaluate(const glm::vec3& p) const
+        {
+            double x = p.x, y = p.y, z = p.z;
+            double value = xx * x * x + yy * y * y + zz * z * z + ww
+                + 2.0 * (xy * x * y + xz * x * z + yz * y * z + xw * x + yw * y + zw * z);
+            return std::max(value, 0.0); // rounding can push a perfect fit slightly negative
+        }
+    };
+
+    struct Collapse
+    {
+        double cost;
+        unsigned int from;
+        unsigned int to;
+    };
+
+    std::vector<glm::vec3>    m_Positions;
+    std::vector<unsigned int> m_Indices;  // current triangles
+    std::vector<Quadric>      m_Quadrics;
+    std::vector<char>         m_Locked;
+    float                     m_Error = 0.0f;
+
+    float Extent() const
+    {
+        glm::vec3 minimum(m_Positions[0]), maximum(m_Positions[0]);
+        for (const glm::vec3& position : m_Positions)
+        {
+            minimum = glm::min(minimum, position);
+            maximum = glm::max(maximum, position);
+        }
+        return glm::length(maximum - minimum);
+    }
+
+    void LockBordersAndSeams()
+    {
+        // vertices with the same position form one corner of the surface, borders are found between corners.
+        // vertices no triangle uses (e.g. copies the indices were redirected away from) don't make a seam
+        std::vector<unsigned char> referenced(m_Positions.size(), 0);
+        for (unsigned int index : m_Indices)
+            referenced[index] = 1;
+        std::vector<unsigned int> order;
+        order.reserve(m_Positions.size());
+        for (size_t i = 0; i < m_Positions.size(); i++)
+        {
+            if (referenced[i])
+                order.push_back(static_cast<unsigned int>(i));
+        }
+        std::sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b) {
+            const glm::vec3& pa = m_Positions[a];
+            const glm::vec3& pb = m_Positions[b];
+            return pa.x != pb.x ? pa.x < pb.x : pa.y != pb.y ? pa.y < pb.y : pa.z < pb.z;
+        });
+        std::vector<unsigned int> corner(m_Positions.size());
+        for (size_t i = 0, begin = 0; i < order.size(); i++)
+        {
+            if (m_Positions[order[i]] != m_Positions[order[begin]])
+                begin = i;
+            corner[order[i]] = order[begin];
+            if (i > begin)
+                m_Locked[order[i]] = m_Locked[order[begin]] = 1; // several vertices at one position: a seam
+        }
+
+        // an edge between two corners used by anything but exactly two triangles is a border or non-manifold
+        std::unordered_map<uint64_t, unsigned int> edgeUses;
+        for (size_t i = 0; i < m_Indices.size(); i += 3)
+        {
+            for (int k = 0; k < 3; k++)
+                edgeUses[EdgeKey(corner[m_Indices[i + k]], corner[m_Indices[i + (k + 1) % 3]])]++;
+        }
+        for (size_t i = 0; i < m_Indices.size(); i += 3)
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                unsigned int a = m_Indices[i + k], b = m_Indices[i + (k + 1) % 3];
+                if (edgeUses[EdgeKey(corner[a], corner[b])] != 2)
+                    m_Locked[a] = m_Locked[b] = 1;
+            }
+        }
+    }
+
+    static uint64_t EdgeKey(unsigned int a, unsigned int b)
+    {
+        return a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a;
+    }
+
+    // one round of independent collapses, returns how many were made
+    size_t CollapsePass(size_t targetTriangles, float maxError)
+    {
+        const size_t triangleCount = m_Indices.size() / 3;
+        const size_t vertexCount = m_Positions.size();
+
+        // triangles around every vertex
+        std::vector<unsigned int> adjacencyOffset(vertexCount + 1, 0);
+        for (unsigned int index : m_Indices)
+            adjacencyOffset[index + 1]++;
+        for (size_t v = 0; v < vertexCount; v++)
+            adjacencyOffset[v + 1] += adjacencyOffset[v];
+        std::vector<unsigned int> adjacency(m_Indices.size());
+        {
+            std::vector<unsigned int> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+            for (size_t i = 0; i < m_Indices.size(); i++)
+                adjacency[fill[m_Indices[i]]++] = static_cast<unsigned int>(i / 3);
+        }
+
+        // the cheaper direction of every edge that may collapse at all
+        std::vector<uint64_t> edges;
+        edges.reserve(m_Indices.size());
+        for (size_t i = 0; i < m_Indices.size(); i += 3)
+        {
+            for (int k = 0; k < 3; k++)
+                edges.push_back(EdgeKey(m_Indices[i + k], m_Indices[i + (k + 1) % 3]));
+        }
+        std::sort(edges.begin(), edges.end());
+        edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+        std::vector<Collapse> collapses;
+        collapses.reserve(edges.size());
+        for (uint64_t edge : edges)
+        {
+            unsigned int a = static_cast<unsigned int>(edge >> 32), b = static_cast<unsigned int>(edge & 0xffffffffu);
+            if (a == b || (m_Locked[a] && m_Locked[b]))
+                continue;
+            Quadric sum = m_Quadrics[a];
+            sum.Add(m_Quadrics[b]);
+            double toB = m_Locked[a] ? HUGE_VAL : sum.Evaluate(m_Positions[b]);
+            double toA = m_Locked[b] ? HUGE_VAL : sum.Evaluate(m_Positions[a]);
+            collapses.push_back(toB <= toA ? Collapse{ toB, a, b } : Collapse{ toA, b, a });
+        }
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y) { return x.cost < y.cost; });
+
+        // most collapses remove two triangles. A vertex whose surroundings changed this pass waits for the next one,
+        // so every collapse is checked against the current surface
+        const size_t goal = std::max<size_t>(1, (triangleCount - std::min(triangleCount, targetTriangles)) / 2);
+        const double maxCost = double(maxError) * maxError;
+        std::vector<unsigned int> remap(vertexCount);
+        for (size_t v = 0; v < vertexCount; v++)
+            remap[v] = static_cast<unsigned int>(v);
+        std::vector<char> touched(vertexCount, 0);
+        size_t collapsed = 0;
+        for (const Collapse& collapse : collapses)
+        {
+            if (collapsed >= goal || collapse.cost > maxCost)
+                break;
+            if (touched[collapse.from] || touched[collapse.to])
+                continue;
+            if (Flips(collapse.from, collapse.to, adjacency, adjacencyOffset))
+                continue;
+
+            remap[collapse.from] = collapse.to;
+            m_Quadrics[collapse.to].Add(m_Quadrics[collapse.from]);
+            m_Error = std::max(m_Error, static_cast<float>(std::sqrt(collapse.cost)));
+            for (unsigned int a = adjacencyOffset[collapse.from]; a < adjacencyOffset[collapse.from + 1]; a++)
+            {
+                for (int k = 0; k < 3; k++)
+                    touched[m_Indices[adjacency[a] * 3 + k]] = 1;
+            }
+            collapsed++;
+        }
+
+        // drop the triangles that collapsed to a line
+        size_t write = 0;
+        for (size_t i = 0; i < m_Indices.size(); i += 3)
+        {
+            unsigned int a = remap[m_Indices[i]], b = remap[m_Indices[i + 1]], c = remap[m_Indices[i + 2]];
+            if (a == b || b == c || c == a)
+                continue;
+            m_Indices[write++] = a;
+            m_Indices[write++] = b;
+            m_Indices[write++] = c;
+        }
+        m_Indices.resize(write);
+        return collapsed;
+    }
+
+    // whether moving from onto to turns any remaining triangle of from over or squashes it into a sliver
+    bool Flips(unsigned int from, unsigned int to, const std::vector<unsigned int>& adjacency, const std::vector<unsigned int>& adjacencyOffset) const
+    {
+        for (unsigned int a = adjacencyOffset[from]; a < adjacencyOffset[from + 1]; a++)
+        {
+            const unsigned int* triangle = &m_Indices[adjacency[a] * 3];
+            if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+                continue; // degenerates and disappears
+            glm::vec3 before[3], after[3];
+            for (int k = 0; k < 3; k++)
+            {
+                before[k] = m_Positions[triangle[k]];
+                after[k] = triangle[k] == from ? m_Positions[to] : before[k];
+            }
+            glm::vec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+            glm::vec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+            if (glm::dot(normalBefore, normalAfter) < 0.25f * glm::length(normalBefore) * glm::length(normalAfter))
+                return true;
+        }
+        return false;
+    }
+};
+#endif
@@ -0,0 +1,272 @@
+#ifndef MESHLET_H
+#define MESHLET_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/index_buffer.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Meshlets are runs of up to MESHLET_MAX_TRIANGLES consecutive triangles of a mesh's index buffer touching at most
+// MESHLET_MAX_VERTICES vertices. The mesh optimizer already orders triangles by locality, so consecutive runs are
+// compact clusters and no extra index buffer is needed: culling outputs ranges of the existing index buffer.
+// Each meshlet has a bounding sphere for frustum culling and a normal cone for backface culling.
+
+#define MESHLET_MAX_VERTICES 64
+#define MESHLET_MAX_TRIANGLES 124
+
+struct Meshlet
+{
+    unsigned int firstIndex = 0; // into the mesh's index buffer
+    unsigned int indexCount = 0;
+    unsigned int baseVertex = 0; // of the IndexRange the meshlet lies in
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = 0.0f;
+    glm::vec3 coneAxis = glm::vec3(0.0f);
+    float coneCos = 0.0f;        // cosine and sine of the cone's half angle, every face normal is within it of the axis.
+    float coneSin = 1.0f;        // a sine of 1 means the meshlet is never backface culled
+};
+
+// world space culling inputs, planes are (normal, distance) with dot(normal, p) - distance >= 0 inside
+struct MeshletCullParams
+{
+    glm::vec4 planes[6];
+    glm::vec3 cameraPosition = glm::vec3(0.0f);
+    bool frustumCulling = true;
+    bool backfaceCulling = true;
+
+    // from any frustum with Plane faces like the one in entity.h
+    template<typename TFrustum>
+    static MeshletCullParams FromFrustum(const TFrustum& frustum, const glm::vec3& cameraPosition)
+    {
+        MeshletCullParams params;
+        params.planes[0] = glm::vec4(frustum.leftFace.normal, frustum.leftFace.distance);
+        params.planes[1] = glm::vec4(frustum.rightFace.normal, frustum.rightFace.distance);
+        params.planes[2] = glm::vec4(frustum.topFace.normal, frustum.topFace.distance);
+        params.planes[3] = glm::vec4(frustum.bottomFace.normal, frustum.bottomFace.distance);
+        params.planes[4] = glm::vec4(frustum.nearFace.normal, frustum.nearFace.distance);
+        params.planes[5] = glm::vec4(frustum.farFace.normal, frustum.farFace.distance);
+        params.cameraPosition = cameraPosition;
+        return params;
+    }
+};
+
+struct MeshletCullStatistics
+{
+    unsigned int meshlets = 0;
+    unsigned int frustumCulled = 0;
+    unsigned int backfaceCulled = 0;
+    unsigned int visibleTriangles = 0;
+
+    void Add(const MeshletCullStatistics& other)
+    {
+        meshlets += other.meshlets;
+        frustumCulled += other.frustumCulled;
+        backfaceCulled += other.backfaceCulled;
+        visibleTriangles += other.visibleTriangles;
+    }
+};
+
+// surviving meshlets as glMultiDrawElementsBaseVertex arguments, neighbouring meshlets are merged into one range
+struct MeshletDrawList
+{
+    std::vector<GLsizei>     counts;
+    std::vector<const void*> offsets;
+    std::vector<GLint>       baseVertices;
+    std::vector<unsigned int> firstIndices; // same ranges in indices rather than bytes
+
+    void Clear()
+    {
+        counts.clear();
+        offsets.clear();
+        baseVertices.clear();
+        firstIndices.clear();
+    }
+
+    size_t Size() const { return counts.size(); }
+};
+
+class MeshletBuilder
+{
+public:
+    // splits a triangle list into meshlets, never across the 16-bit ranges of the mesh's index buffer
+    template<typename TVertex>
+    static std::vector<Meshlet> Build(const std::vector<TVertex>& vertices, const std::vector<unsigned int>& indices, const std::vector<IndexRange>& ranges)
+    {
+        return Build(vertices.data(), vertices.size(), indices.data(), ranges);
+    }
+
+    // the same for arrays that live elsewhere, e.g. in a memory mapped mesh cache
+    template<typename TVertex>
+    static std::vector<Meshlet> Build(const TVertex* vertices, size_t vertexCount, const unsigned int* indices, const std::vector<IndexRange>& ranges)
+    {
+        std::vector<Meshlet> meshlets;
+        // marks vertices already counted for the current meshlet
+        std::vector<unsigned int> seenBy(vertexCount, ~0u);
+        for (const IndexRange& range : ranges)
+        {
+            Meshlet meshlet;
+            meshlet.firstIndex = range.firstIndex;
+            meshlet.baseVertex = range.baseVertex;
+            unsigned int vertexCount = 0;
+            const unsigned int end = range.firstIndex + range.indexCount;
+            for (unsigned int i = range.firstIndex; i + 3 <= end; i += 3)
+            {
+                unsigned int newVertices = 0;
+                for (int k = 0; k < 3; k++)
+                    newVertices += seenBy[indices[i + k]] != static_cast<unsigned int>(meshlets.size()) ? 1 : 0;
+                if (meshlet.indexCount > 0 && (vertexCount + newVertices > MESHLET_MAX_VERTICES || meshlet.indexCount / 3 >= MESHLET_MAX_TRIANGLES))
+                {
+                    ComputeBounds(meshlet, vertices, indices);
+                    meshlets.push_back(meshlet);
+                    meshlet.firstIndex = i;
+                    meshlet.indexCount = 0;
+                    vertexCount = 0;
+                }
+                for (int k = 0; k < 3; k++)
+                {
+                    unsigned int& seen = seenBy[indices[i + k]];
+                    if (seen != static_cast<unsigned int>(meshlets.size()))
+                    {
+                        seen = static_cast<unsigned int>(meshlets.size());
+                        vertexCount++;
+                    }
+                }
+                meshlet.indexCount += 3;
+            }
+            if (meshlet.indexCount > 0)
+            {
+                ComputeBounds(meshlet, vertices, indices);
+                meshlets.push_back(meshlet);
+            }
+        }
+        return meshlets;
+    }
+
+private:
+    template<typename TVertex>
+    static void ComputeBounds(Meshlet& meshlet, const TVertex* vertices, const unsigned int* indices)
+    {
+        const unsigned int end = meshlet.firstIndex + meshlet.indexCount;
+
+        // sphere around the bounding box center, tight enough for clusters this small
+        glm::vec3 minimum(vertices[indices[meshlet.firstIndex]].Position), maximum(minimum);
+        for (unsigned int i = meshlet.firstIndex; i < end; i++)
+        {
+            minimum = glm::min(minimum, vertices[indices[i]].Position);
+            maximum = glm::max(maximum, vertices[indices[i]].Position);
+        }
+        meshlet.center = (minimum + maximum) * 0.5f;
+        meshlet.radius = 0.0f;
+        for (unsigned int i = meshlet.firstIndex; i < end; i++)
+            meshlet.radius = std::max(meshlet.radius, glm::length(vertices[indices[i]].Position - meshlet.center));
+
+        // normal cone: average face normal and the widest deviation from it
+        meshlet.coneAxis = glm::vec3(0.0f);
+        meshlet.coneCos = 0.0f;
+        meshlet.coneSin = 1.0f;
+        std::vector<glm::vec3> normals;
+        glm::vec3 axis(0.0f);
+        for (unsigned int i = meshlet.firstIndex; i + 3 <= end; i += 3)
+        {
+            const glm::vec3& p0 = vertices[indices[i]].Position;
+            const glm::vec3& p1 = vertices[indices[i + 1]].Position;
+            const glm::vec3& p2 = vertices[indices[i + 2]].Position;
+            glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+            float length = glm::length(normal);
+            if (length <= 0.0f)
+                continue; // degenerate triangles face nowhere
+            normals.push_back(normal / length);
+            axis += normals.back();
+        }
+        float axisLength = glm::length(axis);
+        if (normals.empty() || axisLength <= 0.0f)
+            return;
+        axis /= axisLength;
+        float minDot = 1.0f;
+        for (const glm::vec3& normal : normals)
+            minDot = std::min(minDot, glm::dot(axis, normal));
+
+        // a cone wider than ~84 degrees can't reject anything useful
+        if (minDot <= 0.1f)
+            return;
+        meshlet.coneAxis = axis;
+        meshlet.coneCos = minDot;
+        meshlet.coneSin = std::sqrt(1.0f - minDot * minDot);
+    }
+};
+
+class MeshletCuller
+{
+public:
+    // appends the visible meshlets of a mesh drawn with the given model matrix to drawList
+    static MeshletCullStatistics Cull(const std::vector<Meshlet>& meshlets, const glm::mat4& model, GLenum indexType,
+        const MeshletCullParams& params, MeshletDrawList& drawList)
+    {
+        MeshletCullStatistics stats;
+        stats.meshlets = static_cast<unsigned int>(meshlets.size());
+
+        // spheres grow with the largest axis scale, cone axes use the normal matrix
+        const glm::mat3 linear(model);
+        const glm::mat3 normalMatrix = glm::transpose(glm::inverse(linear));
+        const float scale = std::max(glm::length(linear[0]), std::max(glm::length(linear[1]), glm::length(linear[2])));
+        const size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+
+        for (const Meshlet& meshlet : meshlets)
+        {
+            const glm::vec3 center = glm::vec3(model * glm::vec4(meshlet.center, 1.0f));
+            const float radius = meshlet.radius * scale;
+
+            if (params.frustumCulling && !InFrustum(params, center, radius))
+            {
+                stats.frustumCulled++;
+                continue;
+            }
+            if (params.backfaceCulling && meshlet.coneSin < 1.0f)
+            {
+                // every face is back facing when even the normal closest to the view direction, at angle+half angle from it,
+                // keeps the whole sphere behind its plane: |d| * cos(angle + halfAngle) >= radius
+                glm::vec3 axis = glm::normalize(normalMatrix * meshlet.coneAxis);
+                glm::vec3 toCenter = center - params.cameraPosition;
+                float cosScaled = glm::dot(toCenter, axis);
+                float sinScaled = glm::length(glm::cross(toCenter, axis));
+                if (cosScaled * meshlet.coneCos - sinScaled * meshlet.coneSin >= radius)
+                {
+                    stats.backfaceCulled++;
+                    continue;
+                }
+            }
+
+            stats.visibleTriangles += meshlet.indexCount / 3;
+            size_t last = drawList.Size();
+            if (last > 0 && drawList.baseVertices[last - 1] == static_cast<GLint>(meshlet.baseVertex) &&
+                drawList.firstIndices[last - 1] + drawList.counts[last - 1] == meshlet.firstIndex)
+            {
+                drawList.counts[last - 1] += static_cast<GLsizei>(meshlet.indexCount);
+                continue;
+            }
+            drawList.counts.push_back(static_cast<GLsizei>(meshlet.indexCount));
+            drawList.offsets.push_back(reinterpret_cast<const void*>(meshlet.firstIndex * indexSize));
+            drawList.baseVertices.push_back(static_cast<GLint>(meshlet.baseVertex));
+            drawList.firstIndices.push_back(meshlet.firstIndex);
+        }
+        return stats;
+    }
+
+private:
+    static bool InFrustum(const MeshletCullParams& params, const glm::vec3& center, float radius)
+    {
+        for (int i = 0; i < 6; i++)
+        {
+            if (glm::dot(glm::vec3(params.planes[i]), center) - params.planes[i].w < -radius)
+                return false;
+        }
+        return true;
+    }
+};
+#endif
@@ -10,19 +10,54 @@
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
+#include <learnopengl/instance_buffer.h>
 #include <learnopengl/mesh.h>
+#include <learnopengl/mesh_cache.h>
+#include <learnopengl/mesh_optimizer.h>
 #include <learnopengl/shader.h>
+#include <learnopengl/texture_atlas.h>
+#include <learnopengl/texture_compress.h>
+#include <learnopengl/texture_loader.h>
 
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <map>
+#include <unordered_set>
 #include <vector>
 using namespace std;
 
 unsigned int TextureFromFile(const char *path, const string &directory, bool gamma = false);
 
+// import settings for Model
+struct ModelLoadOptions
+{
+    // store the imported meshes in a binary cache next to the model and reuse them on the next launch
+    bool useMeshCache = true;
+    // decode textures in the background, meshes show a placeholder until they are uploaded
+    AsyncTextureLoader* textureLoader = nullptr;
+    // attributes the shader consumes, meshes upload the intersection with what the file actually provides
+    unsigned int vertexAttributes = VERTEX_ATTRIBUTES_ALL;
+    // texture coordinates as half floats
+    bool halfTexCoords = false;
+    // normals, tangents and bitangents as GL_INT_2_10_10_10_REV
+    bool packedVectors = false;
+    // weld vertices and reorder triangles and vertices for the post-transform cache, overdraw and vertex fetch
+    bool optimizeMeshes = true;
+    // pack the textures of every material whose meshes only use [0, 1] texture coordinates into one atlas per texture type
+    // and remap the UVs, so those meshes share textures and batch together. The atlas is built synchronously from the
+    // source images and isn't stored in the mesh cache, so this also skips the cache
+    bool atlasTextures = false;
+    // split meshes into meshlets with bounding spheres and normal cones, needed by DrawCulled
+    bool buildMeshlets = false;
+    // simplify every mesh into a chain of LODs, needed by DrawLod and stored in the mesh cache
+    bool generateLods = false;
+    // keep CPU copies of every mesh's vertices and indices, e.g. for StaticBatch. Without them meshes read from the
+    // mesh cache are uploaded straight from the mapped file and imported meshes free theirs once the cache is written
+    bool keepMeshData = false;
+};
+
 class Model 
 {
 public:
@@ -31,38 +66,178 @@ public:
     vector<Mesh>    meshes;
     string directory;
     bool gammaCorrection;
+    bool loadedFromCache = false;
+    ModelLoadOptions options;
+    MeshOptimizationStatistics optimizationStats; // summed over all meshes, only filled in when imported through Assimp
+    unordered_set<unsigned int> loadedTextureIDs;
 
     // constructor, expects a filepath to a 3D model.
-    Model(string const &path, bool gamma = false) : gammaCorrection(gamma)
+    Model(string const &path, bool gamma = false, bool useMeshCache = true, AsyncTextureLoader* textureLoader = nullptr) : gammaCorrection(gamma)
+    {
+        options.useMeshCache = useMeshCache;
+        options.textureLoader = textureLoader;
+        loadModel(path);
+    }
+
+    Model(string const &path, const ModelLoadOptions &options, bool gamma = false) : gammaCorrection(gamma), options(options)
     {
         loadModel(path);
     }
 
+    // GPU memory of all vertex and index buffers
+    size_t GetBufferSize() const
+    {
+        size_t size = 0;
+        for(const Mesh& mesh : meshes)
+            size += mesh.GetBufferSize();
+        return size;
+    }
+
+    // GPU memory the same meshes would use with the full 88 byte Vertex layout and 32-bit indices
+    size_t GetFullLayoutBufferSize() const
+    {
+        size_t size = 0;
+        for(const Mesh& mesh : meshes)
+            size += mesh.vertexCount * sizeof(Vertex) + SplitIndexBuffer::CountIndices(mesh.indexRanges) * sizeof(unsigned int);
+        return size;
+    }
+
     // draws the model, and thus all its meshes
     void Draw(Shader &shader)
     {
         for(unsigned int i = 0; i < meshes.size(); i++)
             meshes[i].Draw(shader);
     }
+
+    // draws only the meshlets that are inside the frustum and not facing away from the camera.
+    // model is the matrix the shader's "model" uniform is set to. Falls back to full meshes when no meshlets were built
+    MeshletCullStatistics DrawCulled(Shader &shader, const glm::mat4 &model, const MeshletCullParams &params)
+    {
+        MeshletCullStatistics stats;
+        for(unsigned int i = 0; i < meshes.size(); i++)
+        {
+            if(meshes[i].meshlets.empty())
+            {
+                meshes[i].Draw(shader);
+                continue;
+            }
+            culledRanges.Clear();
+            stats.Add(MeshletCuller::Cull(meshes[i].meshlets, model, meshes[i].indexType, params, culledRanges));
+            meshes[i].DrawRanges(shader, culledRanges);
+        }
+        return stats;
+    }
+
+    // draws every mesh at the coarsest LOD whose error stays below selection.maxPixelError pixels, returns the triangles drawn
+    unsigned int DrawLod(Shader &shader, const LodSelection &selection)
+    {
+        unsigned int triangles = 0;
+        for(unsigned int i = 0; i < meshes.size(); i++)
+        {
+            unsigned int level = selection.Select(meshes[i].lods);
+            meshes[i].DrawLod(shader, level);
+            triangles += meshes[i].GetTriangleCount(level);
+        }
+        return triangles;
+    }
+
+    // draws instanceCount copies of the model in one draw call per mesh (range), the model matrix of every
+    // copy comes from instanceBuffer (attribute locations 7-10, see instance_buffer.h) instead of the "model" uniform
+    void DrawInstanced(Shader &shader, const InstanceBuffer &instanceBuffer, unsigned int instanceCount)
+    {
+        if(instanceCount == 0)
+            return;
+        for(unsigned int i = 0; i < meshes.size(); i++)
+        {
+            if(meshes[i].instanceBufferGeneration != instanceBuffer.Generation())
+            {
+                instanceBuffer.AttachTo(meshes[i].VAO);
+                meshes[i].instanceBufferGeneration = instanceBuffer.Generation();
+            }
+            meshes[i].DrawInstanced(shader, instanceCount);
+        }
+    }
     
 private:
+    MeshletDrawList culledRanges; // reused by DrawCulled every frame
+
+    // texture atlas shared by the materials that qualified for it, see ModelLoadOptions::atlasTextures
+    MaterialAtlas   textureAtlas;
+    vector<int>     atlasMaterials; // atlas material of every scene material, -1 when it keeps its own textures
+    vector<Texture> atlasTextures;  // one per texture type present in the atlas
+
     // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
     void loadModel(string const &path)
     {
+        const unsigned int importFlags = aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace;
+        // retrieve the directory path of the filepath
+        directory = path.substr(0, path.find_last_of('/'));
+
+        // try the binary cache first, it is only valid for the same file, modification time, import flags and vertex layout options
+        MeshCacheKey cacheKey;
+        bool cacheable = options.useMeshCache && !options.atlasTextures && MeshCache::MakeKey(path, importFlags, cacheKey);
+        cacheKey.layoutFlags = options.vertexAttributes | (options.halfTexCoords ? 1u << 16 : 0u) | (options.packedVectors ? 1u << 17 : 0u) | (options.optimizeMeshes ? 1u << 18 : 0u) | (options.generateLods ? 1u << 19 : 0u);
+        if(cacheable && loadFromCache(MeshCache::GetCachePath(path), cacheKey))
+        {
+            loadedFromCache = true;
+            return;
+        }
+
         // read file via ASSIMP
         Assimp::Importer importer;
-        const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+        const aiScene* scene = importer.ReadFile(path, importFlags);
         // check for errors
         if(!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
         {
             cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << endl;
             return;
         }
-        // retrieve the directory path of the filepath
-        directory = path.substr(0, path.find_last_of('/'));
+
+        if(options.atlasTextures)
+            buildTextureAtlas(path, scene);
 
         // process ASSIMP's root node recursively
         processNode(scene->mRootNode, scene);
+
+        if(cacheable && !MeshCache::Write(MeshCache::GetCachePath(path), cacheKey, meshes))
+            cout << "WARNING::MESH_CACHE:: could not write cache for " << path << endl;
+        for(Mesh& mesh : meshes)
+        {
+            if(options.buildMeshlets)
+                mesh.meshlets = MeshletBuilder::Build(mesh.vertices, mesh.indices, mesh.indexRanges);
+            if(!options.keepMeshData)
+                mesh.ReleaseData();
+        }
+    }
+
+    // builds the meshes from a memory mapped cache file, the vertex and index data is uploaded directly from the mapping and
+    // only copied when keepMeshData is set. Meshlets are cheap to build from the final index order, so they aren't stored
+    // in the cache but built from the mapping too
+    bool loadFromCache(string const &cachePath, const MeshCacheKey &key)
+    {
+        MeshCacheReader reader;
+        if(!reader.Open(cachePath, key))
+            return false;
+
+        meshes.reserve(reader.Meshes().size());
+        for(const CachedMeshView& view : reader.Meshes())
+        {
+            vector<Texture> textures;
+            for(const Texture& cached : view.textures)
+                textures.push_back(loadTexture(cached.path.c_str(), cached.type));
+            VertexLayout layout(view.attributeMask, options.halfTexCoords, options.packedVectors);
+            vector<MeshLod> lods(view.lods.size());
+            vector<IndexList> lodIndices(view.lods.size());
+            for(size_t i = 0; i < lods.size(); i++)
+            {
+                lods[i].error = view.lods[i].error;
+                lodIndices[i] = { view.lods[i].indices, view.lods[i].indexCount };
+            }
+            meshes.emplace_back(view.vertices, view.vertexCount, view.indices, view.indexCount, std::move(textures), std::move(layout), std::move(lods), lodIndices, options.keepMeshData);
+            if(options.buildMeshlets)
+                meshes.back().meshlets = MeshletBuilder::Build(view.vertices, view.vertexCount, view.indices, meshes.back().indexRanges);
+        }
+        return true;
     }
 
     // processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
@@ -94,7 +269,7 @@ private:
         // walk through each of the mesh's vertices
         for(unsigned int i = 0; i < mesh->mNumVertices; i++)
         {
-            Vertex vertex;
+            Vertex vertex{}; // value initialized so welding can compare vertices bytewise
             glm::vec3 vector; // we declare a placeholder vector since assimp uses its own vector class that doesn't directly convert to glm's vec3 class so we transfer the data to this placeholder glm::vec3 first.
             // positions
             vector.x = mesh->mVertices[i].x;
@@ -142,30 +317,188 @@ private:
             for(unsigned int j = 0; j < face.mNumIndices; j++)
                 indices.push_back(face.mIndices[j]);        
         }
-        // process materials
-        aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];    
-        // we assume a convention for sampler names in the shaders. Each diffuse texture should be named
-        // as 'texture_diffuseN' where N is a sequential number ranging from 1 to MAX_SAMPLER_NUMBER. 
-        // Same applies to other texture as the following list summarizes:
-        // diffuse: texture_diffuseN
-        // specular: texture_specularN
-        // normal: texture_normalN
-
-        // 1. diffuse maps
-        vector<Texture> diffuseMaps = loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
-        textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
-        // 2. specular maps
-        vector<Texture> specularMaps = loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular");
-        textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
-        // 3. normal maps
-        std::vector<Texture> normalMaps = loadMaterialTextures(material, aiTextureType_HEIGHT, "texture_normal");
-        textures.insert(textures.end(), normalMaps.begin(), normalMaps.end());
-        // 4. height maps
-        std::vector<Texture> heightMaps = loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height");
-        textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
+        // materials packed into the atlas only need their UVs moved into the material's rectangle
+        int atlasMaterial = mesh->mMaterialIndex < atlasMaterials.size() ? atlasMaterials[mesh->mMaterialIndex] : -1;
+        if(atlasMaterial >= 0)
+        {
+            for(Vertex& vertex : vertices)
+                vertex.TexCoords = textureAtlas.RemapUV(vertex.TexCoords, atlasMaterial);
+            textures = atlasTextures;
+        }
+        else
+        {
+            // process materials
+            aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];    
+            // we assume a convention for sampler names in the shaders. Each diffuse texture should be named
+            // as 'texture_diffuseN' where N is a sequential number ranging from 1 to MAX_SAMPLER_NUMBER. 
+            // Same applies to other texture as the following list summarizes:
+            // diffuse: texture_diffuseN
+            // specular: texture_specularN
+            // normal: texture_normalN
+
+            // 1. diffuse maps
+            vector<Texture> diffuseMaps = loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
+            textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
+            // 2. specular maps
+            vector<Texture> specularMaps = loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular");
+            textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
+            // 3. normal maps
+            std::vector<Texture> normalMaps = loadMaterialTextures(material, aiTextureType_HEIGHT, "texture_normal");
+            textures.insert(textures.end(), normalMaps.begin(), normalMaps.end());
+            // 4. height maps
+            std::vector<Texture> heightMaps = loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height");
+            textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
+        }
         
+        if(options.optimizeMeshes)
+            optimizationStats.Add(MeshOptimizer::Optimize(vertices, indices));
+
+        // LODs reuse the vertices, so they are simplified after the vertex order is final
+        vector<MeshLod> lods;
+        if(options.generateLods && !vertices.empty())
+        {
+            // the simplifier treats copies of a vertex as a seam and locks them, so without the welding done by
+            // Optimize it gets indices that point at the first copy only
+            vector<unsigned int> weldedIndices;
+            if(!options.optimizeMeshes)
+            {
+                const vector<unsigned int> first = MeshOptimizer::FindDuplicateVertices(vertices);
+                weldedIndices.reserve(indices.size());
+                for(unsigned int index : indices)
+                    weldedIndices.push_back(first[index]);
+            }
+            lods = MeshSimplifier::BuildLodChain(&vertices[0].Position.x, vertices.size(), sizeof(Vertex), options.optimizeMeshes ? indices : weldedIndices);
+            if(options.optimizeMeshes)
+            {
+                for(MeshLod& lod : lods)
+                    MeshOptimizer::OptimizeVertexCache(lod.indices, vertices.size());
+            }
+        }
+
+        // upload only the attributes the importer produced and the shader consumes
+        unsigned int attributes = VERTEX_ATTRIBUTE_BIT(VERTEX_ATTRIBUTE_POSITION);
+        if(mesh->HasNormals())
+            attributes |= VERTEX_ATTRIBUTE_BIT(VERTEX_ATTRIBUTE_NORMAL);
+        if(mesh->mTextureCoords[0])
+            attributes |= VERTEX_ATTRIBUTE_BIT(VERTEX_ATTRIBUTE_TEXCOORDS);
+        if(mesh->mTextureCoords[0] && mesh->HasTangentsAndBitangents())
+            attributes |= VERTEX_ATTRIBUTE_BIT(VERTEX_ATTRIBUTE_TANGENT) | VERTEX_ATTRIBUTE_BIT(VERTEX_ATTRIBUTE_BITANGENT);
+        VertexLayout layout(attributes & options.vertexAttributes, options.halfTexCoords, options.packedVectors);
+
         // return a mesh object created from the extracted mesh data
-        return Mesh(vertices, indices, textures);
+        return Mesh(std::move(vertices), std::move(indices), std::move(textures), std::move(layout), std::move(lods));
+    }
+
+    // packs the textures of every qualifying material into one atlas per texture type
+    void buildTextureAtlas(string const &path, const aiScene *scene)
+    {
+        struct AtlasLayer
+        {
+            aiTextureType type;
+            const char *name;
+            glm::u8vec4 defaultColor; // what materials without a texture of this type get
+            bool color; // stored as sRGB when gamma corrected
+        };
+        static const AtlasLayer layers[] = {
+            { aiTextureType_DIFFUSE,  "texture_diffuse",  glm::u8vec4(255, 255, 255, 255), true },
+            { aiTextureType_SPECULAR, "texture_specular", glm::u8vec4(0, 0, 0, 255),       false },
+            { aiTextureType_HEIGHT,   "texture_normal",   glm::u8vec4(128, 128, 255, 255), false },
+            { aiTextureType_AMBIENT,  "texture_height",   glm::u8vec4(0, 0, 0, 255),       false },
+        };
+        const size_t layerCount = sizeof(layers) / sizeof(layers[0]);
+
+        // a material qualifies when it has at most one texture of each type and all its meshes keep their UVs in [0, 1]
+        vector<bool> eligible(scene->mNumMaterials, true);
+        for(unsigned int m = 0; m < scene->mNumMaterials; m++)
+        {
+            unsigned int textureCount = 0;
+            for(const AtlasLayer& layer : layers)
+            {
+                unsigned int count = scene->mMaterials[m]->GetTextureCount(layer.type);
+                if(count > 1)
+                    eligible[m] = false;
+                textureCount += count;
+            }
+            if(textureCount == 0)
+                eligible[m] = false;
+        }
+        for(unsigned int i = 0; i < scene->mNumMeshes; i++)
+        {
+            const aiMesh* mesh = scene->mMeshes[i];
+            if(!mesh->mTextureCoords[0] || !MaterialAtlas::CanRemap(reinterpret_cast<const glm::vec2*>(mesh->mTextureCoords[0]), mesh->mNumVertices, sizeof(aiVector3D)))
+                eligible[mesh->mMaterialIndex] = false;
+        }
+
+        vector<AtlasMaterial> materials;
+        vector<unsigned int> sceneMaterials;
+        vector<bool> layerUsed(layerCount, false);
+        for(unsigned int m = 0; m < scene->mNumMaterials; m++)
+        {
+            if(!eligible[m])
+                continue;
+            AtlasMaterial material;
+            material.images.resize(layerCount);
+            for(size_t l = 0; l < layerCount; l++)
+            {
+                if(scene->mMaterials[m]->GetTextureCount(layers[l].type) == 0)
+                    continue;
+                aiString str;
+                scene->mMaterials[m]->GetTexture(layers[l].type, 0, &str);
+                string filename = this->directory + '/' + string(str.C_Str());
+                int width, height, nrComponents;
+                unsigned char *data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
+                if(data)
+                {
+                    material.images[l] = AtlasImage::FromPixels(data, width, height, nrComponents);
+                    layerUsed[l] = true;
+                }
+                else
+                    cout << "Texture failed to load at path: " << str.C_Str() << endl;
+                stbi_image_free(data);
+            }
+            materials.push_back(std::move(material));
+            sceneMaterials.push_back(m);
+        }
+        // with a single material there are no binds to save
+        if(materials.size() < 2)
+            return;
+
+        vector<glm::u8vec4> defaultColors;
+        for(const AtlasLayer& layer : layers)
+            defaultColors.push_back(layer.defaultColor);
+        if(!textureAtlas.Build(materials, defaultColors))
+        {
+            cout << "WARNING::ATLAS:: materials don't fit a " << MaterialAtlas::MAX_SIZE << " atlas, keeping separate textures" << endl;
+            return;
+        }
+
+        atlasMaterials.assign(scene->mNumMaterials, -1);
+        for(size_t i = 0; i < sceneMaterials.size(); i++)
+            atlasMaterials[sceneMaterials[i]] = static_cast<int>(i);
+        for(size_t l = 0; l < layerCount; l++)
+        {
+            if(!layerUsed[l])
+                continue;
+            // the registry owns the atlas textures like any other, and copies of the model share them since the
+            // packing only depends on the source file
+            const bool gamma = gammaCorrection && layers[l].color;
+            Texture texture;
+            texture.handle = TextureRegistry::Instance().Acquire(path + ".atlas." + layers[l].name, gamma, false, [&]()
+            {
+                return textureAtlas.Upload(l, gamma);
+            });
+            texture.id = texture.handle.ID();
+            texture.type = layers[l].name;
+            texture.path = "atlas";
+            atlasTextures.push_back(texture);
+            textures_loaded.push_back(texture);
+        }
+        cout << "Packed " << materials.size() << " of " << scene->mNumMaterials << " materials into a " << textureAtlas.width << "x" << textureAtlas.height
+             << " atlas (" << int(textureAtlas.Density() * 100.0f) << "% used)" << endl;
+
+        // only the rectangles are needed from here on
+        textureAtlas.layerPixels.clear();
+        textureAtlas.layerPixels.shrink_to_fit();
     }
 
     // checks all material textures of a given type and loads the textures if they're not loaded yet.
@@ -177,29 +510,30 @@ private:
         {
             aiString str;
             mat->GetTexture(type, i, &str);
-            // check if texture was loaded before and if so, continue to next iteration: skip loading a new texture
-            bool skip = false;
-            for(unsigned int j = 0; j < textures_loaded.size(); j++)
-            {
-                if(std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0)
-                {
-                    textures.push_back(textures_loaded[j]);
-                    skip = true; // a texture with the same filepath has already been loaded, continue to next one. (optimization)
-                    break;
-                }
-            }
-            if(!skip)
-            {   // if texture hasn't been loaded already, load it
-                Texture texture;
-                texture.id = TextureFromFile(str.C_Str(), this->directory);
-                texture.type = typeName;
-                texture.path = str.C_Str();
-                textures.push_back(texture);
-                textures_loaded.push_back(texture);  // store it as texture loaded for entire model, to ensure we won't unnecessary load duplicate textures.
-            }
+            textures.push_back(loadTexture(str.C_Str(), typeName));
         }
         return textures;
     }
+
+    // loads a single texture relative to the model directory through the shared TextureRegistry,
+    // textures already loaded by this or any other model are reused instead of being decoded again.
+    Texture loadTexture(const char *path, const string &typeName)
+    {
+        Texture texture;
+        AsyncTextureLoader* loader = options.textureLoader;
+        texture.handle = TextureRegistry::Instance().Acquire(this->directory + '/' + string(path), gammaCorrection, loader && loader->Compresses(gammaCorrection), [&]()
+        {
+            if(loader)
+                return loader->Request(path, this->directory, gammaCorrection);
+            return TextureFromFile(path, this->directory, gammaCorrection);
+        }, loader ? loader->PendingQuery() : TextureRegistry::PendingFunction());
+        texture.id = texture.handle.ID();
+        texture.type = typeName;
+        texture.path = path;
+        if(loadedTextureIDs.insert(texture.id).second)
+            textures_loaded.push_back(texture);  // keep a list of every distinct texture used by this model
+        return texture;
+    }
 };
 
 
@@ -215,23 +549,8 @@ unsigned int TextureFromFile(const char *path, const string &directory, bool gam
     unsigned char *data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
     if (data)
     {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
+        // the same formats as streamed textures, gamma corrected color textures are stored as sRGB
+        UploadTexturePixels(textureID, data, width, height, nrComponents, gamma);
         stbi_image_free(data);
     }
     else
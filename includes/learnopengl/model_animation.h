@@ -12,12 +12,14 @@
 
 #include <learnopengl/mesh.h>
 #include <learnopengl/shader.h>
+#include <learnopengl/texture_loader.h>
 
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <map>
+#include <unordered_set>
 #include <vector>
 #include <learnopengl/assimp_glm_helpers.h>
 #include <learnopengl/animdata.h>
@@ -32,11 +34,14 @@ public:
     vector<Mesh>    meshes;
     string directory;
     bool gammaCorrection;
+    AsyncTextureLoader* textureLoader;
+    unordered_set<unsigned int> loadedTextureIDs;
 	
 	
 
     // constructor, expects a filepath to a 3D model.
-    Model(string const &path, bool gamma = false) : gammaCorrection(gamma)
+    // with a textureLoader textures are decoded in the background and show a placeholder until they are uploaded.
+    Model(string const &path, bool gamma = false, AsyncTextureLoader* textureLoader = nullptr) : gammaCorrection(gamma), textureLoader(textureLoader)
     {
         loadModel(path);
     }
@@ -252,26 +257,20 @@ private:
         {
             aiString str;
             mat->GetTexture(type, i, &str);
-            // check if texture was loaded before and if so, continue to next iteration: skip loading a new texture
-            bool skip = false;
-            for(unsigned int j = 0; j < textures_loaded.size(); j++)
+            // textures already loaded by this or any other model are shared through the TextureRegistry
+            Texture texture;
+            texture.handle = TextureRegistry::Instance().Acquire(this->directory + '/' + string(str.C_Str()), gammaCorrection, textureLoader && textureLoader->Compresses(gammaCorrection), [&]()
             {
-                if(std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0)
-                {
-                    textures.push_back(textures_loaded[j]);
-                    skip = true; // a texture with the same filepath has already been loaded, continue to next one. (optimization)
-                    break;
-                }
-            }
-            if(!skip)
-            {   // if texture hasn't been loaded already, load it
-                Texture texture;
-                texture.id = TextureFromFile(str.C_Str(), this->directory);
-                texture.type = typeName;
-                texture.path = str.C_Str();
-                textures.push_back(texture);
-                textures_loaded.push_back(texture);  // store it as texture loaded for entire model, to ensure we won't unnecessary load duplicate textures.
-            }
+                if(textureLoader)
+                    return textureLoader->Request(str.C_Str(), this->directory, gammaCorrection);
+                return TextureFromFile(str.C_Str(), this->directory, gammaCorrection);
+            }, textureLoader ? textureLoader->PendingQuery() : TextureRegistry::PendingFunction());
+            texture.id = texture.handle.ID();
+            texture.type = typeName;
+            texture.path = str.C_Str();
+            textures.push_back(texture);
+            if(loadedTextureIDs.insert(texture.id).second)
+                textures_loaded.push_back(texture);  // keep a list of every distinct texture used by this model
         }
         return textures;
     }
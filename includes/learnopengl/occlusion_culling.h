@@ -0,0 +1,305 @@
+#ifndef OCCLUSION_CULLING_H
+#define OCCLUSION_CULLING_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/frustum_culling.h>
+#include <learnopengl/job_system.h>
+#include <learnopengl/simd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Software occlusion culling. A few large occluders are rasterized on the CPU into a small depth buffer, and the
+// bounding boxes of other objects are tested against a hierarchical-Z (Hi-Z) pyramid built from it, so objects behind
+// a mountain are skipped before they cost a draw call.
+//
+// The buffer stores 1/w, which is linear in screen space and keeps its precision far away; 0 is empty, larger is
+// nearer. Rasterization is tiled: triangles are set up and binned to the screen tiles they touch, then every tile is
+// filled on its own, SIMD_LANES pixels at a time, so tiles can run in parallel on a JobSystem. Hi-Z level k holds the
+// farthest depth of every 2^k x 2^k pixel block.
+//
+// Occluders are sampled at pixel centers, so they should lie inside the geometry they stand for, e.g. a coarse
+// terrain through the lowest heights of the cells around every vertex. They are solid from both sides, so an occluder
+// that only hides things from one side, like a terrain seen from below, has to be left out of such frames; Rasterize
+// without occluders clears the buffer and every box is visible. Box tests only ever err toward visible: boxes that
+// cross the near plane or leave the screen count as visible.
+class OcclusionCuller
+{
+public:
+    // width and tileWidth are rounded up to multiples of 8, the widest SIMD lane count
+    OcclusionCuller(int width = 256, int height = 128, int tileWidth = 64, int tileHeight = 32)
+    {
+        m_Width = (std::max(width, 8) + 7) / 8 * 8;
+        m_Height = std::max(height, 1);
+        m_TileWidth = std::min((std::max(tileWidth, 8) + 7) / 8 * 8, m_Width);
+        m_TileHeight = std::min(std::max(tileHeight, 1), m_Height);
+        m_TilesX = (m_Width + m_TileWidth - 1) / m_TileWidth;
+        m_TilesY = (m_Height + m_TileHeight - 1) / m_TileHeight;
+        m_Bins.resize(m_TilesX * m_TilesY);
+
+        m_HiZ.emplace_back(m_Width * m_Height, 0.0f);
+        m_LevelWidth.push_back(m_Width);
+        m_LevelHeight.push_back(m_Height);
+        while (m_LevelWidth.back() > 1 || m_LevelHeight.back() > 1)
+        {
+            const int levelWidth = (m_LevelWidth.back() + 1) / 2;
+            const int levelHeight = (m_LevelHeight.back() + 1) / 2;
+            m_HiZ.emplace_back(levelWidth * levelHeight, 0.0f);
+            m_LevelWidth.push_back(levelWidth);
+            m_LevelHeight.push_back(levelHeight);
+        }
+    }
+
+    // clears the occluders, viewProjection maps world space to clip space for this frame
+    void BeginFrame(const glm::mat4& viewProjection)
+    {
+        m_ViewProjection = viewProjection;
+        m_Triangles.clear();
+        for (std::vector<uint32_t>& bin : m_Bins)
+            bin.clear();
+    }
+
+    // transforms, clips and bins a triangle list, nothing is rasterized until Rasterize
+    void AddOccluder(const glm::vec3* positions, size_t vertexCount, const uint32_t* indices, size_t indexCount, const glm::mat4& model)
+    {
+        const glm::mat4 transform = m_ViewProjection * model;
+        m_Clip.resize(vertexCount);
+        for (size_t i = 0; i < vertexCount; i++)
+            m_Clip[i] = transform * glm::vec4(positions[i], 1.0f);
+
+        for (size_t i = 0; i + 2 < indexCount; i += 3)
+        {
+            const glm::vec4 a = m_Clip[indices[i]], b = m_Clip[indices[i + 1]], c = m_Clip[indices[i + 2]];
+            // entirely outside one side of the view volume
+            if ((a.x > a.w && b.x > b.w && c.x > c.w) || (a.x < -a.w && b.x < -b.w && c.x < -c.w) ||
+                (a.y > a.w && b.y > b.w && c.y > c.w) || (a.y < -a.w && b.y < -b.w && c.y < -c.w) ||
+                (a.z > a.w && b.z > b.w && c.z > c.w))
+                continue;
+
+            // clip against the near plane z >= -w, which turns the triangle into a polygon of up to 4 vertices
+            const glm::vec4 input[3] = { a, b, c };
+            glm::vec4 polygon[4];
+            int count = 0;
+            for (int v = 0; v < 3; v++)
+            {
+                const glm::vec4& current = input[v];
+                const glm::vec4& next = input[(v + 1) % 3];
+                const float currentDistance = current.z + current.w, nextDistance = next.z + next.w;
+                if (currentDistance >= 0.0f)
+                    polygon[count++] = current;
+                if ((currentDistance >= 0.0f) != (nextDistance >= 0.0f))
+                    polygon[count++] = current + (next - current) * (currentDistance / (currentDistance - nextDistance));
+            }
+            for (int v = 1; v + 1 < count; v++)
+                SetupTriangle(polygon[0], polygon[v], polygon[v + 1]);
+        }
+    }
+
+    // fills the depth buffer from the binned triangles and builds the Hi-Z levels
+    void Rasterize(JobSystem* jobs = nullptr)
+    {
+        const int tileCount = m_TilesX * m_TilesY;
+        auto rasterizeTiles = [this](size_t begin, size_t end)
+        {
+            for (size_t tile = begin; tile < end; tile++)
+                RasterizeTile(static_cast<int>(tile));
+        };
+        if (jobs)
+            jobs->ParallelFor(tileCount, 1, rasterizeTiles);
+        else
+            rasterizeTiles(0, tileCount);
+
+        for (size_t level = 1; level < m_HiZ.size(); level++)
+        {
+            const std::vector<float>& source = m_HiZ[level - 1];
+            const int sourceWidth = m_LevelWidth[level - 1], sourceHeight = m_LevelHeight[level - 1];
+            std::vector<float>& target = m_HiZ[level];
+            for (int y = 0; y < m_LevelHeight[level]; y++)
+                for (int x = 0; x < m_LevelWidth[level]; x++)
+                {
+                    const int x0 = 2 * x, y0 = 2 * y;
+                    const int x1 = std::min(x0 + 1, sourceWidth - 1), y1 = std::min(y0 + 1, sourceHeight - 1);
+                    target[y * m_LevelWidth[level] + x] = std::min(std::min(source[y0 * sourceWidth + x0], source[y0 * sourceWidth + x1]),
+                                                                   std::min(source[y1 * sourceWidth + x0], source[y1 * sourceWidth + x1]));
+                }
+        }
+    }
+
+    // false when the box is behind the occluders everywhere it covers
+    bool IsVisible(const glm::vec3& center, const glm::vec3& extents) const
+    {
+        float minX = std::numeric_limits<float>::max(), minY = std::numeric_limits<float>::max();
+        float maxX = -std::numeric_limits<float>::max(), maxY = -std::numeric_limits<float>::max();
+        float nearest = 0.0f;
+        for (int corner = 0; corner < 8; corner++)
+        {
+            const glm::vec3 sign((corner & 1) ? 1.0f : -1.0f, (corner & 2) ? 1.0f : -1.0f, (corner & 4) ? 1.0f : -1.0f);
+            const glm::vec4 clip = m_ViewProjection * glm::vec4(center + sign * extents, 1.0f);
+            if (clip.z < -clip.w || clip.w <= 0.0f)
+                return true;
+            const float inverseW = 1.0f / clip.w;
+            const float x = (clip.x * inverseW * 0.5f + 0.5f) * m_Width;
+            const float y = (clip.y * inverseW * 0.5f + 0.5f) * m_Height;
+            minX = std::min(minX, x);
+            maxX = std::max(maxX, x);
+            minY = std::min(minY, y);
+            maxY = std::max(maxY, y);
+            nearest = std::max(nearest, inverseW);
+        }
+        if (maxX < 0.0f || maxY < 0.0f || minX >= m_Width || minY >= m_Height)
+            return true;
+
+        int x0 = static_cast<int>(std::max(minX, 0.0f)), x1 = static_cast<int>(std::min(maxX, m_Width - 1.0f));
+        int y0 = static_cast<int>(std::max(minY, 0.0f)), y1 = static_cast<int>(std::min(maxY, m_Height - 1.0f));
+        // the finest level where the box covers at most 4 x 4 texels
+        size_t level = 0;
+        while (level + 1 < m_HiZ.size() && ((x1 >> level) - (x0 >> level) >= 4 || (y1 >> level) - (y0 >> level) >= 4))
+            level++;
+        x0 >>= level;
+        x1 >>= level;
+        y0 >>= level;
+        y1 >>= level;
+
+        const std::vector<float>& depth = m_HiZ[level];
+        const int levelWidth = m_LevelWidth[level];
+        for (int y = y0; y <= y1; y++)
+            for (int x = x0; x <= x1; x++)
+                if (nearest >= depth[y * levelWidth + x])
+                    return true;
+        return false;
+    }
+
+    // removes the indices of the boxes that are occluded from visible, e.g. the output of FrustumCuller::Cull
+    size_t Cull(const PackedAABBs& boxes, std::vector<uint32_t>& visible) const
+    {
+        size_t count = 0;
+        for (uint32_t index : visible)
+            if (IsVisible(boxes.GetCenter(index), boxes.GetExtents(index)))
+                visible[count++] = index;
+        visible.resize(count);
+        return count;
+    }
+
+    int GetWidth() const { return m_Width; }
+    int GetHeight() const { return m_Height; }
+    // 1/w per pixel, rows from the bottom of the screen
+    const float* GetDepth() const { return m_HiZ[0].data(); }
+    // triangles after clipping that reached the rasterizer this frame
+    size_t GetTriangleCount() const { return m_Triangles.size(); }
+
+private:
+    // edge functions and the depth plane of a screen space triangle, evaluated at pixel centers
+    struct RasterTriangle
+    {
+        float edgeA[3], edgeB[3], edgeC[3];
+        float depthA, depthB, depthC;
+        int minX, minY, maxX, maxY;
+    };
+
+    int m_Width, m_Height;
+    int m_TileWidth, m_TileHeight;
+    int m_TilesX, m_TilesY;
+    glm::mat4 m_ViewProjection = glm::mat4(1.0f);
+    std::vector<glm::vec4> m_Clip;
+    std::vector<RasterTriangle> m_Triangles;
+    std::vector<std::vector<uint32_t>> m_Bins; // triangles per tile
+    std::vector<std::vector<float>> m_HiZ;     // level 0 is the depth buffer
+    std::vector<int> m_LevelWidth, m_LevelHeight;
+
+    void SetupTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c)
+    {
+        glm::vec3 screen[3];
+        const glm::vec4* clip[3] = { &a, &b, &c };
+        for (int v = 0; v < 3; v++)
+        {
+            const float inverseW = 1.0f / clip[v]->w;
+            screen[v] = glm::vec3((clip[v]->x * inverseW * 0.5f + 0.5f) * m_Width, (clip[v]->y * inverseW * 0.5f + 0.5f) * m_Height, inverseW);
+        }
+        float area = (screen[1].x - screen[0].x) * (screen[2].y - screen[0].y) - (screen[1].y - screen[0].y) * (screen[2].x - screen[0].x);
+        if (!(std::abs(area) > 1e-6f))
+            return;
+        // occluders are solid from both sides, so clockwise triangles are turned around instead of culled
+        if (area < 0.0f)
+        {
+            std::swap(screen[1], screen[2]);
+            area = -area;
+        }
+
+        RasterTriangle triangle;
+        const float minX = std::min(std::min(screen[0].x, screen[1].x), screen[2].x);
+        const float maxX = std::max(std::max(screen[0].x, screen[1].x), screen[2].x);
+        const float minY = std::min(std::min(screen[0].y, screen[1].y), screen[2].y);
+        const float maxY = std::max(std::max(screen[0].y, screen[1].y), screen[2].y);
+        // pixel x is covered when its center x + 0.5 is inside
+        triangle.minX = static_cast<int>(std::ceil(std::max(minX - 0.5f, 0.0f)));
+        triangle.maxX = static_cast<int>(std::floor(std::min(maxX - 0.5f, m_Width - 1.0f)));
+        triangle.minY = static_cast<int>(std::ceil(std::max(minY - 0.5f, 0.0f)));
+        triangle.maxY = static_cast<int>(std::floor(std::min(maxY - 0.5f, m_Height - 1.0f)));
+        if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+            return;
+
+        for (int e = 0; e < 3; e++)
+        {
+            const glm::vec3& from = screen[e];
+            const glm::vec3& to = screen[(e + 1) % 3];
+            triangle.edgeA[e] = from.y - to.y;
+            triangle.edgeB[e] = to.x - from.x;
+            triangle.edgeC[e] = -(triangle.edgeA[e] * from.x + triangle.edgeB[e] * from.y);
+        }
+        const glm::vec3 d1 = screen[1] - screen[0], d2 = screen[2] - screen[0];
+        triangle.depthA = (d1.z * d2.y - d2.z * d1.y) / area;
+        triangle.depthB = (d2.z * d1.x - d1.z * d2.x) / area;
+        triangle.depthC = screen[0].z - triangle.depthA * screen[0].x - triangle.depthB * screen[0].y;
+
+        const uint32_t index = static_cast<uint32_t>(m_Triangles.size());
+        m_Triangles.push_back(triangle);
+        for (int tileY = triangle.minY / m_TileHeight; tileY <= triangle.maxY / m_TileHeight; tileY++)
+            for (int tileX = triangle.minX / m_TileWidth; tileX <= triangle.maxX / m_TileWidth; tileX++)
+                m_Bins[tileY * m_TilesX + tileX].push_back(index);
+    }
+
+    void RasterizeTile(int tile)
+    {
+        const int tileMinX = (tile % m_TilesX) * m_TileWidth, tileMinY = (tile / m_TilesX) * m_TileHeight;
+        const int tileMaxX = std::min(tileMinX + m_TileWidth, m_Width) - 1, tileMaxY = std::min(tileMinY + m_TileHeight, m_Height) - 1;
+        float* depth = m_HiZ[0].data();
+        for (int y = tileMinY; y <= tileMaxY; y++)
+            std::fill(depth + y * m_Width + tileMinX, depth + y * m_Width + tileMaxX + 1, 0.0f);
+
+        static const float laneOffsets[8] = { 0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f };
+        const SimdFloat offsets = SimdFloat::Load(laneOffsets);
+        for (uint32_t index : m_Bins[tile])
+        {
+            const RasterTriangle& triangle = m_Triangles[index];
+            // whole lane groups, tiles start on a multiple of the lane count
+            const int minX = std::max(triangle.minX, tileMinX) / SimdFloat::Width * SimdFloat::Width;
+            const int maxX = std::min(triangle.maxX, tileMaxX);
+            const int minY = std::max(triangle.minY, tileMinY), maxY = std::min(triangle.maxY, tileMaxY);
+            const SimdFloat edgeA0 = SimdFloat::Set(triangle.edgeA[0]), edgeA1 = SimdFloat::Set(triangle.edgeA[1]), edgeA2 = SimdFloat::Set(triangle.edgeA[2]);
+            const SimdFloat depthA = SimdFloat::Set(triangle.depthA);
+            for (int y = minY; y <= maxY; y++)
+            {
+                const float centerY = y + 0.5f;
+                const SimdFloat row0 = SimdFloat::Set(triangle.edgeB[0] * centerY + triangle.edgeC[0]);
+                const SimdFloat row1 = SimdFloat::Set(triangle.edgeB[1] * centerY + triangle.edgeC[1]);
+                const SimdFloat row2 = SimdFloat::Set(triangle.edgeB[2] * centerY + triangle.edgeC[2]);
+                const SimdFloat rowDepth = SimdFloat::Set(triangle.depthB * centerY + triangle.depthC);
+                float* pixels = depth + y * m_Width;
+                for (int x = minX; x <= maxX; x += SimdFloat::Width)
+                {
+                    const SimdFloat centerX = SimdFloat::Set(static_cast<float>(x)) + offsets;
+                    const SimdFloat inside = SimdFloat::Min(SimdFloat::Min(edgeA0 * centerX + row0, edgeA1 * centerX + row1), edgeA2 * centerX + row2);
+                    const SimdFloat stored = SimdFloat::Load(pixels + x);
+                    SimdFloat::IfNegative(inside, stored, SimdFloat::Max(stored, depthA * centerX + rowDepth)).Store(pixels + x);
+                }
+            }
+        }
+    }
+};
+
+#endif
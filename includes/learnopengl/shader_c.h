@@ -4,6 +4,8 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include <learnopengl/shader_cache.h>
+
 #include <string>
 #include <fstream>
 #include <sstream>
@@ -13,9 +15,9 @@ class ComputeShader
 {
 public:
     unsigned int ID;
-    // constructor generates the shader on the fly
+    // constructor generates the shader on the fly, with a cache the linked program is reused from an earlier run
     // ------------------------------------------------------------------------
-    ComputeShader(const char* computePath)
+    ComputeShader(const char* computePath, ShaderCache* cache = nullptr)
     {
         // 1. retrieve the vertex/fragment source code from filePath
         std::string computeCode;
@@ -39,6 +41,13 @@ public:
         {
             std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.what() << std::endl;
         }
+        uint64_t cacheKey = 0;
+        if (cache)
+        {
+            cacheKey = cache->GetKey({ { GL_COMPUTE_SHADER, computeCode } });
+            if (cache->Load(cacheKey, ID))
+                return;
+        }
         const char* cShaderCode = computeCode.c_str();
         // 2. compile shaders
         unsigned int compute;
@@ -51,8 +60,12 @@ public:
         // shader Program
         ID = glCreateProgram();
         glAttachShader(ID, compute);
+        if (cache)
+            cache->PrepareLink(ID);
         glLinkProgram(ID);
         checkCompileErrors(ID, "PROGRAM");
+        if (cache)
+            cache->Store(cacheKey, ID);
         // delete the shaders as they're linked into our program now and no longer necessary
         glDeleteShader(compute);
     }
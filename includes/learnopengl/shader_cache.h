@@ -0,0 +1,271 @@
+#ifndef SHADER_CACHE_H
+#define SHADER_CACHE_H
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+// On disk cache of linked program binaries (glGetProgramBinary / glProgramBinary), so a program only has to be compiled
+// from GLSL the first time it is used with a driver.
+//
+// A program is identified by a 64 bit FNV-1a hash over every stage type and source, the defines and the driver
+// (vendor, renderer, version). Each program is stored in its own file in the cache directory, named after the key.
+//
+// File layout (little endian):
+//   ShaderCacheHeader
+//   program binary (binaryLength bytes)
+// A cache file is only used when the stored key and version match and the binary checksum is right. A binary the driver
+// rejects (e.g. after a driver update that kept the version string) is deleted and the program compiled again.
+//
+// Program binaries are core since GL 4.1, on older contexts the cache stays disabled and every program is compiled.
+
+#define SHADER_CACHE_VERSION 1
+
+struct ShaderCacheHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t key;
+    uint32_t binaryFormat;
+    uint32_t binaryLength;
+    uint64_t checksum; // of the binary
+};
+
+struct ProgramBinary
+{
+    uint32_t format = 0;
+    std::vector<unsigned char> data;
+};
+
+// one stage of a program, type is the GL shader type (GL_VERTEX_SHADER, ...)
+struct ShaderStageSource
+{
+    uint32_t type;
+    const std::string& source;
+};
+
+class ShaderCache
+{
+public:
+    // needs a current context, the driver strings become part of every key
+    explicit ShaderCache(const std::string& directory) : m_Directory(directory)
+    {
+        m_Driver = GetDriverString();
+        GLint formats = 0;
+        if (GLAD_GL_VERSION_4_1 && glProgramBinary && glGetProgramBinary)
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        m_Supported = formats > 0;
+        if (m_Supported)
+        {
+            std::error_code error;
+            std::filesystem::create_directories(m_Directory, error);
+        }
+    }
+
+    bool IsSupported() const { return m_Supported; }
+
+    // programs created from a cached binary and programs that had to be compiled
+    unsigned int GetHits() const { return m_Hits; }
+    unsigned int GetMisses() const { return m_Misses; }
+
+    // --- GL free part ------------------------------------------------------------------------------------------------
+
+    // 64 bit FNV-1a, continue a hash by passing it as seed
+    static uint64_t Hash(const void* data, size_t size, uint64_t seed = 14695981039346656037ull)
+    {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        uint64_t hash = seed;
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    // every string is hashed with its length in front, so moving text from one stage to the next changes the key
+    static uint64_t MakeKey(std::initializer_list<ShaderStageSource> stages, const std::string& defines, const std::string& driver)
+    {
+        uint64_t hash = Hash(nullptr, 0);
+        for (const ShaderStageSource& stage : stages)
+        {
+            hash = Hash(&stage.type, sizeof(stage.type), hash);
+            hash = HashString(stage.source, hash);
+        }
+        hash = HashString(defines, hash);
+        return HashString(driver, hash);
+    }
+
+    static std::string GetFileName(uint64_t key)
+    {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.glprogram", static_cast<unsigned long long>(key));
+        return name;
+    }
+
+    static bool Write(const std::string& cachePath, uint64_t key, const ProgramBinary& binary)
+    {
+        ShaderCacheHeader header;
+        std::memcpy(header.magic, "LGPB", 4);
+        header.version = SHADER_CACHE_VERSION;
+        header.key = key;
+        header.binaryFormat = binary.format;
+        header.binaryLength = static_cast<uint32_t>(binary.data.size());
+        header.checksum = Hash(binary.data.data(), binary.data.size());
+
+        // write to a temporary file and rename so a crash never leaves a half written binary
+        const std::string tempPath = cachePath + ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if (!file)
+                return false;
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(binary.data.data()), binary.data.size());
+            if (!file)
+                return false;
+        }
+
+        std::error_code error;
+        std::filesystem::rename(tempPath, cachePath, error);
+        if (error)
+        {
+            std::filesystem::remove(tempPath, error);
+            return false;
+        }
+        return true;
+    }
+
+    // false if there is no file or it doesn't belong to key, is from another cache version, truncated or corrupt
+    static bool Read(const std::string& cachePath, uint64_t key, ProgramBinary& binary)
+    {
+        std::ifstream file(cachePath, std::ios::binary | std::ios::ate);
+        if (!file)
+            return false;
+        const std::streamoff size = file.tellg();
+        if (size < static_cast<std::streamoff>(sizeof(ShaderCacheHeader)))
+            return false;
+        file.seekg(0);
+
+        ShaderCacheHeader header;
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (!file || std::memcmp(header.magic, "LGPB", 4) != 0 || header.version != SHADER_CACHE_VERSION || header.key != key ||
+            header.binaryLength == 0 || size != static_cast<std::streamoff>(sizeof(header) + header.binaryLength))
+            return false;
+
+        binary.format = header.binaryFormat;
+        binary.data.resize(header.binaryLength);
+        file.read(reinterpret_cast<char*>(binary.data.data()), header.binaryLength);
+        return file && Hash(binary.data.data(), binary.data.size()) == header.checksum;
+    }
+
+    // --- GL part -----------------------------------------------------------------------------------------------------
+
+    static std::string GetDriverString()
+    {
+        std::string driver;
+        for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+        {
+            const GLubyte* value = glGetString(name);
+            if (value)
+                driver += reinterpret_cast<const char*>(value);
+            driver += '\n';
+        }
+        return driver;
+    }
+
+    uint64_t GetKey(std::initializer_list<ShaderStageSource> stages, const std::string& defines = "") const
+    {
+        return MakeKey(stages, defines, m_Driver);
+    }
+
+    std::string GetCachePath(uint64_t key) const
+    {
+        return (std::filesystem::path(m_Directory) / GetFileName(key)).string();
+    }
+
+    // Creates program from the cached binary of key. Returns false, and leaves program alone, if there is none or the
+    // driver rejects it, then the caller compiles the program and hands it to Store.
+    bool Load(uint64_t key, unsigned int& program)
+    {
+        if (!m_Supported)
+            return false;
+        const std::string cachePath = GetCachePath(key);
+        ProgramBinary binary;
+        if (!Read(cachePath, key, binary))
+        {
+            m_Misses++;
+            return false;
+        }
+
+        GLuint id = glCreateProgram();
+        glProgramBinary(id, binary.format, binary.data.data(), static_cast<GLsizei>(binary.data.size()));
+        // an unknown format is a GL_INVALID_ENUM, don't leave it for the next glGetError of the application
+        while (glGetError() != GL_NO_ERROR) {}
+        GLint success = GL_FALSE;
+        glGetProgramiv(id, GL_LINK_STATUS, &success);
+        if (!success)
+        {
+            glDeleteProgram(id);
+            std::error_code error;
+            std::filesystem::remove(cachePath, error);
+            m_Misses++;
+            return false;
+        }
+        program = id;
+        m_Hits++;
+        return true;
+    }
+
+    // call between attaching the shaders and glLinkProgram, some drivers only keep a binary when asked to
+    void PrepareLink(unsigned int program) const
+    {
+        if (m_Supported)
+            glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
+    // stores the binary of a freshly linked program under key, programs that failed to link are not stored
+    bool Store(uint64_t key, unsigned int program) const
+    {
+        if (!m_Supported)
+            return false;
+        GLint success = GL_FALSE;
+        GLint length = 0;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (!success || length <= 0)
+            return false;
+
+        ProgramBinary binary;
+        binary.data.resize(length);
+        GLenum format = 0;
+        GLsizei written = 0;
+        glGetProgramBinary(program, length, &written, &format, binary.data.data());
+        if (written <= 0)
+            return false;
+        binary.data.resize(written);
+        binary.format = format;
+        return Write(GetCachePath(key), key, binary);
+    }
+
+private:
+    std::string m_Directory;
+    std::string m_Driver;
+    bool m_Supported = false;
+    unsigned int m_Hits = 0;
+    unsigned int m_Misses = 0;
+
+    static uint64_t HashString(const std::string& str, uint64_t hash)
+    {
+        const uint64_t length = str.size();
+        hash = Hash(&length, sizeof(length), hash);
+        return Hash(str.data(), str.size(), hash);
+    }
+};
+#endif
@@ -4,6 +4,8 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include <learnopengl/shader_cache.h>
+
 #include <string>
 #include <fstream>
 #include <sstream>
@@ -13,9 +15,9 @@ class Shader
 {
 public:
     unsigned int ID;
-    // constructor generates the shader on the fly
+    // constructor generates the shader on the fly, with a cache the linked program is reused from an earlier run
     // ------------------------------------------------------------------------
-    Shader(const char* vertexPath, const char* fragmentPath)
+    Shader(const char* vertexPath, const char* fragmentPath, ShaderCache* cache = nullptr)
     {
         // 1. retrieve the vertex/fragment source code from filePath
         std::string vertexCode;
@@ -45,6 +47,13 @@ public:
         {
             std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.what() << std::endl;
         }
+        uint64_t cacheKey = 0;
+        if (cache)
+        {
+            cacheKey = cache->GetKey({ { GL_VERTEX_SHADER, vertexCode }, { GL_FRAGMENT_SHADER, fragmentCode } });
+            if (cache->Load(cacheKey, ID))
+                return;
+        }
         const char* vShaderCode = vertexCode.c_str();
         const char * fShaderCode = fragmentCode.c_str();
         // 2. compile shaders
@@ -63,8 +72,12 @@ public:
         ID = glCreateProgram();
         glAttachShader(ID, vertex);
         glAttachShader(ID, fragment);
+        if (cache)
+            cache->PrepareLink(ID);
         glLinkProgram(ID);
         checkCompileErrors(ID, "PROGRAM");
+        if (cache)
+            cache->Store(cacheKey, ID);
         // delete the shaders as they're linked into our program now and no longer necessary
         glDeleteShader(vertex);
         glDeleteShader(fragment);
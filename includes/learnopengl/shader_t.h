@@ -4,6 +4,8 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include <learnopengl/shader_cache.h>
+
 #include <string>
 #include <fstream>
 #include <sstream>
@@ -13,10 +15,10 @@ class Shader
 {
 public:
     unsigned int ID;
-    // constructor generates the shader on the fly
+    // constructor generates the shader on the fly, with a cache the linked program is reused from an earlier run
     // ------------------------------------------------------------------------
     Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr,
-           const char* tessControlPath = nullptr, const char* tessEvalPath = nullptr)
+           const char* tessControlPath = nullptr, const char* tessEvalPath = nullptr, ShaderCache* cache = nullptr)
     {
         // 1. retrieve the vertex/fragment source code from filePath
         std::string vertexCode;
@@ -79,6 +81,16 @@ public:
             std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " 
                 << e.what() << std::endl;
         }
+        // stages that aren't given hash as empty sources
+        uint64_t cacheKey = 0;
+        if(cache)
+        {
+            cacheKey = cache->GetKey({ { GL_VERTEX_SHADER, vertexCode }, { GL_FRAGMENT_SHADER, fragmentCode },
+                                       { GL_GEOMETRY_SHADER, geometryCode }, { GL_TESS_CONTROL_SHADER, tessControlCode },
+                                       { GL_TESS_EVALUATION_SHADER, tessEvalCode } });
+            if(cache->Load(cacheKey, ID))
+                return;
+        }
         const char* vShaderCode = vertexCode.c_str();
         const char * fShaderCode = fragmentCode.c_str();
         // 2. compile shaders
@@ -132,8 +144,12 @@ public:
             glAttachShader(ID, tessControl);
         if(tessEvalPath != nullptr)
             glAttachShader(ID, tessEval);
+        if(cache)
+            cache->PrepareLink(ID);
         glLinkProgram(ID);
         checkCompileErrors(ID, "PROGRAM");
+        if(cache)
+            cache->Store(cacheKey, ID);
         // delete the shaders as they're linked into our program now and no longer necessary
         glDeleteShader(vertex);
         glDeleteShader(fragment);
@@ -0,0 +1,130 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+// Packs of floats for kernels that work on structure of arrays data, one value per lane. A kernel is written once as a
+// template over the lane type and instantiated with SimdFloat for the bulk of its data and SimdFloat1 for a scalar
+// remainder or reference. SimdFloat is the widest type the compiler targets: 8 lanes with AVX2 (-mavx2 or
+// /arch:AVX2), 4 lanes with SSE2, which every x86-64 target has, and 1 lane elsewhere.
+// The ...Mask comparisons return one bit per lane, lane 0 in bit 0.
+
+struct SimdFloat1
+{
+    static const int Width = 1;
+    float v;
+
+    static SimdFloat1 Set(float x) { return { x }; }
+    static SimdFloat1 Load(const float* p) { return { *p }; }
+    void Store(float* p) const { *p = v; }
+    static SimdFloat1 Gather(const float* base, const int32_t* offsets) { return { base[offsets[0]] }; }
+    static SimdFloat1 Min(SimdFloat1 a, SimdFloat1 b) { return { std::min(a.v, b.v) }; }
+    static SimdFloat1 Max(SimdFloat1 a, SimdFloat1 b) { return { std::max(a.v, b.v) }; }
+    static SimdFloat1 Sqrt(SimdFloat1 a) { return { std::sqrt(a.v) }; }
+    static SimdFloat1 IfNegative(SimdFloat1 x, SimdFloat1 a, SimdFloat1 b) { return { x.v < 0.0f ? a.v : b.v }; }
+    static bool AnyNonZero(SimdFloat1 a) { return a.v != 0.0f; }
+    static int GreaterMask(SimdFloat1 a, SimdFloat1 b) { return a.v > b.v ? 1 : 0; }
+    static int GreaterEqualMask(SimdFloat1 a, SimdFloat1 b) { return a.v >= b.v ? 1 : 0; }
+    static float HorizontalMin(SimdFloat1 a) { return a.v; }
+    static float HorizontalMax(SimdFloat1 a) { return a.v; }
+    friend SimdFloat1 operator+(SimdFloat1 a, SimdFloat1 b) { return { a.v + b.v }; }
+    friend SimdFloat1 operator-(SimdFloat1 a, SimdFloat1 b) { return { a.v - b.v }; }
+    friend SimdFloat1 operator*(SimdFloat1 a, SimdFloat1 b) { return { a.v * b.v }; }
+    friend SimdFloat1 operator/(SimdFloat1 a, SimdFloat1 b) { return { a.v / b.v }; }
+};
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(__AVX2__)
+struct SimdFloat4
+{
+    static const int Width = 4;
+    __m128 v;
+
+    static SimdFloat4 Set(float x) { return { _mm_set1_ps(x) }; }
+    static SimdFloat4 Load(const float* p) { return { _mm_loadu_ps(p) }; }
+    void Store(float* p) const { _mm_storeu_ps(p, v); }
+    // SSE has no gather, the four loads are scalar
+    static SimdFloat4 Gather(const float* base, const int32_t* offsets)
+    {
+        return { _mm_setr_ps(base[offsets[0]], base[offsets[1]], base[offsets[2]], base[offsets[3]]) };
+    }
+    static SimdFloat4 Min(SimdFloat4 a, SimdFloat4 b) { return { _mm_min_ps(a.v, b.v) }; }
+    static SimdFloat4 Max(SimdFloat4 a, SimdFloat4 b) { return { _mm_max_ps(a.v, b.v) }; }
+    static SimdFloat4 Sqrt(SimdFloat4 a) { return { _mm_sqrt_ps(a.v) }; }
+    static SimdFloat4 IfNegative(SimdFloat4 x, SimdFloat4 a, SimdFloat4 b)
+    {
+        __m128 mask = _mm_cmplt_ps(x.v, _mm_setzero_ps());
+        return { _mm_or_ps(_mm_and_ps(mask, a.v), _mm_andnot_ps(mask, b.v)) };
+    }
+    static bool AnyNonZero(SimdFloat4 a) { return _mm_movemask_ps(_mm_cmpneq_ps(a.v, _mm_setzero_ps())) != 0; }
+    static int GreaterMask(SimdFloat4 a, SimdFloat4 b) { return _mm_movemask_ps(_mm_cmpgt_ps(a.v, b.v)); }
+    static int GreaterEqualMask(SimdFloat4 a, SimdFloat4 b) { return _mm_movemask_ps(_mm_cmpge_ps(a.v, b.v)); }
+    static float HorizontalMin(SimdFloat4 a)
+    {
+        __m128 m = _mm_min_ps(a.v, _mm_shuffle_ps(a.v, a.v, _MM_SHUFFLE(1, 0, 3, 2)));
+        m = _mm_min_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+        return _mm_cvtss_f32(m);
+    }
+    static float HorizontalMax(SimdFloat4 a)
+    {
+        __m128 m = _mm_max_ps(a.v, _mm_shuffle_ps(a.v, a.v, _MM_SHUFFLE(1, 0, 3, 2)));
+        m = _mm_max_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+        return _mm_cvtss_f32(m);
+    }
+    friend SimdFloat4 operator+(SimdFloat4 a, SimdFloat4 b) { return { _mm_add_ps(a.v, b.v) }; }
+    friend SimdFloat4 operator-(SimdFloat4 a, SimdFloat4 b) { return { _mm_sub_ps(a.v, b.v) }; }
+    friend SimdFloat4 operator*(SimdFloat4 a, SimdFloat4 b) { return { _mm_mul_ps(a.v, b.v) }; }
+    friend SimdFloat4 operator/(SimdFloat4 a, SimdFloat4 b) { return { _mm_div_ps(a.v, b.v) }; }
+};
+#endif
+
+#if defined(__AVX2__)
+struct SimdFloat8
+{
+    static const int Width = 8;
+    __m256 v;
+
+    static SimdFloat8 Set(float x) { return { _mm256_set1_ps(x) }; }
+    static SimdFloat8 Load(const float* p) { return { _mm256_loadu_ps(p) }; }
+    void Store(float* p) const { _mm256_storeu_ps(p, v); }
+    static SimdFloat8 Gather(const float* base, const int32_t* offsets)
+    {
+        return { _mm256_i32gather_ps(base, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(offsets)), 4) };
+    }
+    static SimdFloat8 Min(SimdFloat8 a, SimdFloat8 b) { return { _mm256_min_ps(a.v, b.v) }; }
+    static SimdFloat8 Max(SimdFloat8 a, SimdFloat8 b) { return { _mm256_max_ps(a.v, b.v) }; }
+    static SimdFloat8 Sqrt(SimdFloat8 a) { return { _mm256_sqrt_ps(a.v) }; }
+    static SimdFloat8 IfNegative(SimdFloat8 x, SimdFloat8 a, SimdFloat8 b) { return { _mm256_blendv_ps(b.v, a.v, x.v) }; }
+    static bool AnyNonZero(SimdFloat8 a) { return _mm256_movemask_ps(_mm256_cmp_ps(a.v, _mm256_setzero_ps(), _CMP_NEQ_OQ)) != 0; }
+    static int GreaterMask(SimdFloat8 a, SimdFloat8 b) { return _mm256_movemask_ps(_mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ)); }
+    static int GreaterEqualMask(SimdFloat8 a, SimdFloat8 b) { return _mm256_movemask_ps(_mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ)); }
+    static float HorizontalMin(SimdFloat8 a)
+    {
+        return SimdFloat4::HorizontalMin({ _mm_min_ps(_mm256_castps256_ps128(a.v), _mm256_extractf128_ps(a.v, 1)) });
+    }
+    static float HorizontalMax(SimdFloat8 a)
+    {
+        return SimdFloat4::HorizontalMax({ _mm_max_ps(_mm256_castps256_ps128(a.v), _mm256_extractf128_ps(a.v, 1)) });
+    }
+    friend SimdFloat8 operator+(SimdFloat8 a, SimdFloat8 b) { return { _mm256_add_ps(a.v, b.v) }; }
+    friend SimdFloat8 operator-(SimdFloat8 a, SimdFloat8 b) { return { _mm256_sub_ps(a.v, b.v) }; }
+    friend SimdFloat8 operator*(SimdFloat8 a, SimdFloat8 b) { return { _mm256_mul_ps(a.v, b.v) }; }
+    friend SimdFloat8 operator/(SimdFloat8 a, SimdFloat8 b) { return { _mm256_div_ps(a.v, b.v) }; }
+};
+typedef SimdFloat8 SimdFloat;
+#elif defined(__SSE2__) || defined(_M_X64)
+typedef SimdFloat4 SimdFloat;
+#else
+typedef SimdFloat1 SimdFloat;
+#endif
+
+#define SIMD_LANES SimdFloat::Width
+
+#endif
@@ -0,0 +1,340 @@
+#ifndef SKINNING_H
+#define SKINNING_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <learnopengl/job_system.h>
+#include <learnopengl/mesh.h>
+#include <learnopengl/simd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// CPU skinning of a mesh with the same bone IDs, weights and final bone matrices the vertex shader uses, for work
+// that needs the deformed vertices on the CPU: per frame bounds of animated characters, picking, headless checks of
+// a pose, or preskinned vertices for upload.
+//
+// The vertices are kept as structure of arrays streams, so one kernel invocation skins SKINNING_LANES vertices at
+// once, see simd.h for how the width is picked. Linear blend skinning blends the matrices; dual quaternion skinning
+// blends rigid transforms, so joints that twist keep their volume, and handles bone scale by blending it separately.
+
+enum class SkinningMode
+{
+    Linear,
+    DualQuaternion
+};
+
+#define SKINNING_LANES SIMD_LANES
+#define SKINNING_PALETTE_STRIDE 16 // floats per bone in the palette
+
+class CpuSkinner
+{
+public:
+    // copies the bind pose of vertices into streams, the skinner doesn't keep a reference to them
+    explicit CpuSkinner(const std::vector<Vertex>& vertices)
+    {
+        m_VertexCount = vertices.size();
+        // padded with copies of the last vertex so every batch is full, they don't change the bounds
+        m_PaddedCount = (m_VertexCount + SKINNING_LANES - 1) / SKINNING_LANES * SKINNING_LANES;
+        for (int c = 0; c < 3; c++)
+        {
+            m_Position[c].resize(m_PaddedCount);
+            m_Normal[c].resize(m_PaddedCount);
+            m_SkinnedPosition[c].resize(m_PaddedCount);
+            m_SkinnedNormal[c].resize(m_PaddedCount);
+        }
+        for (int k = 0; k < MAX_BONE_INFLUENCE; k++)
+        {
+            m_Weight[k].resize(m_PaddedCount);
+            m_Offset[k].resize(m_PaddedCount);
+        }
+
+        int maxBone = -1;
+        for (size_t i = 0; i < m_PaddedCount; i++)
+        {
+            const Vertex& vertex = vertices[std::min(i, m_VertexCount - 1)];
+            for (int c = 0; c < 3; c++)
+            {
+                m_Position[c][i] = vertex.Position[c];
+                m_Normal[c][i] = vertex.Normal[c];
+            }
+            // palette slot 0 is the identity, bone b sits in slot b + 1. Unused influences point at the identity
+            // with weight 0, vertices without any bone get the identity with weight 1 and stay where they are
+            float total = 0.0f;
+            for (int k = 0; k < MAX_BONE_INFLUENCE; k++)
+            {
+                bool used = vertex.m_BoneIDs[k] >= 0 && vertex.m_Weights[k] > 0.0f;
+                m_Weight[k][i] = used ? vertex.m_Weights[k] : 0.0f;
+                m_Offset[k][i] = used ? (vertex.m_BoneIDs[k] + 1) * SKINNING_PALETTE_STRIDE : 0;
+                total += m_Weight[k][i];
+                if (used)
+                    maxBone = std::max(maxBone, vertex.m_BoneIDs[k]);
+            }
+            if (total <= 0.0f)
+                m_Weight[0][i] = 1.0f;
+            else
+                for (int k = 0; k < MAX_BONE_INFLUENCE; k++)
+                    m_Weight[k][i] /= total;
+        }
+        m_Palette.assign((maxBone + 2) * SKINNING_PALETTE_STRIDE, 0.0f);
+    }
+
+    // deforms every vertex by the final bone matrices of a pose (Animator::GetFinalBoneMatrices) and computes the
+    // bounds of the result. Bones the vertices use beyond boneCount count as identity. With a JobSystem the vertices are
+    // split into ranges of about grain vertices that are skinned in parallel
+    void Skin(const glm::mat4* boneMatrices, size_t boneCount, SkinningMode mode, JobSystem* jobs = nullptr, size_t grain = 4096)
+    {
+        Run<SimdFloat>(boneMatrices, boneCount, mode, jobs, grain);
+    }
+
+    // the same with one vertex at a time, as a reference for the vector kernels
+    void SkinScalar(const glm::mat4* boneMatrices, size_t boneCount, SkinningMode mode)
+    {
+        Run<SimdFloat1>(boneMatrices, boneCount, mode, nullptr, m_PaddedCount);
+    }
+
+    size_t GetVertexCount() const { return m_VertexCount; }
+    glm::vec3 GetPosition(size_t i) const { return glm::vec3(m_SkinnedPosition[0][i], m_SkinnedPosition[1][i], m_SkinnedPosition[2][i]); }
+    glm::vec3 GetNormal(size_t i) const { return glm::vec3(m_SkinnedNormal[0][i], m_SkinnedNormal[1][i], m_SkinnedNormal[2][i]); }
+    // model space bounds of the last Skin, e.g. for Entity::setLocalBounds
+    const glm::vec3& GetBoundsMin() const { return m_BoundsMin; }
+    const glm::vec3& GetBoundsMax() const { return m_BoundsMax; }
+
+    // writes the skinned positions and normals into a copy of the mesh's vertices, e.g. to upload preskinned vertices
+    void WriteVertices(Vertex* vertices) const
+    {
+        for (size_t i = 0; i < m_VertexCount; i++)
+        {
+            vertices[i].Position = GetPosition(i);
+            vertices[i].Normal = GetNormal(i);
+        }
+    }
+
+private:
+    struct Bounds
+    {
+        glm::vec3 min;
+        glm::vec3 max;
+    };
+
+    size_t m_VertexCount = 0;
+    size_t m_PaddedCount = 0;
+    std::vector<float> m_Position[3];
+    std::vector<float> m_Normal[3];
+    std::vector<float> m_Weight[MAX_BONE_INFLUENCE];
+    std::vector<int32_t> m_Offset[MAX_BONE_INFLUENCE]; // into m_Palette, in floats
+    std::vector<float> m_SkinnedPosition[3];
+    std::vector<float> m_SkinnedNormal[3];
+    std::vector<float> m_Palette;
+    std::vector<Bounds> m_ChunkBounds;
+    glm::vec3 m_BoundsMin = glm::vec3(0.0f);
+    glm::vec3 m_BoundsMax = glm::vec3(0.0f);
+
+    template<typename V>
+    void Run(const glm::mat4* boneMatrices, size_t boneCount, SkinningMode mode, JobSystem* jobs, size_t grain)
+    {
+        FillPalette(boneMatrices, boneCount, mode);
+        if (m_VertexCount == 0)
+        {
+            m_BoundsMin = m_BoundsMax = glm::vec3(0.0f);
+            return;
+        }
+
+        const size_t batches = m_PaddedCount / V::Width;
+        const size_t grainBatches = std::max<size_t>(1, grain / V::Width);
+        m_ChunkBounds.resize((batches + grainBatches - 1) / grainBatches);
+        auto skinRange = [this, mode, grainBatches](size_t begin, size_t end)
+        {
+            const float inf = std::numeric_limits<float>::max();
+            V boundsMin[3] = { V::Set(inf), V::Set(inf), V::Set(inf) };
+            V boundsMax[3] = { V::Set(-inf), V::Set(-inf), V::Set(-inf) };
+            for (size_t batch = begin; batch < end; batch++)
+            {
+                if (mode == SkinningMode::Linear)
+                    SkinLinear<V>(batch * V::Width, boundsMin, boundsMax);
+                else
+                    SkinDualQuaternion<V>(batch * V::Width, boundsMin, boundsMax);
+            }
+            // ranges never straddle a chunk of the grain, so each one owns its entry
+            Bounds& bounds = m_ChunkBounds[begin / grainBatches];
+            for (int c = 0; c < 3; c++)
+            {
+                bounds.min[c] = V::HorizontalMin(boundsMin[c]);
+                bounds.max[c] = V::HorizontalMax(boundsMax[c]);
+            }
+        };
+        if (jobs)
+            jobs->ParallelFor(batches, grainBatches, [&](size_t begin, size_t end)
+            {
+                for (size_t chunk = begin; chunk < end; chunk += grainBatches)
+                    skinRange(chunk, std::min(end, chunk + grainBatches));
+            });
+        else
+            for (size_t chunk = 0; chunk < batches; chunk += grainBatches)
+                skinRange(chunk, std::min(batches, chunk + grainBatches));
+
+        m_BoundsMin = m_ChunkBounds[0].min;
+        m_BoundsMax = m_ChunkBounds[0].max;
+        for (const Bounds& bounds : m_ChunkBounds)
+        {
+            m_BoundsMin = glm::min(m_BoundsMin, bounds.min);
+            m_BoundsMax = glm::max(m_BoundsMax, bounds.max);
+        }
+    }
+
+    // Linear: the upper three rows of each matrix. Dual quaternion: real part xyzw, dual part xyzw, scale xyz
+    void FillPalette(const glm::mat4* boneMatrices, size_t boneCount, SkinningMode mode)
+    {
+        const size_t slots = m_Palette.size() / SKINNING_PALETTE_STRIDE;
+        for (size_t slot = 0; slot < slots; slot++)
+        {
+            glm::mat4 matrix = slot > 0 && slot - 1 < boneCount ? boneMatrices[slot - 1] : glm::mat4(1.0f);
+            float* entry = &m_Palette[slot * SKINNING_PALETTE_STRIDE];
+            if (mode == SkinningMode::Linear)
+            {
+                for (int row = 0; row < 3; row++)
+                    for (int column = 0; column < 4; column++)
+                        entry[row * 4 + column] = matrix[column][row];
+                continue;
+            }
+
+            glm::vec3 scale(glm::length(glm::vec3(matrix[0])), glm::length(glm::vec3(matrix[1])), glm::length(glm::vec3(matrix[2])));
+            glm::mat3 rotation(glm::vec3(matrix[0]) / scale.x, glm::vec3(matrix[1]) / scale.y, glm::vec3(matrix[2]) / scale.z);
+            glm::quat real = glm::normalize(glm::quat_cast(rotation));
+            glm::quat dual = glm::quat(0.0f, matrix[3].x, matrix[3].y, matrix[3].z) * real * 0.5f;
+            const float values[11] = { real.x, real.y, real.z, real.w, dual.x, dual.y, dual.z, dual.w, scale.x, scale.y, scale.z };
+            std::copy(values, values + 11, entry);
+        }
+    }
+
+    template<typename V>
+    static void Cross(const V a[3], const V b[3], V out[3])
+    {
+        out[0] = a[1] * b[2] - a[2] * b[1];
+        out[1] = a[2] * b[0] - a[0] * b[2];
+        out[2] = a[0] * b[1] - a[1] * b[0];
+    }
+
+    template<typename V>
+    void Finish(size_t i, const V position[3], V normal[3], V boundsMin[3], V boundsMax[3])
+    {
+        V length = V::Sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        V inverse = V::IfNegative(length - V::Set(1e-20f), V::Set(0.0f), V::Set(1.0f) / length);
+        for (int c = 0; c < 3; c++)
+        {
+            position[c].Store(&m_SkinnedPosition[c][i]);
+            (normal[c] * inverse).Store(&m_SkinnedNormal[c][i]);
+            boundsMin[c] = V::Min(boundsMin[c], position[c]);
+            boundsMax[c] = V::Max(boundsMax[c], position[c]);
+        }
+    }
+
+    // V::Width vertices starting at i: blends the bone matrices by weight, then transforms by the blend
+    template<typename V>
+    void SkinLinear(size_t i, V boundsMin[3], V boundsMax[3])
+    {
+        V matrix[12];
+        for (int e = 0; e < 12; e++)
+            matrix[e] = V::Set(0.0f);
+        for (int k = 0; k < MAX_BONE_INFLUENCE; k++)
+        {
+            V weight = V::Load(&m_Weight[k][i]);
+            if (!V::AnyNonZero(weight))
+                continue;
+            const int32_t* offsets = &m_Offset[k][i];
+            for (int e = 0; e < 12; e++)
+                matrix[e] = matrix[e] + weight * V::Gather(m_Palette.data() + e, offsets);
+        }
+
+        V p[3] = { V::Load(&m_Position[0][i]), V::Load(&m_Position[1][i]), V::Load(&m_Position[2][i]) };
+        V n[3] = { V::Load(&m_Normal[0][i]), V::Load(&m_Normal[1][i]), V::Load(&m_Normal[2][i]) };
+        V position[3], normal[3];
+        for (int row = 0; row < 3; row++)
+        {
+            const V* m = &matrix[row * 4];
+            position[row] = m[0] * p[0] + m[1] * p[1] + m[2] * p[2] + m[3];
+            normal[row] = m[0] * n[0] + m[1] * n[1] + m[2] * n[2];
+        }
+        Finish(i, position, normal, boundsMin, boundsMax);
+    }
+
+    // V::Width vertices starting at i: blends the dual quaternions (flipped onto the first influence's hemisphere) and
+    // the scales by weight, then scales, rotates and translates
+    template<typename V>
+    void SkinDualQuaternion(size_t i, V boundsMin[3], V boundsMax[3])
+    {
+        V real[4], dual[4], scale[3];
+        for (int e = 0; e < 4; e++)
+            real[e] = dual[e] = V::Set(0.0f);
+        for (int c = 0; c < 3; c++)
+            scale[c] = V::Set(0.0f);
+        V first[4];
+        for (int k = 0; k < MAX_BONE_INFLUENCE; k++)
+        {
+            V weight = V::Load(&m_Weight[k][i]);
+            if (k > 0 && !V::AnyNonZero(weight))
+                continue;
+            const int32_t* offsets = &m_Offset[k][i];
+            V r[4];
+            for (int e = 0; e < 4; e++)
+                r[e] = V::Gather(m_Palette.data() + e, offsets);
+            if (k == 0)
+                for (int e = 0; e < 4; e++)
+                    first[e] = r[e];
+            V dot = r[0] * first[0] + r[1] * first[1] + r[2] * first[2] + r[3] * first[3];
+            V signedWeight = V::IfNegative(dot, V::Set(0.0f) - weight, weight);
+            for (int e = 0; e < 4; e++)
+            {
+                real[e] = real[e] + signedWeight * r[e];
+                dual[e] = dual[e] + signedWeight * V::Gather(m_Palette.data() + 4 + e, offsets);
+            }
+            for (int c = 0; c < 3; c++)
+                scale[c] = scale[c] + weight * V::Gather(m_Palette.data() + 8 + c, offsets);
+        }
+
+        V inverse = V::Set(1.0f) / V::Sqrt(real[0] * real[0] + real[1] * real[1] + real[2] * real[2] + real[3] * real[3]);
+        for (int e = 0; e < 4; e++)
+        {
+            real[e] = real[e] * inverse;
+            dual[e] = dual[e] * inverse;
+        }
+
+        // v' = v + 2 r.xyz x (r.xyz x v + r.w v), t = 2 (r.w d.xyz - d.w r.xyz + r.xyz x d.xyz)
+        const V two = V::Set(2.0f);
+        V p[3], n[3];
+        for (int c = 0; c < 3; c++)
+        {
+            p[c] = V::Load(&m_Position[c][i]) * scale[c];
+            n[c] = V::Load(&m_Normal[c][i]) / scale[c];
+        }
+        V rotatedP[3], rotatedN[3], translation[3];
+        Rotate(real, p, rotatedP);
+        Rotate(real, n, rotatedN);
+        V rd[3];
+        Cross(real, dual, rd);
+        for (int c = 0; c < 3; c++)
+            translation[c] = two * (real[3] * dual[c] - dual[3] * real[c] + rd[c]);
+
+        V position[3];
+        for (int c = 0; c < 3; c++)
+            position[c] = rotatedP[c] + translation[c];
+        Finish(i, position, rotatedN, boundsMin, boundsMax);
+    }
+
+    template<typename V>
+    static void Rotate(const V q[4], const V v[3], V out[3])
+    {
+        V inner[3], outer[3];
+        Cross(q, v, inner);
+        for (int c = 0; c < 3; c++)
+            inner[c] = inner[c] + q[3] * v[c];
+        Cross(q, inner, outer);
+        for (int c = 0; c < 3; c++)
+            out[c] = v[c] + V::Set(2.0f) * outer[c];
+    }
+};
+#endif
@@ -0,0 +1,265 @@
+#ifndef STATIC_BATCH_H
+#define STATIC_BATCH_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/index_buffer.h>
+#include <learnopengl/mesh.h>
+#include <learnopengl/shader.h>
+
+#include <cstdint>
+#include <vector>
+
+// Merges the meshes of a static model into shared buffers. Meshes with the same vertex layout share one
+// VAO/VBO/EBO, and within it meshes with the same textures form one material that is drawn with a single
+// glMultiDrawElementsBaseVertex. Drawing a model then costs one VAO bind per layout and one texture setup
+// and draw call per material instead of one of each per mesh.
+
+struct DrawStatistics
+{
+    unsigned int vaoBinds = 0;
+    unsigned int textureBinds = 0;
+    unsigned int drawCalls = 0;
+};
+
+// the draws of one material, in the layout glMultiDrawElementsBaseVertex expects
+struct StaticBatchMaterial
+{
+    vector<Texture>     textures;
+    vector<GLsizei>     counts;
+    vector<const void*> offsets;      // byte offsets into the index buffer
+    vector<GLint>       baseVertices;
+};
+
+// CPU side result of merging, uploaded by StaticBatch. Kept separate so the merge can be checked without a GL context
+struct StaticBatchData
+{
+    VertexLayout                layout;
+    vector<Vertex>              vertices;
+    GLenum                      indexType = GL_UNSIGNED_SHORT;
+    vector<uint16_t>            indices;
+    vector<uint32_t>            wideIndices; // only used when indexType is GL_UNSIGNED_INT
+    vector<StaticBatchMaterial> materials;
+    unsigned int                meshCount = 0;
+
+    // absolute vertex index of every index of a material, in draw order
+    vector<unsigned int> ExpandMaterial(size_t material) const
+    {
+        const StaticBatchMaterial& m = materials[material];
+        const size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+        vector<unsigned int> expanded;
+        for (size_t d = 0; d < m.counts.size(); d++)
+        {
+            size_t first = reinterpret_cast<size_t>(m.offsets[d]) / indexSize;
+            for (GLsizei i = 0; i < m.counts[d]; i++)
+            {
+                unsigned int index = indexType == GL_UNSIGNED_SHORT ? indices[first + i] : wideIndices[first + i];
+                expanded.push_back(m.baseVertices[d] + index);
+            }
+        }
+        return expanded;
+    }
+};
+
+class StaticBatch
+{
+public:
+    StaticBatch(const vector<Mesh>& meshes)
+    {
+        for (StaticBatchData& data : Merge(meshes))
+            upload(std::move(data));
+    }
+
+    StaticBatch(const StaticBatch&) = delete;
+    StaticBatch& operator=(const StaticBatch&) = delete;
+
+    ~StaticBatch()
+    {
+        for (Buffer& buffer : m_Buffers)
+        {
+            glDeleteVertexArrays(1, &buffer.VAO);
+            glDeleteBuffers(1, &buffer.VBO);
+            glDeleteBuffers(1, &buffer.EBO);
+        }
+    }
+
+    DrawStatistics Draw(Shader& shader) const
+    {
+        DrawStatistics stats;
+        for (const Buffer& buffer : m_Buffers)
+        {
+            glBindVertexArray(buffer.VAO);
+            stats.vaoBinds++;
+            for (const StaticBatchMaterial& material : buffer.materials)
+            {
+                Mesh::BindTextures(shader, material.textures);
+                stats.textureBinds += static_cast<unsigned int>(material.textures.size());
+                glMultiDrawElementsBaseVertex(GL_TRIANGLES, material.counts.data(), buffer.indexType, material.offsets.data(),
+                    static_cast<GLsizei>(material.counts.size()), material.baseVertices.data());
+                stats.drawCalls++;
+            }
+        }
+        glBindVertexArray(0);
+        glActiveTexture(GL_TEXTURE0);
+        return stats;
+    }
+
+    // what Draw costs, without drawing
+    DrawStatistics GetDrawStatistics() const
+    {
+        DrawStatistics stats;
+        for (const Buffer& buffer : m_Buffers)
+        {
+            stats.vaoBinds++;
+            for (const StaticBatchMaterial& material : buffer.materials)
+            {
+                stats.textureBinds += static_cast<unsigned int>(material.textures.size());
+                stats.drawCalls++;
+            }
+        }
+        return stats;
+    }
+
+    // what drawing the same meshes one by one with Mesh::Draw costs
+    static DrawStatistics CountUnbatched(const vector<Mesh>& meshes)
+    {
+        DrawStatistics stats;
+        for (const Mesh& mesh : meshes)
+        {
+            stats.vaoBinds++;
+            stats.textureBinds += static_cast<unsigned int>(mesh.textures.size());
+            stats.drawCalls += static_cast<unsigned int>(mesh.indexRanges.size());
+        }
+        return stats;
+    }
+
+    // groups meshes by vertex layout, then by textures, and concatenates their vertices and indices
+    static vector<StaticBatchData> Merge(const vector<Mesh>& meshes)
+    {
+        vector<StaticBatchData> batches;
+        vector<vector<const Mesh*>> batchMeshes;
+        for (const Mesh& mesh : meshes)
+        {
+            size_t b = 0;
+            while (b < batches.size() && !SameLayout(batches[b].layout, mesh.layout))
+                b++;
+            if (b == batches.size())
+            {
+                batches.emplace_back();
+                batches.back().layout = mesh.layout;
+                batchMeshes.emplace_back();
+            }
+            batchMeshes[b].push_back(&mesh);
+        }
+
+        for (size_t b = 0; b < batches.size(); b++)
+        {
+            StaticBatchData& data = batches[b];
+
+            // 16-bit indices unless one of the meshes can't be split into 16-bit ranges
+            vector<SplitIndexBuffer> split;
+            for (const Mesh* mesh : batchMeshes[b])
+            {
+                split.push_back(SplitIndexBuffer::FromTriangles(mesh->indices.data(), mesh->indices.size()));
+                if (split.back().type != GL_UNSIGNED_SHORT)
+                    data.indexType = GL_UNSIGNED_INT;
+            }
+
+            for (size_t m = 0; m < batchMeshes[b].size(); m++)
+            {
+                const Mesh& mesh = *batchMeshes[b][m];
+                StaticBatchMaterial& material = findMaterial(data, mesh.textures);
+                const GLint vertexBase = static_cast<GLint>(data.vertices.size());
+                data.vertices.insert(data.vertices.end(), mesh.vertices.begin(), mesh.vertices.end());
+
+                if (data.indexType == GL_UNSIGNED_SHORT)
+                {
+                    const size_t indexBase = data.indices.size();
+                    data.indices.insert(data.indices.end(), split[m].indices.begin(), split[m].indices.end());
+                    for (const IndexRange& range : split[m].ranges)
+                    {
+                        material.counts.push_back(static_cast<GLsizei>(range.indexCount));
+                        material.offsets.push_back(reinterpret_cast<const void*>((indexBase + range.firstIndex) * sizeof(uint16_t)));
+                        material.baseVertices.push_back(vertexBase + static_cast<GLint>(range.baseVertex));
+                    }
+                }
+                else
+                {
+                    const size_t indexBase = data.wideIndices.size();
+                    const size_t indexCount = mesh.indices.size() - mesh.indices.size() % 3;
+                    data.wideIndices.insert(data.wideIndices.end(), mesh.indices.begin(), mesh.indices.begin() + indexCount);
+                    material.counts.push_back(static_cast<GLsizei>(indexCount));
+                    material.offsets.push_back(reinterpret_cast<const void*>(indexBase * sizeof(uint32_t)));
+                    material.baseVertices.push_back(vertexBase);
+                }
+                data.meshCount++;
+            }
+        }
+        return batches;
+    }
+
+private:
+    struct Buffer
+    {
+        unsigned int VAO = 0, VBO = 0, EBO = 0;
+        GLenum indexType = GL_UNSIGNED_SHORT;
+        vector<StaticBatchMaterial> materials;
+    };
+
+    vector<Buffer> m_Buffers;
+
+    void upload(StaticBatchData data)
+    {
+        Buffer buffer;
+        buffer.indexType = data.indexType;
+        glGenVertexArrays(1, &buffer.VAO);
+        glGenBuffers(1, &buffer.VBO);
+        glGenBuffers(1, &buffer.EBO);
+
+        glBindVertexArray(buffer.VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer.VBO);
+        if (data.layout.stride == sizeof(Vertex))
+            glBufferData(GL_ARRAY_BUFFER, data.vertices.size() * sizeof(Vertex), data.vertices.data(), GL_STATIC_DRAW);
+        else
+        {
+            vector<unsigned char> packed = data.layout.Pack(data.vertices.data(), data.vertices.size());
+            glBufferData(GL_ARRAY_BUFFER, packed.size(), packed.data(), GL_STATIC_DRAW);
+        }
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer.EBO);
+        if (data.indexType == GL_UNSIGNED_SHORT)
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, data.indices.size() * sizeof(uint16_t), data.indices.data(), GL_STATIC_DRAW);
+        else
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, data.wideIndices.size() * sizeof(uint32_t), data.wideIndices.data(), GL_STATIC_DRAW);
+
+        data.layout.Apply();
+        glBindVertexArray(0);
+
+        buffer.materials = std::move(data.materials);
+        m_Buffers.push_back(std::move(buffer));
+    }
+
+    static bool SameLayout(const VertexLayout& a, const VertexLayout& b)
+    {
+        return a.attributeMask == b.attributeMask && a.halfTexCoords == b.halfTexCoords && a.packedVectors == b.packedVectors;
+    }
+
+    // meshes share a material when they bind the same textures in the same order, so the sampler numbering matches
+    static StaticBatchMaterial& findMaterial(StaticBatchData& data, const vector<Texture>& textures)
+    {
+        for (StaticBatchMaterial& material : data.materials)
+        {
+            if (material.textures.size() != textures.size())
+                continue;
+            bool same = true;
+            for (size_t i = 0; i < textures.size() && same; i++)
+                same = material.textures[i].id == textures[i].id && material.textures[i].type == textures[i].type;
+            if (same)
+                return material;
+        }
+        data.materials.emplace_back();
+        data.materials.back().textures = textures;
+        return data.materials.back();
+    }
+};
+#endif
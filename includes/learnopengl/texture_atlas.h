@@ -0,0 +1,389 @@
+#ifndef TEXTURE_ATLAS_H
+#define TEXTURE_ATLAS_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/type_precision.hpp>
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Packs the textures of several materials into one atlas per texture type (diffuse, specular, ...).
+// Every material gets the same rectangle in each type's atlas, so a mesh keeps a single set of texture
+// coordinates: RemapUV moves them into the material's rectangle and all meshes then bind the same textures,
+// which lets StaticBatch draw them with one multi-draw. Only UVs inside [0, 1] can be remapped, meshes that
+// rely on GL_REPEAT have to keep their own textures.
+
+struct AtlasRect
+{
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+};
+
+// skyline bottom-left rectangle packer
+class SkylinePacker
+{
+public:
+    SkylinePacker(int width, int height) : m_Width(width), m_Height(height)
+    {
+        m_Skyline.push_back({ 0, 0, width });
+    }
+
+    // places a width x height rectangle as low as possible, returns false when it doesn't fit
+    bool Insert(int width, int height, AtlasRect& rect)
+    {
+        int bestY = INT_MAX, bestWaste = INT_MAX;
+        size_t bestIndex = m_Skyline.size();
+        for (size_t i = 0; i < m_Skyline.size(); i++)
+        {
+            int y, waste;
+            if (!Fits(i, width, height, y, waste))
+                continue;
+            if (y < bestY || (y == bestY && waste < bestWaste))
+            {
+                bestY = y;
+                bestWaste = waste;
+                bestIndex = i;
+            }
+        }
+        if (bestIndex == m_Skyline.size())
+            return false;
+
+        rect.x = m_Skyline[bestIndex].x;
+        rect.y = bestY;
+        rect.width = width;
+        rect.height = height;
+        AddLevel(bestIndex, rect);
+        m_UsedArea += size_t(width) * height;
+        return true;
+    }
+
+    // fraction of the atlas covered by rectangles
+    float Occupancy() const
+    {
+        return float(m_UsedArea) / (float(m_Width) * float(m_Height));
+    }
+
+private:
+    struct Segment
+    {
+        int x;
+        int y;
+        int width;
+    };
+
+    int m_Width;
+    int m_Height;
+    size_t m_UsedArea = 0;
+    std::vector<Segment> m_Skyline;
+
+    // a rectangle starting at segment index rests on the highest segment it spans
+    bool Fits(size_t index, int width, int height, int& y, int& waste) const
+    {
+        int x = m_Skyline[index].x;
+        if (x + width > m_Width)
+            return false;
+        y = 0;
+        int remaining = width;
+        for (size_t i = index; remaining > 0; i++)
+        {
+            if (i == m_Skyline.size())
+                return false;
+            y = std::max(y, m_Skyline[i].y);
+            remaining -= m_Skyline[i].width;
+        }
+        if (y + height > m_Height)
+            return false;
+
+        // area trapped below the rectangle
+        waste = 0;
+        remaining = width;
+        for (size_t i = index; remaining > 0; i++)
+        {
+            int span = std::min(remaining, m_Skyline[i].width);
+            waste += (y - m_Skyline[i].y) * span;
+            remaining -= span;
+        }
+        return true;
+    }
+
+    void AddLevel(size_t index, const AtlasRect& rect)
+    {
+        Segment segment{ rect.x, rect.y + rect.height, rect.width };
+        m_Skyline.insert(m_Skyline.begin() + index, segment);
+
+        // shrink or remove the segments now covered by the new one
+        for (size_t i = index + 1; i < m_Skyline.size(); i++)
+        {
+            int end = m_Skyline[i - 1].x + m_Skyline[i - 1].width;
+            if (m_Skyline[i].x >= end)
+                break;
+            int shrink = end - m_Skyline[i].x;
+            m_Skyline[i].x += shrink;
+            m_Skyline[i].width -= shrink;
+            if (m_Skyline[i].width > 0)
+                break;
+            m_Skyline.erase(m_Skyline.begin() + i);
+            i--;
+        }
+
+        // merge neighbours at the same height
+        for (size_t i = 0; i + 1 < m_Skyline.size(); i++)
+        {
+            if (m_Skyline[i].y == m_Skyline[i + 1].y)
+            {
+                m_Skyline[i].width += m_Skyline[i + 1].width;
+                m_Skyline.erase(m_Skyline.begin() + i + 1);
+                i--;
+            }
+        }
+    }
+};
+
+// 8-bit RGBA image
+struct AtlasImage
+{
+    int width = 0;
+    int height = 0;
+    std::vector<unsigned char> pixels;
+
+    bool Valid() const { return width > 0 && height > 0; }
+
+    // converts 1-4 channel 8-bit pixels to RGBA
+    static AtlasImage FromPixels(const unsigned char* data, int width, int height, int channels)
+    {
+        AtlasImage image;
+        image.width = width;
+        image.height = height;
+        image.pixels.resize(size_t(width) * height * 4);
+        for (size_t i = 0; i < size_t(width) * height; i++)
+        {
+            const unsigned char* src = data + i * channels;
+            unsigned char* dst = &image.pixels[i * 4];
+            dst[0] = src[0];
+            dst[1] = channels > 2 ? src[1] : src[0];
+            dst[2] = channels > 2 ? src[2] : src[0];
+            dst[3] = channels == 4 ? src[3] : (channels == 2 ? src[1] : 255);
+        }
+        return image;
+    }
+
+    static AtlasImage Solid(int width, int height, const unsigned char color[4])
+    {
+        AtlasImage image;
+        image.width = width;
+        image.height = height;
+        image.pixels.resize(size_t(width) * height * 4);
+        for (size_t i = 0; i < size_t(width) * height; i++)
+            std::memcpy(&image.pixels[i * 4], color, 4);
+        return image;
+    }
+
+    // bilinear resample, used when a material's textures don't all have the same size
+    AtlasImage Resized(int newWidth, int newHeight) const
+    {
+        if (newWidth == width && newHeight == height)
+            return *this;
+        AtlasImage image;
+        image.width = newWidth;
+        image.height = newHeight;
+        image.pixels.resize(size_t(newWidth) * newHeight * 4);
+        for (int y = 0; y < newHeight; y++)
+        {
+            float sy = std::max(0.0f, (y + 0.5f) * height / newHeight - 0.5f);
+            int y0 = std::min(int(sy), height - 1), y1 = std::min(y0 + 1, height - 1);
+            float fy = sy - y0;
+            for (int x = 0; x < newWidth; x++)
+            {
+                float sx = std::max(0.0f, (x + 0.5f) * width / newWidth - 0.5f);
+                int x0 = std::min(int(sx), width - 1), x1 = std::min(x0 + 1, width - 1);
+                float fx = sx - x0;
+                for (int c = 0; c < 4; c++)
+                {
+                    float top = Texel(x0, y0, c) * (1.0f - fx) + Texel(x1, y0, c) * fx;
+                    float bottom = Texel(x0, y1, c) * (1.0f - fx) + Texel(x1, y1, c) * fx;
+                    image.pixels[(size_t(y) * newWidth + x) * 4 + c] = static_cast<unsigned char>(top * (1.0f - fy) + bottom * fy + 0.5f);
+                }
+            }
+        }
+        return image;
+    }
+
+private:
+    float Texel(int x, int y, int c) const { return pixels[(size_t(y) * width + x) * 4 + c]; }
+};
+
+// the textures one material contributes, one image per atlas layer (texture type); invalid images are filled
+// with the layer's default color
+struct AtlasMaterial
+{
+    std::vector<AtlasImage> images;
+};
+
+class MaterialAtlas
+{
+public:
+    static const int MAX_SIZE = 8192;
+
+    int width = 0;
+    int height = 0;
+    int padding = 0;
+    std::vector<AtlasRect> rects;                         // per material, inside the padding
+    std::vector<std::vector<unsigned char>> layerPixels;  // per texture type, RGBA
+
+    // packs materials (every one with the same number of images) into atlases of layerCount types.
+    // materials are scaled down to at most maxMaterialSize. returns false when they don't fit MAX_SIZE.
+    bool Build(const std::vector<AtlasMaterial>& materials, const std::vector<glm::u8vec4>& defaultColors, int maxMaterialSize = 1024, int padding = 4)
+    {
+        this->padding = padding;
+        const size_t layerCount = defaultColors.size();
+
+        // a material's rectangle is as large as its largest texture
+        std::vector<glm::ivec2> sizes(materials.size(), glm::ivec2(1));
+        size_t area = 0;
+        for (size_t m = 0; m < materials.size(); m++)
+        {
+            for (const AtlasImage& image : materials[m].images)
+                if (image.Valid())
+                    sizes[m] = glm::max(sizes[m], glm::ivec2(image.width, image.height));
+            float scale = std::min(1.0f, float(maxMaterialSize) / float(std::max(sizes[m].x, sizes[m].y)));
+            sizes[m] = glm::max(glm::ivec2(glm::vec2(sizes[m]) * scale), glm::ivec2(1));
+            area += size_t(sizes[m].x + 2 * padding) * (sizes[m].y + 2 * padding);
+        }
+
+        // insert the tallest first, that packs skylines tightest
+        std::vector<size_t> order(materials.size());
+        for (size_t m = 0; m < order.size(); m++)
+            order[m] = m;
+        std::sort(order.begin(), order.end(), [&sizes](size_t a, size_t b)
+            {
+                return sizes[a].y != sizes[b].y ? sizes[a].y > sizes[b].y : sizes[a].x > sizes[b].x;
+            });
+
+        // smallest power of two square (or 2:1) atlas the rectangles fit into
+        int side = 64;
+        while (size_t(side) * side < area)
+            side *= 2;
+        rects.assign(materials.size(), AtlasRect());
+        for (width = side, height = side / 2; width <= MAX_SIZE; )
+        {
+            if (height >= 1 && Pack(sizes, order, padding))
+                break;
+            if (height < width)
+                height = width;
+            else
+                width *= 2, height = width / 2;
+        }
+        if (width > MAX_SIZE)
+            return false;
+
+        layerPixels.assign(layerCount, std::vector<unsigned char>());
+        for (size_t layer = 0; layer < layerCount; layer++)
+        {
+            std::vector<unsigned char>& pixels = layerPixels[layer];
+            pixels.resize(size_t(width) * height * 4);
+            const unsigned char* color = &defaultColors[layer][0];
+            for (size_t i = 0; i < size_t(width) * height; i++)
+                std::memcpy(&pixels[i * 4], color, 4);
+
+            for (size_t m = 0; m < materials.size(); m++)
+            {
+                const AtlasRect& rect = rects[m];
+                const AtlasImage* source = layer < materials[m].images.size() && materials[m].images[layer].Valid() ? &materials[m].images[layer] : nullptr;
+                AtlasImage image = source ? source->Resized(rect.width, rect.height) : AtlasImage::Solid(rect.width, rect.height, color);
+                Blit(pixels, image, rect);
+            }
+        }
+        return true;
+    }
+
+    // moves a [0, 1] texture coordinate into the material's rectangle
+    glm::vec2 RemapUV(const glm::vec2& uv, size_t material) const
+    {
+        const AtlasRect& rect = rects[material];
+        glm::vec2 clamped = glm::clamp(uv, glm::vec2(0.0f), glm::vec2(1.0f));
+        return (glm::vec2(rect.x, rect.y) + clamped * glm::vec2(rect.width, rect.height)) / glm::vec2(width, height);
+    }
+
+    // true when every texture coordinate can be remapped without changing what the mesh looks like
+    static bool CanRemap(const glm::vec2* uvs, size_t count, size_t stride = sizeof(glm::vec2))
+    {
+        const float EPSILON = 1.0e-3f;
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(uvs);
+        for (size_t i = 0; i < count; i++)
+        {
+            const glm::vec2& uv = *reinterpret_cast<const glm::vec2*>(bytes + i * stride);
+            if (uv.x < -EPSILON || uv.y < -EPSILON || uv.x > 1.0f + EPSILON || uv.y > 1.0f + EPSILON)
+                return false;
+        }
+        return true;
+    }
+
+    // fraction of the atlas covered by material texels (without padding)
+    float Density() const
+    {
+        size_t used = 0;
+        for (const AtlasRect& rect : rects)
+            used += size_t(rect.width) * rect.height;
+        return width > 0 ? float(used) / (float(width) * float(height)) : 0.0f;
+    }
+
+    // uploads one layer as a mipmapped GL_TEXTURE_2D, gamma stores it as sRGB like gamma corrected model textures.
+    // returns the texture id
+    unsigned int Upload(size_t layer, bool gamma = false) const
+    {
+        unsigned int textureID;
+        glGenTextures(1, &textureID);
+        glBindTexture(GL_TEXTURE_2D, textureID);
+        glTexImage2D(GL_TEXTURE_2D, 0, gamma ? GL_SRGB_ALPHA : GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, layerPixels[layer].data());
+        glGenerateMipmap(GL_TEXTURE_2D);
+        // clamp, remapped UVs never wrap and the edges must not pull in the opposite side
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        return textureID;
+    }
+
+private:
+    bool Pack(const std::vector<glm::ivec2>& sizes, const std::vector<size_t>& order, int padding)
+    {
+        SkylinePacker packer(width, height);
+        for (size_t m : order)
+        {
+            AtlasRect padded;
+            if (!packer.Insert(sizes[m].x + 2 * padding, sizes[m].y + 2 * padding, padded))
+                return false;
+            rects[m] = { padded.x + padding, padded.y + padding, sizes[m].x, sizes[m].y };
+        }
+        return true;
+    }
+
+    // copies image into rect and repeats its border texels into the padding, so filtering and the smaller
+    // mip levels don't bleed in neighbouring materials
+    void Blit(std::vector<unsigned char>& pixels, const AtlasImage& image, const AtlasRect& rect) const
+    {
+        for (int y = -padding; y < rect.height + padding; y++)
+        {
+            int sy = std::min(std::max(y, 0), rect.height - 1);
+            int dy = rect.y + y;
+            if (dy < 0 || dy >= height)
+                continue;
+            for (int x = -padding; x < rect.width + padding; x++)
+            {
+                int sx = std::min(std::max(x, 0), rect.width - 1);
+                int dx = rect.x + x;
+                if (dx < 0 || dx >= width)
+                    continue;
+                std::memcpy(&pixels[(size_t(dy) * width + dx) * 4], &image.pixels[(size_t(sy) * image.width + sx) * 4], 4);
+            }
+        }
+    }
+};
+#endif
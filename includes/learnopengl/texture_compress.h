@@ -0,0 +1,391 @@
+#ifndef TEXTURE_COMPRESS_H
+#define TEXTURE_COMPRESS_H
+
+#include <glad/glad.h>
+#include <stb_image.h>
+
+extern "C" {
+#include <image_DXT.h>
+}
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Block compression (DXT1/BC1 for opaque, DXT5/BC3 for images with alpha) on top of the bundled image_DXT encoder,
+// with a full mip chain and a DDS file cache next to the source image.
+// S3TC is an extension and not core GL, the loaders check IsSupported and upload plain pixels without it.
+// Single channel maps (roughness, AO, height) stay uncompressed, DXT1 would expand them to RGB and blur them with color
+// endpoints meant for three channels.
+
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+
+struct CompressedMip
+{
+    int width = 0;
+    int height = 0;
+    std::vector<unsigned char> data;
+};
+
+struct CompressedTexture
+{
+    bool hasAlpha = false; // DXT5 when true, DXT1 otherwise
+    std::vector<CompressedMip> mips;
+
+    bool Valid() const { return !mips.empty(); }
+
+    // srgb picks the formats that decode color data to linear when sampled
+    GLenum GLFormat(bool srgb = false) const
+    {
+        if (srgb)
+            return hasAlpha ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_SRGB_S3TC_DXT1_EXT;
+        return hasAlpha ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    }
+
+    size_t Size() const
+    {
+        size_t size = 0;
+        for (const CompressedMip& mip : mips)
+            size += mip.data.size();
+        return size;
+    }
+
+    // size of the same mip chain uploaded as GL_RGBA8, for reporting the savings
+    size_t UncompressedSize() const
+    {
+        size_t size = 0;
+        for (const CompressedMip& mip : mips)
+            size += size_t(mip.width) * mip.height * 4;
+        return size;
+    }
+};
+
+// uploads 8 bit pixels with a full mip chain, gamma stores 3 and 4 channel images as sRGB
+inline void UploadTexturePixels(unsigned int textureID, const unsigned char* pixels, int width, int height, int components, bool gamma = false)
+{
+    GLenum format = GL_RGB;
+    if (components == 1)
+        format = GL_RED;
+    else if (components == 3)
+        format = GL_RGB;
+    else if (components == 4)
+        format = GL_RGBA;
+    GLenum internalFormat = format;
+    if (gamma && format == GL_RGB)
+        internalFormat = GL_SRGB;
+    else if (gamma && format == GL_RGBA)
+        internalFormat = GL_SRGB_ALPHA;
+
+    // rows of 1 or 3 component images aren't 4 byte aligned
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, GL_UNSIGNED_BYTE, pixels);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+}
+
+class TextureCompressor
+{
+public:
+    static int BlockSize(bool hasAlpha) { return hasAlpha ? 16 : 8; }
+
+    // whether the driver takes DXT1/DXT5 uploads, with srgb also their sRGB formats. The extensions are queried once,
+    // the first call needs a current context so make it on the GL thread
+    static bool IsSupported(bool srgb = false)
+    {
+        static const bool s3tc = HasExtension("GL_EXT_texture_compression_s3tc");
+        static const bool s3tcSrgb = s3tc && (HasExtension("GL_EXT_texture_sRGB") || HasExtension("GL_EXT_texture_compression_s3tc_srgb"));
+        return srgb ? s3tcSrgb : s3tc;
+    }
+
+    // the loaders keep images with this many channels uncompressed, see the top of the file
+    static bool ShouldCompress(int channels)
+    {
+        return channels > 1;
+    }
+
+    static size_t MipDataSize(int width, int height, bool hasAlpha)
+    {
+        return size_t((width + 3) / 4) * ((height + 3) / 4) * BlockSize(hasAlpha);
+    }
+
+    // compresses pixels and its mip chain, spreading strips of 4x4 blocks of every level over threadCount threads
+    static CompressedTexture Compress(const unsigned char* pixels, int width, int height, int channels, unsigned int threadCount = 0)
+    {
+        CompressedTexture texture;
+        if (!pixels || width < 1 || height < 1 || channels < 1 || channels > 4)
+            return texture;
+        texture.hasAlpha = (channels == 2 || channels == 4);
+
+        // build the uncompressed mip chain first (box filter)
+        std::vector<std::vector<unsigned char>> levels;
+        std::vector<std::pair<int, int>> sizes;
+        levels.emplace_back(pixels, pixels + size_t(width) * height * channels);
+        sizes.emplace_back(width, height);
+        while (sizes.back().first > 1 || sizes.back().second > 1)
+        {
+            int w = sizes.back().first, h = sizes.back().second;
+            int nw = std::max(1, w / 2), nh = std::max(1, h / 2);
+            levels.push_back(Downsample(levels.back(), w, h, channels, nw, nh));
+            sizes.emplace_back(nw, nh);
+        }
+
+        texture.mips.resize(levels.size());
+        struct Task { size_t level; int firstRow; int rowCount; };
+        std::vector<Task> tasks;
+        for (size_t level = 0; level < levels.size(); level++)
+        {
+            CompressedMip& mip = texture.mips[level];
+            mip.width = sizes[level].first;
+            mip.height = sizes[level].second;
+            mip.data.resize(MipDataSize(mip.width, mip.height, texture.hasAlpha));
+            // strips of 16 rows = 4 rows of blocks, blocks are independent so strips can be compressed in any order
+            for (int row = 0; row < mip.height; row += STRIP_ROWS)
+                tasks.push_back({ level, row, std::min(STRIP_ROWS, mip.height - row) });
+        }
+
+        if (threadCount == 0)
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+        threadCount = std::min<unsigned int>(threadCount, static_cast<unsigned int>(tasks.size()));
+
+        std::atomic<size_t> next(0);
+        auto worker = [&]()
+        {
+            for (size_t i = next++; i < tasks.size(); i = next++)
+            {
+                const Task& task = tasks[i];
+                CompressedMip& mip = texture.mips[task.level];
+                const unsigned char* src = levels[task.level].data() + size_t(task.firstRow) * mip.width * channels;
+                int outSize = 0;
+                unsigned char* blocks = texture.hasAlpha
+                    ? convert_image_to_DXT5(src, mip.width, task.rowCount, channels, &outSize)
+                    : convert_image_to_DXT1(src, mip.width, task.rowCount, channels, &outSize);
+                if (blocks)
+                {
+                    size_t offset = MipDataSize(mip.width, task.firstRow, texture.hasAlpha);
+                    std::memcpy(mip.data.data() + offset, blocks, outSize);
+                    free(blocks);
+                }
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (unsigned int i = 1; i < threadCount; i++)
+            threads.emplace_back(worker);
+        worker();
+        for (std::thread& thread : threads)
+            thread.join();
+
+        return texture;
+    }
+
+    static bool SaveDDS(const std::string& path, const CompressedTexture& texture)
+    {
+        if (!texture.Valid())
+            return false;
+
+        DDS_header header;
+        std::memset(&header, 0, sizeof(header));
+        header.dwMagic = FourCC('D', 'D', 'S', ' ');
+        header.dwSize = 124;
+        header.dwFlags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT | DDSD_LINEARSIZE;
+        header.dwWidth = texture.mips[0].width;
+        header.dwHeight = texture.mips[0].height;
+        header.dwPitchOrLinearSize = static_cast<unsigned int>(texture.mips[0].data.size());
+        header.dwMipMapCount = static_cast<unsigned int>(texture.mips.size());
+        header.sPixelFormat.dwSize = 32;
+        header.sPixelFormat.dwFlags = DDPF_FOURCC;
+        header.sPixelFormat.dwFourCC = texture.hasAlpha ? FourCC('D', 'X', 'T', '5') : FourCC('D', 'X', 'T', '1');
+        header.sCaps.dwCaps1 = DDSCAPS_TEXTURE | DDSCAPS_COMPLEX | DDSCAPS_MIPMAP;
+
+        // write next to the destination and rename, a concurrent reader never sees a partial file
+        const std::string tempPath = path + ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if (!file)
+                return false;
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            for (const CompressedMip& mip : texture.mips)
+                file.write(reinterpret_cast<const char*>(mip.data.data()), mip.data.size());
+            if (!file)
+                return false;
+        }
+        std::error_code error;
+        std::filesystem::rename(tempPath, path, error);
+        return !error;
+    }
+
+    static bool LoadDDS(const std::string& path, CompressedTexture& texture)
+    {
+        texture = CompressedTexture();
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+            return false;
+
+        DDS_header header;
+        if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+            return false;
+        if (header.dwMagic != FourCC('D', 'D', 'S', ' ') || header.dwSize != 124 || !(header.sPixelFormat.dwFlags & DDPF_FOURCC))
+            return false;
+        if (header.sPixelFormat.dwFourCC == FourCC('D', 'X', 'T', '5'))
+            texture.hasAlpha = true;
+        else if (header.sPixelFormat.dwFourCC != FourCC('D', 'X', 'T', '1'))
+            return false;
+
+        int width = static_cast<int>(header.dwWidth);
+        int height = static_cast<int>(header.dwHeight);
+        unsigned int mipCount = std::max(1u, header.dwMipMapCount);
+        for (unsigned int level = 0; level < mipCount && width > 0 && height > 0; level++)
+        {
+            CompressedMip mip;
+            mip.width = width;
+            mip.height = height;
+            mip.data.resize(MipDataSize(width, height, texture.hasAlpha));
+            if (!file.read(reinterpret_cast<char*>(mip.data.data()), mip.data.size()))
+            {
+                texture = CompressedTexture();
+                return false;
+            }
+            texture.mips.push_back(std::move(mip));
+            if (width == 1 && height == 1)
+                break;
+            width = std::max(1, width / 2);
+            height = std::max(1, height / 2);
+        }
+        return texture.Valid();
+    }
+
+    // DDS cache file used for a source image, it is stale once the source is newer
+    static std::string CachePath(const std::string& sourcePath)
+    {
+        return sourcePath + ".dds";
+    }
+
+    static bool CacheIsFresh(const std::string& sourcePath)
+    {
+        std::error_code error;
+        auto cacheTime = std::filesystem::last_write_time(CachePath(sourcePath), error);
+        if (error)
+            return false;
+        auto sourceTime = std::filesystem::last_write_time(sourcePath, error);
+        return !error && cacheTime >= sourceTime;
+    }
+
+    // uploads all mip levels with glCompressedTexImage2D into textureID, with srgb as sRGB color data
+    static void Upload(unsigned int textureID, const CompressedTexture& texture, bool srgb = false)
+    {
+        glBindTexture(GL_TEXTURE_2D, textureID);
+        for (size_t level = 0; level < texture.mips.size(); level++)
+        {
+            const CompressedMip& mip = texture.mips[level];
+            glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), texture.GLFormat(srgb), mip.width, mip.height, 0,
+                static_cast<GLsizei>(mip.data.size()), mip.data.data());
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(texture.mips.size()) - 1);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+
+private:
+    static constexpr int STRIP_ROWS = 16;
+
+    static bool HasExtension(const char* name)
+    {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; i++)
+        {
+            const GLubyte* extension = glGetStringi(GL_EXTENSIONS, i);
+            if (extension && std::strcmp(reinterpret_cast<const char*>(extension), name) == 0)
+                return true;
+        }
+        return false;
+    }
+
+    static unsigned int FourCC(char a, char b, char c, char d)
+    {
+        return unsigned(a) | (unsigned(b) << 8) | (unsigned(c) << 16) | (unsigned(d) << 24);
+    }
+
+    static std::vector<unsigned char> Downsample(const std::vector<unsigned char>& src, int w, int h, int channels, int nw, int nh)
+    {
+        std::vector<unsigned char> dst(size_t(nw) * nh * channels);
+        for (int y = 0; y < nh; y++)
+        {
+            int y0 = std::min(y * 2, h - 1), y1 = std::min(y * 2 + 1, h - 1);
+            for (int x = 0; x < nw; x++)
+            {
+                int x0 = std::min(x * 2, w - 1), x1 = std::min(x * 2 + 1, w - 1);
+                for (int c = 0; c < channels; c++)
+                {
+                    int sum = src[(size_t(y0) * w + x0) * channels + c] + src[(size_t(y0) * w + x1) * channels + c] +
+                        src[(size_t(y1) * w + x0) * channels + c] + src[(size_t(y1) * w + x1) * channels + c];
+                    dst[(size_t(y) * nw + x) * channels + c] = static_cast<unsigned char>((sum + 2) / 4);
+                }
+            }
+        }
+        return dst;
+    }
+};
+
+// loads directory/path as a block compressed texture, compressing and caching it as DDS on the first run.
+// falls back to plain pixels when the driver has no S3TC and for single channel images
+inline unsigned int CompressedTextureFromFile(const char *path, const std::string &directory, bool gamma = false, unsigned int threadCount = 0)
+{
+    std::string filename = directory + '/' + std::string(path);
+
+    unsigned int textureID;
+    glGenTextures(1, &textureID);
+
+    int width, height, nrComponents;
+    bool compress = TextureCompressor::IsSupported(gamma);
+    if (compress && stbi_info(filename.c_str(), &width, &height, &nrComponents) && !TextureCompressor::ShouldCompress(nrComponents))
+        compress = false;
+
+    CompressedTexture texture;
+    if (!compress || !TextureCompressor::CacheIsFresh(filename) || !TextureCompressor::LoadDDS(TextureCompressor::CachePath(filename), texture))
+    {
+        unsigned char *data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
+        if (!data)
+        {
+            std::cout << "Texture failed to load at path: " << path << std::endl;
+            return textureID;
+        }
+        if (!compress)
+        {
+            UploadTexturePixels(textureID, data, width, height, nrComponents, gamma);
+            stbi_image_free(data);
+            return textureID;
+        }
+        texture = TextureCompressor::Compress(data, width, height, nrComponents, threadCount);
+        stbi_image_free(data);
+        TextureCompressor::SaveDDS(TextureCompressor::CachePath(filename), texture);
+    }
+    TextureCompressor::Upload(textureID, texture, gamma);
+    return textureID;
+}
+#endif
@@ -0,0 +1,213 @@
+#ifndef TEXTURE_DECODER_H
+#define TEXTURE_DECODER_H
+
+#include <stb_image.h>
+#include <learnopengl/texture_compress.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Image decoding on a pool of worker threads. Nothing in here touches OpenGL, so the
+// decode stage and the hand-off queue can be driven without a context.
+// With compression enabled the workers hand back DXT mip chains (from the DDS cache when it is fresh) instead of pixels.
+
+// pixels decoded from disk, owned by whoever pops it from the ready queue (release with Free)
+struct DecodedImage
+{
+    std::string path;
+    unsigned int textureID = 0; // texture object the pixels are destined for
+    bool gamma = false; // color data, uploaded with an sRGB internal format
+    int width = 0;
+    int height = 0;
+    int components = 0;
+    unsigned char* data = nullptr;
+    CompressedTexture compressed;
+
+    bool Valid() const { return data != nullptr || compressed.Valid(); }
+
+    void Free()
+    {
+        if (data)
+            stbi_image_free(data);
+        data = nullptr;
+    }
+};
+
+// unbounded multi-producer/multi-consumer queue
+template<typename T>
+class ConcurrentQueue
+{
+public:
+    void Push(T value)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Items.push_back(std::move(value));
+        }
+        m_Condition.notify_one();
+    }
+
+    // non blocking, returns false if the queue is empty
+    bool TryPop(T& out)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (m_Items.empty())
+            return false;
+        out = std::move(m_Items.front());
+        m_Items.pop_front();
+        return true;
+    }
+
+    // blocks until an item arrives or Close is called, returns false once closed and drained
+    bool WaitPop(T& out)
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_Condition.wait(lock, [this] { return m_Closed || !m_Items.empty(); });
+        if (m_Items.empty())
+            return false;
+        out = std::move(m_Items.front());
+        m_Items.pop_front();
+        return true;
+    }
+
+    void Close()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Closed = true;
+        }
+        m_Condition.notify_all();
+    }
+
+    size_t Size() const
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        return m_Items.size();
+    }
+
+private:
+    mutable std::mutex m_Mutex;
+    std::condition_variable m_Condition;
+    std::deque<T> m_Items;
+    bool m_Closed = false;
+};
+
+// decodes image files on worker threads and pushes the pixels to a ready queue
+class TextureDecodePool
+{
+public:
+    explicit TextureDecodePool(unsigned int threadCount = 0, bool compress = false) : m_Compress(compress)
+    {
+        if (threadCount == 0)
+        {
+            unsigned int hardware = std::thread::hardware_concurrency();
+            // leave one core for the GL thread
+            threadCount = hardware > 1 ? hardware - 1 : 1;
+        }
+        for (unsigned int i = 0; i < threadCount; i++)
+            m_Workers.emplace_back([this] { WorkerLoop(); });
+    }
+
+    TextureDecodePool(const TextureDecodePool&) = delete;
+    TextureDecodePool& operator=(const TextureDecodePool&) = delete;
+
+    ~TextureDecodePool()
+    {
+        m_Jobs.Close();
+        for (std::thread& worker : m_Workers)
+            worker.join();
+        // free anything nobody collected
+        DecodedImage image;
+        while (m_Ready.TryPop(image))
+            image.Free();
+    }
+
+    // queues a file for decoding, the result carries textureID and gamma back to the caller.
+    // compress = false keeps this image uncompressed even when the pool compresses
+    void Submit(const std::string& path, unsigned int textureID, bool gamma = false, bool compress = true)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_PendingMutex);
+            m_Pending++;
+        }
+        m_Jobs.Push(Job{ path, textureID, gamma, m_Compress && compress });
+    }
+
+    // pops one decoded image (valid or failed), returns false if none is ready yet
+    bool TryPopReady(DecodedImage& out)
+    {
+        if (!m_Ready.TryPop(out))
+            return false;
+        std::lock_guard<std::mutex> lock(m_PendingMutex);
+        m_Pending--;
+        return true;
+    }
+
+    // number of submitted images that haven't been popped yet
+    size_t Pending() const
+    {
+        std::lock_guard<std::mutex> lock(m_PendingMutex);
+        return m_Pending;
+    }
+
+    size_t ThreadCount() const { return m_Workers.size(); }
+
+    // the decode step on its own, runs on the calling thread
+    static DecodedImage Decode(const std::string& path, unsigned int textureID, bool compress = false, bool gamma = false)
+    {
+        DecodedImage image;
+        image.path = path;
+        image.textureID = textureID;
+        image.gamma = gamma;
+        // single channel maps stay uncompressed, also when an older DDS cache of them is around
+        int channels = 0;
+        if (compress && stbi_info(path.c_str(), &image.width, &image.height, &channels) && !TextureCompressor::ShouldCompress(channels))
+            compress = false;
+        if (compress && TextureCompressor::CacheIsFresh(path) && TextureCompressor::LoadDDS(TextureCompressor::CachePath(path), image.compressed))
+        {
+            image.width = image.compressed.mips[0].width;
+            image.height = image.compressed.mips[0].height;
+            image.components = image.compressed.hasAlpha ? 4 : 3;
+            return image;
+        }
+
+        image.data = stbi_load(path.c_str(), &image.width, &image.height, &image.components, 0);
+        if (compress && image.data)
+        {
+            // the pool already spreads images over threads, so compress each one on this thread only
+            image.compressed = TextureCompressor::Compress(image.data, image.width, image.height, image.components, 1);
+            TextureCompressor::SaveDDS(TextureCompressor::CachePath(path), image.compressed);
+            image.Free();
+        }
+        return image;
+    }
+
+private:
+    struct Job
+    {
+        std::string path;
+        unsigned int textureID;
+        bool gamma;
+        bool compress;
+    };
+
+    void WorkerLoop()
+    {
+        Job job;
+        while (m_Jobs.WaitPop(job))
+            m_Ready.Push(Decode(job.path, job.textureID, job.compress, job.gamma));
+    }
+
+    std::vector<std::thread> m_Workers;
+    ConcurrentQueue<Job> m_Jobs;
+    ConcurrentQueue<DecodedImage> m_Ready;
+    bool m_Compress;
+
+    mutable std::mutex m_PendingMutex;
+    size_t m_Pending = 0;
+};
+#endif
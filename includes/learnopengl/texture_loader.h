@@ -0,0 +1,130 @@
+#ifndef TEXTURE_LOADER_H
+#define TEXTURE_LOADER_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/texture_decoder.h>
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_set>
+
+// Streams material textures in: Request hands back a texture object that holds a 1x1 placeholder
+// straight away, decoding happens on a TextureDecodePool and ProcessUploads (GL thread, once per frame)
+// swaps in the real pixels within a time budget. Meshes keep the same texture id the whole time.
+// With compress set, textures arrive as DXT1/DXT5 mip chains cached as DDS (see texture_compress.h), as long as the
+// driver supports S3TC (sRGB S3TC for gamma corrected textures), otherwise they are uploaded as plain pixels.
+class AsyncTextureLoader
+{
+public:
+    // needs a current context, the S3TC support is checked here
+    explicit AsyncTextureLoader(unsigned int threadCount = 0, bool compress = false)
+        : m_Pool(threadCount, compress && TextureCompressor::IsSupported()),
+          m_Compress(compress && TextureCompressor::IsSupported()),
+          m_CompressSrgb(compress && TextureCompressor::IsSupported(true)) {}
+
+    // decodes that never reached ProcessUploads never write into their texture
+    ~AsyncTextureLoader() { m_Outstanding->clear(); }
+
+    // returns a texture id immediately, the image at directory/path replaces the placeholder once decoded.
+    // gamma marks color textures, they are uploaded with an sRGB internal format like TextureFromFile does
+    unsigned int Request(const char* path, const std::string& directory, bool gamma = false)
+    {
+        std::string filename = directory + '/' + std::string(path);
+
+        unsigned int textureID;
+        glGenTextures(1, &textureID);
+        UploadPlaceholder(textureID);
+
+        m_Pool.Submit(filename, textureID, gamma, Compresses(gamma));
+        m_Outstanding->insert(textureID);
+        return textureID;
+    }
+
+    // whether Request hands back block compressed textures (single channel images excepted)
+    bool Compresses(bool gamma = false) const { return gamma ? m_CompressSrgb : m_Compress; }
+
+    // true until the decoded image for textureID has been uploaded (or failed)
+    bool IsPending(unsigned int textureID) const { return m_Outstanding->count(textureID) != 0; }
+
+    // IsPending as a function that stays safe to call after the loader is destroyed, for TextureRegistry::Acquire
+    std::function<bool(unsigned int)> PendingQuery() const
+    {
+        std::shared_ptr<std::unordered_set<unsigned int>> outstanding = m_Outstanding;
+        return [outstanding](unsigned int textureID) { return outstanding->count(textureID) != 0; };
+    }
+
+    // uploads decoded images until budgetMs is used up, at least one image is uploaded per call when ready.
+    // returns the number of textures uploaded.
+    unsigned int ProcessUploads(double budgetMs = 2.0)
+    {
+        auto start = std::chrono::steady_clock::now();
+        unsigned int uploaded = 0;
+        DecodedImage image;
+        while (m_Pool.TryPopReady(image))
+        {
+            Upload(image);
+            m_Outstanding->erase(image.textureID);
+            image.Free();
+            uploaded++;
+
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            if (elapsed.count() >= budgetMs)
+                break;
+        }
+        return uploaded;
+    }
+
+    // blocks the GL thread until every requested texture is uploaded, for loading screens or headless runs
+    void Finish()
+    {
+        while (Pending() > 0)
+        {
+            if (ProcessUploads(1000.0) == 0)
+                std::this_thread::yield();
+        }
+    }
+
+    size_t Pending() const { return m_Pool.Pending(); }
+
+    // color shown until the real texture arrives
+    static void UploadPlaceholder(unsigned int textureID)
+    {
+        static const unsigned char grey[4] = { 128, 128, 128, 255 };
+        glBindTexture(GL_TEXTURE_2D, textureID);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, grey);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+
+private:
+    TextureDecodePool m_Pool;
+    bool m_Compress;
+    bool m_CompressSrgb;
+    // texture ids requested but not uploaded yet, GL thread only
+    std::shared_ptr<std::unordered_set<unsigned int>> m_Outstanding = std::make_shared<std::unordered_set<unsigned int>>();
+
+    static void Upload(const DecodedImage& image)
+    {
+        if (!image.Valid())
+        {
+            // keep the placeholder
+            std::cout << "Texture failed to load at path: " << image.path << std::endl;
+            return;
+        }
+
+        if (image.compressed.Valid())
+        {
+            TextureCompressor::Upload(image.textureID, image.compressed, image.gamma);
+            return;
+        }
+
+        UploadTexturePixels(image.textureID, image.data, image.width, image.height, image.components, image.gamma);
+    }
+};
+#endif
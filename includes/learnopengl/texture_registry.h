@@ -0,0 +1,198 @@
+#ifndef TEXTURE_REGISTRY_H
+#define TEXTURE_REGISTRY_H
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Process-wide texture cache. Textures are keyed by canonical path and load parameters, so every Model
+// (and every copy of the same Model) shares one GL texture per image. Entries are reference counted through
+// TextureHandle; unreferenced textures stay resident until CollectGarbage evicts them.
+// Only use it from the GL thread.
+
+struct TextureKey
+{
+    std::string path;
+    bool gamma = false;
+    bool compressed = false; // block compressed (DXT) or plain pixels
+
+    bool operator==(const TextureKey& other) const
+    {
+        return gamma == other.gamma && compressed == other.compressed && path == other.path;
+    }
+};
+
+struct TextureKeyHash
+{
+    size_t operator()(const TextureKey& key) const
+    {
+        return std::hash<std::string>()(key.path) ^ (key.gamma ? 0x9e3779b97f4a7c15ull : 0ull) ^ (key.compressed ? 0xc2b2ae3d27d4eb4full : 0ull);
+    }
+};
+
+struct TextureRegistryEntry
+{
+    unsigned int id = 0;
+    unsigned int refCount = 0;
+    uint64_t lastReleased = 0; // release tick, used to evict the oldest unreferenced textures first
+    std::function<bool(unsigned int)> pending; // true while an asynchronous upload into id is outstanding
+};
+
+class TextureRegistry;
+
+// counted reference to a registry entry, copy it freely
+class TextureHandle
+{
+public:
+    TextureHandle() = default;
+    TextureHandle(const TextureHandle& other) : m_Entry(other.m_Entry) { AddRef(); }
+    TextureHandle(TextureHandle&& other) noexcept : m_Entry(other.m_Entry) { other.m_Entry = nullptr; }
+    ~TextureHandle() { Reset(); }
+
+    TextureHandle& operator=(const TextureHandle& other)
+    {
+        if (this != &other)
+        {
+            Reset();
+            m_Entry = other.m_Entry;
+            AddRef();
+        }
+        return *this;
+    }
+
+    TextureHandle& operator=(TextureHandle&& other) noexcept
+    {
+        if (this != &other)
+        {
+            Reset();
+            m_Entry = other.m_Entry;
+            other.m_Entry = nullptr;
+        }
+        return *this;
+    }
+
+    unsigned int ID() const { return m_Entry ? m_Entry->id : 0; }
+    bool Valid() const { return m_Entry != nullptr; }
+    unsigned int RefCount() const { return m_Entry ? m_Entry->refCount : 0; }
+
+    inline void Reset();
+
+private:
+    friend class TextureRegistry;
+    explicit TextureHandle(TextureRegistryEntry* entry) : m_Entry(entry) { AddRef(); }
+
+    void AddRef()
+    {
+        if (m_Entry)
+            m_Entry->refCount++;
+    }
+
+    TextureRegistryEntry* m_Entry = nullptr; // unordered_map nodes never move, so this stays valid until eviction
+};
+
+class TextureRegistry
+{
+public:
+    typedef std::function<unsigned int()> CreateFunction;
+    typedef std::function<void(unsigned int)> DestroyFunction;
+    typedef std::function<bool(unsigned int)> PendingFunction;
+
+    static TextureRegistry& Instance()
+    {
+        static TextureRegistry registry;
+        return registry;
+    }
+
+    // returns the texture for filename, calling create only when no texture with the same key is resident.
+    // when create starts an asynchronous upload, pending tells whether it is still outstanding (see CollectGarbage)
+    TextureHandle Acquire(const std::string& filename, bool gamma, bool compressed, const CreateFunction& create,
+                          const PendingFunction& pending = PendingFunction())
+    {
+        TextureKey key{ CanonicalPath(filename), gamma, compressed };
+        auto it = m_Entries.find(key);
+        if (it == m_Entries.end())
+        {
+            TextureRegistryEntry entry;
+            entry.id = create();
+            entry.pending = pending;
+            m_CreateCount++;
+            it = m_Entries.emplace(std::move(key), entry).first;
+        }
+        return TextureHandle(&it->second);
+    }
+
+    // evicts unreferenced textures, oldest first, until at most keepUnused remain. returns the number evicted.
+    // textures whose upload is still pending are kept, the loader would otherwise write into a deleted (or reused) name
+    size_t CollectGarbage(size_t keepUnused = 0)
+    {
+        std::vector<std::unordered_map<TextureKey, TextureRegistryEntry, TextureKeyHash>::iterator> unused;
+        for (auto it = m_Entries.begin(); it != m_Entries.end(); ++it)
+        {
+            const TextureRegistryEntry& entry = it->second;
+            if (entry.refCount == 0 && !(entry.pending && entry.pending(entry.id)))
+                unused.push_back(it);
+        }
+        if (unused.size() <= keepUnused)
+            return 0;
+
+        std::sort(unused.begin(), unused.end(), [](const auto& a, const auto& b)
+            {
+                return a->second.lastReleased < b->second.lastReleased;
+            });
+        size_t evictCount = unused.size() - keepUnused;
+        for (size_t i = 0; i < evictCount; i++)
+        {
+            m_Destroy(unused[i]->second.id);
+            m_Entries.erase(unused[i]);
+        }
+        return evictCount;
+    }
+
+    // lets tests and headless tools run without a GL context
+    void SetDestroyFunction(const DestroyFunction& destroy) { m_Destroy = destroy; }
+
+    // number of times a texture actually had to be created (decoded and uploaded)
+    size_t CreateCount() const { return m_CreateCount; }
+    size_t Size() const { return m_Entries.size(); }
+
+    static std::string CanonicalPath(const std::string& filename)
+    {
+        // absolute first, weakly_canonical leaves a relative path alone when no part of it exists yet
+        std::error_code error;
+        std::filesystem::path canonical = std::filesystem::absolute(filename, error);
+        if (!error)
+            canonical = std::filesystem::weakly_canonical(canonical, error);
+        if (error)
+            canonical = std::filesystem::path(filename).lexically_normal();
+        return canonical.generic_string();
+    }
+
+private:
+    friend class TextureHandle;
+
+    TextureRegistry() : m_Destroy([](unsigned int id) { glDeleteTextures(1, &id); }) {}
+
+    void Released(TextureRegistryEntry* entry)
+    {
+        entry->lastReleased = ++m_ReleaseTick;
+    }
+
+    std::unordered_map<TextureKey, TextureRegistryEntry, TextureKeyHash> m_Entries;
+    DestroyFunction m_Destroy;
+    size_t m_CreateCount = 0;
+    uint64_t m_ReleaseTick = 0;
+};
+
+inline void TextureHandle::Reset()
+{
+    if (m_Entry && --m_Entry->refCount == 0)
+        TextureRegistry::Instance().Released(m_Entry);
+    m_Entry = nullptr;
+}
+#endif
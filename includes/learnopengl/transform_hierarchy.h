@@ -0,0 +1,343 @@
+#ifndef TRANSFORM_HIERARCHY_H
+#define TRANSFORM_HIERARCHY_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <learnopengl/job_system.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Flat transform hierarchy: local translation, rotation (quaternion) and scale plus the world matrix of every node in
+// separate arrays, laid out in depth first order. Parents come before their children and every subtree is one
+// contiguous range [i, SubtreeEnd(i)), so
+//  - moving a node marks its subtree dirty by setting one range of bits,
+//  - Update computes world matrices in a single forward pass over the dirty bits, skipping clean words 64 nodes at a
+//    time, and
+//  - dirty subtrees are independent ranges that a JobSystem can update in parallel.
+// Nodes are addressed by handles that stay valid while nodes around them are created, destroyed or reparented; those
+// structural changes only flag the layout, which Update rebuilds in one pass.
+class TransformHierarchy
+{
+public:
+    typedef uint32_t Handle;
+    static constexpr Handle Invalid = ~0u;
+
+    Handle Create(Handle parent = Invalid, const glm::vec3& position = glm::vec3(0.0f),
+                  const glm::quat& rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f), const glm::vec3& scale = glm::vec3(1.0f))
+    {
+        Handle handle;
+        if (!m_FreeHandles.empty())
+        {
+            handle = m_FreeHandles.back();
+            m_FreeHandles.pop_back();
+        }
+        else
+        {
+            handle = static_cast<Handle>(m_HandleToIndex.size());
+            m_HandleToIndex.push_back(0);
+        }
+
+        // appending keeps the layout when the parent's subtree ends at the back, as when building a tree depth first
+        const uint32_t index = static_cast<uint32_t>(m_Parent.size());
+        const uint32_t parentIndex = parent == Invalid ? Invalid : m_HandleToIndex[parent];
+        if (parentIndex != Invalid && m_SubtreeEnd[parentIndex] != index)
+            m_LayoutDirty = true;
+
+        m_HandleToIndex[handle] = index;
+        m_IndexToHandle.push_back(handle);
+        m_Parent.push_back(parentIndex);
+        m_SubtreeEnd.push_back(index + 1);
+        m_Position.push_back(position);
+        m_Rotation.push_back(rotation);
+        m_Scale.push_back(scale);
+        m_World.push_back(glm::mat4(1.0f));
+        m_Dirty.resize((m_Parent.size() + 63) / 64, 0);
+        SetDirty(index);
+
+        if (!m_LayoutDirty)
+            for (uint32_t ancestor = parentIndex; ancestor != Invalid; ancestor = m_Parent[ancestor])
+                m_SubtreeEnd[ancestor] = index + 1;
+        return handle;
+    }
+
+    // destroys node and everything below it, their handles become invalid
+    void Destroy(Handle node)
+    {
+        RebuildLayout();
+        const uint32_t begin = m_HandleToIndex[node];
+        const uint32_t end = m_SubtreeEnd[begin];
+        for (uint32_t i = begin; i < end; i++)
+        {
+            m_FreeHandles.push_back(m_IndexToHandle[i]);
+            m_HandleToIndex[m_IndexToHandle[i]] = Invalid;
+        }
+        std::vector<uint32_t> order;
+        order.reserve(m_Parent.size() - (end - begin));
+        for (uint32_t i = 0; i < m_Parent.size(); i++)
+            if (i < begin || i >= end)
+                order.push_back(i);
+        Reorder(order);
+    }
+
+    // parent Invalid makes node a root
+    void SetParent(Handle node, Handle parent)
+    {
+        m_Parent[m_HandleToIndex[node]] = parent == Invalid ? Invalid : m_HandleToIndex[parent];
+        m_LayoutDirty = true;
+    }
+
+    void SetLocalPosition(Handle node, const glm::vec3& position)
+    {
+        m_Position[m_HandleToIndex[node]] = position;
+        MarkSubtreeDirty(m_HandleToIndex[node]);
+    }
+
+    void SetLocalRotation(Handle node, const glm::quat& rotation)
+    {
+        m_Rotation[m_HandleToIndex[node]] = rotation;
+        MarkSubtreeDirty(m_HandleToIndex[node]);
+    }
+
+    void SetLocalScale(Handle node, const glm::vec3& scale)
+    {
+        m_Scale[m_HandleToIndex[node]] = scale;
+        MarkSubtreeDirty(m_HandleToIndex[node]);
+    }
+
+    const glm::vec3& GetLocalPosition(Handle node) const { return m_Position[m_HandleToIndex[node]]; }
+    const glm::quat& GetLocalRotation(Handle node) const { return m_Rotation[m_HandleToIndex[node]]; }
+    const glm::vec3& GetLocalScale(Handle node) const { return m_Scale[m_HandleToIndex[node]]; }
+    Handle GetParent(Handle node) const
+    {
+        uint32_t parent = m_Parent[m_HandleToIndex[node]];
+        return parent == Invalid ? Invalid : m_IndexToHandle[parent];
+    }
+
+    // as of the last Update
+    const glm::mat4& GetWorldMatrix(Handle node) const { return m_World[m_HandleToIndex[node]]; }
+
+    // world matrices by layout index, with IndexToHandle, for passes over every node (culling, instance lists)
+    const std::vector<glm::mat4>& GetWorldMatrices() const { return m_World; }
+    Handle IndexToHandle(uint32_t index) const { return m_IndexToHandle[index]; }
+    uint32_t HandleToIndex(Handle node) const { return m_HandleToIndex[node]; }
+    size_t Size() const { return m_Parent.size(); }
+
+    // recomputes the world matrix of every dirty node. With a JobSystem, dirty subtrees of more than grain nodes are
+    // split below their root and the pieces run in parallel
+    void Update(JobSystem* jobs = nullptr, size_t grain = 1024)
+    {
+        RebuildLayout();
+        if (!jobs || jobs->ThreadCount() == 1)
+        {
+            UpdateDirtyRange(0, static_cast<uint32_t>(m_Parent.size()));
+            std::fill(m_Dirty.begin(), m_Dirty.end(), 0);
+            return;
+        }
+
+        // independent pieces: dirty nodes whose parent is clean, with their whole subtree
+        m_Tasks.clear();
+        for (uint32_t i = NextDirty(0); i < m_Parent.size(); i = NextDirty(m_SubtreeEnd[i]))
+            m_Tasks.push_back(i);
+        // a big piece has its root computed here and its child subtrees become pieces of their own
+        for (size_t t = 0; t < m_Tasks.size(); t++)
+        {
+            uint32_t root = m_Tasks[t];
+            if (m_SubtreeEnd[root] - root <= grain || m_SubtreeEnd[root] == root + 1)
+                continue;
+            ComputeWorld(root);
+            m_Tasks[t] = root + 1;
+            for (uint32_t child = m_SubtreeEnd[root + 1]; child < m_SubtreeEnd[root]; child = m_SubtreeEnd[child])
+                m_Tasks.push_back(child);
+            t--;
+        }
+        jobs->ParallelFor(m_Tasks.size(), std::max<size_t>(1, m_Tasks.size() / (jobs->ThreadCount() * 8)), [this](size_t begin, size_t end)
+        {
+            for (size_t t = begin; t < end; t++)
+                for (uint32_t i = m_Tasks[t]; i < m_SubtreeEnd[m_Tasks[t]]; i++)
+                    ComputeWorld(i);
+        });
+        std::fill(m_Dirty.begin(), m_Dirty.end(), 0);
+    }
+
+    // heap memory of the node arrays, in bytes
+    size_t GetMemoryUsage() const
+    {
+        return m_Parent.capacity() * sizeof(uint32_t) * 4 + m_Position.capacity() * sizeof(glm::vec3) * 2 +
+               m_Rotation.capacity() * sizeof(glm::quat) + m_World.capacity() * sizeof(glm::mat4) + m_Dirty.capacity() * sizeof(uint64_t);
+    }
+
+private:
+    // per node, by layout index
+    std::vector<uint32_t> m_Parent;     // layout index of the parent, Invalid for roots
+    std::vector<uint32_t> m_SubtreeEnd; // one past the last node of the subtree
+    std::vector<glm::vec3> m_Position;
+    std::vector<glm::quat> m_Rotation;
+    std::vector<glm::vec3> m_Scale;
+    std::vector<glm::mat4> m_World;
+    std::vector<uint32_t> m_IndexToHandle;
+    std::vector<uint64_t> m_Dirty; // one bit per node
+
+    std::vector<uint32_t> m_HandleToIndex; // Invalid for destroyed handles
+    std::vector<Handle> m_FreeHandles;
+    bool m_LayoutDirty = false;
+    std::vector<uint32_t> m_Tasks;
+
+    bool IsDirty(uint32_t index) const { return (m_Dirty[index >> 6] >> (index & 63)) & 1; }
+    void SetDirty(uint32_t index) { m_Dirty[index >> 6] |= uint64_t(1) << (index & 63); }
+
+    void MarkSubtreeDirty(uint32_t begin)
+    {
+        if (m_LayoutDirty)
+        {
+            // subtree ranges are stale until the rebuild, which dirties everything anyway
+            SetDirty(begin);
+            return;
+        }
+        const uint32_t end = m_SubtreeEnd[begin];
+        for (uint32_t i = begin; i < end;)
+        {
+            // whole words at once where the range covers them
+            if ((i & 63) == 0 && i + 64 <= end)
+            {
+                m_Dirty[i >> 6] = ~uint64_t(0);
+                i += 64;
+            }
+            else
+                SetDirty(i++);
+        }
+    }
+
+    // first dirty node at or after index, Size() if there is none
+    uint32_t NextDirty(uint32_t index) const
+    {
+        const uint32_t count = static_cast<uint32_t>(m_Parent.size());
+        while (index < count)
+        {
+            uint64_t word = m_Dirty[index >> 6] >> (index & 63);
+            if (word != 0)
+                return std::min(count, index + CountTrailingZeros(word));
+            index = (index | 63) + 1;
+        }
+        return count;
+    }
+
+    static uint32_t CountTrailingZeros(uint64_t word)
+    {
+        uint32_t count = 0;
+        while ((word & 0xffffffff) == 0) { word >>= 32; count += 32; }
+        while ((word & 0xff) == 0) { word >>= 8; count += 8; }
+        while ((word & 1) == 0) { word >>= 1; count++; }
+        return count;
+    }
+
+    void UpdateDirtyRange(uint32_t begin, uint32_t end)
+    {
+        for (uint32_t i = NextDirty(begin); i < end; i = NextDirty(i + 1))
+            ComputeWorld(i);
+    }
+
+    void ComputeWorld(uint32_t i)
+    {
+        glm::mat4 local = glm::mat4_cast(m_Rotation[i]);
+        local[0] *= m_Scale[i].x;
+        local[1] *= m_Scale[i].y;
+        local[2] *= m_Scale[i].z;
+        local[3] = glm::vec4(m_Position[i], 1.0f);
+        m_World[i] = m_Parent[i] == Invalid ? local : m_World[m_Parent[i]] * local;
+    }
+
+    // puts the nodes back into depth first order after structural changes and dirties every node
+    void RebuildLayout()
+    {
+        if (!m_LayoutDirty)
+            return;
+        const uint32_t count = static_cast<uint32_t>(m_Parent.size());
+
+        // children of every node in creation order, as ranges of one array (counting sort by parent)
+        std::vector<uint32_t> childStart(count + 2, 0);
+        for (uint32_t i = 0; i < count; i++)
+            childStart[(m_Parent[i] == Invalid ? count : m_Parent[i]) + 1]++;
+        for (uint32_t i = 0; i <= count; i++)
+            childStart[i + 1] += childStart[i];
+        std::vector<uint32_t> children(count);
+        std::vector<uint32_t> fill(childStart.begin(), childStart.end() - 1);
+        for (uint32_t i = 0; i < count; i++)
+            children[fill[m_Parent[i] == Invalid ? count : m_Parent[i]]++] = i;
+
+        // depth first from the roots, children pushed in reverse to keep their order
+        std::vector<uint32_t> order;
+        order.reserve(count);
+        std::vector<uint32_t> stack;
+        for (uint32_t c = childStart[count + 1]; c-- > childStart[count];)
+            stack.push_back(children[c]);
+        while (!stack.empty())
+        {
+            uint32_t node = stack.back();
+            stack.pop_back();
+            order.push_back(node);
+            for (uint32_t c = childStart[node + 1]; c-- > childStart[node];)
+                stack.push_back(children[c]);
+        }
+        // nodes on a parent cycle are never reached from a root, they are made roots
+        if (order.size() < count)
+        {
+            std::vector<bool> reached(count, false);
+            for (uint32_t node : order)
+                reached[node] = true;
+            for (uint32_t i = 0; i < count; i++)
+                if (!reached[i])
+                {
+                    m_Parent[i] = Invalid;
+                    order.push_back(i);
+                }
+        }
+        m_LayoutDirty = false;
+        Reorder(order);
+    }
+
+    // keeps the nodes order[0], order[1], ... in that order, parents must precede their children in order
+    void Reorder(const std::vector<uint32_t>& order)
+    {
+        const uint32_t count = static_cast<uint32_t>(order.size());
+        std::vector<uint32_t> newIndex(m_Parent.size(), Invalid);
+        for (uint32_t i = 0; i < count; i++)
+            newIndex[order[i]] = i;
+
+        std::vector<uint32_t> parent(count), handles(count);
+        std::vector<glm::vec3> position(count), scale(count);
+        std::vector<glm::quat> rotation(count);
+        std::vector<glm::mat4> world(count);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            uint32_t old = order[i];
+            parent[i] = m_Parent[old] == Invalid ? Invalid : newIndex[m_Parent[old]];
+            handles[i] = m_IndexToHandle[old];
+            position[i] = m_Position[old];
+            rotation[i] = m_Rotation[old];
+            scale[i] = m_Scale[old];
+            world[i] = m_World[old];
+            m_HandleToIndex[handles[i]] = i;
+        }
+        m_Parent.swap(parent);
+        m_IndexToHandle.swap(handles);
+        m_Position.swap(position);
+        m_Rotation.swap(rotation);
+        m_Scale.swap(scale);
+        m_World.swap(world);
+
+        // subtree ends from the back, children always follow their parent
+        m_SubtreeEnd.assign(count, 0);
+        for (uint32_t i = 0; i < count; i++)
+            m_SubtreeEnd[i] = i + 1;
+        for (uint32_t i = count; i-- > 0;)
+            if (m_Parent[i] != Invalid)
+                m_SubtreeEnd[m_Parent[i]] = std::max(m_SubtreeEnd[m_Parent[i]], m_SubtreeEnd[i]);
+
+        m_Dirty.assign((count + 63) / 64, ~uint64_t(0));
+    }
+};
+#endif
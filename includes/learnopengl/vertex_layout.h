@@ -0,0 +1,176 @@
+#ifndef VERTEX_LAYOUT_H
+#define VERTEX_LAYOUT_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Describes which vertex attributes a mesh uploads and in what format. Attribute locations are fixed
+// (they match the layout(location = N) used by the shaders), so a shader reading an attribute a mesh
+// doesn't upload simply gets the default (0, 0, 0, 1).
+
+enum VertexAttribute
+{
+    VERTEX_ATTRIBUTE_POSITION     = 0,
+    VERTEX_ATTRIBUTE_NORMAL       = 1,
+    VERTEX_ATTRIBUTE_TEXCOORDS    = 2,
+    VERTEX_ATTRIBUTE_TANGENT      = 3,
+    VERTEX_ATTRIBUTE_BITANGENT    = 4,
+    VERTEX_ATTRIBUTE_BONE_IDS     = 5,
+    VERTEX_ATTRIBUTE_BONE_WEIGHTS = 6,
+    VERTEX_ATTRIBUTE_COUNT        = 7
+};
+
+#define VERTEX_ATTRIBUTE_BIT(attribute) (1u << (attribute))
+#define VERTEX_ATTRIBUTES_ALL ((1u << VERTEX_ATTRIBUTE_COUNT) - 1u)
+#define VERTEX_ATTRIBUTES_STATIC (VERTEX_ATTRIBUTES_ALL & ~(VERTEX_ATTRIBUTE_BIT(VERTEX_ATTRIBUTE_BONE_IDS) | VERTEX_ATTRIBUTE_BIT(VERTEX_ATTRIBUTE_BONE_WEIGHTS)))
+
+struct VertexAttributeFormat
+{
+    unsigned int location;
+    GLint components;
+    GLenum type;
+    GLboolean normalized;
+    bool integer;       // uploaded with glVertexAttribIPointer
+    unsigned int offset;
+    unsigned int size;  // bytes
+};
+
+class VertexLayout
+{
+public:
+    unsigned int attributeMask = 0;
+    bool halfTexCoords = false;  // texture coordinates as 2 x GL_HALF_FLOAT
+    bool packedVectors = false;  // normal, tangent and bitangent as GL_INT_2_10_10_10_REV
+    unsigned int stride = 0;
+    std::vector<VertexAttributeFormat> attributes;
+
+    VertexLayout() = default;
+
+    VertexLayout(unsigned int mask, bool halfTexCoords = false, bool packedVectors = false)
+        : attributeMask(mask | VERTEX_ATTRIBUTE_BIT(VERTEX_ATTRIBUTE_POSITION)), halfTexCoords(halfTexCoords), packedVectors(packedVectors)
+    {
+        Add(VERTEX_ATTRIBUTE_POSITION, 3, GL_FLOAT, GL_FALSE, false, 12);
+        if (Has(VERTEX_ATTRIBUTE_NORMAL))
+            AddVector(VERTEX_ATTRIBUTE_NORMAL);
+        if (Has(VERTEX_ATTRIBUTE_TEXCOORDS))
+        {
+            if (halfTexCoords)
+                Add(VERTEX_ATTRIBUTE_TEXCOORDS, 2, GL_HALF_FLOAT, GL_FALSE, false, 4);
+            else
+                Add(VERTEX_ATTRIBUTE_TEXCOORDS, 2, GL_FLOAT, GL_FALSE, false, 8);
+        }
+        if (Has(VERTEX_ATTRIBUTE_TANGENT))
+            AddVector(VERTEX_ATTRIBUTE_TANGENT);
+        if (Has(VERTEX_ATTRIBUTE_BITANGENT))
+            AddVector(VERTEX_ATTRIBUTE_BITANGENT);
+        if (Has(VERTEX_ATTRIBUTE_BONE_IDS))
+            Add(VERTEX_ATTRIBUTE_BONE_IDS, 4, GL_INT, GL_FALSE, true, 16);
+        if (Has(VERTEX_ATTRIBUTE_BONE_WEIGHTS))
+            Add(VERTEX_ATTRIBUTE_BONE_WEIGHTS, 4, GL_FLOAT, GL_FALSE, false, 16);
+    }
+
+    // the layout of the Vertex struct itself, every attribute at full precision
+    static VertexLayout Full()
+    {
+        return VertexLayout(VERTEX_ATTRIBUTES_ALL);
+    }
+
+    bool Has(VertexAttribute attribute) const
+    {
+        return (attributeMask & VERTEX_ATTRIBUTE_BIT(attribute)) != 0;
+    }
+
+    // interleaves the enabled attributes of vertices into a buffer ready for glBufferData.
+    // Vertex is passed as a template parameter so this header doesn't depend on mesh.h
+    template<typename TVertex>
+    std::vector<unsigned char> Pack(const TVertex* vertices, size_t count) const
+    {
+        std::vector<unsigned char> buffer(count * stride);
+        for (size_t i = 0; i < count; i++)
+        {
+            const TVertex& v = vertices[i];
+            unsigned char* dst = buffer.data() + i * stride;
+            for (const VertexAttributeFormat& attribute : attributes)
+            {
+                unsigned char* out = dst + attribute.offset;
+                switch (attribute.location)
+                {
+                case VERTEX_ATTRIBUTE_POSITION:  std::memcpy(out, &v.Position, 12); break;
+                case VERTEX_ATTRIBUTE_NORMAL:    WriteVector(out, v.Normal); break;
+                case VERTEX_ATTRIBUTE_TEXCOORDS:
+                    if (halfTexCoords)
+                    {
+                        uint32_t packed = glm::packHalf2x16(v.TexCoords);
+                        std::memcpy(out, &packed, 4);
+                    }
+                    else
+                        std::memcpy(out, &v.TexCoords, 8);
+                    break;
+                case VERTEX_ATTRIBUTE_TANGENT:   WriteVector(out, v.Tangent); break;
+                case VERTEX_ATTRIBUTE_BITANGENT: WriteVector(out, v.Bitangent); break;
+                case VERTEX_ATTRIBUTE_BONE_IDS:     std::memcpy(out, v.m_BoneIDs, 16); break;
+                case VERTEX_ATTRIBUTE_BONE_WEIGHTS: std::memcpy(out, v.m_Weights, 16); break;
+                }
+            }
+        }
+        return buffer;
+    }
+
+    // sets up the attribute pointers of the currently bound VAO for the currently bound GL_ARRAY_BUFFER
+    void Apply() const
+    {
+        for (const VertexAttributeFormat& attribute : attributes)
+        {
+            glEnableVertexAttribArray(attribute.location);
+            if (attribute.integer)
+                glVertexAttribIPointer(attribute.location, attribute.components, attribute.type, stride, (void*)(size_t)attribute.offset);
+            else
+                glVertexAttribPointer(attribute.location, attribute.components, attribute.type, attribute.normalized, stride, (void*)(size_t)attribute.offset);
+        }
+    }
+
+    // packs a unit vector into a signed normalized 10:10:10:2 integer
+    static uint32_t PackSnorm1010102(const glm::vec3& v)
+    {
+        glm::vec3 n = glm::clamp(v, glm::vec3(-1.0f), glm::vec3(1.0f));
+        int32_t x = static_cast<int32_t>(glm::round(n.x * 511.0f));
+        int32_t y = static_cast<int32_t>(glm::round(n.y * 511.0f));
+        int32_t z = static_cast<int32_t>(glm::round(n.z * 511.0f));
+        return (uint32_t(x) & 0x3FFu) | ((uint32_t(y) & 0x3FFu) << 10) | ((uint32_t(z) & 0x3FFu) << 20);
+    }
+
+private:
+    void Add(VertexAttribute location, GLint components, GLenum type, GLboolean normalized, bool integer, unsigned int size)
+    {
+        attributes.push_back({ static_cast<unsigned int>(location), components, type, normalized, integer, stride, size });
+        stride += size;
+    }
+
+    void AddVector(VertexAttribute location)
+    {
+        if (packedVectors)
+            Add(location, 4, GL_INT_2_10_10_10_REV, GL_TRUE, false, 4);
+        else
+            Add(location, 3, GL_FLOAT, GL_FALSE, false, 12);
+    }
+
+    void WriteVector(unsigned char* out, const glm::vec3& v) const
+    {
+        if (packedVectors)
+        {
+            float length = glm::length(v);
+            uint32_t packed = PackSnorm1010102(length > 0.0f ? v / length : v);
+            std::memcpy(out, &packed, 4);
+        }
+        else
+            std::memcpy(out, &v, 12);
+    }
+};
+#endif
@@ -0,0 +1,133 @@
+#include "Simulation.h"
+#include <glm/gtc/quaternion.hpp>
+
+Simulation::Simulation(const SimulationState& initialState, const SimulationSettings& settings, float fixedDeltaTime) :
+	settings(settings), previous(initialState), current(initialState), resetPosition(initialState.planePosition), accumulator(0.0f), fixedDeltaTime(fixedDeltaTime) {
+}
+
+void Simulation::setResetPosition(const glm::vec3& position) {
+	resetPosition = position;
+}
+
+void Simulation::rotatePlane(SimulationState& state, const glm::vec3& axis, float deg) {
+	glm::quat rotation = glm::angleAxis(glm::radians(deg), glm::normalize(axis));
+	state.planeForward = rotation * state.planeForward;
+	state.planeUp = rotation * state.planeUp;
+	state.planeRight = rotation * state.planeRight;
+}
+
+void Simulation::orthonormalize(SimulationState& state) {
+	// thousands of small rotations per second slowly drift the basis apart
+	state.planeForward = glm::normalize(state.planeForward);
+	state.planeRight = glm::normalize(glm::cross(state.planeUp, state.planeForward));
+	state.planeUp = glm::cross(state.planeForward, state.planeRight);
+}
+
+void Simulation::step(const PlaneInput& input) {
+	const float dt = fixedDeltaTime;
+	previous = current;
+	SimulationState& s = current;
+
+	// plane controls
+	if (input.pitchUp)
+		rotatePlane(s, s.planeRight, settings.pitchRate * dt);
+	if (input.pitchDown)
+		rotatePlane(s, s.planeRight, -settings.pitchRate * dt);
+	if (input.rollRight)
+		rotatePlane(s, s.planeForward, settings.rollRate * dt);
+	if (input.rollLeft)
+		rotatePlane(s, s.planeForward, -settings.rollRate * dt);
+	if (input.yawRight)
+		rotatePlane(s, s.planeUp, -settings.yawRate * dt);
+	if (input.yawLeft)
+		rotatePlane(s, s.planeUp, settings.yawRate * dt);
+	orthonormalize(s);
+
+	if (input.accelerate)
+		s.planeSpeed += settings.planeAccelerationRate * dt;
+	else if (input.decelerate)
+		s.planeSpeed -= settings.planeAccelerationRate * dt;
+	else {
+		if (s.planeSpeed + 5.0f > settings.defaultPlaneSpeed) {
+			s.planeSpeed -= settings.planeAccelerationRate * 0.5f * dt;
+		}
+		else if (s.planeSpeed - 5.0f < settings.defaultPlaneSpeed) {
+			s.planeSpeed += settings.planeAccelerationRate * 0.5f * dt;
+		}
+	}
+	s.planeSpeed = glm::clamp(s.planeSpeed, settings.minPlaneSpeed, settings.maxPlaneSpeed);
+
+	if (input.reset) {
+		s.planePosition = resetPosition;
+		// don't interpolate across a teleport
+		previous.planePosition = resetPosition;
+	}
+
+	// day-night cycle and tide
+	s.time += dt;
+	s.sunPosition.x = 2100.0f * cosf(0.15f * s.time);
+	s.sunPosition.y = settings.maxSunHeight * sinf(0.15f * s.time);
+	s.sunStrength = s.sunPosition.y / 800;
+	if (s.sunStrength < 0.0f) s.sunStrength = 0.0f;
+
+	s.moonPosition.x = 2100.0f * cosf(0.15f * s.time + glm::radians(180.0f));
+	s.moonPosition.y = settings.maxSunHeight * sinf(0.15f * s.time + glm::radians(180.0f));
+
+	s.seaPosition.y = 250.0f * sinf(0.125f * s.time) - 500.0f;
+
+	s.planePosition += s.planeForward * s.planeSpeed * dt;
+}
+
+unsigned int Simulation::advance(const PlaneInput& input, float frameTime) {
+	if (frameTime > MAX_FRAME_TIME) frameTime = MAX_FRAME_TIME;
+	if (frameTime < 0.0f) frameTime = 0.0f;
+	accumulator += frameTime;
+
+	unsigned int steps = 0;
+	PlaneInput tickInput = input;
+	while (accumulator >= fixedDeltaTime) {
+		step(tickInput);
+		// reset is an edge, apply it once per frame only
+		tickInput.reset = false;
+		accumulator -= fixedDeltaTime;
+		steps++;
+	}
+	return steps;
+}
+
+SimulationState Simulation::getInterpolatedState() const {
+	const float alpha = getAlpha();
+	SimulationState state = current;
+	state.time = glm::mix(previous.time, current.time, alpha);
+	state.planePosition = glm::mix(previous.planePosition, current.planePosition, alpha);
+	state.planeSpeed = glm::mix(previous.planeSpeed, current.planeSpeed, alpha);
+	state.sunPosition = glm::mix(previous.sunPosition, current.sunPosition, alpha);
+	state.moonPosition = glm::mix(previous.moonPosition, current.moonPosition, alpha);
+	state.seaPosition = glm::mix(previous.seaPosition, current.seaPosition, alpha);
+	state.sunStrength = glm::mix(previous.sunStrength, current.sunStrength, alpha);
+
+	// right, up and forward form a rotation matrix, slerp its quaternion
+	glm::quat q0 = glm::quat_cast(glm::mat3(previous.planeRight, previous.planeUp, previous.planeForward));
+	glm::quat q1 = glm::quat_cast(glm::mat3(current.planeRight, current.planeUp, current.planeForward));
+	glm::mat3 basis = glm::mat3_cast(glm::slerp(q0, q1, alpha));
+	state.planeRight = basis[0];
+	state.planeUp = basis[1];
+	state.planeForward = basis[2];
+	return state;
+}
+
+float Simulation::getAlpha() const {
+	return accumulator / fixedDeltaTime;
+}
+
+float Simulation::getFixedDeltaTime() const {
+	return fixedDeltaTime;
+}
+
+const SimulationState& Simulation::getCurrentState() const {
+	return current;
+}
+
+const SimulationSettings& Simulation::getSettings() const {
+	return settings;
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <glm/glm.hpp>
+
+// Keys sampled once per frame, decoupled from GLFW so the simulation can run headless
+struct PlaneInput {
+	bool pitchUp = false;
+	bool pitchDown = false;
+	bool rollRight = false;
+	bool rollLeft = false;
+	bool yawRight = false;
+	bool yawLeft = false;
+	bool accelerate = false;
+	bool decelerate = false;
+	bool reset = false;
+};
+
+struct SimulationSettings {
+	float defaultPlaneSpeed = 100.0f;
+	float maxPlaneSpeed = 300.0f;
+	float minPlaneSpeed = 30.0f;
+	float planeAccelerationRate = 50.0f;
+	float pitchRate = 150.0f;
+	float yawRate = 50.0f;
+	float rollRate = 200.0f;
+	float maxSunHeight = 2500.0f;
+};
+
+struct SimulationState {
+	float time = 0.0f;
+
+	glm::vec3 planePosition = glm::vec3(0.0f, 75.0f, 0.0f);
+	glm::vec3 planeForward = glm::vec3(0.0f, 0.0f, 1.0f);
+	glm::vec3 planeUp = glm::vec3(0.0f, 1.0f, 0.0f);
+	glm::vec3 planeRight = glm::vec3(1.0f, 0.0f, 0.0f);
+	float planeSpeed = 100.0f;
+
+	glm::vec3 sunPosition = glm::vec3(0.0f, 5.0f, 0.0f);
+	glm::vec3 moonPosition = glm::vec3(0.0f, -5.0f, 0.0f);
+	glm::vec3 seaPosition = glm::vec3(0.0f);
+	float sunStrength = 1.0f;
+};
+
+// Fixed-timestep simulation core with an accumulator; rendering reads an interpolated state
+class Simulation {
+	private:
+		SimulationSettings settings;
+		SimulationState previous;
+		SimulationState current;
+		glm::vec3 resetPosition;
+		float accumulator;
+		float fixedDeltaTime;
+
+		static void rotatePlane(SimulationState& state, const glm::vec3& axis, float deg);
+		static void orthonormalize(SimulationState& state);
+
+	public:
+		// frame times above this are clamped so a long hitch can't jump the plane
+		static constexpr float MAX_FRAME_TIME = 0.25f;
+
+		Simulation(const SimulationState& initialState, const SimulationSettings& settings = SimulationSettings(), float fixedDeltaTime = 1.0f / 120.0f);
+
+		void setResetPosition(const glm::vec3& position);
+
+		// runs exactly one tick of fixedDeltaTime
+		void step(const PlaneInput& input);
+
+		// accumulates frameTime and runs as many whole ticks as fit, returns the number of ticks run
+		unsigned int advance(const PlaneInput& input, float frameTime);
+
+		// blend between the last two ticks by the leftover accumulator fraction
+		SimulationState getInterpolatedState() const;
+
+		float getAlpha() const;
+		float getFixedDeltaTime() const;
+		const SimulationState& getCurrentState() const;
+		const SimulationSettings& getSettings() const;
+};
@@ -1,5 +1,7 @@
 #include "Utilities.h"
 #include <glm/glm.hpp>
+#include <algorithm>
+#include <cassert>
 
 VerticesData getVerticesFromHeightMap(float** data, unsigned int width, float horizontalScaling, float heightScaling) {
 	unsigned int numOfVerts = width * width;
@@ -43,16 +45,17 @@ VerticesData getVerticesFromHeightMap(float** data, unsigned int width, float ho
 		vertsAndNormals[i] = tempVertsAndNormals[i];
 	}
 
-	std::vector<unsigned int> indicesVector;
-	for (unsigned int i = 0; i < width - 1; i++) {
-		for (unsigned int j = 0; j < width; j++) {
-			for (unsigned int k = 0; k < 2; k++) {
-				indicesVector.emplace_back(j + width * (i + k));
-			}
+	// every strip uses the same indices relative to its first vertex, so only one strip is stored and
+	// the strips are drawn with a base vertex. The highest index is 2 * width - 1, which fits 16 bits up to width 32768
+	assert(2 * width - 1 <= 0xFFFF);
+	std::vector<unsigned short> indicesVector;
+	for (unsigned int j = 0; j < width; j++) {
+		for (unsigned int k = 0; k < 2; k++) {
+			indicesVector.emplace_back((unsigned short)(j + width * k));
 		}
 	}
 	unsigned int numOfIndices = indicesVector.size();
-	unsigned int* indices = new unsigned int[numOfIndices];
+	unsigned short* indices = new unsigned short[numOfIndices];
 	for (int i = 0; i < numOfIndices; i++) {
 		indices[i] = indicesVector[i];
 	}
@@ -60,9 +63,132 @@ VerticesData getVerticesFromHeightMap(float** data, unsigned int width, float ho
 	VerticesData verticesData(vertsAndNormals, indices, numOfVerts, numOfIndices);
 	verticesData.stripsCount = width - 1;
 	verticesData.numOfverticesPerStrip = width * 2;
+	verticesData.baseVertexPerStrip = width;
 
 	delete[] verts;
 	delete[] normals;
 
 	return verticesData;
-}
\ No newline at end of file
+}
+
+std::vector<TerrainChunk> getTerrainChunks(float** data, unsigned int width, unsigned int chunkSize, float horizontalScaling, float heightScaling) {
+	std::vector<TerrainChunk> chunks;
+	for (unsigned int z = 0; z + 1 < width; z += chunkSize) {
+		for (unsigned int x = 0; x + 1 < width; x += chunkSize) {
+			TerrainChunk chunk;
+			chunk.x = x;
+			chunk.z = z;
+			chunk.columns = std::min(chunkSize, width - 1 - x);
+			chunk.rows = std::min(chunkSize, width - 1 - z);
+			float minHeight = data[z][x];
+			float maxHeight = data[z][x];
+			for (unsigned int j = z; j <= z + chunk.rows; j++) {
+				for (unsigned int i = x; i <= x + chunk.columns; i++) {
+					minHeight = std::min(minHeight, data[j][i]);
+					maxHeight = std::max(maxHeight, data[j][i]);
+				}
+			}
+			chunk.min = glm::vec3(x * horizontalScaling, minHeight * heightScaling, z * horizontalScaling);
+			chunk.max = glm::vec3((x + chunk.columns) * horizontalScaling, maxHeight * heightScaling, (z + chunk.rows) * horizontalScaling);
+			chunks.push_back(chunk);
+		}
+	}
+	return chunks;
+}
+
+OccluderMesh getOccluderFromHeightMap(float** data, unsigned int width, unsigned int step, float horizontalScaling, float heightScaling) {
+	unsigned int cells = (width - 1 + step - 1) / step;
+	unsigned int vertsPerSide = cells + 1;
+
+	// lowest height of every coarse cell, borders included
+	std::vector<float> cellMin(cells * cells);
+	for (unsigned int cz = 0; cz < cells; cz++) {
+		for (unsigned int cx = 0; cx < cells; cx++) {
+			unsigned int x1 = std::min((cx + 1) * step, width - 1);
+			unsigned int z1 = std::min((cz + 1) * step, width - 1);
+			float lowest = data[cz * step][cx * step];
+			for (unsigned int z = cz * step; z <= z1; z++) {
+				for (unsigned int x = cx * step; x <= x1; x++) {
+					lowest = std::min(lowest, data[z][x]);
+				}
+			}
+			cellMin[cz * cells + cx] = lowest;
+		}
+	}
+
+	OccluderMesh mesh;
+	mesh.verticesPerSide = vertsPerSide;
+	for (unsigned int vz = 0; vz < vertsPerSide; vz++) {
+		for (unsigned int vx = 0; vx < vertsPerSide; vx++) {
+			float lowest = 0.0f;
+			bool first = true;
+			for (unsigned int cz = (vz > 0 ? vz - 1 : 0); cz <= std::min(vz, cells - 1); cz++) {
+				for (unsigned int cx = (vx > 0 ? vx - 1 : 0); cx <= std::min(vx, cells - 1); cx++) {
+					lowest = first ? cellMin[cz * cells + cx] : std::min(lowest, cellMin[cz * cells + cx]);
+					first = false;
+				}
+			}
+			float x = (float)std::min(vx * step, width - 1) * horizontalScaling;
+			float z = (float)std::min(vz * step, width - 1) * horizontalScaling;
+			mesh.positions.emplace_back(x, lowest * heightScaling, z);
+		}
+	}
+
+	for (unsigned int cz = 0; cz < cells; cz++) {
+		for (unsigned int cx = 0; cx < cells; cx++) {
+			uint32_t v0 = cz * vertsPerSide + cx;
+			uint32_t v1 = v0 + 1;
+			uint32_t v2 = v0 + vertsPerSide;
+			uint32_t v3 = v2 + 1;
+			mesh.indices.insert(mesh.indices.end(), { v0, v2, v1, v1, v2, v3 });
+		}
+	}
+	return mesh;
+}
+
+bool getOccluderHeight(const OccluderMesh& occluder, float x, float z, float& height) {
+	unsigned int vertsPerSide = occluder.verticesPerSide;
+	if (vertsPerSide < 2) {
+		return false;
+	}
+	const glm::vec3& first = occluder.positions.front();
+	const glm::vec3& last = occluder.positions.back();
+	if (x < first.x || z < first.z || x > last.x || z > last.z) {
+		return false;
+	}
+
+	// the cell around x, z; only the last column and row can be narrower than the rest
+	unsigned int cells = vertsPerSide - 1;
+	float spacing = occluder.positions[1].x - first.x;
+	unsigned int cx = std::min((unsigned int)((x - first.x) / spacing), cells - 1);
+	unsigned int cz = std::min((unsigned int)((z - first.z) / spacing), cells - 1);
+	const glm::vec3& p0 = occluder.positions[cz * vertsPerSide + cx];
+	const glm::vec3& p1 = occluder.positions[cz * vertsPerSide + cx + 1];
+	const glm::vec3& p2 = occluder.positions[(cz + 1) * vertsPerSide + cx];
+	const glm::vec3& p3 = occluder.positions[(cz + 1) * vertsPerSide + cx + 1];
+	float fx = (x - p0.x) / (p1.x - p0.x);
+	float fz = (z - p0.z) / (p2.z - p0.z);
+
+	// the cell is split along its p1 - p2 diagonal into (p0, p2, p1) and (p1, p2, p3)
+	if (fx + fz <= 1.0f) {
+		height = p0.y + fx * (p1.y - p0.y) + fz * (p2.y - p0.y);
+	}
+	else {
+		height = p3.y + (1.0f - fx) * (p2.y - p3.y) + (1.0f - fz) * (p1.y - p3.y);
+	}
+	return true;
+}
+
+bool isAboveOccluder(const OccluderMesh& occluder, const glm::vec3& point) {
+	float height;
+	if (getOccluderHeight(occluder, point.x, point.z, height)) {
+		return point.y > height;
+	}
+	// beside the grid the underside can be seen from anywhere below its top
+	for (const glm::vec3& position : occluder.positions) {
+		if (point.y <= position.y) {
+			return false;
+		}
+	}
+	return true;
+}
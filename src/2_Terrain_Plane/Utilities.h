@@ -1,19 +1,54 @@
 #pragma once
+#include <glm/glm.hpp>
+#include <cstdint>
 #include <vector>
 
 const float HEIGHT_SCALING_FACTOR = 16.0f;
 const float HORIZONTAL_SCALING_FACTOR = 2.0f;
 
 struct VerticesData {
-	VerticesData(float* vertsAndNormals, unsigned int* indices, unsigned int verticesCount, unsigned int indicesCount) :
-		vertsAndNormals(vertsAndNormals), indices(indices), verticesCount(verticesCount), indicesCount(indicesCount), stripsCount(0), numOfverticesPerStrip(0) {
+	VerticesData(float* vertsAndNormals, unsigned short* indices, unsigned int verticesCount, unsigned int indicesCount) :
+		vertsAndNormals(vertsAndNormals), indices(indices), verticesCount(verticesCount), indicesCount(indicesCount), stripsCount(0), numOfverticesPerStrip(0), baseVertexPerStrip(0) {
 	}
 	float* vertsAndNormals;
-	unsigned int* indices;
+	// 16-bit indices of a single strip relative to its first vertex, every strip is drawn with them and a base vertex of
+	// stripIndex * baseVertexPerStrip
+	unsigned short* indices;
 	unsigned int verticesCount;
 	unsigned int indicesCount;
 	unsigned int stripsCount;
 	unsigned int numOfverticesPerStrip;
+	unsigned int baseVertexPerStrip;
 };
 
-VerticesData getVerticesFromHeightMap(float** data, unsigned int width, float horizontalScaling = HORIZONTAL_SCALING_FACTOR, float heightScaling = HEIGHT_SCALING_FACTOR);
\ No newline at end of file
+VerticesData getVerticesFromHeightMap(float** data, unsigned int width, float horizontalScaling = HORIZONTAL_SCALING_FACTOR, float heightScaling = HEIGHT_SCALING_FACTOR);
+
+// a rectangle of quads of a height map grid, drawn as one sub-strip per row of the shared strip indices
+struct TerrainChunk {
+	unsigned int x;
+	unsigned int z;
+	unsigned int columns;
+	unsigned int rows;
+	glm::vec3 min; // model space bounds
+	glm::vec3 max;
+};
+
+std::vector<TerrainChunk> getTerrainChunks(float** data, unsigned int width, unsigned int chunkSize, float horizontalScaling = HORIZONTAL_SCALING_FACTOR, float heightScaling = HEIGHT_SCALING_FACTOR);
+
+// a coarse triangle list for occlusion culling, a grid of verticesPerSide x verticesPerSide vertices in rows along z
+struct OccluderMesh {
+	std::vector<glm::vec3> positions;
+	std::vector<uint32_t> indices;
+	unsigned int verticesPerSide = 0;
+};
+
+// A grid with every step-th vertex of the height map. Each vertex takes the lowest height of the cells around it, so
+// the coarse surface stays below the terrain and never hides anything the terrain itself doesn't.
+OccluderMesh getOccluderFromHeightMap(float** data, unsigned int width, unsigned int step, float horizontalScaling = HORIZONTAL_SCALING_FACTOR, float heightScaling = HEIGHT_SCALING_FACTOR);
+
+// height of the occluder surface at model space x, z as its triangles interpolate it, false outside the grid
+bool getOccluderHeight(const OccluderMesh& occluder, float x, float z, float& height);
+
+// The occluder only hides what lies beneath it as long as it is seen from above, from below its underside would hide
+// everything over it. True when the model space point lies above the surface, outside the grid above its highest vertex.
+bool isAboveOccluder(const OccluderMesh& occluder, const glm::vec3& point);
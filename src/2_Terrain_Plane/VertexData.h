@@ -54,7 +54,7 @@ const unsigned int SphereVerticesCount = (SphereRings + 1) * (SphereSegments + 1
 float SphereVertices[SphereVerticesCount * 3];
 
 const unsigned int SphereFaceIndicesCount = SphereRings * SphereSegments;
-unsigned int SphereFaceIndices[SphereFaceIndicesCount * 3 * 2];
+unsigned short SphereFaceIndices[SphereFaceIndicesCount * 3 * 2];
 
 const unsigned int SquareVerticesCount = 4;
 const float SquareVertices[] = {
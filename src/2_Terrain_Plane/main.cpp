@@ -10,17 +10,21 @@
 #include <learnopengl/shader_m.h>
 #include <learnopengl/camera.h>
 #include <learnopengl/model.h>
+#include <learnopengl/static_batch.h>
+#include <learnopengl/job_system.h>
+#include <learnopengl/occlusion_culling.h>
 
 #include <iostream>
 
 #include "HeightMap.h"
 #include "VertexData.h"
 #include "Utilities.h"
+#include "Simulation.h"
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
-void processInput(GLFWwindow *window, float dt);
+void processInput(GLFWwindow *window);
 unsigned int loadTexture(const char *path);
 
 struct TerrainData {
@@ -55,42 +59,49 @@ GLuint seaEBO;
 glm::vec3 seaPosition = glm::vec3();
 VerticesData* seaVertsData;
 
+// terrain and sea are drawn in chunks, only those in the view and not behind the mountains
+std::vector<TerrainChunk> terrainChunks;
+std::vector<TerrainChunk> seaChunks;
+PackedAABBs terrainChunkBounds; // world space, filled on the first frame
+PackedAABBs seaChunkBounds;     // world space, refilled every frame as the tide moves
+std::vector<uint32_t> visibleChunks;
+// the coarse terrain is the only occluder, the sea, sun and moon are hidden behind it while the camera is above it
+OccluderMesh terrainOccluder;
+OcclusionCuller* occlusionCuller;
+JobSystem* jobSystem;
+
 glm::vec3 moonPosition(0.0f, -5.0f, 0.0f);
 float maxSunHeight = 2500.0f;
 float sunStrength = 1.0f;
+// the sun and moon sphere at full detail and its LODs, all in sunEBO
+std::vector<IndexRange> sphereRanges;
+std::vector<MeshLod> sphereLods;
 
 Model* plane;
+StaticBatch* planeBatch;
 Shader* planeShader;
 glm::vec3 planePosition = glm::vec3(0.0f, 75.0f, 0.0f);
 glm::vec3 planeForward = glm::vec3(0.0f, 0.0f, 1.0f);
 glm::vec3 planeUp = glm::vec3(0.0f, 1.0f, 0.0f);
 glm::vec3 planeRight = glm::vec3(1.0f, 0.0f, 0.0f);
-float defaultPlaneSpeed = 100.0f;
-float planeSpeed = defaultPlaneSpeed;
-float maxPlaneSpeed = 300.0f;
-float minPlaneSpeed = 30.0f;
-float planeAccelerationRate = 50.0f;
-float pitchRate = 150.0f;
-float yawRate = 50.0f;
-float rollRate = 200.0f;
 float camDistanceFromPlane = 50.0f;
 float maxFov = 90.0f;
 float minFov = 60.0f;
-void yawPlane(float deg);
-void pitchPlane(float deg);
-void rollPlane(float deg);
-void updateCamAfterPlane();
 
-glm::vec3 resetPosition;
+AsyncTextureLoader* textureLoader;
+
+// fixed-step simulation, rendering uses the state interpolated between its last two ticks
+Simulation* simulation;
+PlaneInput planeInput;
 
 void initTerrain(GLuint& terrainVAO, GLuint& terrainVBO, GLuint& terrainEBO, VerticesData& verticesData);
 void initSun(GLuint& sunVAO, GLuint& sunVBO, GLuint& sunEBO);
 void initSea(GLuint& seaVAO, GLuint& seaVBO, GLuint& seaEBO);
-void updateObjects(SunData& sunData, float dt);
+void applySimulationState(const SimulationState& state, SunData& sunData);
 void update(GLFWwindow*& window, TerrainData& terrainData, SunData& sunData);
 void render(TerrainData& terrainData, SunData& sunData);
-void drawTerrain(GLuint& terrainVAO, VerticesData& verticesData);
-void drawSun(GLuint& sunVAO);
+void drawTerrain(GLuint& terrainVAO, VerticesData& verticesData, const std::vector<TerrainChunk>& chunks, const std::vector<uint32_t>& visible);
+void drawSun(GLuint& sunVAO, unsigned int lodLevel);
 void drawSea(GLuint& seaVAO);
 
 // settings
@@ -109,57 +120,6 @@ float lastFrame = 0.0f;
 
 const float PI = 3.14159265358979323846;
 
-void yawPlane(float deg) {
-    glm::vec3 axis = glm::normalize(planeUp);
-    float angle = glm::radians(deg);
-    glm::mat4 rotMat = glm::rotate(glm::mat4(1.0f), angle, axis);
-    glm::vec4 forward = rotMat * glm::vec4(planeForward, 1.0f);
-    glm::vec4 up = rotMat * glm::vec4(planeUp, 1.0f);
-    glm::vec4 right = rotMat * glm::vec4(planeRight, 1.0f);
-
-    planeForward = forward;
-    planeUp = up;
-    planeRight = right;
-
-    updateCamAfterPlane();
-}
-
-void pitchPlane(float deg){
-    glm::vec3 axis = glm::normalize(planeRight);
-    float angle = glm::radians(deg);
-    glm::mat4 rotMat = glm::rotate(glm::mat4(1.0f), angle, axis);
-    glm::vec4 forward = rotMat * glm::vec4(planeForward, 1.0f);
-    glm::vec4 up = rotMat * glm::vec4(planeUp, 1.0f);
-    glm::vec4 right = rotMat * glm::vec4(planeRight, 1.0f);
-
-    planeForward = forward;
-    planeUp = up;
-    planeRight = right;
-
-    updateCamAfterPlane();
-}
-
-void rollPlane(float deg){
-    glm::vec3 axis = glm::normalize(planeForward);
-    float angle = glm::radians(deg);
-    glm::mat4 rotMat = glm::rotate(glm::mat4(1.0f), angle, axis);
-    glm::vec4 forward = rotMat * glm::vec4(planeForward, 1.0f);
-    glm::vec4 up = rotMat * glm::vec4(planeUp, 1.0f);
-    glm::vec4 right = rotMat * glm::vec4(planeRight, 1.0f);
-
-    planeForward = forward;
-    planeUp = up;
-    planeRight = right;
-
-    updateCamAfterPlane();
-}
-
-void updateCamAfterPlane() {
-    camera.Front = planeForward;
-    camera.Right = planeRight;
-    camera.WorldUp = planeUp;
-}
-
 void initSphere() {
     initSphereVertices();
     initSphereIndices();
@@ -208,7 +168,7 @@ void initSphereIndices() {
 
     unsigned int count = tempIndices.size();
     for (int i = 0; i < count; i++) {
-        SphereFaceIndices[i] = tempIndices[i];
+        SphereFaceIndices[i] = (unsigned short)tempIndices[i];
     }
 }
 
@@ -239,7 +199,7 @@ void initTerrain(GLuint& terrainVAO, GLuint& terrainVBO, GLuint& terrainEBO, Ver
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, terrainEBO);
     glBufferData(
         GL_ELEMENT_ARRAY_BUFFER,
-        verticesData.indicesCount * sizeof(unsigned int),
+        verticesData.indicesCount * sizeof(unsigned short),
         verticesData.indices,
         GL_STATIC_DRAW
     );
@@ -263,13 +223,25 @@ void initSun(GLuint& sunVAO, GLuint& sunVBO, GLuint& sunEBO) {
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
     glEnableVertexAttribArray(0);
 
+    // LOD chain, the sun and moon are far away and rarely more than a few pixels wide
+    std::vector<unsigned int> sphereIndices(SphereFaceIndices, SphereFaceIndices + SphereFaceIndicesCount * 6);
+    sphereLods = MeshSimplifier::BuildLodChain(SphereVertices, SphereVerticesCount, 3 * sizeof(float), sphereIndices);
+    std::vector<const std::vector<unsigned int>*> lists = { &sphereIndices };
+    for (const MeshLod& lod : sphereLods)
+        lists.push_back(&lod.indices);
+    std::vector<std::vector<IndexRange>> listRanges;
+    SplitIndexBuffer sphereIndexBuffer = SplitIndexBuffer::FromTriangleLists(lists, listRanges);
+    sphereRanges = listRanges[0];
+    for (size_t i = 0; i < sphereLods.size(); i++)
+        sphereLods[i].indexRanges = listRanges[i + 1];
+
     // generate EBO
     glGenBuffers(1, &sunEBO);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sunEBO);
     glBufferData(
         GL_ELEMENT_ARRAY_BUFFER,
-        SphereFaceIndicesCount * sizeof(unsigned int) * 6,
-        SphereFaceIndices,
+        sphereIndexBuffer.Size(),
+        sphereIndexBuffer.Data(),
         GL_STATIC_DRAW
     );
 }
@@ -307,21 +279,34 @@ void initSea(GLuint& seaVAO, GLuint& seaVBO, GLuint& seaEBO) {
     );
 }
 
-void drawTerrain(GLuint& terrainVAO, VerticesData& verticesData) {
-    glBindVertexArray(terrainVAO);
-    for (unsigned int i = 0; i < verticesData.stripsCount; i++) {
-        glDrawElements(
-            GL_TRIANGLE_STRIP,
-            verticesData.numOfverticesPerStrip,
-            GL_UNSIGNED_INT,
-            (void*)(sizeof(unsigned int) * verticesData.numOfverticesPerStrip * i)
-        );
+// every row of a chunk is a piece of a strip: the strip indices alternate between two rows of the grid, so
+// starting 2 * x indices in and taking 2 * (columns + 1) draws columns x to x + columns
+void drawTerrain(GLuint& terrainVAO, VerticesData& verticesData, const std::vector<TerrainChunk>& chunks, const std::vector<uint32_t>& visible) {
+    static std::vector<GLsizei> counts;
+    static std::vector<const void*> offsets;
+    static std::vector<GLint> baseVertices;
+    counts.clear();
+    offsets.clear();
+    baseVertices.clear();
+    for (uint32_t i : visible) {
+        const TerrainChunk& chunk = chunks[i];
+        for (unsigned int row = 0; row < chunk.rows; row++) {
+            counts.push_back(2 * (chunk.columns + 1));
+            offsets.push_back(reinterpret_cast<const void*>(2 * chunk.x * sizeof(unsigned short)));
+            baseVertices.push_back(verticesData.baseVertexPerStrip * (chunk.z + row));
+        }
+    }
+    if (counts.empty()) {
+        return;
     }
+
+    glBindVertexArray(terrainVAO);
+    glMultiDrawElementsBaseVertex(GL_TRIANGLE_STRIP, counts.data(), GL_UNSIGNED_SHORT, offsets.data(), (GLsizei)counts.size(), baseVertices.data());
 }
 
-void drawSun(GLuint& sunVAO) {
+void drawSun(GLuint& sunVAO, unsigned int lodLevel) {
     glBindVertexArray(sunVAO);
-    glDrawElements(GL_TRIANGLES, SphereFaceIndicesCount * 6, GL_UNSIGNED_INT, 0);
+    SplitIndexBuffer::Draw(lodLevel == 0 ? sphereRanges : sphereLods[lodLevel - 1].indexRanges, GL_UNSIGNED_SHORT);
 }
 
 void drawSea(GLuint& seaVAO) {
@@ -388,7 +373,24 @@ void render(TerrainData& terrainData, SunData& sunData) {
     model = glm::translate(model, HORIZONTAL_SCALING_FACTOR * glm::vec3(-halfWidth, 0.0f, -halfWidth));
     model = glm::translate(model, HEIGHT_SCALING_FACTOR * glm::vec3(0.0f, 1.0f, 0.0f));
     terrainData.terrainShader.setMat4("model", model);
-    drawTerrain(terrainData.terrainVAO, terrainData.verticesData);
+
+    // visibility of the terrain chunks: in the view frustum and not behind the coarse terrain
+    if (terrainChunkBounds.Size() == 0) {
+        for (const TerrainChunk& chunk : terrainChunks) {
+            terrainChunkBounds.AddTransformed(AABB(chunk.min, chunk.max), model);
+        }
+    }
+    FrustumCuller frustumCuller(createFrustumFromCamera(camera, (float)SCR_WIDTH / (float)SCR_HEIGHT, glm::radians(camera.Zoom), 0.1f, 10000.0f));
+    // below the coarse terrain its underside would fill the depth buffer and hide everything above it, then it is left
+    // out and the empty buffer hides nothing
+    occlusionCuller->BeginFrame(projection * view);
+    if (isAboveOccluder(terrainOccluder, glm::vec3(glm::inverse(model) * glm::vec4(camera.Position, 1.0f)))) {
+        occlusionCuller->AddOccluder(terrainOccluder.positions.data(), terrainOccluder.positions.size(), terrainOccluder.indices.data(), terrainOccluder.indices.size(), model);
+    }
+    occlusionCuller->Rasterize(jobSystem);
+    frustumCuller.Cull(terrainChunkBounds, visibleChunks);
+    occlusionCuller->Cull(terrainChunkBounds, visibleChunks);
+    drawTerrain(terrainData.terrainVAO, terrainData.verticesData, terrainChunks, visibleChunks);
 
     // sea
     terrainData.terrainShader.use();
@@ -408,7 +410,13 @@ void render(TerrainData& terrainData, SunData& sunData) {
     terrainData.terrainShader.setMat4("model", seaModel);
     terrainData.terrainShader.setFloat("shininess", 128.0f);
     //drawSea(seaVAO);
-    drawTerrain(seaVAO, *seaVertsData);
+    seaChunkBounds.Clear();
+    for (const TerrainChunk& chunk : seaChunks) {
+        seaChunkBounds.AddTransformed(AABB(chunk.min, chunk.max), seaModel);
+    }
+    frustumCuller.Cull(seaChunkBounds, visibleChunks);
+    occlusionCuller->Cull(seaChunkBounds, visibleChunks);
+    drawTerrain(seaVAO, *seaVertsData, seaChunks, visibleChunks);
 
     // sun
     sunData.sunShader.use();
@@ -419,7 +427,10 @@ void render(TerrainData& terrainData, SunData& sunData) {
     sunModel = glm::translate(sunModel, sunData.position);
     sunModel = glm::scale(sunModel, glm::vec3(100.0f, 100.0f, 100.0f));
     sunData.sunShader.setMat4("model", sunModel);
-    drawSun(sunData.sunVAO);
+    float sunDistance = glm::length(sunData.position - camera.Position) - 100.0f;
+    if (occlusionCuller->IsVisible(sunData.position, glm::vec3(100.0f))) {
+        drawSun(sunData.sunVAO, LodSelection::FromDistance(sunDistance, 100.0f, glm::radians(camera.Zoom), (float)SCR_HEIGHT).Select(sphereLods));
+    }
 
     // moon
     sunData.sunShader.setVec3("color", glm::vec3(1.0f, 1.0f, 1.0f));
@@ -427,7 +438,10 @@ void render(TerrainData& terrainData, SunData& sunData) {
     moonModel = glm::translate(moonModel, moonPosition);
     moonModel = glm::scale(moonModel, glm::vec3(50.0f, 50.0f, 50.0f));
     sunData.sunShader.setMat4("model", moonModel);
-    drawSun(sunData.sunVAO);
+    float moonDistance = glm::length(moonPosition - camera.Position) - 50.0f;
+    if (occlusionCuller->IsVisible(moonPosition, glm::vec3(50.0f))) {
+        drawSun(sunData.sunVAO, LodSelection::FromDistance(moonDistance, 50.0f, glm::radians(camera.Zoom), (float)SCR_HEIGHT).Select(sphereLods));
+    }
 
     // plane
     planeShader->use();
@@ -455,23 +469,25 @@ void render(TerrainData& terrainData, SunData& sunData) {
     planeModel = glm::translate(glm::mat4(1.0f), planePosition) * rotMat * glm::rotate(glm::mat4(1.0f), glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
     planeModel = glm::scale(planeModel, glm::vec3(0.25f));
     planeShader->setMat4("model", planeModel);
-    plane->Draw(*planeShader);
+    planeBatch->Draw(*planeShader);
 }
 
-void updateObjects(SunData& sunData, float dt) {
-    static float t = 0.0f;
-    t += dt;
-    sunData.position.x = 2100.0f * cosf(0.15f * t);
-    sunData.position.y = maxSunHeight * sinf(0.15f * t);
-    sunStrength = sunData.position.y / 800;
-    if (sunStrength < 0.0f) sunStrength = 0.0f;
+void applySimulationState(const SimulationState& state, SunData& sunData) {
+    sunData.position = state.sunPosition;
+    sunStrength = state.sunStrength;
+    moonPosition = state.moonPosition;
+    seaPosition = state.seaPosition;
 
-    moonPosition.x = 2100.0f * cosf(0.15f * t + glm::radians(180.0f));
-    moonPosition.y = maxSunHeight * sinf(0.15f * t + glm::radians(180.0f));
+    planePosition = state.planePosition;
+    planeForward = state.planeForward;
+    planeUp = state.planeUp;
+    planeRight = state.planeRight;
 
-    seaPosition.y = 250.0f * sinf(0.125f * t) - 500.0f;
+    const SimulationSettings& settings = simulation->getSettings();
+    float t = (state.planeSpeed - settings.minPlaneSpeed) / (settings.maxPlaneSpeed - settings.minPlaneSpeed);
+    camera.Zoom = (1 - t) * minFov + t * maxFov;
 
-    planePosition += glm::normalize(planeForward) * planeSpeed * dt;
+    camera.WorldUp = planeUp;
     glm::vec3 camPos = planePosition - (planeForward * camDistanceFromPlane);
     glm::vec3 camLook = planePosition - camPos;
     camPos += planeUp * 10.0f;
@@ -484,8 +500,11 @@ void update(GLFWwindow*& window, TerrainData& terrainData, SunData& sunData) {
     float dt = currentFrame - lastFrame;
     lastFrame = currentFrame;
 
-    processInput(window, dt);
-    updateObjects(sunData, dt);
+    processInput(window);
+    // swap decoded model textures in, bounded so streaming never stalls a frame
+    textureLoader->ProcessUploads(2.0);
+    simulation->advance(planeInput, dt);
+    applySimulationState(simulation->getInterpolatedState(), sunData);
     render(terrainData, sunData);
 
     glfwSwapBuffers(window);
@@ -531,6 +550,9 @@ int main()
     }
 
     glEnable(GL_DEPTH_TEST);
+
+    // linked programs are kept per driver, so only the first launch compiles GLSL
+    ShaderCache shaderCache("shader_cache");
     
     HeightMap heightMap(2048 + 1);
     //HeightMap heightMap(4 + 1);
@@ -542,6 +564,14 @@ int main()
     VerticesData seaData = getVerticesFromHeightMap(seaMapData.data, seaMapData.width, HORIZONTAL_SCALING_FACTOR, 1.0f);
     seaVertsData = &seaData;
 
+    terrainChunks = getTerrainChunks(heightMapData.data, heightMapData.width, 64);
+    seaChunks = getTerrainChunks(seaMapData.data, seaMapData.width, 64, HORIZONTAL_SCALING_FACTOR, 1.0f);
+    terrainOccluder = getOccluderFromHeightMap(heightMapData.data, heightMapData.width, 32);
+    JobSystem jobs;
+    jobSystem = &jobs;
+    OcclusionCuller terrainOcclusionCuller(256, 128);
+    occlusionCuller = &terrainOcclusionCuller;
+
     minTerrainHeight = vertsData.vertsAndNormals[1];
     maxTerrainHeight = vertsData.vertsAndNormals[1];
     for (int i = 1; i < vertsData.verticesCount; i++) {
@@ -574,7 +604,7 @@ int main()
     GLuint terrainVBO;
     GLuint terrainEBO;
     initTerrain(terrainVAO, terrainVBO, terrainEBO, vertsData);
-    Shader terrainShader("TerrainVertexShader.vs", "TerrainFragmentShader.fs");
+    Shader terrainShader("TerrainVertexShader.vs", "TerrainFragmentShader.fs", &shaderCache);
     terrainShader.use();
     terrainShader.setVec3("color", glm::vec3(1.0f, 0.5f, 0.2f));
     terrainShader.setFloat("shininess", 50.0f);
@@ -585,94 +615,98 @@ int main()
     GLuint sunVBO;
     GLuint sunEBO;
     initSun(sunVAO, sunVBO, sunEBO);
-    Shader sunShader("LightSphere.vs", "LightSphere.fs");
+    Shader sunShader("LightSphere.vs", "LightSphere.fs", &shaderCache);
     SunData sunData = SunData(sunVAO, sunVBO, sunEBO, sunShader, sunPosition);
 
     initTerrain(seaVAO, seaVBO, seaEBO, *seaVertsData);
 
-    Model planeModel(FileSystem::getPath("resources/objects/fighterjet/fighterjet.obj"));
-    Shader planeshader("PlaneVertexShader.vs", "PlaneFragmentShader.fs");
+    // plane textures stream in as DXT, compressed once and cached as DDS next to the source images
+    AsyncTextureLoader asyncTextureLoader(0, true);
+    textureLoader = &asyncTextureLoader;
+
+    // the plane shader only reads positions, normals and texture coordinates
+    ModelLoadOptions planeOptions;
+    planeOptions.textureLoader = textureLoader;
+    planeOptions.vertexAttributes = VERTEX_ATTRIBUTE_BIT(VERTEX_ATTRIBUTE_POSITION) | VERTEX_ATTRIBUTE_BIT(VERTEX_ATTRIBUTE_NORMAL) | VERTEX_ATTRIBUTE_BIT(VERTEX_ATTRIBUTE_TEXCOORDS);
+    planeOptions.halfTexCoords = true;
+    planeOptions.packedVectors = true;
+    // StaticBatch merges the meshes on the CPU, they are freed once the batch is built
+    planeOptions.keepMeshData = true;
+    Model planeModel(FileSystem::getPath("resources/objects/fighterjet/fighterjet.obj"), planeOptions);
+    if (!planeModel.loadedFromCache && planeOptions.optimizeMeshes) {
+        const MeshOptimizationStatistics& stats = planeModel.optimizationStats;
+        std::cout << "Plane model optimized: ACMR " << stats.before.ACMR() << " -> " << stats.after.ACMR()
+                  << ", ATVR " << stats.before.ATVR() << " -> " << stats.after.ATVR()
+                  << ", " << stats.weldedVertices << " vertices welded" << std::endl;
+    }
+    std::cout << "Plane model buffers: " << planeModel.GetBufferSize() / 1024 << " KB (full vertex layout: " << planeModel.GetFullLayoutBufferSize() / 1024 << " KB)" << std::endl;
+    Shader planeshader("PlaneVertexShader.vs", "PlaneFragmentShader.fs", &shaderCache);
     planeShader = &planeshader;
     plane = &planeModel;
-
-    planePosition.y = maxTerrainHeight * 0.5f;
-
-    resetPosition = planePosition;
+    // the plane never deforms, so its meshes are merged into one draw per material
+    StaticBatch planeStaticBatch(planeModel.meshes);
+    planeBatch = &planeStaticBatch;
+    for (Mesh& mesh : planeModel.meshes)
+        mesh.ReleaseData();
+    DrawStatistics unbatched = StaticBatch::CountUnbatched(planeModel.meshes);
+    DrawStatistics batched = planeStaticBatch.GetDrawStatistics();
+    std::cout << "Plane draw: " << unbatched.drawCalls << " -> " << batched.drawCalls << " draw calls, "
+              << unbatched.vaoBinds << " -> " << batched.vaoBinds << " VAO binds, "
+              << unbatched.textureBinds << " -> " << batched.textureBinds << " texture binds" << std::endl;
+
+    SimulationSettings simulationSettings;
+    simulationSettings.maxSunHeight = maxSunHeight;
+    SimulationState initialState;
+    initialState.planePosition.y = maxTerrainHeight * 0.5f;
+    initialState.planeSpeed = simulationSettings.defaultPlaneSpeed;
+    initialState.sunPosition = sunPosition;
+    initialState.moonPosition = moonPosition;
+    Simulation planeSimulation(initialState, simulationSettings);
+    simulation = &planeSimulation;
+
+    // don't feed the time spent loading into the first frame
+    lastFrame = static_cast<float>(glfwGetTime());
+
+    // the first frame also pays for anything the driver defers to the first draw, so wait for it before reporting
+    update(window, terrainData, sunData);
+    glFinish();
+    std::cout << "First frame after " << glfwGetTime() * 1000.0 << " ms, shader programs: ";
+    if (shaderCache.IsSupported())
+        std::cout << shaderCache.GetHits() << " from cache, " << shaderCache.GetMisses() << " compiled" << std::endl;
+    else
+        std::cout << "compiled, no program binary support" << std::endl;
 
     while (!glfwWindowShouldClose(window))
     {
         update(window, terrainData, sunData);
     }
 
-    if (vertsData.vertsAndNormals != nullptr) delete vertsData.vertsAndNormals;
-    if (vertsData.indices != nullptr) delete vertsData.indices;
+    if (vertsData.vertsAndNormals != nullptr) delete[] vertsData.vertsAndNormals;
+    if (vertsData.indices != nullptr) delete[] vertsData.indices;
 
-    if (seaVertsData->vertsAndNormals != nullptr) delete seaVertsData->vertsAndNormals;
-    if (seaVertsData->indices != nullptr) delete seaVertsData->indices;
+    if (seaVertsData->vertsAndNormals != nullptr) delete[] seaVertsData->vertsAndNormals;
+    if (seaVertsData->indices != nullptr) delete[] seaVertsData->indices;
 
     glfwTerminate();
     return 0;
 }
 
-// process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
-// ---------------------------------------------------------------------------------------------------------
-void processInput(GLFWwindow *window, float dt)
+// process all input: query GLFW whether relevant keys are pressed/released this frame and store them for the simulation
+// ------------------------------------------------------------------------------------------------------------------
+void processInput(GLFWwindow *window)
 {
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window, true);
 
-    //glm::vec3 movement = glm::vec3();
-    //if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
-    //    movement.z += 1.0f;
-    //if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
-    //    movement.z -= 1.0f;
-    //if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
-    //    movement.x -= 1.0f;
-    //if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
-    //    movement.x += 1.0f;
-    //if (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS)
-    //    movement.y += 1.0f;
-    //if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS)
-    //    movement.y -= 1.0f;
-
-    //if (glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS)
-    //    movement *= speedMultiplier;
-    //movement *= moveSpeed;
-    //camera.MyProcessKeyboard(movement, dt);
-
-    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
-        pitchPlane(pitchRate * dt);
-    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
-        pitchPlane(-pitchRate * dt);
-    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
-        rollPlane(rollRate * dt);
-    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
-        rollPlane(-rollRate * dt);
-    if (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS)
-        yawPlane(-yawRate * dt);
-    if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS)
-        yawPlane(yawRate * dt);
-
-    if (glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS)
-        planeSpeed += planeAccelerationRate * dt;
-    else if (glfwGetKey(window, GLFW_KEY_LEFT_CONTROL) == GLFW_PRESS)
-        planeSpeed -= planeAccelerationRate * dt;
-    else {
-        if (planeSpeed + 5.0f > defaultPlaneSpeed) {
-            planeSpeed -= planeAccelerationRate * 0.5f * dt;
-        }
-        else if (planeSpeed - 5.0f < defaultPlaneSpeed) {
-            planeSpeed += planeAccelerationRate * 0.5f * dt;
-        }
-    }
-
-    planeSpeed = glm::clamp(planeSpeed, minPlaneSpeed, maxPlaneSpeed);
-    float t = (planeSpeed - minPlaneSpeed) / (maxPlaneSpeed - minPlaneSpeed);
-    float fov = (1 - t) * minFov + t * maxFov;
-    camera.Zoom = fov;
-
-    if (glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS)
-        planePosition = resetPosition;
+    planeInput.pitchUp = glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS;
+    planeInput.pitchDown = glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS;
+    planeInput.rollRight = glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS;
+    planeInput.rollLeft = glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS;
+    planeInput.yawRight = glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS;
+    planeInput.yawLeft = glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS;
+    planeInput.accelerate = glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS;
+    planeInput.decelerate = glfwGetKey(window, GLFW_KEY_LEFT_CONTROL) == GLFW_PRESS;
+    planeInput.reset = glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS;
 }
 
 // glfw: whenever the window size changed (by OS or user resize) this callback function executes
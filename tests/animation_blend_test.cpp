@@ -0,0 +1,237 @@
+#include <glad/glad.h>
+#include <learnopengl/animation_blend.h>
+
+#include "test.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <memory>
+#include <random>
+#include <vector>
+
+// PoseBlend on a small skeleton built in memory: a blend at weight 0 or 1 gives its inputs, an n-way blend of two
+// poses the two-way blend, an additive layer of the reference pose changes nothing and a masked blend leaves the
+// nodes outside the mask alone. A cross-fade of AnimationBlender keeps the weights of the clips summing to 1.
+
+// root - hips - spine - neck - head, and a leg under the hips
+static const char* NODE_NAMES[] = { "root", "hips", "spine", "neck", "head", "leg" };
+static const int NODE_PARENTS[] = { -1, 0, 1, 2, 3, 1 };
+static const int NODE_COUNT = 6;
+
+static aiNodeAnim* MakeChannel(std::mt19937& rng, const char* name, int keyCount)
+{
+    std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+    aiNodeAnim* channel = new aiNodeAnim();
+    channel->mNodeName = aiString(name);
+    channel->mNumPositionKeys = channel->mNumRotationKeys = channel->mNumScalingKeys = keyCount;
+    channel->mPositionKeys = new aiVectorKey[keyCount];
+    channel->mRotationKeys = new aiQuatKey[keyCount];
+    channel->mScalingKeys = new aiVectorKey[keyCount];
+    for (int k = 0; k < keyCount; k++)
+    {
+        channel->mPositionKeys[k] = aiVectorKey(k, aiVector3D(value(rng), value(rng), value(rng)));
+        glm::quat q = glm::normalize(glm::quat(value(rng), value(rng), value(rng), value(rng)));
+        channel->mRotationKeys[k] = aiQuatKey(k, aiQuaternion(q.w, q.x, q.y, q.z));
+        channel->mScalingKeys[k] = aiVectorKey(k, aiVector3D(1.0f + 0.2f * value(rng), 1.0f + 0.2f * value(rng), 1.0f));
+    }
+    return channel;
+}
+
+// every node animated with random keys, every node but the root skinned
+static std::unique_ptr<Animation> MakeClip(unsigned int seed)
+{
+    std::mt19937 rng(seed);
+    const int keyCount = 10;
+
+    std::vector<aiNode*> nodes;
+    std::vector<std::vector<aiNode*>> children(NODE_COUNT);
+    std::map<std::string, BoneInfo> boneInfoMap;
+    for (int i = 0; i < NODE_COUNT; i++)
+    {
+        aiNode* node = new aiNode(NODE_NAMES[i]);
+        node->mTransformation = aiMatrix4x4(aiVector3D(1.0f), aiQuaternion(1.0f, 0.0f, 0.0f, 0.0f), aiVector3D(0.0f, 1.0f, 0.0f));
+        nodes.push_back(node);
+        if (NODE_PARENTS[i] >= 0)
+            children[NODE_PARENTS[i]].push_back(node);
+        if (i > 0)
+            boneInfoMap[NODE_NAMES[i]] = BoneInfo{ i - 1, glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -float(i), 0.0f)) };
+    }
+    for (int i = 0; i < NODE_COUNT; i++)
+    {
+        nodes[i]->mNumChildren = static_cast<unsigned int>(children[i].size());
+        nodes[i]->mChildren = children[i].empty() ? nullptr : new aiNode*[children[i].size()];
+        for (size_t c = 0; c < children[i].size(); c++)
+        {
+            nodes[i]->mChildren[c] = children[i][c];
+            children[i][c]->mParent = nodes[i];
+        }
+    }
+
+    aiAnimation animation;
+    animation.mDuration = keyCount - 1;
+    animation.mTicksPerSecond = 25.0;
+    animation.mNumChannels = NODE_COUNT;
+    animation.mChannels = new aiNodeAnim*[NODE_COUNT];
+    for (int i = 0; i < NODE_COUNT; i++)
+        animation.mChannels[i] = MakeChannel(rng, NODE_NAMES[i], keyCount);
+
+    std::unique_ptr<Animation> clip(new Animation(nodes[0], &animation, boneInfoMap));
+    delete nodes[0];
+    return clip;
+}
+
+static bool SamePose(const BoneTransform& a, const BoneTransform& b, float tolerance = 1e-5f)
+{
+    // q and -q are the same rotation
+    return glm::length(a.translation - b.translation) <= tolerance && glm::length(a.scale - b.scale) <= tolerance &&
+        1.0f - std::abs(glm::dot(a.rotation, b.rotation)) <= tolerance;
+}
+
+static bool SamePoses(const std::vector<BoneTransform>& a, const std::vector<BoneTransform>& b, float tolerance = 1e-5f)
+{
+    bool same = a.size() == b.size();
+    for (size_t i = 0; same && i < a.size(); i++)
+        same = SamePose(a[i], b[i], tolerance);
+    return same;
+}
+
+static std::vector<BoneTransform> SamplePose(const Animation& skeleton, const Animation& clip, float time)
+{
+    std::vector<BoneTransform> pose(skeleton.GetNodes().size());
+    std::vector<BoneCursor> cursors(clip.GetBones().size());
+    PoseBlend::Sample(skeleton, clip, PoseBlend::MapNodes(skeleton, clip), time, cursors.data(), pose.data());
+    return pose;
+}
+
+static void TestSkeleton(const Animation& skeleton)
+{
+    const std::vector<AnimationNode>& nodes = skeleton.GetNodes();
+    CHECK(nodes.size() == NODE_COUNT);
+    CHECK(skeleton.GetBones().size() == NODE_COUNT);
+    CHECK(skeleton.GetBoneSlotCount() == NODE_COUNT - 1);
+    bool parentsFirst = true;
+    for (size_t i = 0; i < nodes.size(); i++)
+        parentsFirst = parentsFirst && nodes[i].parent < (int)i;
+    CHECK(parentsFirst);
+    CHECK(nodes[skeleton.FindNode("head")].parent == skeleton.FindNode("neck"));
+    CHECK(nodes[skeleton.FindNode("root")].boneID == -1 && nodes[skeleton.FindNode("leg")].boneID == NODE_COUNT - 2);
+}
+
+static void TestBlend(const Animation& a, const Animation& b)
+{
+    const std::vector<BoneTransform> poseA = SamplePose(a, a, 2.3f), poseB = SamplePose(a, b, 6.7f);
+    const size_t count = poseA.size();
+    std::vector<BoneTransform> out(count), sum(count);
+
+    // weight 0 and 1 are the inputs
+    PoseBlend::Blend(poseA.data(), poseB.data(), 0.0f, nullptr, count, out.data());
+    CHECK(SamePoses(out, poseA, 0.0f));
+    PoseBlend::Blend(poseA.data(), poseB.data(), 1.0f, nullptr, count, out.data());
+    CHECK(SamePoses(out, poseB));
+
+    // an n-way blend of two poses is the two-way blend, whatever the total weight
+    const float weights[] = { 0.0f, 0.3f, 0.5f, 0.8f, 1.0f };
+    for (float t : weights)
+    {
+        PoseBlend::Blend(poseA.data(), poseB.data(), t, nullptr, count, out.data());
+        PoseBlend::Clear(sum.data(), count);
+        PoseBlend::Accumulate(poseA.data(), 2.0f * (1.0f - t), count, sum.data());
+        PoseBlend::Accumulate(poseB.data(), 2.0f * t, count, sum.data());
+        PoseBlend::Normalize(sum.data(), 2.0f, count);
+        CHECK(SamePoses(sum, out));
+    }
+}
+
+static void TestAdditive(const Animation& a, const Animation& b)
+{
+    const std::vector<BoneTransform> base = SamplePose(a, b, 3.1f), reference = SamplePose(a, a, 0.0f), pose = SamplePose(a, a, 5.4f);
+    const size_t count = base.size();
+    std::vector<BoneTransform> out(count);
+
+    // the reference pose adds nothing, at any weight
+    PoseBlend::ApplyAdditive(base.data(), reference.data(), reference.data(), 1.0f, nullptr, count, out.data());
+    CHECK(SamePoses(out, base));
+    PoseBlend::ApplyAdditive(base.data(), reference.data(), reference.data(), 0.5f, nullptr, count, out.data());
+    CHECK(SamePoses(out, base));
+
+    // added onto the reference itself it gives the pose back, at weight 0 the base
+    PoseBlend::ApplyAdditive(reference.data(), pose.data(), reference.data(), 1.0f, nullptr, count, out.data());
+    CHECK(SamePoses(out, pose, 1e-4f));
+    PoseBlend::ApplyAdditive(base.data(), pose.data(), reference.data(), 0.0f, nullptr, count, out.data());
+    CHECK(SamePoses(out, base, 0.0f));
+}
+
+static void TestMask(const Animation& a, const Animation& b)
+{
+    // the upper body, spine and everything below it
+    const BlendMask mask = BlendMask::FromSubtree(a, "spine");
+    const char* masked[] = { "spine", "neck", "head" };
+    int maskedCount = 0;
+    for (float weight : mask.weights)
+        maskedCount += weight > 0.0f;
+    CHECK(maskedCount == 3);
+    for (const char* name : masked)
+        CHECK(mask.weights[a.FindNode(name)] == 1.0f);
+    CHECK(BlendMask::FromSubtree(a, "tail").weights == std::vector<float>(NODE_COUNT, 0.0f));
+
+    const std::vector<BoneTransform> poseA = SamplePose(a, a, 1.5f), poseB = SamplePose(a, b, 4.5f);
+    const size_t count = poseA.size();
+    std::vector<BoneTransform> out(count);
+    PoseBlend::Blend(poseA.data(), poseB.data(), 1.0f, mask.weights.data(), count, out.data());
+    bool unmaskedKept = true, maskedBlended = true;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (mask.weights[i] == 0.0f)
+            unmaskedKept = unmaskedKept && SamePose(out[i], poseA[i], 0.0f);
+        else
+            maskedBlended = maskedBlended && SamePose(out[i], poseB[i]);
+    }
+    CHECK(unmaskedKept);
+    CHECK(maskedBlended);
+
+    // an additive layer through the mask as well
+    const std::vector<BoneTransform> reference = SamplePose(a, b, 0.0f);
+    PoseBlend::ApplyAdditive(poseA.data(), poseB.data(), reference.data(), 1.0f, mask.weights.data(), count, out.data());
+    unmaskedKept = true;
+    for (size_t i = 0; i < count; i++)
+        if (mask.weights[i] == 0.0f)
+            unmaskedKept = unmaskedKept && SamePose(out[i], poseA[i], 0.0f);
+    CHECK(unmaskedKept);
+}
+
+static void TestCrossFade(const Animation& a, const Animation& b)
+{
+    AnimationBlender blender(&a);
+    blender.CrossFade(&a, 0.0f);
+    blender.Update(0.1f);
+    CHECK(blender.GetWeight(&a) == 1.0f);
+
+    // fading over half a second in 20 ms frames, the weights always sum to 1 and b only gains
+    blender.CrossFade(&b, 0.5f);
+    bool summed = true, rising = true;
+    float previous = 0.0f;
+    for (int frame = 0; frame < 30; frame++)
+    {
+        blender.Update(0.02f);
+        const float weightB = blender.GetWeight(&b);
+        summed = summed && std::abs(blender.GetWeight(&a) + weightB - 1.0f) < 1e-5f;
+        rising = rising && weightB >= previous;
+        previous = weightB;
+    }
+    CHECK(summed);
+    CHECK(rising);
+    CHECK(blender.GetWeight(&b) == 1.0f);
+    // the faded out clip is dropped
+    CHECK(blender.GetClipCount() == 1 && blender.GetWeight(&a) == 0.0f);
+}
+
+int main()
+{
+    std::unique_ptr<Animation> a = MakeClip(3), b = MakeClip(7);
+    TestSkeleton(*a);
+    TestBlend(*a, *b);
+    TestAdditive(*a, *b);
+    TestMask(*a, *b);
+    TestCrossFade(*a, *b);
+    return TestResult("animation_blend_test");
+}
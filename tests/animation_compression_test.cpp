@@ -0,0 +1,93 @@
+#include <learnopengl/bone.h>
+
+#include "test.h"
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+// Compressed translation tracks have to stay within the position tolerance at every original key, also when their
+// range is too wide for 16 bit quantization, and have to read back unchanged from a clip file.
+
+static float MaxKeyError(const Bone& bone, const std::vector<float>& times, const std::vector<glm::vec3>& positions)
+{
+    float maxError = 0.0f;
+    BoneCursor cursor;
+    for (size_t i = 0; i < times.size(); i++)
+        maxError = std::max(maxError, glm::length(bone.SampleTransform(times[i], cursor).translation - positions[i]));
+    return maxError;
+}
+
+// a bone moving along a wavy path, keys on whole ticks
+static Bone MakeBone(float range, int keyCount, std::vector<float>& times, std::vector<glm::vec3>& positions)
+{
+    aiNodeAnim channel;
+    channel.mNumPositionKeys = keyCount;
+    channel.mPositionKeys = new aiVectorKey[keyCount];
+    for (int i = 0; i < keyCount; i++)
+    {
+        float t = float(i) / keyCount;
+        glm::vec3 position(range * t, range * 0.1f * std::sin(t * 40.0f), -range * 0.5f * t * t);
+        times.push_back(float(i));
+        positions.push_back(position);
+        channel.mPositionKeys[i].mTime = i;
+        channel.mPositionKeys[i].mValue = aiVector3D(position.x, position.y, position.z);
+    }
+    channel.mNumRotationKeys = 1;
+    channel.mRotationKeys = new aiQuatKey[1];
+    channel.mNumScalingKeys = 1;
+    channel.mScalingKeys = new aiVectorKey[1];
+    channel.mScalingKeys[0].mValue = aiVector3D(1.0f, 1.0f, 1.0f);
+    return Bone("bone", 0, &channel);
+}
+
+static void TestTolerance(float range, bool expectRaw)
+{
+    std::vector<float> times;
+    std::vector<glm::vec3> positions;
+    Bone bone = MakeBone(range, 2000, times, positions);
+    AnimationCompressionSettings settings;
+    AnimationCompressionStats stats;
+    bone.Compress(settings, stats);
+    CHECK(bone.GetPositionTrack().IsRaw() == expectRaw);
+    CHECK(bone.GetPositionTrack().Size() < times.size());
+    CHECK(stats.maxPositionError <= settings.positionTolerance);
+    // sampling repeats the codec's arithmetic up to float rounding of the larger coordinates
+    CHECK(MaxKeyError(bone, times, positions) <= settings.positionTolerance * 1.01f + range * 1e-6f);
+}
+
+static void TestClipRoundTrip()
+{
+    std::vector<float> times;
+    std::vector<glm::vec3> positions;
+    Bone bone = MakeBone(1000.0f, 500, times, positions);
+    AnimationCompressionStats stats;
+    bone.Compress(AnimationCompressionSettings(), stats);
+
+    const std::string path = "animation_compression_test.track";
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        bone.GetPositionTrack().Write(file);
+        bone.GetRotationTrack().Write(file);
+        bone.GetScaleTrack().Write(file);
+    }
+    QuantizedTrack positionTrack, rotationTrack, scaleTrack;
+    {
+        std::ifstream file(path, std::ios::binary);
+        CHECK(positionTrack.Read(file) && rotationTrack.Read(file) && scaleTrack.Read(file));
+    }
+    std::remove(path.c_str());
+    CHECK(positionTrack.IsRaw() && !rotationTrack.IsRaw() && !scaleTrack.IsRaw());
+    CHECK(positionTrack.times == bone.GetPositionTrack().times && positionTrack.rawValues == bone.GetPositionTrack().rawValues);
+
+    Bone loaded("bone", 0, bone.GetTimeStep(), positionTrack, rotationTrack, scaleTrack);
+    CHECK(MaxKeyError(loaded, times, positions) == MaxKeyError(bone, times, positions));
+}
+
+int main()
+{
+    TestTolerance(10.0f, false);
+    TestTolerance(1000.0f, true);
+    TestClipRoundTrip();
+    return TestResult("animation_compression_test");
+}
@@ -0,0 +1,66 @@
+#include <glad/glad.h>
+#include <learnopengl/animation_instance.h>
+
+#include "benchmark.h"
+#include "humanoid_clip.h"
+
+#include <vector>
+
+// What a character costs once clips are shared: memory of one humanoid clip against the AnimationInstance every
+// character playing it owns, the total for crowds that share the clip against crowds where every character loads its
+// own copy, and the time to update a character on one thread.
+
+static size_t TreeMemory(const AssimpNodeData& node)
+{
+    size_t total = node.children.capacity() * sizeof(AssimpNodeData) + node.name.capacity();
+    for (const AssimpNodeData& child : node.children)
+        total += TreeMemory(child);
+    return total;
+}
+
+// the clip and the heap memory it owns; a std::map node is counted as its value plus three pointers and a color
+static size_t ClipMemory(const Animation& clip)
+{
+    size_t total = sizeof(Animation) + clip.GetKeyMemoryUsage() + clip.GetBones().capacity() * sizeof(Bone) + TreeMemory(clip.GetRootNode());
+    for (const AnimationNode& node : clip.GetNodes())
+        total += sizeof(AnimationNode) + node.name.capacity();
+    for (const auto& entry : clip.GetBoneIDMap())
+        total += sizeof(entry) + 4 * sizeof(void*) + entry.first.capacity();
+    return total;
+}
+
+int main()
+{
+    std::unique_ptr<Animation> clip = MakeHumanoidClip(1);
+    const size_t clipBytes = ClipMemory(*clip);
+    AnimationInstance single(clip.get());
+    const size_t instanceBytes = sizeof(AnimationInstance) + single.GetMemoryUsage();
+
+    Section("memory, humanoid clip of " + std::to_string(clip->GetBoneSlotCount()) + " bones and " + std::to_string(int(clip->GetDuration() / clip->GetTicksPerSecond())) + " s");
+    Report("clip keys", clip->GetKeyMemoryUsage() / 1024.0, "KiB");
+    Report("clip", clipBytes / 1024.0, "KiB");
+    Report("AnimationInstance", instanceBytes / 1024.0, "KiB");
+    for (size_t characters : { 1, 100, 1000 })
+    {
+        const std::string crowd = std::to_string(characters) + " characters, ";
+        Report(crowd + "one shared clip", (clipBytes + characters * instanceBytes) / 1024.0, "KiB");
+        Report(crowd + "a clip each", characters * (clipBytes + instanceBytes) / 1024.0, "KiB");
+    }
+
+    // characters at different points of the clip, so their key cursors don't move in step
+    const size_t characterCount = 1000;
+    std::vector<AnimationInstance> instances(characterCount, AnimationInstance(clip.get()));
+    for (size_t i = 0; i < characterCount; i++)
+        instances[i].Seek(clip->GetDuration() * i / characterCount);
+    const int frames = 20;
+    const double seconds = BestOf(3, [&] {
+        for (int frame = 0; frame < frames; frame++)
+            for (AnimationInstance& instance : instances)
+                instance.Update(1.0f / 60.0f);
+    });
+    Section("update, " + std::to_string(characterCount) + " characters on one thread");
+    Report("per character", seconds / (frames * characterCount) * 1.0e6, "us");
+    Report("per frame", seconds / frames * 1000.0, "ms");
+    Report("characters in a 60 Hz frame", characterCount * frames / seconds / 60.0, "");
+    return 0;
+}
@@ -0,0 +1,64 @@
+#include <glad/glad.h>
+#include <learnopengl/animation_system.h>
+
+#include "benchmark.h"
+#include "humanoid_clip.h"
+
+#include <map>
+#include <thread>
+#include <vector>
+
+// AnimationSystem updating a crowd of humanoids that play four shared clips, on JobSystems of one thread up to every
+// hardware thread: time per frame, characters per second and the speedup over one thread, for a few job grains.
+
+int main()
+{
+    std::vector<std::unique_ptr<Animation>> clips;
+    for (unsigned int seed = 1; seed <= 4; seed++)
+        clips.push_back(MakeHumanoidClip(seed));
+
+    const size_t characterCount = 2000;
+    std::vector<AnimationInstance> instances;
+    instances.reserve(characterCount);
+    for (size_t i = 0; i < characterCount; i++)
+    {
+        const Animation* clip = clips[i % clips.size()].get();
+        instances.push_back(AnimationInstance(clip));
+        instances.back().Seek(clip->GetDuration() * i / characterCount);
+    }
+
+    const unsigned int hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<unsigned int> threadCounts;
+    for (unsigned int threads = 1; threads < hardwareThreads; threads *= 2)
+        threadCounts.push_back(threads);
+    threadCounts.push_back(hardwareThreads);
+
+    Section(std::to_string(characterCount) + " characters of " + std::to_string(clips[0]->GetBoneSlotCount()) + " bones, " +
+        std::to_string(hardwareThreads) + " hardware threads");
+    const int frames = 10;
+    std::map<size_t, double> singleThread; // seconds per frame on one thread, by grain
+    for (unsigned int threads : threadCounts)
+    {
+        JobSystem jobs(threads);
+        AnimationSystem system(jobs);
+        for (AnimationInstance& instance : instances)
+            system.Add(&instance);
+        for (size_t grain : { 4, 16, 64 })
+        {
+            const double seconds = BestOf(3, [&] {
+                for (int frame = 0; frame < frames; frame++)
+                    system.Update(1.0f / 60.0f, grain);
+            }) / frames;
+            if (threads == 1)
+                singleThread[grain] = seconds;
+            const std::string name = std::to_string(threads) + (threads == 1 ? " thread" : " threads") + ", grain " + std::to_string(grain);
+            Report(name, seconds * 1000.0, "ms/frame");
+            Report(name, characterCount / seconds / 1000.0, "k characters/s");
+            if (threads > 1)
+                Report(name + ", speedup over 1 thread", singleThread[grain] / seconds, "x");
+        }
+        if (threads == 1)
+            Report("bone matrix buffer", system.GetBoneMatrices().size() * sizeof(glm::mat4) / 1024.0, "KiB");
+    }
+    return 0;
+}
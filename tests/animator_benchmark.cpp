@@ -0,0 +1,67 @@
+#include <glad/glad.h>
+#include <learnopengl/animator.h>
+
+#include "benchmark.h"
+#include "humanoid_clip.h"
+
+#include <vector>
+
+// Poses per second Animator evaluates on the baked, flat node hierarchy of a humanoid clip, against the recursive walk
+// over the AssimpNodeData tree that baking replaced: a bone found by name and the bone map copied at every node.
+
+// Animator::CalculateBoneTransform as it was before the hierarchy was baked
+static void CalculateBoneTransform(const Animation& animation, float time, const AssimpNodeData* node, glm::mat4 parentTransform,
+    std::vector<glm::mat4>& finalBoneMatrices)
+{
+    std::string nodeName = node->name;
+    glm::mat4 nodeTransform = node->transformation;
+    const Bone* bone = animation.FindBone(nodeName);
+    if (bone)
+        nodeTransform = bone->Sample(time);
+
+    glm::mat4 globalTransformation = parentTransform * nodeTransform;
+    auto boneInfoMap = animation.GetBoneIDMap();
+    if (boneInfoMap.find(nodeName) != boneInfoMap.end())
+    {
+        int index = boneInfoMap[nodeName].id;
+        glm::mat4 offset = boneInfoMap[nodeName].offset;
+        finalBoneMatrices[index] = globalTransformation * offset;
+    }
+
+    for (int i = 0; i < node->childrenCount; i++)
+        CalculateBoneTransform(animation, time, &node->children[i], globalTransformation, finalBoneMatrices);
+}
+
+int main()
+{
+    std::unique_ptr<Animation> clip = MakeHumanoidClip(1);
+    Section("humanoid clip, " + std::to_string(clip->GetNodes().size()) + " nodes, " + std::to_string(clip->GetBoneSlotCount()) + " bones");
+
+    // a 60 Hz frame at a time, the way a game advances it
+    const int frames = 20000;
+    Animator animator(clip.get());
+    const double flatSeconds = BestOf(3, [&] {
+        for (int frame = 0; frame < frames; frame++)
+            animator.UpdateAnimation(1.0f / 60.0f);
+        Consume(size_t(animator.GetFinalBoneMatrices()[1][3][0] != 0.0f));
+    });
+
+    const int recursiveFrames = frames / 20;
+    std::vector<glm::mat4> finalBoneMatrices(clip->GetBoneSlotCount(), glm::mat4(1.0f));
+    const double recursiveSeconds = BestOf(3, [&] {
+        float time = 0.0f;
+        for (int frame = 0; frame < recursiveFrames; frame++)
+        {
+            time = fmod(time + clip->GetTicksPerSecond() / 60.0f, clip->GetDuration());
+            CalculateBoneTransform(*clip, time, &clip->GetRootNode(), glm::mat4(1.0f), finalBoneMatrices);
+        }
+        Consume(size_t(finalBoneMatrices[1][3][0] != 0.0f));
+    });
+
+    Report("baked hierarchy, Animator::UpdateAnimation", frames / flatSeconds, "poses/s");
+    Report("baked hierarchy, Animator::UpdateAnimation", flatSeconds / frames * 1.0e6, "us/pose");
+    Report("recursive walk with bone lookups by name", recursiveFrames / recursiveSeconds, "poses/s");
+    Report("recursive walk with bone lookups by name", recursiveSeconds / recursiveFrames * 1.0e6, "us/pose");
+    Report("speedup", (frames / flatSeconds) / (recursiveFrames / recursiveSeconds), "x");
+    return 0;
+}
@@ -0,0 +1,52 @@
+#ifndef TESTS_BENCHMARK_H
+#define TESTS_BENCHMARK_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+
+// Timing for the headless benchmarks. A benchmark prints what it measured and checks nothing, so the benchmarks are
+// built with the tests but not run by ctest. Numbers are only worth comparing from a Release build.
+
+typedef std::chrono::steady_clock BenchmarkClock;
+
+inline double SecondsSince(BenchmarkClock::time_point start)
+{
+    return std::chrono::duration<double>(BenchmarkClock::now() - start).count();
+}
+
+// shortest of runs calls of work in seconds, the run least disturbed by the rest of the system
+template<typename TWork>
+double BestOf(int runs, TWork work)
+{
+    double best = 0.0;
+    for (int run = 0; run < runs; run++)
+    {
+        const BenchmarkClock::time_point start = BenchmarkClock::now();
+        work();
+        const double seconds = SecondsSince(start);
+        if (run == 0 || seconds < best)
+            best = seconds;
+    }
+    return best;
+}
+
+// keeps the compiler from dropping work whose result nobody reads
+inline void Consume(size_t value)
+{
+    static volatile size_t sink;
+    sink = sink + value;
+}
+
+inline void Report(const std::string& name, double value, const char* unit)
+{
+    std::printf("%-56s %14.3f %s\n", name.c_str(), value, unit);
+}
+
+inline void Section(const std::string& title)
+{
+    std::printf("\n%s\n", title.c_str());
+}
+
+#endif
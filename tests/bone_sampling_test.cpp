@@ -0,0 +1,171 @@
+#include <learnopengl/bone.h>
+
+#include "test.h"
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+// Bone::SampleTransform with a playback cursor has to give exactly the poses of the original linear key search,
+// whatever the playback does: loop, seek, step backwards or jump over many keys.
+
+struct Track
+{
+    std::vector<float> times;
+    std::vector<glm::vec3> positions;
+    std::vector<glm::quat> rotations;
+};
+
+static std::vector<float> RandomTimes(std::mt19937& rng, int count, float duration)
+{
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::vector<float> times;
+    float time = 0.0f;
+    for (int i = 0; i < count; i++)
+    {
+        times.push_back(time);
+        time += duration / count * (0.25f + 1.5f * unit(rng));
+    }
+    return times;
+}
+
+static void MakeChannel(std::mt19937& rng, aiNodeAnim& channel, Track& track, int positionCount, int rotationCount, int scaleCount, float duration)
+{
+    std::uniform_real_distribution<float> value(-2.0f, 2.0f);
+
+    track.times = RandomTimes(rng, positionCount, duration);
+    channel.mNumPositionKeys = positionCount;
+    channel.mPositionKeys = new aiVectorKey[positionCount];
+    for (int i = 0; i < positionCount; i++)
+    {
+        track.positions.push_back(glm::vec3(value(rng), value(rng), value(rng)));
+        channel.mPositionKeys[i].mTime = track.times[i];
+        channel.mPositionKeys[i].mValue = aiVector3D(track.positions[i].x, track.positions[i].y, track.positions[i].z);
+    }
+
+    std::vector<float> rotationTimes = RandomTimes(rng, rotationCount, duration);
+    channel.mNumRotationKeys = rotationCount;
+    channel.mRotationKeys = new aiQuatKey[rotationCount];
+    for (int i = 0; i < rotationCount; i++)
+    {
+        glm::quat q = glm::normalize(glm::quat(value(rng), value(rng), value(rng), value(rng)));
+        channel.mRotationKeys[i].mTime = rotationTimes[i];
+        channel.mRotationKeys[i].mValue = aiQuaternion(q.w, q.x, q.y, q.z);
+        track.rotations.push_back(q);
+    }
+
+    std::vector<float> scaleTimes = RandomTimes(rng, scaleCount, duration);
+    channel.mNumScalingKeys = scaleCount;
+    channel.mScalingKeys = new aiVectorKey[scaleCount];
+    for (int i = 0; i < scaleCount; i++)
+    {
+        channel.mScalingKeys[i].mTime = scaleTimes[i];
+        channel.mScalingKeys[i].mValue = aiVector3D(1.0f + 0.25f * value(rng), 1.0f, 1.0f - 0.25f * value(rng));
+    }
+}
+
+// the key search Bone used before cursors: first key whose successor lies after the time, the last segment past the end
+static int LinearKey(const std::vector<float>& times, float animationTime)
+{
+    for (int index = 0; index < (int)times.size() - 1; ++index)
+    {
+        if (animationTime < times[index + 1])
+            return index;
+    }
+    return (int)times.size() - 2;
+}
+
+static bool SameTransform(const BoneTransform& a, const BoneTransform& b)
+{
+    return std::memcmp(&a.translation, &b.translation, sizeof(a.translation)) == 0 &&
+           std::memcmp(&a.rotation, &b.rotation, sizeof(a.rotation)) == 0 &&
+           std::memcmp(&a.scale, &b.scale, sizeof(a.scale)) == 0;
+}
+
+static void TestAgainstLinearSearch(int positionCount, int rotationCount, int scaleCount)
+{
+    std::mt19937 rng(positionCount * 131 + rotationCount * 17 + scaleCount);
+    const float duration = 10.0f;
+    aiNodeAnim channel;
+    Track track;
+    MakeChannel(rng, channel, track, positionCount, rotationCount, scaleCount, duration);
+    Bone bone("bone", 0, &channel);
+
+    // the reference interpolates translation with the linear search, the same way Bone does
+    auto referencePosition = [&](float time)
+    {
+        if (positionCount == 1)
+            return track.positions[0];
+        int key = LinearKey(track.times, time);
+        float factor = (time - track.times[key]) / (track.times[key + 1] - track.times[key]);
+        return glm::mix(track.positions[key], track.positions[key + 1], factor);
+    };
+
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    BoneCursor cursor;
+    float time = 0.0f;
+    int mismatches = 0;
+    for (int step = 0; step < 20000; step++)
+    {
+        // mostly small forward steps, sometimes a seek, a step back or a loop around
+        float choice = unit(rng);
+        if (choice < 0.9f)
+            time += 0.016f * unit(rng) * 2.0f;
+        else if (choice < 0.95f)
+            time = duration * unit(rng);
+        else
+            time = std::max(0.0f, time - unit(rng));
+        if (time > duration)
+            time = std::fmod(time, duration);
+
+        BoneTransform withCursor = bone.SampleTransform(time, cursor);
+        BoneCursor fresh;
+        BoneTransform binarySearch = bone.SampleTransform(time, fresh);
+        glm::vec3 reference = referencePosition(time);
+        if (!SameTransform(withCursor, binarySearch) || std::memcmp(&withCursor.translation, &reference, sizeof(reference)) != 0)
+            mismatches++;
+        if (positionCount > 1 && bone.GetPositionIndex(time) != LinearKey(track.times, time))
+            mismatches++;
+    }
+    CHECK(mismatches == 0);
+
+    // the lookups clamp before the first and after the last key
+    CHECK(positionCount < 2 || bone.GetPositionIndex(-1.0f) == 0);
+    CHECK(positionCount < 2 || bone.GetPositionIndex(duration * 10.0f) == positionCount - 2);
+}
+
+// compressed tracks go through the same cursor logic on their 16 bit times
+static void TestCompressedCursor()
+{
+    std::mt19937 rng(7);
+    aiNodeAnim channel;
+    Track track;
+    MakeChannel(rng, channel, track, 200, 150, 3, 10.0f);
+    Bone bone("bone", 0, &channel);
+    AnimationCompressionSettings settings;
+    AnimationCompressionStats stats;
+    bone.Compress(settings, stats);
+    CHECK(bone.IsCompressed());
+
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    BoneCursor cursor;
+    int mismatches = 0;
+    for (int step = 0; step < 5000; step++)
+    {
+        float time = unit(rng) < 0.9f ? std::fmod(step * 0.01f, 10.0f) : 10.0f * unit(rng);
+        BoneCursor fresh;
+        if (!SameTransform(bone.SampleTransform(time, cursor), bone.SampleTransform(time, fresh)))
+            mismatches++;
+    }
+    CHECK(mismatches == 0);
+}
+
+int main()
+{
+    TestAgainstLinearSearch(1, 1, 1);
+    TestAgainstLinearSearch(2, 3, 1);
+    TestAgainstLinearSearch(10, 7, 2);
+    TestAgainstLinearSearch(1000, 300, 50);
+    TestCompressedCursor();
+    return TestResult("bone_sampling_test");
+}
@@ -0,0 +1,169 @@
+#include <glad/glad.h>
+#include <learnopengl/camera.h>
+#include <learnopengl/model.h>
+#include <learnopengl/bounding_volume_hierarchy.h>
+#include <learnopengl/frustum_culling.h>
+
+#include "benchmark.h"
+
+#include <random>
+#include <vector>
+
+// BoundingVolumeHierarchy on 10k, 100k and 1M boxes spread over a flat world that grows with the count, so the density
+// stays the same and a frustum sees a smaller share of it: the time to build the tree and its memory per object,
+// frustum culls against isOnFrustum on every box and against FrustumCuller, ray casts and box overlap queries against
+// testing every box, and the cost of keeping the tree up to date when a tenth of the objects move a little (Refit) or
+// jump across the world (Move), with the cull time of the updated tree next to a rebuilt one.
+
+static bool IntersectRay(const AABB& box, const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance)
+{
+    const glm::vec3 t1 = (box.center - box.extents - origin) * inverseDirection, t2 = (box.center + box.extents - origin) * inverseDirection;
+    const glm::vec3 near = glm::min(t1, t2), far = glm::max(t1, t2);
+    const float enter = std::max(std::max(near.x, near.y), std::max(near.z, 0.0f));
+    const float exit = std::min(std::min(far.x, far.y), std::min(far.z, maxDistance));
+    return enter <= exit;
+}
+
+static bool Overlaps(const AABB& box, const glm::vec3& min, const glm::vec3& max)
+{
+    return glm::all(glm::lessThanEqual(box.center - box.extents, max)) && glm::all(glm::lessThanEqual(min, box.center + box.extents));
+}
+
+static void Benchmark(size_t objectCount, const Frustum& frustum)
+{
+    std::mt19937 rng(7);
+    const float world = std::cbrt(float(objectCount)) * 20.0f;
+    std::uniform_real_distribution<float> position(-world, world), extent(0.2f, 4.0f), jitter(-0.05f, 0.05f), direction(-1.0f, 1.0f);
+    std::vector<AABB> boxes;
+    boxes.reserve(objectCount);
+    for (size_t i = 0; i < objectCount; i++)
+        boxes.emplace_back(glm::vec3(position(rng), position(rng) * 0.2f, position(rng)), extent(rng), extent(rng), extent(rng));
+
+    Section(std::to_string(objectCount) + " boxes");
+    BoundingVolumeHierarchy bvh;
+    const double buildSeconds = BestOf(objectCount >= 1000000 ? 1 : 3, [&] { bvh.Build(boxes); });
+    Report("build", buildSeconds * 1000.0, "ms");
+    Report("memory", double(bvh.GetMemoryUsage()) / objectCount, "bytes/object");
+    Report("height", bvh.GetHeight(), "");
+
+    // frustum culls
+    PackedAABBs packed;
+    for (const AABB& box : boxes)
+        packed.Add(box);
+    const FrustumCuller culler(frustum);
+    std::vector<uint32_t> visible;
+    const double cullSeconds = BestOf(20, [&] { bvh.Cull(frustum, visible); });
+    Report("visible", 100.0 * visible.size() / objectCount, "%");
+    const double linearSeconds = BestOf(5, [&] {
+        visible.clear();
+        for (size_t i = 0; i < objectCount; i++)
+            if (static_cast<const BoundingVolume&>(boxes[i]).isOnFrustum(frustum))
+                visible.push_back(static_cast<uint32_t>(i));
+    });
+    const double packedSeconds = BestOf(20, [&] { culler.Cull(packed, visible); });
+    Report("cull, isOnFrustum on every box", linearSeconds * 1000.0, "ms");
+    Report("cull, FrustumCuller", packedSeconds * 1000.0, "ms");
+    Report("cull, BoundingVolumeHierarchy", cullSeconds * 1000.0, "ms");
+
+    // ray casts from random points in random directions, near the ground plane like picking rays
+    const int rayCount = 10000, bruteForceRays = 20;
+    std::vector<glm::vec3> origins(rayCount), directions(rayCount);
+    for (int r = 0; r < rayCount; r++)
+    {
+        origins[r] = glm::vec3(position(rng), position(rng) * 0.2f, position(rng));
+        directions[r] = glm::normalize(glm::vec3(direction(rng), direction(rng) * 0.2f, direction(rng)));
+    }
+    size_t hits = 0;
+    const double raySeconds = BestOf(3, [&] {
+        hits = 0;
+        for (int r = 0; r < rayCount; r++)
+        {
+            BoundingVolumeHierarchy::RayHit hit;
+            hits += bvh.RayCast(origins[r], directions[r], world, hit);
+        }
+    });
+    const double bruteForceRaySeconds = BestOf(3, [&] {
+        size_t bruteForceHits = 0;
+        for (int r = 0; r < bruteForceRays; r++)
+        {
+            const glm::vec3 inverseDirection = 1.0f / directions[r];
+            for (const AABB& box : boxes)
+                bruteForceHits += IntersectRay(box, origins[r], inverseDirection, world);
+        }
+        Consume(bruteForceHits);
+    });
+    Report("rays hitting a box", 100.0 * hits / rayCount, "%");
+    Report("ray cast, every box", bruteForceRaySeconds / bruteForceRays * 1.0e6, "us");
+    Report("ray cast, BoundingVolumeHierarchy", raySeconds / rayCount * 1.0e6, "us");
+
+    // 10 x 10 x 10 overlap queries on the ground
+    const int queryCount = 10000, bruteForceQueries = 20;
+    std::vector<glm::vec3> queryCenters(queryCount);
+    for (glm::vec3& center : queryCenters)
+        center = glm::vec3(position(rng), 0.0f, position(rng));
+    std::vector<uint32_t> result;
+    size_t found = 0;
+    const double querySeconds = BestOf(3, [&] {
+        found = 0;
+        for (const glm::vec3& center : queryCenters)
+        {
+            result.clear();
+            bvh.Query(center - glm::vec3(5.0f), center + glm::vec3(5.0f), result);
+            found += result.size();
+        }
+    });
+    const double bruteForceQuerySeconds = BestOf(3, [&] {
+        size_t bruteForceFound = 0;
+        for (int q = 0; q < bruteForceQueries; q++)
+            for (const AABB& box : boxes)
+                bruteForceFound += Overlaps(box, queryCenters[q] - glm::vec3(5.0f), queryCenters[q] + glm::vec3(5.0f));
+        Consume(bruteForceFound);
+    });
+    Report("boxes per overlap query", double(found) / queryCount, "");
+    Report("overlap query, every box", bruteForceQuerySeconds / bruteForceQueries * 1.0e6, "us");
+    Report("overlap query, BoundingVolumeHierarchy", querySeconds / queryCount * 1.0e6, "us");
+
+    // a tenth of the objects move a little, then a tenth jump somewhere else
+    const size_t movedCount = objectCount / 10;
+    std::vector<uint32_t> moved(movedCount);
+    for (uint32_t& proxy : moved)
+        proxy = rng() % objectCount;
+    size_t changed = 0;
+    BenchmarkClock::time_point start = BenchmarkClock::now();
+    for (uint32_t proxy : moved)
+    {
+        boxes[proxy].center += glm::vec3(jitter(rng), jitter(rng), jitter(rng));
+        changed += bvh.Refit(proxy, boxes[proxy].center, boxes[proxy].extents);
+    }
+    const double refitSeconds = SecondsSince(start);
+    Report("10% moved a little, Refit", refitSeconds * 1000.0, "ms");
+    Report("10% moved a little, leaves past their margin", 100.0 * changed / movedCount, "%");
+    Report("cull after Refit", BestOf(20, [&] { bvh.Cull(frustum, visible); }) * 1000.0, "ms");
+
+    std::vector<glm::vec3> destinations(movedCount);
+    for (glm::vec3& destination : destinations)
+        destination = glm::vec3(position(rng), position(rng) * 0.2f, position(rng));
+    start = BenchmarkClock::now();
+    for (size_t k = 0; k < movedCount; k++)
+    {
+        boxes[moved[k]].center = destinations[k];
+        bvh.Move(moved[k], boxes[moved[k]].center, boxes[moved[k]].extents);
+    }
+    const double moveSeconds = SecondsSince(start);
+    Report("10% jumped, Move", moveSeconds * 1000.0, "ms");
+    Report("cull after Move", BestOf(20, [&] { bvh.Cull(frustum, visible); }) * 1000.0, "ms");
+
+    start = BenchmarkClock::now();
+    bvh.Rebuild();
+    Report("Rebuild", SecondsSince(start) * 1000.0, "ms");
+    Report("cull after Rebuild", BestOf(20, [&] { bvh.Cull(frustum, visible); }) * 1000.0, "ms");
+}
+
+int main()
+{
+    Camera camera(glm::vec3(0.0f, 5.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), -60.0f, -10.0f);
+    const Frustum frustum = createFrustumFromCamera(camera, 16.0f / 9.0f, glm::radians(50.0f), 0.1f, 400.0f);
+    for (size_t objectCount : { 10000, 100000, 1000000 })
+        Benchmark(objectCount, frustum);
+    return 0;
+}
@@ -0,0 +1,174 @@
+#include <glad/glad.h>
+#include <learnopengl/camera.h>
+#include <learnopengl/model.h>
+#include <learnopengl/bounding_volume_hierarchy.h>
+
+#include "test.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+// Every BoundingVolumeHierarchy query has to return what testing each box on its own returns: Cull the boxes
+// isOnFrustum accepts, RayCast the nearest box the ray enters, Query the boxes overlapping the query box. Checked after
+// Build and again after the tree was changed with Insert, Move, Refit and Remove, which ignore removed proxies.
+
+struct Scene
+{
+    std::vector<AABB> boxes;
+    std::vector<bool> alive;
+    std::vector<BoundingVolumeHierarchy::Proxy> proxies;
+};
+
+static bool RayBox(const AABB& box, const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance, float& distance)
+{
+    const glm::vec3 t1 = (box.center - box.extents - origin) * inverseDirection;
+    const glm::vec3 t2 = (box.center + box.extents - origin) * inverseDirection;
+    const glm::vec3 entries = glm::min(t1, t2), exits = glm::max(t1, t2);
+    const float enter = std::max(std::max(entries.x, entries.y), std::max(entries.z, 0.0f));
+    const float exit = std::min(std::min(exits.x, exits.y), std::min(exits.z, maxDistance));
+    distance = enter;
+    return enter <= exit;
+}
+
+static void CheckQueries(const BoundingVolumeHierarchy& bvh, const Scene& scene, const Frustum& frustum, std::mt19937& rng, float world)
+{
+    std::vector<uint32_t> visible, expected;
+    bvh.Cull(frustum, visible);
+    std::sort(visible.begin(), visible.end());
+    for (uint32_t i = 0; i < scene.boxes.size(); i++)
+        if (scene.alive[i] && static_cast<const BoundingVolume&>(scene.boxes[i]).isOnFrustum(frustum))
+            expected.push_back(i);
+    CHECK(!expected.empty());
+    CHECK(visible == expected);
+
+    std::uniform_real_distribution<float> position(-world, world), direction(-1.0f, 1.0f), size(1.0f, world * 0.2f);
+    int rayMismatches = 0, queryMismatches = 0;
+    for (int r = 0; r < 200; r++)
+    {
+        const glm::vec3 origin(position(rng), position(rng) * 0.2f, position(rng));
+        const glm::vec3 dir = glm::normalize(glm::vec3(direction(rng), direction(rng) * 0.2f, direction(rng)));
+        const glm::vec3 inverseDirection = 1.0f / dir;
+        BoundingVolumeHierarchy::RayHit hit;
+        const bool hasHit = bvh.RayCast(origin, dir, world, hit);
+        float closest = world;
+        bool expectedHit = false;
+        for (uint32_t i = 0; i < scene.boxes.size(); i++)
+        {
+            float distance;
+            if (scene.alive[i] && RayBox(scene.boxes[i], origin, inverseDirection, closest, distance))
+            {
+                closest = distance;
+                expectedHit = true;
+            }
+        }
+        // boxes at the same distance may be reported in any order, only the distance has to match
+        rayMismatches += hasHit != expectedHit || (hasHit && (hit.distance != closest || !scene.alive[hit.userData]));
+
+        const glm::vec3 center(position(rng), position(rng) * 0.2f, position(rng));
+        const glm::vec3 extents(size(rng), size(rng), size(rng));
+        std::vector<uint32_t> found, overlapping;
+        bvh.Query(center - extents, center + extents, found);
+        std::sort(found.begin(), found.end());
+        for (uint32_t i = 0; i < scene.boxes.size(); i++)
+        {
+            const AABB& box = scene.boxes[i];
+            if (scene.alive[i] && glm::all(glm::lessThanEqual(box.center - box.extents, center + extents)) &&
+                glm::all(glm::lessThanEqual(center - extents, box.center + box.extents)))
+                overlapping.push_back(i);
+        }
+        queryMismatches += found != overlapping;
+    }
+    CHECK(rayMismatches == 0);
+    CHECK(queryMismatches == 0);
+}
+
+int main()
+{
+    Camera camera(glm::vec3(0.0f, 5.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), -60.0f, -10.0f);
+    const Frustum frustum = createFrustumFromCamera(camera, 16.0f / 9.0f, glm::radians(50.0f), 0.1f, 400.0f);
+
+    std::mt19937 rng(7);
+    const size_t count = 10000;
+    const float world = 500.0f;
+    std::uniform_real_distribution<float> position(-world, world), extent(0.2f, 4.0f), step(-3.0f, 3.0f);
+
+    Scene scene;
+    for (size_t i = 0; i < count; i++)
+        scene.boxes.emplace_back(glm::vec3(position(rng), position(rng) * 0.2f, position(rng)), extent(rng), extent(rng), extent(rng));
+    scene.alive.assign(count, true);
+
+    BoundingVolumeHierarchy bvh;
+    bvh.Build(scene.boxes);
+    for (size_t i = 0; i < count; i++)
+        scene.proxies.push_back(static_cast<BoundingVolumeHierarchy::Proxy>(i));
+    CHECK(bvh.GetHeight() < 64);
+    CheckQueries(bvh, scene, frustum, rng, world);
+
+    // move most boxes a little, alternating reinsertion and refitting, remove some and insert new ones
+    for (int round = 0; round < 3; round++)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            if (!scene.alive[i] || rng() % 4 == 0)
+                continue;
+            AABB& box = scene.boxes[i];
+            box.center += glm::vec3(step(rng), step(rng) * 0.2f, step(rng));
+            if (i % 2)
+                bvh.Move(scene.proxies[i], box.center, box.extents);
+            else
+                bvh.Refit(scene.proxies[i], box.center, box.extents);
+        }
+        for (size_t i = round; i < count; i += 7)
+        {
+            if (!scene.alive[i])
+                continue;
+            bvh.Remove(scene.proxies[i]);
+            scene.alive[i] = false;
+        }
+        for (int n = 0; n < 500; n++)
+        {
+            scene.boxes.emplace_back(glm::vec3(position(rng), position(rng) * 0.2f, position(rng)), extent(rng), extent(rng), extent(rng));
+            scene.alive.push_back(true);
+            const uint32_t userData = static_cast<uint32_t>(scene.boxes.size() - 1);
+            scene.proxies.push_back(bvh.Insert(scene.boxes.back().center, scene.boxes.back().extents, userData));
+        }
+        CheckQueries(bvh, scene, frustum, rng, world);
+    }
+
+    bvh.Rebuild();
+    CheckQueries(bvh, scene, frustum, rng, world);
+
+    // removed and unknown proxies are ignored
+    const BoundingVolumeHierarchy::Proxy removed = bvh.Insert(glm::vec3(0.0f), glm::vec3(1.0f), 0);
+    bvh.Remove(removed);
+    CHECK(!bvh.Move(removed, glm::vec3(0.0f), glm::vec3(1000.0f)));
+    CHECK(!bvh.Refit(removed, glm::vec3(0.0f), glm::vec3(1000.0f)));
+    bvh.Remove(removed);
+    CHECK(!bvh.Move(BoundingVolumeHierarchy::Invalid, glm::vec3(0.0f), glm::vec3(1.0f)));
+    CHECK(!bvh.Refit(BoundingVolumeHierarchy::Invalid, glm::vec3(0.0f), glm::vec3(1.0f)));
+    bvh.Remove(BoundingVolumeHierarchy::Invalid);
+    CheckQueries(bvh, scene, frustum, rng, world);
+
+    // a box that shrinks well inside its leaf gets a tighter one, small changes keep the leaf
+    const size_t last = scene.boxes.size() - 1;
+    AABB& shrinking = scene.boxes[last];
+    shrinking.extents = glm::vec3(5.0f);
+    bvh.Move(scene.proxies[last], shrinking.center, shrinking.extents);
+    shrinking.extents = glm::vec3(4.95f);
+    CHECK(!bvh.Move(scene.proxies[last], shrinking.center, shrinking.extents));
+    shrinking.extents = glm::vec3(0.5f);
+    CHECK(bvh.Move(scene.proxies[last], shrinking.center, shrinking.extents));
+    shrinking.extents = glm::vec3(0.1f);
+    CHECK(bvh.Refit(scene.proxies[last], shrinking.center, shrinking.extents));
+    CheckQueries(bvh, scene, frustum, rng, world);
+
+    // an empty tree finds nothing
+    BoundingVolumeHierarchy empty;
+    std::vector<uint32_t> result;
+    BoundingVolumeHierarchy::RayHit hit;
+    empty.Cull(frustum, result);
+    CHECK(result.empty());
+    CHECK(!empty.RayCast(glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), 100.0f, hit));
+    return TestResult("bounding_volume_hierarchy_test");
+}
@@ -0,0 +1,104 @@
+#include <glad/glad.h>
+#include <learnopengl/camera.h>
+#include <learnopengl/model.h>
+#include <learnopengl/frustum_culling.h>
+
+#include "benchmark.h"
+
+#include <random>
+#include <thread>
+#include <vector>
+
+// Frustum culling of 100k and 1M objects scattered around the camera: isOnFrustum called on every bounding volume, as
+// Entity::drawSelfAndChild does, against FrustumCuller on the packed volumes, on the calling thread and on every
+// hardware thread, for boxes and for spheres. FrustumCuller's SIMD width is the one this build picked.
+
+int main()
+{
+    Camera camera(glm::vec3(0.0f, 5.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), -60.0f, -10.0f);
+    const Frustum frustum = createFrustumFromCamera(camera, 16.0f / 9.0f, glm::radians(50.0f), 0.1f, 400.0f);
+    const FrustumCuller culler(frustum);
+    const unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+    JobSystem jobs(cores);
+
+    for (size_t objectCount : { 100000, 1000000 })
+    {
+        std::mt19937 rng(1);
+        std::uniform_real_distribution<float> position(-500.0f, 500.0f), extent(0.1f, 20.0f), angle(0.0f, 360.0f), scale(0.3f, 3.0f);
+        std::vector<AABB> localBoxes, worldBoxes;
+        std::vector<Sphere> spheres;
+        std::vector<Transform> transforms(objectCount);
+        PackedAABBs packedBoxes;
+        PackedSpheres packedSpheres;
+        localBoxes.reserve(objectCount);
+        worldBoxes.reserve(objectCount);
+        spheres.reserve(objectCount);
+        for (size_t i = 0; i < objectCount; i++)
+        {
+            const glm::vec3 center(position(rng), position(rng) * 0.1f, position(rng)), size(extent(rng), extent(rng), extent(rng));
+            transforms[i].setLocalPosition(center);
+            transforms[i].setLocalRotation(glm::vec3(angle(rng), angle(rng), angle(rng)));
+            transforms[i].setLocalScale(glm::vec3(scale(rng), scale(rng), scale(rng)));
+            transforms[i].computeModelMatrix();
+            localBoxes.emplace_back(-size * 0.5f, size * 0.5f);
+            packedBoxes.AddTransformed(localBoxes.back(), transforms[i].getModelMatrix());
+            spheres.emplace_back(center, size.x);
+            packedSpheres.Add(center, size.x);
+        }
+        // the same world boxes AddTransformed packed, for isOnFrustum without the transform
+        for (size_t i = 0; i < objectCount; i++)
+        {
+            const glm::vec3 center = glm::vec3(transforms[i].getModelMatrix() * glm::vec4(localBoxes[i].center, 1.0f));
+            const glm::mat4& model = transforms[i].getModelMatrix();
+            glm::vec3 extents;
+            for (int k = 0; k < 3; k++)
+                extents[k] = std::abs(model[0][k] * localBoxes[i].extents.x) + std::abs(model[1][k] * localBoxes[i].extents.y) +
+                             std::abs(model[2][k] * localBoxes[i].extents.z);
+            worldBoxes.emplace_back(center, extents.x, extents.y, extents.z);
+        }
+
+        std::vector<uint32_t> visible;
+        const int runs = 10;
+        const double boxTransformSeconds = BestOf(runs, [&] {
+            visible.clear();
+            for (size_t i = 0; i < objectCount; i++)
+                if (localBoxes[i].isOnFrustum(frustum, transforms[i]))
+                    visible.push_back(static_cast<uint32_t>(i));
+        });
+        const double boxSeconds = BestOf(runs, [&] {
+            visible.clear();
+            for (size_t i = 0; i < objectCount; i++)
+                if (static_cast<const BoundingVolume&>(worldBoxes[i]).isOnFrustum(frustum))
+                    visible.push_back(static_cast<uint32_t>(i));
+        });
+        const size_t visibleBoxes = visible.size();
+        const double packedBoxSeconds = BestOf(runs, [&] { culler.Cull(packedBoxes, visible); });
+        const double sphereSeconds = BestOf(runs, [&] {
+            visible.clear();
+            for (size_t i = 0; i < objectCount; i++)
+                if (static_cast<const BoundingVolume&>(spheres[i]).isOnFrustum(frustum))
+                    visible.push_back(static_cast<uint32_t>(i));
+        });
+        const size_t visibleSpheres = visible.size();
+        const double packedSphereSeconds = BestOf(runs, [&] { culler.Cull(packedSpheres, visible); });
+
+        Section(std::to_string(objectCount) + " objects, " + std::to_string(SIMD_LANES) + " SIMD lanes");
+        Report("boxes visible", 100.0 * visibleBoxes / objectCount, "%");
+        Report("boxes, isOnFrustum with the model transform", boxTransformSeconds * 1000.0, "ms");
+        Report("boxes, isOnFrustum on world boxes", boxSeconds * 1000.0, "ms");
+        Report("boxes, FrustumCuller", packedBoxSeconds * 1000.0, "ms");
+        Report("boxes, FrustumCuller", objectCount / packedBoxSeconds / 1.0e6, "MObject/s");
+        Report("spheres visible", 100.0 * visibleSpheres / objectCount, "%");
+        Report("spheres, isOnFrustum", sphereSeconds * 1000.0, "ms");
+        Report("spheres, FrustumCuller", packedSphereSeconds * 1000.0, "ms");
+        Report("spheres, FrustumCuller", objectCount / packedSphereSeconds / 1.0e6, "MObject/s");
+        if (cores > 1)
+        {
+            const double parallelBoxSeconds = BestOf(runs, [&] { culler.Cull(packedBoxes, visible, &jobs); });
+            const double parallelSphereSeconds = BestOf(runs, [&] { culler.Cull(packedSpheres, visible, &jobs); });
+            Report("boxes, FrustumCuller on " + std::to_string(cores) + " threads", parallelBoxSeconds * 1000.0, "ms");
+            Report("spheres, FrustumCuller on " + std::to_string(cores) + " threads", parallelSphereSeconds * 1000.0, "ms");
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,54 @@
+#include <glad/glad.h>
+#include <learnopengl/camera.h>
+#include <learnopengl/model.h>
+#include <learnopengl/frustum_culling.h>
+
+#include "test.h"
+
+#include <random>
+#include <vector>
+
+// FrustumCuller has to return exactly the boxes and spheres isOnFrustum accepts, in increasing order, whether it
+// runs on the calling thread or split into ranges on a JobSystem, and for counts that aren't a multiple of the
+// SIMD width.
+
+int main()
+{
+    Camera camera(glm::vec3(0.0f, 5.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), -60.0f, -10.0f);
+    const Frustum frustum = createFrustumFromCamera(camera, 16.0f / 9.0f, glm::radians(50.0f), 0.1f, 400.0f);
+    const FrustumCuller culler(frustum);
+    JobSystem jobs(4);
+
+    for (size_t count : { size_t(0), size_t(1), size_t(7), size_t(1000), size_t(100003) })
+    {
+        std::mt19937 rng(static_cast<unsigned int>(count));
+        std::uniform_real_distribution<float> position(-500.0f, 500.0f), extent(0.1f, 20.0f);
+        PackedAABBs boxes;
+        PackedSpheres spheres;
+        std::vector<uint32_t> expectedBoxes, expectedSpheres;
+        for (size_t i = 0; i < count; i++)
+        {
+            const glm::vec3 center(position(rng), position(rng) * 0.1f, position(rng));
+            const AABB box(center, extent(rng), extent(rng), extent(rng));
+            const Sphere sphere(center, extent(rng));
+            boxes.Add(box);
+            spheres.Add(sphere);
+            if (static_cast<const BoundingVolume&>(box).isOnFrustum(frustum))
+                expectedBoxes.push_back(static_cast<uint32_t>(i));
+            if (static_cast<const BoundingVolume&>(sphere).isOnFrustum(frustum))
+                expectedSpheres.push_back(static_cast<uint32_t>(i));
+        }
+        CHECK(count < 1000 || (!expectedBoxes.empty() && expectedBoxes.size() < count));
+
+        std::vector<uint32_t> visible;
+        CHECK(culler.Cull(boxes, visible) == expectedBoxes.size());
+        CHECK(visible == expectedBoxes);
+        CHECK(culler.Cull(boxes, visible, &jobs, 1000) == expectedBoxes.size());
+        CHECK(visible == expectedBoxes);
+        CHECK(culler.Cull(spheres, visible) == expectedSpheres.size());
+        CHECK(visible == expectedSpheres);
+        CHECK(culler.Cull(spheres, visible, &jobs, 1000) == expectedSpheres.size());
+        CHECK(visible == expectedSpheres);
+    }
+    return TestResult("frustum_culling_test");
+}
@@ -0,0 +1,131 @@
+#ifndef TESTS_GL_STUB_H
+#define TESTS_GL_STUB_H
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+// A stand-in for a GL context, for benchmarks that measure the CPU side of code issuing GL calls. LoadGLStub points
+// every GL function at one that does nothing and returns 0, except that glGen* and glCreate* hand out increasing
+// names, shaders always compile, buffer data is copied once and the calls in GLStubCounters are counted. Several of the stubs are called through
+// function pointers of other signatures, which the x86-64 and AArch64 calling conventions allow in practice; this is
+// for benchmarks, not for anything shipped.
+
+struct GLStubCounters
+{
+    size_t drawCalls = 0;     // glDraw* and glMultiDraw* calls, not glDrawBuffer(s)
+    size_t uniformCalls = 0;  // glUniform* calls
+    size_t uploadedBytes = 0; // data passed to glBufferData and glBufferSubData
+};
+
+inline GLStubCounters& GLStubCount()
+{
+    static GLStubCounters counters;
+    return counters;
+}
+
+inline GLuint APIENTRY GLStubNothing()
+{
+    return 0;
+}
+
+inline GLuint APIENTRY GLStubCreate()
+{
+    static GLuint name = 0;
+    return ++name;
+}
+
+inline void APIENTRY GLStubGen(GLsizei count, GLuint* names)
+{
+    for (GLsizei i = 0; i < count; i++)
+        names[i] = GLStubCreate();
+}
+
+inline const GLubyte* APIENTRY GLStubGetString(GLenum)
+{
+    return reinterpret_cast<const GLubyte*>("3.3.0 stub");
+}
+
+// glad gives up on a context without extensions, so there is one
+inline const GLubyte* APIENTRY GLStubGetStringi(GLenum, GLuint)
+{
+    return reinterpret_cast<const GLubyte*>("GL_STUB_extension");
+}
+
+inline void APIENTRY GLStubGetIntegerv(GLenum name, GLint* value)
+{
+    *value = name == GL_NUM_EXTENSIONS ? 1 : 0;
+}
+
+// compile and link status
+inline void APIENTRY GLStubGetObjectiv(GLuint, GLenum, GLint* value)
+{
+    *value = GL_TRUE;
+}
+
+inline void APIENTRY GLStubDraw()
+{
+    GLStubCount().drawCalls++;
+}
+
+inline void APIENTRY GLStubUniform()
+{
+    GLStubCount().uniformCalls++;
+}
+
+// uploads are copied once, as a driver copies them to staging memory
+inline void GLStubUpload(GLsizeiptr size, const void* data)
+{
+    static std::vector<unsigned char> staging;
+    if (staging.size() < size_t(size))
+        staging.resize(size_t(size));
+    std::memcpy(staging.data(), data, size_t(size));
+    GLStubCount().uploadedBytes += size_t(size);
+}
+
+inline void APIENTRY GLStubBufferData(GLenum, GLsizeiptr size, const void* data, GLenum)
+{
+    if (data)
+        GLStubUpload(size, data);
+}
+
+inline void APIENTRY GLStubBufferSubData(GLenum, GLintptr, GLsizeiptr size, const void* data)
+{
+    GLStubUpload(size, data);
+}
+
+inline void* GLStubLoad(const char* name)
+{
+    const bool prefixed = std::strncmp(name, "gl", 2) == 0;
+    const char* rest = prefixed ? name + 2 : name;
+    if (std::strcmp(rest, "GetString") == 0)
+        return reinterpret_cast<void*>(GLStubGetString);
+    if (std::strcmp(rest, "GetStringi") == 0)
+        return reinterpret_cast<void*>(GLStubGetStringi);
+    if (std::strcmp(rest, "GetIntegerv") == 0)
+        return reinterpret_cast<void*>(GLStubGetIntegerv);
+    if (std::strcmp(rest, "GetShaderiv") == 0 || std::strcmp(rest, "GetProgramiv") == 0)
+        return reinterpret_cast<void*>(GLStubGetObjectiv);
+    if (std::strcmp(rest, "BufferData") == 0)
+        return reinterpret_cast<void*>(GLStubBufferData);
+    if (std::strcmp(rest, "BufferSubData") == 0)
+        return reinterpret_cast<void*>(GLStubBufferSubData);
+    if (std::strncmp(rest, "Gen", 3) == 0 && std::strcmp(rest, "GenerateMipmap") != 0)
+        return reinterpret_cast<void*>(GLStubGen);
+    if (std::strncmp(rest, "Create", 6) == 0)
+        return reinterpret_cast<void*>(GLStubCreate);
+    if ((std::strncmp(rest, "Draw", 4) == 0 && std::strncmp(rest, "DrawBuffer", 10) != 0) || std::strncmp(rest, "MultiDraw", 9) == 0)
+        return reinterpret_cast<void*>(GLStubDraw);
+    if (std::strncmp(rest, "Uniform", 7) == 0)
+        return reinterpret_cast<void*>(GLStubUniform);
+    return reinterpret_cast<void*>(GLStubNothing);
+}
+
+inline bool LoadGLStub()
+{
+    return gladLoadGLLoader(reinterpret_cast<GLADloadproc>(GLStubLoad)) != 0;
+}
+
+#endif
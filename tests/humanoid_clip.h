@@ -0,0 +1,122 @@
+#ifndef TESTS_HUMANOID_CLIP_H
+#define TESTS_HUMANOID_CLIP_H
+
+#include <glad/glad.h>
+#include <learnopengl/animation.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// An animation clip built in memory for the animation benchmarks, with the skeleton of a typical humanoid rig: an
+// armature node over 65 bones (hips, spine, neck and head, two arms with five three-jointed fingers, two legs). Every
+// bone is animated with random keys at 30 keys per second, the armature node isn't.
+
+struct HumanoidNode
+{
+    std::string name;
+    int parent;
+};
+
+inline int AddHumanoidNode(std::vector<HumanoidNode>& nodes, const std::string& name, int parent)
+{
+    nodes.push_back(HumanoidNode{ name, parent });
+    return static_cast<int>(nodes.size()) - 1;
+}
+
+inline std::vector<HumanoidNode> MakeHumanoidSkeleton()
+{
+    std::vector<HumanoidNode> nodes;
+    const int armature = AddHumanoidNode(nodes, "Armature", -1);
+    const int hips = AddHumanoidNode(nodes, "Hips", armature);
+    int spine = hips;
+    for (const char* name : { "Spine", "Spine1", "Spine2" })
+        spine = AddHumanoidNode(nodes, name, spine);
+    const int neck = AddHumanoidNode(nodes, "Neck", spine);
+    const int head = AddHumanoidNode(nodes, "Head", neck);
+    AddHumanoidNode(nodes, "HeadTop_End", head);
+    for (const char* side : { "Left", "Right" })
+    {
+        int arm = spine;
+        for (const char* name : { "Shoulder", "Arm", "ForeArm", "Hand" })
+            arm = AddHumanoidNode(nodes, std::string(side) + name, arm);
+        for (const char* finger : { "Thumb", "Index", "Middle", "Ring", "Pinky" })
+        {
+            int joint = arm;
+            for (int i = 1; i <= 4; i++)
+                joint = AddHumanoidNode(nodes, std::string(side) + "Hand" + finger + std::to_string(i), joint);
+        }
+        int leg = hips;
+        for (const char* name : { "UpLeg", "Leg", "Foot", "ToeBase", "Toe_End" })
+            leg = AddHumanoidNode(nodes, std::string(side) + name, leg);
+    }
+    return nodes;
+}
+
+// seconds long, with its own random keys for every seed
+inline std::unique_ptr<Animation> MakeHumanoidClip(unsigned int seed, float seconds = 2.0f)
+{
+    const std::vector<HumanoidNode> skeleton = MakeHumanoidSkeleton();
+    const int nodeCount = static_cast<int>(skeleton.size());
+    const int keysPerSecond = 30;
+    const int keyCount = static_cast<int>(seconds * keysPerSecond) + 1;
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+
+    std::vector<aiNode*> nodes;
+    std::map<std::string, BoneInfo> boneInfoMap;
+    for (int i = 0; i < nodeCount; i++)
+    {
+        aiNode* node = new aiNode(skeleton[i].name);
+        node->mTransformation = aiMatrix4x4(aiVector3D(1.0f), aiQuaternion(1.0f, 0.0f, 0.0f, 0.0f), aiVector3D(0.0f, 0.1f, 0.0f));
+        nodes.push_back(node);
+        if (i > 0)
+            boneInfoMap[skeleton[i].name] = BoneInfo{ i - 1, glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -0.1f * i, 0.0f)) };
+    }
+    for (int i = 0; i < nodeCount; i++)
+    {
+        std::vector<aiNode*> children;
+        for (int c = 0; c < nodeCount; c++)
+            if (skeleton[c].parent == i)
+                children.push_back(nodes[c]);
+        nodes[i]->mNumChildren = static_cast<unsigned int>(children.size());
+        nodes[i]->mChildren = children.empty() ? nullptr : new aiNode*[children.size()];
+        for (size_t c = 0; c < children.size(); c++)
+        {
+            nodes[i]->mChildren[c] = children[c];
+            children[c]->mParent = nodes[i];
+        }
+    }
+
+    aiAnimation animation;
+    animation.mDuration = keyCount - 1;
+    animation.mTicksPerSecond = keysPerSecond;
+    animation.mNumChannels = nodeCount - 1;
+    animation.mChannels = new aiNodeAnim*[nodeCount - 1];
+    for (int i = 1; i < nodeCount; i++)
+    {
+        aiNodeAnim* channel = new aiNodeAnim();
+        channel->mNodeName = aiString(skeleton[i].name);
+        channel->mNumPositionKeys = channel->mNumRotationKeys = channel->mNumScalingKeys = keyCount;
+        channel->mPositionKeys = new aiVectorKey[keyCount];
+        channel->mRotationKeys = new aiQuatKey[keyCount];
+        channel->mScalingKeys = new aiVectorKey[keyCount];
+        for (int k = 0; k < keyCount; k++)
+        {
+            channel->mPositionKeys[k] = aiVectorKey(k, aiVector3D(0.1f * value(rng), 0.1f + 0.01f * value(rng), 0.1f * value(rng)));
+            const glm::quat q = glm::normalize(glm::quat(4.0f, value(rng), value(rng), value(rng)));
+            channel->mRotationKeys[k] = aiQuatKey(k, aiQuaternion(q.w, q.x, q.y, q.z));
+            channel->mScalingKeys[k] = aiVectorKey(k, aiVector3D(1.0f));
+        }
+        animation.mChannels[i - 1] = channel;
+    }
+
+    std::unique_ptr<Animation> clip(new Animation(nodes[0], &animation, boneInfoMap));
+    delete nodes[0];
+    return clip;
+}
+
+#endif
@@ -0,0 +1,129 @@
+#include <learnopengl/index_buffer.h>
+
+#include "test.h"
+
+#include <random>
+#include <vector>
+
+// SplitIndexBuffer has to reproduce the source triangles exactly (Expand), with every 16 bit range inside 65536
+// vertices of its base vertex, ranges laid out back to back and trailing partial triangles dropped.
+
+static void CheckRanges(const SplitIndexBuffer& buffer, size_t expectedIndices)
+{
+    const size_t storedIndices = buffer.type == GL_UNSIGNED_SHORT ? buffer.indices.size() : buffer.wideIndices.size();
+    CHECK(storedIndices == expectedIndices);
+    unsigned int next = 0;
+    for (const IndexRange& range : buffer.ranges)
+    {
+        CHECK(range.firstIndex == next);
+        CHECK(range.indexCount > 0 && range.indexCount % 3 == 0);
+        next += range.indexCount;
+    }
+    CHECK(next == expectedIndices);
+}
+
+// triangles walking through vertexCount vertices, each one within spread vertices of its position
+static std::vector<unsigned int> MakeTriangles(std::mt19937& rng, size_t triangleCount, unsigned int vertexCount, unsigned int spread)
+{
+    std::vector<unsigned int> indices;
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        unsigned int base = static_cast<unsigned int>((uint64_t)t * (vertexCount - spread) / triangleCount);
+        for (int corner = 0; corner < 3; corner++)
+            indices.push_back(base + rng() % spread);
+    }
+    return indices;
+}
+
+static void TestSmallMesh()
+{
+    std::mt19937 rng(1);
+    std::vector<unsigned int> source = MakeTriangles(rng, 1000, 5000, 5000);
+    source[0] = 0;
+    SplitIndexBuffer buffer = SplitIndexBuffer::FromTriangles(source.data(), source.size());
+    CHECK(buffer.type == GL_UNSIGNED_SHORT);
+    CHECK(buffer.ranges.size() == 1 && buffer.ranges[0].baseVertex == 0);
+    CHECK(buffer.Expand() == source);
+    CheckRanges(buffer, source.size());
+}
+
+static void TestSplit()
+{
+    std::mt19937 rng(2);
+    std::vector<unsigned int> source = MakeTriangles(rng, 200000, 1000000, 300);
+    SplitIndexBuffer buffer = SplitIndexBuffer::FromTriangles(source.data(), source.size());
+    CHECK(buffer.type == GL_UNSIGNED_SHORT);
+    CHECK(buffer.ranges.size() > 1);
+    CHECK(buffer.Expand() == source);
+    CheckRanges(buffer, source.size());
+    for (const IndexRange& range : buffer.ranges)
+        for (unsigned int i = 0; i < range.indexCount; i++)
+            CHECK(source[range.firstIndex + i] - range.baseVertex < INDEX_BUFFER_MAX_RANGE_VERTICES);
+}
+
+static void TestWide()
+{
+    // one triangle spans more than 65536 vertices, the whole mesh keeps 32 bit indices
+    std::vector<unsigned int> source = { 0, 1, 2, 3, 4, 100000 };
+    SplitIndexBuffer buffer = SplitIndexBuffer::FromTriangles(source.data(), source.size());
+    CHECK(buffer.type == GL_UNSIGNED_INT);
+    CHECK(buffer.indices.empty());
+    CHECK(buffer.Expand() == source);
+    CheckRanges(buffer, source.size());
+}
+
+static void TestPartialTriangles()
+{
+    std::vector<unsigned int> source = { 0, 1, 2, 2, 1, 3, 4, 5 };
+    SplitIndexBuffer buffer = SplitIndexBuffer::FromTriangles(source.data(), source.size());
+    CHECK(buffer.Expand() == std::vector<unsigned int>(source.begin(), source.begin() + 6));
+    CheckRanges(buffer, 6);
+
+    // the same on the 32 bit path
+    std::vector<unsigned int> wide = { 0, 1, 200000, 7 };
+    buffer = SplitIndexBuffer::FromTriangles(wide.data(), wide.size());
+    CHECK(buffer.Expand() == std::vector<unsigned int>(wide.begin(), wide.begin() + 3));
+    CheckRanges(buffer, 3);
+
+    // nothing left, no ranges to draw
+    for (size_t count = 0; count < 3; count++)
+    {
+        buffer = SplitIndexBuffer::FromTriangles(source.data(), count);
+        CHECK(buffer.ranges.empty());
+        CHECK(buffer.Size() == 0);
+    }
+}
+
+static void TestLists()
+{
+    std::mt19937 rng(3);
+    std::vector<unsigned int> lod0 = MakeTriangles(rng, 30000, 200000, 200);
+    std::vector<unsigned int> lod1 = MakeTriangles(rng, 5000, 200000, 2000);
+    std::vector<unsigned int> empty;
+    std::vector<unsigned int> partial = { 5, 6 };
+    std::vector<const std::vector<unsigned int>*> lists = { &lod0, &empty, &lod1, &partial };
+    std::vector<std::vector<IndexRange>> listRanges;
+    SplitIndexBuffer buffer = SplitIndexBuffer::FromTriangleLists(lists, listRanges);
+    CHECK(listRanges.size() == lists.size());
+    CHECK(listRanges[1].empty() && listRanges[3].empty());
+    CheckRanges(buffer, lod0.size() + lod1.size());
+
+    // every list reads back from its own ranges
+    for (size_t l = 0; l < lists.size(); l++)
+    {
+        SplitIndexBuffer part = buffer;
+        part.ranges = listRanges[l];
+        std::vector<unsigned int> expected(lists[l]->begin(), lists[l]->end() - lists[l]->size() % 3);
+        CHECK(part.Expand() == expected);
+    }
+}
+
+int main()
+{
+    TestSmallMesh();
+    TestSplit();
+    TestWide();
+    TestPartialTriangles();
+    TestLists();
+    return TestResult("index_buffer_test");
+}
@@ -0,0 +1,152 @@
+#include <glad/glad.h>
+#include <learnopengl/camera.h>
+#include <learnopengl/filesystem.h>
+#include <learnopengl/model.h>
+#include <learnopengl/frustum_culling.h>
+
+#include "benchmark.h"
+#include "gl_stub.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <random>
+#include <vector>
+
+// CPU cost of drawing 100k rocks in a ring around a planet, as the asteroid field demos do, on a GL stub: a
+// setMat4("model") and Mesh::Draw per rock against InstanceBufferBuilder, InstanceBuffer::Upload and one
+// Mesh::DrawInstanced. Both draw the visible set FrustumCuller leaves of the whole ring, once with every rock in view
+// and once from a camera inside the ring.
+
+struct FrameCost
+{
+    double seconds = 0.0;
+    GLStubCounters counters;
+};
+
+// best of runs frames, with the GL calls counted over one of them
+template<typename TFrame>
+static FrameCost MeasureFrame(int runs, TFrame frame)
+{
+    FrameCost cost;
+    cost.seconds = BestOf(runs, frame);
+    GLStubCount() = GLStubCounters();
+    frame();
+    cost.counters = GLStubCount();
+    return cost;
+}
+
+static void ReportFrame(const std::string& name, const FrameCost& cost)
+{
+    Report(name, cost.seconds * 1000.0, "ms");
+    Report(name + ", draw calls", double(cost.counters.drawCalls), "");
+    Report(name + ", uniform calls", double(cost.counters.uniformCalls), "");
+    Report(name + ", uploaded", cost.counters.uploadedBytes / 1024.0, "KiB");
+}
+
+// a unit cube with a vertex per face corner
+static Mesh MakeRock()
+{
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+    for (int axis = 0; axis < 3; axis++)
+        for (float side : { -1.0f, 1.0f })
+        {
+            glm::vec3 normal(0.0f), u(0.0f), v(0.0f);
+            normal[axis] = side;
+            u[(axis + 1) % 3] = 1.0f;
+            v[(axis + 2) % 3] = side;
+            const unsigned int first = static_cast<unsigned int>(vertices.size());
+            for (int corner = 0; corner < 4; corner++)
+            {
+                Vertex vertex = {};
+                vertex.Position = 0.5f * (normal + (corner & 1 ? u : -u) + (corner & 2 ? v : -v));
+                vertex.Normal = normal;
+                vertex.TexCoords = glm::vec2(corner & 1, corner >> 1);
+                vertices.push_back(vertex);
+            }
+            indices.insert(indices.end(), { first, first + 1, first + 3, first, first + 3, first + 2 });
+        }
+    Texture texture = { 1, "texture_diffuse", "rock.png", TextureHandle() };
+    return Mesh(vertices, indices, { texture }, VertexLayout(VERTEX_ATTRIBUTES_STATIC));
+}
+
+// what Model::DrawInstanced does for each of its meshes
+static void DrawInstanced(Mesh& mesh, Shader& shader, const InstanceBuffer& instanceBuffer, size_t instanceCount)
+{
+    if (mesh.instanceBufferGeneration != instanceBuffer.Generation())
+    {
+        instanceBuffer.AttachTo(mesh.VAO);
+        mesh.instanceBufferGeneration = instanceBuffer.Generation();
+    }
+    mesh.DrawInstanced(shader, static_cast<unsigned int>(instanceCount));
+}
+
+int main()
+{
+    if (!LoadGLStub())
+        return 1;
+    Shader shader(FileSystem::getPath("src/2_Terrain_Plane/LightSphere.vs").c_str(), FileSystem::getPath("src/2_Terrain_Plane/LightSphere.fs").c_str());
+    Mesh rock = MakeRock();
+
+    const size_t rockCount = 100000;
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> offset(-25.0f, 25.0f), scale(0.05f, 0.25f), angle(0.0f, 360.0f);
+    std::vector<glm::mat4> transforms;
+    PackedSpheres bounds;
+    for (size_t i = 0; i < rockCount; i++)
+    {
+        const float around = 360.0f * i / rockCount;
+        const glm::vec3 position(std::sin(glm::radians(around)) * 150.0f + offset(rng), offset(rng) * 0.4f, std::cos(glm::radians(around)) * 150.0f + offset(rng));
+        const float size = scale(rng);
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), position);
+        model = glm::scale(model, glm::vec3(size));
+        model = glm::rotate(model, glm::radians(angle(rng)), glm::vec3(0.4f, 0.6f, 0.8f));
+        transforms.push_back(model);
+        bounds.Add(position, size * 0.8660254f);
+    }
+
+    const Camera views[] = {
+        Camera(glm::vec3(0.0f, 500.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), -90.0f, -89.0f),
+        Camera(glm::vec3(0.0f, 5.0f, 150.0f), glm::vec3(0.0f, 1.0f, 0.0f), -180.0f, 0.0f),
+    };
+    const char* viewNames[] = { "the whole ring in view", "camera inside the ring" };
+    InstanceBuffer instanceBuffer;
+    InstanceBufferBuilder builder;
+    builder.Reserve(rockCount);
+    std::vector<uint32_t> visible;
+    for (int view = 0; view < 2; view++)
+    {
+        const FrustumCuller culler(createFrustumFromCamera(views[view], 16.0f / 9.0f, glm::radians(45.0f), 0.1f, 1000.0f));
+        const double cullSeconds = BestOf(10, [&] { culler.Cull(bounds, visible); });
+        Section(std::string(viewNames[view]) + ", " + std::to_string(visible.size()) + " of " + std::to_string(rockCount) + " rocks visible");
+        Report("cull", cullSeconds * 1000.0, "ms");
+
+        // what drawSelfAndChild does for every entity
+        ReportFrame("one draw per rock", MeasureFrame(5, [&] {
+            for (uint32_t index : visible)
+            {
+                shader.setMat4("model", transforms[index]);
+                rock.Draw(shader);
+            }
+        }));
+
+        const double buildSeconds = BestOf(10, [&] {
+            builder.Clear();
+            for (uint32_t index : visible)
+                builder.Add(transforms[index]);
+        });
+        const double uploadSeconds = BestOf(10, [&] { builder.Upload(instanceBuffer); });
+        const double submitSeconds = BestOf(10, [&] { DrawInstanced(rock, shader, instanceBuffer, builder.Size()); });
+        ReportFrame("instanced", MeasureFrame(10, [&] {
+            builder.Clear();
+            for (uint32_t index : visible)
+                builder.Add(transforms[index]);
+            builder.Upload(instanceBuffer);
+            DrawInstanced(rock, shader, instanceBuffer, builder.Size());
+        }));
+        Report("instanced, build", buildSeconds * 1000.0, "ms");
+        Report("instanced, upload", uploadSeconds * 1000.0, "ms");
+        Report("instanced, submit", submitSeconds * 1000.0, "ms");
+    }
+    return 0;
+}
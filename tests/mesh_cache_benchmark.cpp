@@ -0,0 +1,80 @@
+#include <glad/glad.h>
+#include <learnopengl/filesystem.h>
+#include <learnopengl/model.h>
+
+#include "benchmark.h"
+#include "gl_stub.h"
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+// Model load times of the demo models with and without MeshCache, on a GL stub: the Assimp import alone, a cold load
+// that imports and writes the cache, and a warm load that maps the cache, with the default options and with LODs
+// generated. A Model loaded beforehand keeps every texture in the TextureRegistry, so the times are the meshes only.
+// Pass model paths to measure other models; their caches are written next to them as the demos do.
+
+static size_t FileSize(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    return file ? static_cast<size_t>(file.tellg()) : 0;
+}
+
+static void Benchmark(const std::string& path, bool generateLods)
+{
+    const std::string cachePath = MeshCache::GetCachePath(path);
+    ModelLoadOptions options;
+    options.generateLods = generateLods;
+    ModelLoadOptions uncached = options;
+    uncached.useMeshCache = false;
+    const Model textures(path, uncached);
+    size_t vertices = 0, triangles = 0;
+    for (const Mesh& mesh : textures.meshes)
+    {
+        vertices += mesh.vertexCount;
+        triangles += mesh.GetTriangleCount();
+    }
+
+    const int runs = generateLods ? 2 : 5;
+    const double importSeconds = BestOf(runs, [&] { Model model(path, uncached); });
+    const double coldSeconds = BestOf(runs, [&] {
+        std::remove(cachePath.c_str());
+        Model model(path, options);
+    });
+    bool warm = true;
+    const double warmSeconds = BestOf(runs, [&] {
+        Model model(path, options);
+        warm = warm && model.loadedFromCache;
+    });
+
+    Section(path.substr(path.find_last_of('/') + 1) + (generateLods ? ", LODs generated" : "") + ", " + std::to_string(textures.meshes.size()) + " meshes, " +
+        std::to_string(vertices) + " vertices, " + std::to_string(triangles) + " triangles");
+    if (!warm)
+    {
+        std::printf("the cache was not used\n");
+        return;
+    }
+    Report("cache file", FileSize(cachePath) / 1024.0, "KiB");
+    Report("import without cache", importSeconds * 1000.0, "ms");
+    Report("cold load, import and cache write", coldSeconds * 1000.0, "ms");
+    Report("warm load from cache", warmSeconds * 1000.0, "ms");
+    Report("warm over cold", coldSeconds / warmSeconds, "x");
+}
+
+int main(int argc, char** argv)
+{
+    if (!LoadGLStub())
+        return 1;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; i++)
+        paths.push_back(argv[i]);
+    if (paths.empty())
+        for (const char* model : { "rock/rock.obj", "planet/planet.obj", "cyborg/cyborg.obj", "nanosuit/nanosuit.obj", "Plane/plane.obj" })
+            paths.push_back(FileSystem::getPath(std::string("resources/objects/") + model));
+
+    for (const std::string& path : paths)
+        for (bool generateLods : { false, true })
+            Benchmark(path, generateLods);
+    return 0;
+}
@@ -0,0 +1,133 @@
+#include <glad/glad.h>
+#include <learnopengl/mesh_optimizer.h>
+#include <learnopengl/mesh_simplifier.h>
+
+#include "benchmark.h"
+
+#include <cmath>
+#include <vector>
+
+// MeshSimplifier::BuildLodChain with the defaults the model loader uses, on a smooth sphere, a bumpy torus and an open
+// terrain grid: time to build the chain, triangles and error of every level, the index memory the levels add, and the
+// triangles LodSelection draws at a range of distances on a 1080 pixel high viewport at one pixel of error.
+
+static void MakeSphere(int rings, int segments, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+    for (int r = 0; r <= rings; r++)
+        for (int s = 0; s <= segments; s++)
+        {
+            const float theta = 3.1415927f * r / rings, phi = 6.2831853f * s / segments;
+            Vertex vertex = {};
+            vertex.Position = glm::vec3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+            vertex.TexCoords = glm::vec2(float(s) / segments, float(r) / rings);
+            vertices.push_back(vertex);
+        }
+    for (int r = 0; r < rings; r++)
+        for (int s = 0; s < segments; s++)
+        {
+            const unsigned int a = r * (segments + 1) + s, b = a + segments + 1;
+            if (r > 0)
+                indices.insert(indices.end(), { a, a + 1, b });
+            if (r < rings - 1)
+                indices.insert(indices.end(), { a + 1, b + 1, b });
+        }
+}
+
+static void MakeTorus(int rings, int sides, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+    for (int r = 0; r <= rings; r++)
+        for (int s = 0; s <= sides; s++)
+        {
+            const float u = 6.2831853f * r / rings, v = 6.2831853f * s / sides;
+            const float tube = 0.5f + 0.1f * std::sin(7.0f * u) * std::sin(4.0f * v);
+            Vertex vertex = {};
+            vertex.Position = glm::vec3((2.0f + tube * std::cos(v)) * std::cos(u), tube * std::sin(v), (2.0f + tube * std::cos(v)) * std::sin(u));
+            vertex.TexCoords = glm::vec2(float(r) / rings, float(s) / sides);
+            vertices.push_back(vertex);
+        }
+    for (int r = 0; r < rings; r++)
+        for (int s = 0; s < sides; s++)
+        {
+            const unsigned int a = r * (sides + 1) + s, b = a + sides + 1;
+            indices.insert(indices.end(), { a, b, a + 1, a + 1, b, b + 1 });
+        }
+}
+
+// hills over a size x size grid of unit quads
+static void MakeTerrain(int size, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+    for (int z = 0; z <= size; z++)
+        for (int x = 0; x <= size; x++)
+        {
+            Vertex vertex = {};
+            vertex.Position = glm::vec3(float(x), 6.0f * std::sin(x * 0.05f) * std::cos(z * 0.07f) + std::sin(x * 0.3f + z * 0.2f), float(z));
+            vertex.TexCoords = glm::vec2(float(x) / size, float(z) / size);
+            vertices.push_back(vertex);
+        }
+    for (int z = 0; z < size; z++)
+        for (int x = 0; x < size; x++)
+        {
+            const unsigned int a = z * (size + 1) + x, b = a + size + 1;
+            indices.insert(indices.end(), { a, b, a + 1, a + 1, b, b + 1 });
+        }
+}
+
+static void Benchmark(const std::string& name, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+    // as the model loader does, LODs are built from the optimized mesh
+    MeshOptimizer::Optimize(vertices, indices);
+    const size_t triangleCount = indices.size() / 3;
+    Section(name + " (" + std::to_string(triangleCount) + " triangles, " + std::to_string(vertices.size()) + " vertices)");
+
+    std::vector<MeshLod> lods;
+    const double seconds = BestOf(3, [&] { lods = MeshSimplifier::BuildLodChain(&vertices[0].Position.x, vertices.size(), sizeof(Vertex), indices); });
+    Report("build chain", seconds * 1000.0, "ms");
+    Report("build chain", triangleCount / seconds / 1.0e6, "MTriangle/s of level 0");
+
+    glm::vec3 minimum(vertices[0].Position), maximum(vertices[0].Position);
+    for (const Vertex& vertex : vertices)
+    {
+        minimum = glm::min(minimum, vertex.Position);
+        maximum = glm::max(maximum, vertex.Position);
+    }
+    const float extent = glm::length(maximum - minimum);
+    size_t lodIndices = 0;
+    for (size_t level = 0; level < lods.size(); level++)
+    {
+        const std::string prefix = "level " + std::to_string(level + 1) + ", ";
+        Report(prefix + "triangles", double(lods[level].indices.size() / 3), "");
+        Report(prefix + "of level 0", 100.0 * lods[level].indices.size() / indices.size(), "%");
+        Report(prefix + "error of the bounding box diagonal", 100.0 * lods[level].error / extent, "%");
+        lodIndices += lods[level].indices.size();
+    }
+    Report("indices added by the levels", 100.0 * lodIndices / indices.size(), "% of level 0");
+
+    // the mesh scaled so its diagonal is 2 units, like a character or a rock in a scene
+    const float scale = 2.0f / extent;
+    for (float distance : { 2.0f, 10.0f, 50.0f, 250.0f })
+    {
+        const LodSelection selection = LodSelection::FromDistance(distance, scale, glm::radians(45.0f), 1080.0f);
+        const unsigned int level = selection.Select(lods);
+        const size_t drawn = level == 0 ? triangleCount : lods[level - 1].indices.size() / 3;
+        Report("at " + std::to_string(int(distance)) + " units, level " + std::to_string(level) + ", triangles drawn", double(drawn), "");
+    }
+}
+
+int main()
+{
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+    MakeSphere(200, 200, vertices, indices);
+    Benchmark("sphere", vertices, indices);
+
+    vertices.clear();
+    indices.clear();
+    MakeTorus(300, 100, vertices, indices);
+    Benchmark("bumpy torus", vertices, indices);
+
+    vertices.clear();
+    indices.clear();
+    MakeTerrain(256, vertices, indices);
+    Benchmark("terrain grid", vertices, indices);
+    return 0;
+}
@@ -0,0 +1,179 @@
+#include <glad/glad.h>
+#include <learnopengl/mesh_optimizer.h>
+
+#include "benchmark.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+// MeshOptimizer on closed meshes delivered as a shuffled triangle soup, the worst an exporter does: time of every
+// pass, vertex cache efficiency (ACMR and ATVR of the simulated FIFO cache) and overdraw after each of them.
+// Overdraw is measured by rasterizing the triangles in draw order with a depth test from the six axis directions,
+// pixels shaded over pixels covered; 1 is none.
+
+// a torus with bumps on it, seen from the side it occludes itself
+static void MakeMesh(int rings, int sides, float bumps, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+    std::vector<glm::vec3> grid;
+    for (int r = 0; r < rings; r++)
+        for (int s = 0; s < sides; s++)
+        {
+            const float u = 6.2831853f * r / rings, v = 6.2831853f * s / sides;
+            const float tube = 0.5f + bumps * std::sin(5.0f * u) * std::sin(3.0f * v);
+            grid.push_back(glm::vec3((2.0f + tube * std::cos(v)) * std::cos(u), tube * std::sin(v), (2.0f + tube * std::cos(v)) * std::sin(u)));
+        }
+    std::vector<std::array<unsigned int, 3>> triangles;
+    for (int r = 0; r < rings; r++)
+        for (int s = 0; s < sides; s++)
+        {
+            const unsigned int a = r * sides + s, b = ((r + 1) % rings) * sides + s;
+            const unsigned int c = r * sides + (s + 1) % sides, d = ((r + 1) % rings) * sides + (s + 1) % sides;
+            triangles.push_back({ a, c, b });
+            triangles.push_back({ c, d, b });
+        }
+    std::mt19937 rng(1);
+    std::shuffle(triangles.begin(), triangles.end(), rng);
+    // every triangle with its own three vertices, value initialized so welding finds the copies
+    for (const std::array<unsigned int, 3>& triangle : triangles)
+        for (unsigned int corner : triangle)
+        {
+            Vertex vertex = {};
+            vertex.Position = grid[corner];
+            indices.push_back(static_cast<unsigned int>(vertices.size()));
+            vertices.push_back(vertex);
+        }
+}
+
+static double MeasureOverdraw(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices)
+{
+    const int resolution = 256;
+    glm::vec3 minimum(std::numeric_limits<float>::max()), maximum(-std::numeric_limits<float>::max());
+    for (const Vertex& vertex : vertices)
+    {
+        minimum = glm::min(minimum, vertex.Position);
+        maximum = glm::max(maximum, vertex.Position);
+    }
+    const float extent = glm::max(glm::max(maximum.x - minimum.x, maximum.y - minimum.y), maximum.z - minimum.z);
+
+    size_t shaded = 0, covered = 0;
+    std::vector<float> depth(resolution * resolution);
+    for (int axis = 0; axis < 3; axis++)
+        for (float direction : { 1.0f, -1.0f })
+        {
+            // the camera looks along direction * axis, screen x and y are the other two axes
+            const int screenX = (axis + 1) % 3, screenY = (axis + 2) % 3;
+            std::fill(depth.begin(), depth.end(), std::numeric_limits<float>::max());
+            for (size_t i = 0; i + 2 < indices.size(); i += 3)
+            {
+                glm::vec3 p[3];
+                for (int k = 0; k < 3; k++)
+                {
+                    const glm::vec3 position = (vertices[indices[i + k]].Position - minimum) / extent;
+                    p[k] = glm::vec3(position[screenX] * (resolution - 1), position[screenY] * (resolution - 1), direction * position[axis]);
+                }
+                float area = (p[1].x - p[0].x) * (p[2].y - p[0].y) - (p[2].x - p[0].x) * (p[1].y - p[0].y);
+                // back facing seen along -axis flips with the direction, skip those and degenerates
+                if (area * direction >= 0.0f)
+                    continue;
+                const int x0 = std::max(0, int(std::floor(std::min({ p[0].x, p[1].x, p[2].x }))));
+                const int x1 = std::min(resolution - 1, int(std::ceil(std::max({ p[0].x, p[1].x, p[2].x }))));
+                const int y0 = std::max(0, int(std::floor(std::min({ p[0].y, p[1].y, p[2].y }))));
+                const int y1 = std::min(resolution - 1, int(std::ceil(std::max({ p[0].y, p[1].y, p[2].y }))));
+                for (int y = y0; y <= y1; y++)
+                    for (int x = x0; x <= x1; x++)
+                    {
+                        const float px = x + 0.5f, py = y + 0.5f;
+                        const float w0 = ((p[1].x - px) * (p[2].y - py) - (p[2].x - px) * (p[1].y - py)) / area;
+                        const float w1 = ((p[2].x - px) * (p[0].y - py) - (p[0].x - px) * (p[2].y - py)) / area;
+                        const float w2 = 1.0f - w0 - w1;
+                        if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f)
+                            continue;
+                        const float z = w0 * p[0].z + w1 * p[1].z + w2 * p[2].z;
+                        float& stored = depth[y * resolution + x];
+                        if (z < stored)
+                        {
+                            covered += stored == std::numeric_limits<float>::max();
+                            stored = z;
+                            shaded++;
+                        }
+                    }
+            }
+        }
+    return covered ? double(shaded) / double(covered) : 0.0;
+}
+
+static void ReportOrder(const std::string& name, const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices)
+{
+    const VertexCacheStatistics stats = MeshOptimizer::AnalyzeVertexCache(indices.data(), indices.size(), vertices.size());
+    Report(name + ", ACMR", stats.ACMR(), "");
+    Report(name + ", ATVR", stats.ATVR(), "");
+    Report(name + ", overdraw", MeasureOverdraw(vertices, indices), "");
+}
+
+static void Benchmark(const std::string& name, int rings, int sides, float bumps)
+{
+    std::vector<Vertex> soup;
+    std::vector<unsigned int> soupIndices;
+    MakeMesh(rings, sides, bumps, soup, soupIndices);
+    const size_t triangleCount = soupIndices.size() / 3;
+    Section(name + " (" + std::to_string(triangleCount) + " triangles, " + std::to_string(soup.size()) + " vertices as a soup)");
+
+    // every pass on a fresh copy of the previous pass's output, so each is timed on its real input
+    std::vector<Vertex> vertices = soup;
+    std::vector<unsigned int> indices = soupIndices;
+    size_t welded = 0;
+    const double weldSeconds = BestOf(3, [&] {
+        vertices = soup;
+        indices = soupIndices;
+        welded = MeshOptimizer::WeldVertices(vertices, indices);
+    });
+    Report("weld, vertices removed", double(welded), "");
+    ReportOrder("welded", vertices, indices);
+
+    const std::vector<unsigned int> weldedIndices = indices;
+    const double cacheSeconds = BestOf(3, [&] {
+        indices = weldedIndices;
+        MeshOptimizer::OptimizeVertexCache(indices, vertices.size());
+    });
+    ReportOrder("vertex cache order", vertices, indices);
+
+    const std::vector<unsigned int> cacheIndices = indices;
+    const double overdrawSeconds = BestOf(3, [&] {
+        indices = cacheIndices;
+        MeshOptimizer::OptimizeOverdraw(indices, vertices);
+    });
+    ReportOrder("overdraw order", vertices, indices);
+
+    const std::vector<Vertex> overdrawVertices = vertices;
+    const std::vector<unsigned int> overdrawIndices = indices;
+    const double fetchSeconds = BestOf(3, [&] {
+        vertices = overdrawVertices;
+        indices = overdrawIndices;
+        MeshOptimizer::OptimizeVertexFetch(vertices, indices);
+    });
+
+    std::vector<Vertex> optimized;
+    std::vector<unsigned int> optimizedIndices;
+    const double optimizeSeconds = BestOf(3, [&] {
+        optimized = soup;
+        optimizedIndices = soupIndices;
+        MeshOptimizer::Optimize(optimized, optimizedIndices);
+    });
+    Report("weld", weldSeconds * 1000.0, "ms");
+    Report("vertex cache", cacheSeconds * 1000.0, "ms");
+    Report("overdraw", overdrawSeconds * 1000.0, "ms");
+    Report("vertex fetch", fetchSeconds * 1000.0, "ms");
+    Report("Optimize, every pass", optimizeSeconds * 1000.0, "ms");
+    Report("Optimize, every pass", triangleCount / optimizeSeconds / 1.0e6, "MTriangle/s");
+}
+
+int main()
+{
+    Benchmark("smooth torus", 200, 50, 0.0f);
+    Benchmark("bumpy torus", 400, 100, 0.3f);
+    return 0;
+}
@@ -0,0 +1,211 @@
+#include <learnopengl/mesh_optimizer.h>
+#include <learnopengl/mesh_simplifier.h>
+
+#include "test.h"
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+// MeshSimplifier LODs have to index the original vertex buffer with whole triangles, shrink level by level with a
+// growing error, and keep the border of open meshes in place. A triangle soup pointed at one copy of every vertex
+// has to simplify like the welded mesh. On smooth meshes a LOD's error has to cover the distance measured between the
+// LOD and the full detail surface, both ways.
+
+static void MakeTorus(int rings, int sides, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+    for (int r = 0; r <= rings; r++)
+        for (int s = 0; s <= sides; s++)
+        {
+            // the last ring and side repeat the first ones with other texture coordinates, a UV seam
+            float u = 6.2831853f * (r % rings) / rings, v = 6.2831853f * (s % sides) / sides;
+            Vertex vertex = {};
+            vertex.Position = glm::vec3((2.0f + 0.5f * std::cos(v)) * std::cos(u), 0.5f * std::sin(v), (2.0f + 0.5f * std::cos(v)) * std::sin(u));
+            vertex.TexCoords = glm::vec2(float(r) / rings, float(s) / sides);
+            vertices.push_back(vertex);
+        }
+    for (int r = 0; r < rings; r++)
+        for (int s = 0; s < sides; s++)
+        {
+            unsigned int a = r * (sides + 1) + s, b = a + sides + 1;
+            indices.insert(indices.end(), { a, b, a + 1, a + 1, b, b + 1 });
+        }
+}
+
+// a bumpy open grid of size x size quads
+static void MakeGrid(int size, std::vector<glm::vec3>& positions, std::vector<unsigned int>& indices)
+{
+    for (int z = 0; z <= size; z++)
+        for (int x = 0; x <= size; x++)
+            positions.push_back(glm::vec3(x, 0.3f * std::sin(x * 0.4f) * std::cos(z * 0.3f), z));
+    for (int z = 0; z < size; z++)
+        for (int x = 0; x < size; x++)
+        {
+            unsigned int a = z * (size + 1) + x, b = a + size + 1;
+            indices.insert(indices.end(), { a, b, a + 1, a + 1, b, b + 1 });
+        }
+}
+
+static glm::vec3 ClosestPointOnTriangle(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+{
+    const glm::vec3 ab = b - a, ac = c - a, ap = p - a;
+    const float d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+    if (d1 <= 0.0f && d2 <= 0.0f)
+        return a;
+    const glm::vec3 bp = p - b;
+    const float d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+    if (d3 >= 0.0f && d4 <= d3)
+        return b;
+    const float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+        return a + ab * (d1 / (d1 - d3));
+    const glm::vec3 cp = p - c;
+    const float d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+    if (d6 >= 0.0f && d5 <= d6)
+        return c;
+    const float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+        return a + ac * (d2 / (d2 - d6));
+    const float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f)
+        return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+    const float denominator = 1.0f / (va + vb + vc);
+    return a + ab * (vb * denominator) + ac * (vc * denominator);
+}
+
+// largest distance from points spread over the triangles of from to the surface of to
+template<typename TPosition>
+static float SurfaceDistance(const TPosition& position, const std::vector<unsigned int>& from, const std::vector<unsigned int>& to)
+{
+    const int steps = 3;
+    float largest = 0.0f;
+    for (size_t i = 0; i < from.size(); i += 3)
+    {
+        const glm::vec3 a = position(from[i]), b = position(from[i + 1]), c = position(from[i + 2]);
+        for (int u = 0; u <= steps; u++)
+            for (int v = 0; u + v <= steps; v++)
+            {
+                const glm::vec3 p = a + (b - a) * (float(u) / steps) + (c - a) * (float(v) / steps);
+                float nearest = std::numeric_limits<float>::max();
+                for (size_t j = 0; j < to.size(); j += 3)
+                    nearest = std::min(nearest, glm::length(p - ClosestPointOnTriangle(p, position(to[j]), position(to[j + 1]), position(to[j + 2]))));
+                largest = std::max(largest, nearest);
+            }
+    }
+    return largest;
+}
+
+template<typename TPosition>
+static void CheckErrors(const TPosition& position, const std::vector<unsigned int>& indices, const std::vector<MeshLod>& lods)
+{
+    for (const MeshLod& lod : lods)
+    {
+        CHECK(SurfaceDistance(position, lod.indices, indices) <= lod.error);
+        CHECK(SurfaceDistance(position, indices, lod.indices) <= lod.error);
+    }
+}
+
+static void CheckChain(const std::vector<MeshLod>& lods, size_t vertexCount, size_t indexCount)
+{
+    size_t previous = indexCount;
+    float previousError = 0.0f;
+    for (const MeshLod& lod : lods)
+    {
+        CHECK(!lod.indices.empty() && lod.indices.size() % 3 == 0);
+        CHECK(lod.indices.size() < previous);
+        CHECK(lod.error >= previousError);
+        bool inRange = true;
+        for (unsigned int index : lod.indices)
+            inRange = inRange && index < vertexCount;
+        CHECK(inRange);
+        previous = lod.indices.size();
+        previousError = lod.error;
+    }
+}
+
+static void TestTorus()
+{
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+    MakeTorus(64, 32, vertices, indices);
+    std::vector<MeshLod> lods = MeshSimplifier::BuildLodChain(&vertices[0].Position.x, vertices.size(), sizeof(Vertex), indices);
+    CHECK(lods.size() >= 2);
+    CheckChain(lods, vertices.size(), indices.size());
+
+    // the same torus as a soup, three vertices per triangle, with the indices pointed at the first copies
+    std::vector<Vertex> soup;
+    std::vector<unsigned int> soupIndices;
+    for (unsigned int index : indices)
+    {
+        soupIndices.push_back(static_cast<unsigned int>(soup.size()));
+        soup.push_back(vertices[index]);
+    }
+    CHECK(MeshSimplifier::BuildLodChain(&soup[0].Position.x, soup.size(), sizeof(Vertex), soupIndices).empty());
+
+    const std::vector<unsigned int> first = MeshOptimizer::FindDuplicateVertices(soup);
+    for (unsigned int& index : soupIndices)
+        index = first[index];
+    std::vector<MeshLod> soupLods = MeshSimplifier::BuildLodChain(&soup[0].Position.x, soup.size(), sizeof(Vertex), soupIndices);
+    CHECK(soupLods.size() == lods.size());
+    CheckChain(soupLods, soup.size(), soupIndices.size());
+    for (size_t i = 0; i < lods.size() && i < soupLods.size(); i++)
+        CHECK(soupLods[i].indices.size() == lods[i].indices.size());
+
+    // welding gives the vertex count of the indexed torus back
+    std::vector<unsigned int> weldedIndices(indices.size());
+    for (size_t i = 0; i < indices.size(); i++)
+        weldedIndices[i] = static_cast<unsigned int>(i);
+    std::vector<Vertex> welded = soup;
+    CHECK(MeshOptimizer::WeldVertices(welded, weldedIndices) == soup.size() - vertices.size());
+    CHECK(welded.size() == vertices.size());
+}
+
+static void TestOpenGrid()
+{
+    // the border vertices of an open grid must survive in every level
+    const int size = 40;
+    std::vector<glm::vec3> positions;
+    std::vector<unsigned int> indices;
+    MakeGrid(size, positions, indices);
+
+    std::vector<MeshLod> lods = MeshSimplifier::BuildLodChain(&positions[0].x, positions.size(), sizeof(glm::vec3), indices);
+    CHECK(!lods.empty());
+    CheckChain(lods, positions.size(), indices.size());
+    for (const MeshLod& lod : lods)
+    {
+        std::vector<char> used(positions.size(), 0);
+        for (unsigned int index : lod.indices)
+            used[index] = 1;
+        int missingCorners = !used[0] + !used[size] + !used[size * (size + 1)] + !used[positions.size() - 1];
+        CHECK(missingCorners == 0);
+    }
+
+    // too few indices for a triangle, nothing to build
+    CHECK(MeshSimplifier::BuildLodChain(&positions[0].x, positions.size(), sizeof(glm::vec3), std::vector<unsigned int>{ 0, 1 }).empty());
+}
+
+static void TestErrors()
+{
+    // small meshes, the distances are measured by brute force
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+    MakeTorus(24, 12, vertices, indices);
+    std::vector<MeshLod> lods = MeshSimplifier::BuildLodChain(&vertices[0].Position.x, vertices.size(), sizeof(Vertex), indices);
+    CHECK(!lods.empty());
+    CheckErrors([&](unsigned int i) { return vertices[i].Position; }, indices, lods);
+
+    std::vector<glm::vec3> positions;
+    indices.clear();
+    MakeGrid(20, positions, indices);
+    lods = MeshSimplifier::BuildLodChain(&positions[0].x, positions.size(), sizeof(glm::vec3), indices);
+    CHECK(lods.size() >= 2);
+    CheckErrors([&](unsigned int i) { return positions[i]; }, indices, lods);
+}
+
+int main()
+{
+    TestTorus();
+    TestOpenGrid();
+    TestErrors();
+    return TestResult("mesh_simplifier_test");
+}
@@ -0,0 +1,99 @@
+#include <glad/glad.h>
+#include <learnopengl/camera.h>
+#include <learnopengl/model.h>
+#include <learnopengl/entity.h>
+#include <learnopengl/mesh_optimizer.h>
+#include <learnopengl/meshlet.h>
+
+#include "benchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// MeshletBuilder and MeshletCuller on a sphere of half a million triangles, in the order it was generated and after
+// MeshOptimizer: build throughput, how full the meshlets are, cull throughput and how much of the mesh the frustum
+// and the normal cones remove from a few views, and how many draw ranges the survivors merge into.
+
+static void MakeSphere(int rings, int segments, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+    for (int r = 0; r <= rings; r++)
+        for (int s = 0; s <= segments; s++)
+        {
+            const float theta = 3.1415927f * r / rings, phi = 6.2831853f * s / segments;
+            Vertex vertex = {};
+            vertex.Normal = glm::vec3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+            vertex.Position = vertex.Normal * 10.0f;
+            vertex.TexCoords = glm::vec2(float(s) / segments, float(r) / rings);
+            vertices.push_back(vertex);
+        }
+    for (int r = 0; r < rings; r++)
+        for (int s = 0; s < segments; s++)
+        {
+            const unsigned int a = r * (segments + 1) + s, b = a + segments + 1;
+            // the triangles at the poles are degenerate, leave them out
+            if (r > 0)
+                indices.insert(indices.end(), { a, a + 1, b });
+            if (r < rings - 1)
+                indices.insert(indices.end(), { a + 1, b + 1, b });
+        }
+}
+
+static void Benchmark(const std::string& name, const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices)
+{
+    const size_t triangleCount = indices.size() / 3;
+    Section(name + " (" + std::to_string(triangleCount) + " triangles, " + std::to_string(vertices.size()) + " vertices)");
+
+    const SplitIndexBuffer buffer = SplitIndexBuffer::FromTriangles(indices.data(), indices.size());
+    std::vector<Meshlet> meshlets;
+    const double buildSeconds = BestOf(3, [&] { meshlets = MeshletBuilder::Build(vertices, indices, buffer.ranges); });
+    double meshletVertices = 0.0, coneAngle = 0.0;
+    for (const Meshlet& meshlet : meshlets)
+    {
+        std::vector<unsigned int> unique(indices.begin() + meshlet.firstIndex, indices.begin() + meshlet.firstIndex + meshlet.indexCount);
+        std::sort(unique.begin(), unique.end());
+        meshletVertices += double(std::unique(unique.begin(), unique.end()) - unique.begin());
+        coneAngle += glm::degrees(std::atan2(meshlet.coneSin, meshlet.coneCos));
+    }
+    Report("build", triangleCount / buildSeconds / 1.0e6, "MTriangle/s");
+    Report("meshlets", double(meshlets.size()), "");
+    Report("triangles per meshlet, of " + std::to_string(MESHLET_MAX_TRIANGLES), double(triangleCount) / meshlets.size(), "");
+    Report("vertices per meshlet, of " + std::to_string(MESHLET_MAX_VERTICES), meshletVertices / meshlets.size(), "");
+    Report("normal cone half angle, average", coneAngle / meshlets.size(), "degrees");
+
+    // the sphere has radius 10 around the origin
+    struct View { const char* name; Camera camera; };
+    const View views[] = {
+        { "whole sphere in view", Camera(glm::vec3(0.0f, 0.0f, 40.0f), glm::vec3(0.0f, 1.0f, 0.0f), -90.0f, 0.0f) },
+        { "close up", Camera(glm::vec3(0.0f, 0.0f, 14.0f), glm::vec3(0.0f, 1.0f, 0.0f), -90.0f, 0.0f) },
+        { "grazing the horizon", Camera(glm::vec3(0.0f, 10.5f, 6.0f), glm::vec3(0.0f, 1.0f, 0.0f), -90.0f, -10.0f) },
+    };
+    MeshletDrawList drawList;
+    for (const View& view : views)
+    {
+        const Frustum frustum = createFrustumFromCamera(view.camera, 16.0f / 9.0f, glm::radians(45.0f), 0.1f, 100.0f);
+        const MeshletCullParams params = MeshletCullParams::FromFrustum(frustum, view.camera.Position);
+        MeshletCullStatistics stats;
+        const double cullSeconds = BestOf(10, [&] {
+            drawList.Clear();
+            stats = MeshletCuller::Cull(meshlets, glm::mat4(1.0f), buffer.type, params, drawList);
+        });
+        const std::string prefix = std::string(view.name) + ", ";
+        Report(prefix + "cull", meshlets.size() / cullSeconds / 1.0e6, "MMeshlet/s");
+        Report(prefix + "frustum culled", 100.0 * stats.frustumCulled / stats.meshlets, "% meshlets");
+        Report(prefix + "backface culled", 100.0 * stats.backfaceCulled / stats.meshlets, "% meshlets");
+        Report(prefix + "triangles drawn", 100.0 * stats.visibleTriangles / triangleCount, "%");
+        Report(prefix + "draw ranges", double(drawList.Size()), "");
+    }
+}
+
+int main()
+{
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+    MakeSphere(500, 500, vertices, indices);
+    Benchmark("sphere, rows of quads", vertices, indices);
+    MeshOptimizer::Optimize(vertices, indices);
+    Benchmark("sphere, optimized", vertices, indices);
+    return 0;
+}
@@ -0,0 +1,171 @@
+#include <learnopengl/meshlet.h>
+
+#include "test.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <set>
+#include <vector>
+
+// MeshletBuilder has to cut every 16-bit range of a mesh's index buffer into meshlets of at most MESHLET_MAX_VERTICES
+// vertices and MESHLET_MAX_TRIANGLES triangles that together cover every triangle once, with spheres around their
+// vertices. MeshletCuller has to drop meshlets facing away from the camera or outside the frustum, and the ranges it
+// merges the survivors into have to draw exactly their indices.
+
+struct Point
+{
+    glm::vec3 Position;
+};
+
+// a flat grid in the xz plane facing +y, size x size quads, rows along x
+static void MakeGrid(unsigned int size, std::vector<Point>& vertices, std::vector<unsigned int>& indices)
+{
+    for (unsigned int z = 0; z <= size; z++)
+        for (unsigned int x = 0; x <= size; x++)
+            vertices.push_back(Point{ glm::vec3(float(x), 0.0f, float(z)) });
+    for (unsigned int z = 0; z < size; z++)
+        for (unsigned int x = 0; x < size; x++)
+        {
+            unsigned int a = z * (size + 1) + x, b = a + size + 1;
+            indices.insert(indices.end(), { a, b, a + 1, a + 1, b, b + 1 });
+        }
+}
+
+static MeshletCullParams BoxParams(const glm::vec3& minimum, const glm::vec3& maximum, const glm::vec3& cameraPosition)
+{
+    MeshletCullParams params;
+    params.planes[0] = glm::vec4(1.0f, 0.0f, 0.0f, minimum.x);
+    params.planes[1] = glm::vec4(-1.0f, 0.0f, 0.0f, -maximum.x);
+    params.planes[2] = glm::vec4(0.0f, 1.0f, 0.0f, minimum.y);
+    params.planes[3] = glm::vec4(0.0f, -1.0f, 0.0f, -maximum.y);
+    params.planes[4] = glm::vec4(0.0f, 0.0f, 1.0f, minimum.z);
+    params.planes[5] = glm::vec4(0.0f, 0.0f, -1.0f, -maximum.z);
+    params.cameraPosition = cameraPosition;
+    return params;
+}
+
+static void TestBuild()
+{
+    // more than 65536 vertices, so the index buffer has several ranges
+    std::vector<Point> vertices;
+    std::vector<unsigned int> indices;
+    MakeGrid(300, vertices, indices);
+    const SplitIndexBuffer buffer = SplitIndexBuffer::FromTriangles(indices.data(), indices.size());
+    CHECK(buffer.ranges.size() >= 2);
+    const std::vector<Meshlet> meshlets = MeshletBuilder::Build(vertices, indices, buffer.ranges);
+    CHECK(meshlets.size() >= indices.size() / 3 / MESHLET_MAX_TRIANGLES);
+
+    bool withinLimits = true, withinRange = true, spheresContain = true;
+    std::vector<int> covered(indices.size() / 3, 0);
+    for (const Meshlet& meshlet : meshlets)
+    {
+        std::set<unsigned int> unique(indices.begin() + meshlet.firstIndex, indices.begin() + meshlet.firstIndex + meshlet.indexCount);
+        withinLimits = withinLimits && meshlet.indexCount % 3 == 0 && meshlet.indexCount > 0 &&
+            meshlet.indexCount / 3 <= MESHLET_MAX_TRIANGLES && unique.size() <= MESHLET_MAX_VERTICES;
+
+        bool inOneRange = false;
+        for (const IndexRange& range : buffer.ranges)
+            inOneRange = inOneRange || (meshlet.firstIndex >= range.firstIndex &&
+                meshlet.firstIndex + meshlet.indexCount <= range.firstIndex + range.indexCount && meshlet.baseVertex == range.baseVertex);
+        withinRange = withinRange && inOneRange;
+
+        for (unsigned int index : unique)
+            spheresContain = spheresContain && glm::length(vertices[index].Position - meshlet.center) <= meshlet.radius * 1.0001f;
+        for (unsigned int i = meshlet.firstIndex; i < meshlet.firstIndex + meshlet.indexCount; i += 3)
+            covered[i / 3]++;
+    }
+    CHECK(withinLimits);
+    CHECK(withinRange);
+    CHECK(spheresContain);
+    bool coveredOnce = true;
+    for (int count : covered)
+        coveredOnce = coveredOnce && count == 1;
+    CHECK(coveredOnce);
+
+    // a flat grid has a zero width normal cone around +y
+    CHECK(glm::length(meshlets[0].coneAxis - glm::vec3(0.0f, 1.0f, 0.0f)) < 1e-5f && meshlets[0].coneSin < 1e-3f);
+}
+
+static void TestCulling()
+{
+    std::vector<Point> vertices;
+    std::vector<unsigned int> indices;
+    MakeGrid(4, vertices, indices);
+    const SplitIndexBuffer buffer = SplitIndexBuffer::FromTriangles(indices.data(), indices.size());
+    const std::vector<Meshlet> meshlets = MeshletBuilder::Build(vertices, indices, buffer.ranges);
+    CHECK(meshlets.size() == 1);
+    const glm::vec3 minimum(-10.0f), maximum(10.0f);
+
+    // seen from above it faces the camera, from below it faces away
+    MeshletCullParams params = BoxParams(minimum, maximum, glm::vec3(2.0f, 5.0f, 2.0f));
+    MeshletDrawList drawList;
+    MeshletCullStatistics stats = MeshletCuller::Cull(meshlets, glm::mat4(1.0f), buffer.type, params, drawList);
+    CHECK(stats.backfaceCulled == 0 && stats.visibleTriangles == 32 && drawList.Size() == 1);
+
+    params.cameraPosition = glm::vec3(2.0f, -5.0f, 2.0f);
+    drawList.Clear();
+    stats = MeshletCuller::Cull(meshlets, glm::mat4(1.0f), buffer.type, params, drawList);
+    CHECK(stats.backfaceCulled == 1 && stats.visibleTriangles == 0 && drawList.Size() == 0);
+
+    // the model matrix turns it upside down, now the camera below sees its front
+    drawList.Clear();
+    const glm::mat4 flipped = glm::mat4(glm::vec4(1, 0, 0, 0), glm::vec4(0, -1, 0, 0), glm::vec4(0, 0, -1, 0), glm::vec4(0, 0, 4, 1));
+    stats = MeshletCuller::Cull(meshlets, flipped, buffer.type, params, drawList);
+    CHECK(stats.backfaceCulled == 0 && stats.visibleTriangles == 32);
+
+    // outside the frustum, also when it faces the camera; backface culling switched off doesn't bring it back
+    params = BoxParams(glm::vec3(20.0f), glm::vec3(30.0f), glm::vec3(2.0f, 5.0f, 2.0f));
+    params.backfaceCulling = false;
+    drawList.Clear();
+    stats = MeshletCuller::Cull(meshlets, glm::mat4(1.0f), buffer.type, params, drawList);
+    CHECK(stats.frustumCulled == 1 && drawList.Size() == 0);
+
+    // the same meshlet moved into the frustum by the model matrix
+    drawList.Clear();
+    stats = MeshletCuller::Cull(meshlets, glm::translate(glm::mat4(1.0f), glm::vec3(22.0f, 25.0f, 22.0f)), buffer.type, params, drawList);
+    CHECK(stats.frustumCulled == 0 && drawList.Size() == 1);
+}
+
+static void TestDrawRanges()
+{
+    std::vector<Point> vertices;
+    std::vector<unsigned int> indices;
+    MakeGrid(300, vertices, indices);
+    const SplitIndexBuffer buffer = SplitIndexBuffer::FromTriangles(indices.data(), indices.size());
+    const std::vector<Meshlet> meshlets = MeshletBuilder::Build(vertices, indices, buffer.ranges);
+
+    // a frustum over the first third of the columns, the meshlets of a row that survive are neighbours
+    MeshletCullParams params = BoxParams(glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(100.0f, 1.0f, 300.0f), glm::vec3(50.0f, 10.0f, 150.0f));
+    MeshletDrawList drawList;
+    const MeshletCullStatistics stats = MeshletCuller::Cull(meshlets, glm::mat4(1.0f), buffer.type, params, drawList);
+    CHECK(stats.frustumCulled > 0 && stats.frustumCulled < stats.meshlets);
+    CHECK(drawList.Size() < stats.meshlets - stats.frustumCulled);
+
+    // the indices the draw ranges reference, with their base vertex added, are those of the surviving meshlets
+    std::vector<unsigned int> expected, drawn;
+    for (const Meshlet& meshlet : meshlets)
+    {
+        MeshletDrawList single;
+        if (MeshletCuller::Cull({ meshlet }, glm::mat4(1.0f), buffer.type, params, single).visibleTriangles > 0)
+            expected.insert(expected.end(), indices.begin() + meshlet.firstIndex, indices.begin() + meshlet.firstIndex + meshlet.indexCount);
+    }
+    bool offsetsMatch = true;
+    for (size_t d = 0; d < drawList.Size(); d++)
+    {
+        offsetsMatch = offsetsMatch && drawList.offsets[d] == reinterpret_cast<const void*>(drawList.firstIndices[d] * sizeof(uint16_t));
+        for (GLsizei i = 0; i < drawList.counts[d]; i++)
+            drawn.push_back(drawList.baseVertices[d] + buffer.indices[drawList.firstIndices[d] + i]);
+    }
+    CHECK(buffer.type == GL_UNSIGNED_SHORT);
+    CHECK(offsetsMatch);
+    CHECK(drawn.size() == stats.visibleTriangles * 3);
+    CHECK(drawn == expected);
+}
+
+int main()
+{
+    TestBuild();
+    TestCulling();
+    TestDrawRanges();
+    return TestResult("meshlet_test");
+}
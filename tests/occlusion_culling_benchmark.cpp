@@ -0,0 +1,224 @@
+#include <glad/glad.h>
+#include <learnopengl/camera.h>
+#include <learnopengl/model.h>
+#include <learnopengl/frustum_culling.h>
+#include <learnopengl/occlusion_culling.h>
+
+#include "HeightMap.h"
+#include "Random.h"
+#include "Simulation.h"
+#include "Utilities.h"
+#include "benchmark.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cmath>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+// The terrain culling of 2_Terrain_Plane along a recorded flight: the demo's 2049 x 2049 height map, cut into the same
+// 64 x 64 chunks with the same coarse occluder, seen from the chase camera of a minute of scripted flight at 60 frames
+// per second. Per frame it reports the share of chunks and terrain triangles left after frustum culling and after
+// occlusion culling, and the time the culling takes: the frustum cull, the occluder rasterized on the calling thread
+// and on every hardware thread, and the Hi-Z tests of the chunks the frustum kept. The sun and moon tests are counted
+// too. The flight circles the middle of the map, diving into valleys and climbing out of them.
+
+// HeightMap seeds rand with the time; these replace Random.cpp so every run flies over the same terrain
+void Random::init()
+{
+    srand(1);
+}
+
+float Random::randFloat()
+{
+    return (float)((double)rand() / (double)RAND_MAX);
+}
+
+float Random::randFloat(float range)
+{
+    return (randFloat() * 2.0f * range) - range;
+}
+
+int Random::randint()
+{
+    return rand();
+}
+
+static const unsigned int SCR_WIDTH = 1600;
+static const unsigned int SCR_HEIGHT = 900;
+static const float FRAME_TIME = 1.0f / 60.0f;
+
+// the keys held at time seconds into the flight, the script repeats every 10 s
+static PlaneInput ScriptedInput(float seconds)
+{
+    PlaneInput input;
+    const float t = std::fmod(seconds, 10.0f);
+    if (t >= 3.0f && t < 4.5f)
+        input.yawLeft = true;
+    else if ((t >= 4.5f && t < 4.7f) || (t >= 7.5f && t < 7.7f))
+        input.pitchDown = true;
+    else if (t >= 6.0f && t < 6.4f)
+        input.pitchUp = true;
+    else if (t >= 7.7f && t < 8.2f)
+        input.rollRight = true;
+    else if (t >= 8.2f && t < 8.7f)
+        input.rollLeft = true;
+    return input;
+}
+
+struct CameraFrame
+{
+    glm::vec3 position, front, up;
+    float zoom;
+    glm::vec3 sun, moon;
+};
+
+// the chase camera applySimulationState places behind and above the plane
+static std::vector<CameraFrame> RecordFlight(float startHeight, float seconds)
+{
+    const float camDistanceFromPlane = 50.0f, maxFov = 90.0f, minFov = 60.0f;
+    SimulationSettings settings;
+    SimulationState initialState;
+    initialState.planePosition.y = startHeight;
+    initialState.planeSpeed = settings.defaultPlaneSpeed;
+    Simulation simulation(initialState, settings);
+
+    std::vector<CameraFrame> frames;
+    const size_t frameCount = static_cast<size_t>(seconds / FRAME_TIME + 0.5f);
+    for (size_t i = 0; i < frameCount; i++)
+    {
+        simulation.advance(ScriptedInput(i * FRAME_TIME), FRAME_TIME);
+        const SimulationState state = simulation.getInterpolatedState();
+        const float t = (state.planeSpeed - settings.minPlaneSpeed) / (settings.maxPlaneSpeed - settings.minPlaneSpeed);
+        CameraFrame frame;
+        frame.zoom = (1 - t) * minFov + t * maxFov;
+        frame.up = state.planeUp;
+        frame.position = state.planePosition - state.planeForward * camDistanceFromPlane;
+        frame.front = state.planePosition - frame.position;
+        frame.position += state.planeUp * 10.0f;
+        frame.sun = state.sunPosition;
+        frame.moon = state.moonPosition;
+        frames.push_back(frame);
+    }
+    return frames;
+}
+
+static Camera ToCamera(const CameraFrame& frame)
+{
+    Camera camera(frame.position, frame.up);
+    camera.Zoom = frame.zoom;
+    camera.SetFrontVector(frame.front);
+    return camera;
+}
+
+int main()
+{
+    HeightMap heightMap(2048 + 1);
+    const HeightMapData heightMapData = heightMap.getData();
+    const std::vector<TerrainChunk> chunks = getTerrainChunks(heightMapData.data, heightMapData.width, 64);
+    const OccluderMesh occluder = getOccluderFromHeightMap(heightMapData.data, heightMapData.width, 32);
+
+    // the placement and start height the demo uses
+    const float halfWidth = heightMapData.width / 2.0f;
+    glm::mat4 model = glm::translate(glm::mat4(1.0f), HORIZONTAL_SCALING_FACTOR * glm::vec3(-halfWidth, 0.0f, -halfWidth));
+    model = glm::translate(model, HEIGHT_SCALING_FACTOR * glm::vec3(0.0f, 1.0f, 0.0f));
+    const glm::mat4 inverseModel = glm::inverse(model);
+    float maxHeight = heightMapData.data[0][0];
+    for (unsigned int z = 0; z < heightMapData.width; z++)
+        for (unsigned int x = 0; x < heightMapData.width; x++)
+            maxHeight = std::max(maxHeight, heightMapData.data[z][x]);
+    PackedAABBs chunkBounds;
+    size_t terrainTriangles = 0;
+    for (const TerrainChunk& chunk : chunks)
+    {
+        chunkBounds.AddTransformed(AABB(chunk.min, chunk.max), model);
+        terrainTriangles += 2 * chunk.columns * chunk.rows;
+    }
+
+    const std::vector<CameraFrame> flight = RecordFlight(maxHeight * HEIGHT_SCALING_FACTOR * 0.5f, 60.0f);
+    std::vector<Camera> cameras;
+    std::vector<glm::mat4> viewProjections;
+    for (const CameraFrame& frame : flight)
+    {
+        cameras.push_back(ToCamera(frame));
+        const glm::mat4 projection = glm::perspective(glm::radians(frame.zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 10000.0f);
+        viewProjections.push_back(projection * cameras.back().GetViewMatrix());
+    }
+    const size_t frameCount = flight.size();
+
+    OcclusionCuller culler(256, 128);
+    const unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+    JobSystem jobs(cores);
+    std::vector<uint32_t> visible;
+    auto frustumCull = [&](size_t frame) {
+        const FrustumCuller frustumCuller(createFrustumFromCamera(cameras[frame], (float)SCR_WIDTH / (float)SCR_HEIGHT, glm::radians(flight[frame].zoom), 0.1f, 10000.0f));
+        frustumCuller.Cull(chunkBounds, visible);
+    };
+    // below the coarse terrain the occluder is left out, as the demo does
+    auto rasterize = [&](size_t frame, JobSystem* jobSystem) {
+        culler.BeginFrame(viewProjections[frame]);
+        if (isAboveOccluder(occluder, glm::vec3(inverseModel * glm::vec4(flight[frame].position, 1.0f))))
+            culler.AddOccluder(occluder.positions.data(), occluder.positions.size(), occluder.indices.data(), occluder.indices.size(), model);
+        culler.Rasterize(jobSystem);
+    };
+
+    // what every frame keeps, untimed
+    size_t frustumChunks = 0, occlusionChunks = 0, frustumTriangles = 0, occlusionTriangles = 0, occluderFrames = 0, hiddenSun = 0, hiddenMoon = 0;
+    for (size_t frame = 0; frame < frameCount; frame++)
+    {
+        frustumCull(frame);
+        frustumChunks += visible.size();
+        for (uint32_t chunk : visible)
+            frustumTriangles += 2 * chunks[chunk].columns * chunks[chunk].rows;
+        rasterize(frame, nullptr);
+        occluderFrames += culler.GetTriangleCount() > 0;
+        culler.Cull(chunkBounds, visible);
+        occlusionChunks += visible.size();
+        for (uint32_t chunk : visible)
+            occlusionTriangles += 2 * chunks[chunk].columns * chunks[chunk].rows;
+        hiddenSun += !culler.IsVisible(flight[frame].sun, glm::vec3(100.0f));
+        hiddenMoon += !culler.IsVisible(flight[frame].moon, glm::vec3(50.0f));
+    }
+
+    Section(std::to_string(frameCount) + " frames, " + std::to_string(chunks.size()) + " chunks, " +
+        std::to_string(occluder.indices.size() / 3) + " occluder triangles");
+    Report("frames with the occluder rasterized", 100.0 * occluderFrames / frameCount, "%");
+    Report("chunks in the frustum", 100.0 * frustumChunks / (frameCount * chunks.size()), "%");
+    Report("chunks in the frustum and not occluded", 100.0 * occlusionChunks / (frameCount * chunks.size()), "%");
+    Report("terrain triangles", terrainTriangles / 1000.0, "k");
+    Report("terrain triangles drawn, frustum culled", frustumTriangles / 1000.0 / frameCount, "k/frame");
+    Report("terrain triangles drawn, frustum and occlusion culled", occlusionTriangles / 1000.0 / frameCount, "k/frame");
+    Report("frames with the sun occluded", 100.0 * hiddenSun / frameCount, "%");
+    Report("frames with the moon occluded", 100.0 * hiddenMoon / frameCount, "%");
+
+    const double frustumSeconds = BestOf(3, [&] {
+        for (size_t frame = 0; frame < frameCount; frame++)
+            frustumCull(frame);
+    });
+    const double rasterizeSeconds = BestOf(3, [&] {
+        for (size_t frame = 0; frame < frameCount; frame++)
+            rasterize(frame, nullptr);
+    });
+    const double frameSeconds = BestOf(3, [&] {
+        for (size_t frame = 0; frame < frameCount; frame++)
+        {
+            frustumCull(frame);
+            rasterize(frame, nullptr);
+            culler.Cull(chunkBounds, visible);
+        }
+    });
+    Report("frustum cull", frustumSeconds / frameCount * 1000.0, "ms/frame");
+    Report("occluder rasterized", rasterizeSeconds / frameCount * 1000.0, "ms/frame");
+    Report("Hi-Z tests of the chunks in the frustum", (frameSeconds - frustumSeconds - rasterizeSeconds) / frameCount * 1000.0, "ms/frame");
+    Report("all culling", frameSeconds / frameCount * 1000.0, "ms/frame");
+    if (cores > 1)
+    {
+        const double parallelSeconds = BestOf(3, [&] {
+            for (size_t frame = 0; frame < frameCount; frame++)
+                rasterize(frame, &jobs);
+        });
+        Report("occluder rasterized on " + std::to_string(cores) + " threads", parallelSeconds / frameCount * 1000.0, "ms/frame");
+    }
+    return 0;
+}
@@ -0,0 +1,113 @@
+#include <glad/glad.h>
+#include <learnopengl/camera.h>
+#include <learnopengl/model.h>
+#include <learnopengl/occlusion_culling.h>
+
+#include "Utilities.h"
+#include "test.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cmath>
+#include <vector>
+
+// The terrain occluder of 2_Terrain_Plane has to follow the interpolated surface of its grid and may only be
+// rasterized while the camera is above it: seen from above it hides what lies under the terrain, seen from below its
+// underside would hide the sky, the sun and the moon included.
+
+static const unsigned int WIDTH = 65;
+static const unsigned int STEP = 8;
+
+static glm::mat4 TerrainModel()
+{
+    // the same placement the demo uses
+    const float halfWidth = WIDTH / 2.0f;
+    glm::mat4 model = glm::translate(glm::mat4(1.0f), HORIZONTAL_SCALING_FACTOR * glm::vec3(-halfWidth, 0.0f, -halfWidth));
+    return glm::translate(model, HEIGHT_SCALING_FACTOR * glm::vec3(0.0f, 1.0f, 0.0f));
+}
+
+static glm::vec3 ToWorld(const glm::mat4& model, const glm::vec3& local)
+{
+    return glm::vec3(model * glm::vec4(local, 1.0f));
+}
+
+// rasterizes the occluder as the demo does, unless the camera is below it and it has to be left out
+static void Prepare(OcclusionCuller& culler, const OccluderMesh& occluder, const glm::mat4& model, const glm::vec3& eye, const glm::vec3& target, const glm::vec3& up, bool skipBelow)
+{
+    const glm::mat4 view = glm::lookAt(eye, target, up);
+    const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 2.0f, 0.1f, 1000.0f);
+    culler.BeginFrame(projection * view);
+    if (!skipBelow || isAboveOccluder(occluder, glm::vec3(glm::inverse(model) * glm::vec4(eye, 1.0f))))
+        culler.AddOccluder(occluder.positions.data(), occluder.positions.size(), occluder.indices.data(), occluder.indices.size(), model);
+    culler.Rasterize();
+}
+
+static void TestHeights(const OccluderMesh& occluder)
+{
+    CHECK(occluder.verticesPerSide == (WIDTH - 1) / STEP + 1);
+    CHECK(occluder.positions.size() == occluder.verticesPerSide * occluder.verticesPerSide);
+
+    float height;
+    int mismatches = 0;
+    for (const glm::vec3& position : occluder.positions)
+        mismatches += !getOccluderHeight(occluder, position.x, position.z, height) || std::abs(height - position.y) > 1e-4f;
+    CHECK(mismatches == 0);
+
+    // halfway along an edge and across the diagonal of a cell
+    const unsigned int side = occluder.verticesPerSide;
+    const glm::vec3& p0 = occluder.positions[side + 1];
+    const glm::vec3& p1 = occluder.positions[side + 2];
+    const glm::vec3& p2 = occluder.positions[2 * side + 1];
+    CHECK(getOccluderHeight(occluder, (p0.x + p1.x) * 0.5f, p0.z, height) && std::abs(height - (p0.y + p1.y) * 0.5f) < 1e-4f);
+    CHECK(getOccluderHeight(occluder, (p1.x + p2.x) * 0.5f, (p1.z + p2.z) * 0.5f, height) && std::abs(height - (p1.y + p2.y) * 0.5f) < 1e-4f);
+
+    const glm::vec3& last = occluder.positions.back();
+    CHECK(!getOccluderHeight(occluder, -1.0f, 0.0f, height));
+    CHECK(!getOccluderHeight(occluder, 0.0f, last.z + 1.0f, height));
+}
+
+int main()
+{
+    std::vector<float> heights(WIDTH * WIDTH);
+    std::vector<float*> rows(WIDTH);
+    for (unsigned int z = 0; z < WIDTH; z++)
+    {
+        rows[z] = &heights[z * WIDTH];
+        for (unsigned int x = 0; x < WIDTH; x++)
+            rows[z][x] = 0.5f + 0.2f * std::sin(x * 0.1f) * std::cos(z * 0.1f);
+    }
+    const OccluderMesh occluder = getOccluderFromHeightMap(rows.data(), WIDTH, STEP);
+    TestHeights(occluder);
+
+    const glm::mat4 model = TerrainModel();
+    const float center = (WIDTH - 1) * HORIZONTAL_SCALING_FACTOR * 0.5f;
+    float surface;
+    CHECK(getOccluderHeight(occluder, center, center, surface));
+    const glm::vec3 extents(0.5f);
+    OcclusionCuller culler;
+
+    // from above the terrain hides a box under it and leaves one over it visible
+    const glm::vec3 above = ToWorld(model, glm::vec3(center, surface + 40.0f, center));
+    const glm::vec3 under = ToWorld(model, glm::vec3(center, surface - 3.0f, center));
+    const glm::vec3 over = ToWorld(model, glm::vec3(center, surface + 20.0f, center));
+    CHECK(isAboveOccluder(occluder, glm::vec3(center, surface + 40.0f, center)));
+    Prepare(culler, occluder, model, above, under, glm::vec3(0.0f, 0.0f, -1.0f), true);
+    CHECK(!culler.IsVisible(under, extents));
+    CHECK(culler.IsVisible(over, extents));
+
+    // from below the underside would hide the sky, so the occluder is left out and nothing is culled
+    const glm::vec3 below = ToWorld(model, glm::vec3(center, surface - 5.0f, center));
+    const glm::vec3 sun = ToWorld(model, glm::vec3(center + 10.0f, surface + 200.0f, center));
+    CHECK(!isAboveOccluder(occluder, glm::vec3(center, surface - 5.0f, center)));
+    Prepare(culler, occluder, model, below, over, glm::vec3(0.0f, 0.0f, -1.0f), false);
+    CHECK(!culler.IsVisible(over, extents));
+    Prepare(culler, occluder, model, below, over, glm::vec3(0.0f, 0.0f, -1.0f), true);
+    CHECK(culler.IsVisible(over, extents));
+    CHECK(culler.IsVisible(sun, glm::vec3(5.0f)));
+
+    // beside the terrain the camera has to be above its highest vertex
+    const glm::vec3& last = occluder.positions.back();
+    CHECK(!isAboveOccluder(occluder, glm::vec3(last.x + 10.0f, surface, center)));
+    CHECK(isAboveOccluder(occluder, glm::vec3(last.x + 10.0f, HEIGHT_SCALING_FACTOR + 1.0f, center)));
+    return TestResult("occlusion_culling_test");
+}
@@ -0,0 +1,108 @@
+#include <learnopengl/shader_cache.h>
+
+#include "test.h"
+
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+// The GL free part of ShaderCache: a program key has to change with anything that changes the binary, the stage a
+// piece of source belongs to included, and a cache file may only be read back for its own key and when it arrived
+// whole and unmodified.
+
+static void TestKeys()
+{
+    const std::string vertex = "void main() { gl_Position = vec4(0.0); }";
+    const std::string fragment = "out vec4 color; void main() { color = vec4(1.0); }";
+    const std::string driver = "vendor|renderer|4.6";
+    const uint64_t key = ShaderCache::MakeKey({ { GL_VERTEX_SHADER, vertex }, { GL_FRAGMENT_SHADER, fragment } }, "", driver);
+    CHECK(key == ShaderCache::MakeKey({ { GL_VERTEX_SHADER, vertex }, { GL_FRAGMENT_SHADER, fragment } }, "", driver));
+
+    // the same text split differently between the stages
+    const std::string joined = vertex + fragment;
+    const std::string moved = joined.substr(0, vertex.size() + 4), rest = joined.substr(vertex.size() + 4);
+    CHECK(key != ShaderCache::MakeKey({ { GL_VERTEX_SHADER, moved }, { GL_FRAGMENT_SHADER, rest } }, "", driver));
+    // the same sources as other stages
+    CHECK(key != ShaderCache::MakeKey({ { GL_FRAGMENT_SHADER, vertex }, { GL_VERTEX_SHADER, fragment } }, "", driver));
+    // a define, or the source moved into the defines
+    CHECK(key != ShaderCache::MakeKey({ { GL_VERTEX_SHADER, vertex }, { GL_FRAGMENT_SHADER, fragment } }, "#define SHADOWS\n", driver));
+    const std::string empty;
+    CHECK(key != ShaderCache::MakeKey({ { GL_VERTEX_SHADER, vertex }, { GL_FRAGMENT_SHADER, empty } }, fragment, driver));
+    // another driver
+    CHECK(key != ShaderCache::MakeKey({ { GL_VERTEX_SHADER, vertex }, { GL_FRAGMENT_SHADER, fragment } }, "", "vendor|renderer|4.5"));
+
+    CHECK(ShaderCache::GetFileName(0x0123456789abcdefull) == "0123456789abcdef.glprogram");
+}
+
+static void TestFiles(const std::filesystem::path& directory)
+{
+    ProgramBinary binary;
+    binary.format = 0x8e21;
+    for (int i = 0; i < 1000; i++)
+        binary.data.push_back(static_cast<unsigned char>(i * 7));
+    const uint64_t key = 0x1234abcd5678ef00ull;
+    const std::string path = (directory / ShaderCache::GetFileName(key)).string();
+
+    // round trip, no temporary file left behind
+    CHECK(ShaderCache::Write(path, key, binary));
+    CHECK(!std::filesystem::exists(path + ".tmp"));
+    ProgramBinary read;
+    CHECK(ShaderCache::Read(path, key, read));
+    CHECK(read.format == binary.format && read.data == binary.data);
+
+    // a file of another key, or none at all
+    CHECK(!ShaderCache::Read(path, key + 1, read));
+    CHECK(!ShaderCache::Read((directory / "missing.glprogram").string(), key, read));
+
+    const std::uintmax_t size = std::filesystem::file_size(path);
+
+    // truncated in the binary and in the header
+    std::filesystem::resize_file(path, size - 1);
+    CHECK(!ShaderCache::Read(path, key, read));
+    std::filesystem::resize_file(path, sizeof(ShaderCacheHeader) - 1);
+    CHECK(!ShaderCache::Read(path, key, read));
+
+    // a flipped byte in the binary fails the checksum
+    CHECK(ShaderCache::Write(path, key, binary));
+    {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(sizeof(ShaderCacheHeader) + 500);
+        file.put(static_cast<char>(~binary.data[500]));
+    }
+    CHECK(std::filesystem::file_size(path) == size);
+    CHECK(!ShaderCache::Read(path, key, read));
+
+    // trailing bytes
+    CHECK(ShaderCache::Write(path, key, binary));
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::app);
+        file.put(0);
+    }
+    CHECK(!ShaderCache::Read(path, key, read));
+
+    // another cache version
+    CHECK(ShaderCache::Write(path, key, binary));
+    {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        const uint32_t version = SHADER_CACHE_VERSION + 1;
+        file.seekp(offsetof(ShaderCacheHeader, version));
+        file.write(reinterpret_cast<const char*>(&version), sizeof(version));
+    }
+    CHECK(!ShaderCache::Read(path, key, read));
+
+    // an empty binary is never valid
+    CHECK(ShaderCache::Write(path, key, ProgramBinary()));
+    CHECK(!ShaderCache::Read(path, key, read));
+}
+
+int main()
+{
+    TestKeys();
+
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "shader_cache_test";
+    std::filesystem::create_directories(directory);
+    TestFiles(directory);
+    std::filesystem::remove_all(directory);
+    return TestResult("shader_cache_test");
+}
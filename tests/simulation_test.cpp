@@ -0,0 +1,161 @@
+#include "Simulation.h"
+#include "test.h"
+
+#include <cmath>
+
+// The plane simulation of 2_Terrain_Plane runs in fixed ticks of 1/120 s whatever the frame rate: a scripted flight
+// has to end in the same state whether it is stepped tick by tick or advanced by frames of varying length, a long
+// frame may only run the ticks of MAX_FRAME_TIME, and rendering blends from the previous tick (alpha 0) to the
+// current one (alpha 1).
+
+static const float TICK = 1.0f / 120.0f;
+
+// a short flight, the input changes every 8 ticks
+static PlaneInput ScriptedInput(unsigned int tick)
+{
+    PlaneInput input;
+    switch ((tick / 8) % 6)
+    {
+    case 0: input.accelerate = true; break;
+    case 1: input.pitchUp = true; input.rollRight = true; break;
+    case 2: input.yawLeft = true; break;
+    case 3: input.decelerate = true; input.pitchDown = true; break;
+    case 4: input.rollLeft = true; input.yawRight = true; break;
+    default: break;
+    }
+    return input;
+}
+
+static bool Equal(const glm::vec3& a, const glm::vec3& b, float tolerance = 0.0f)
+{
+    return std::abs(a.x - b.x) <= tolerance && std::abs(a.y - b.y) <= tolerance && std::abs(a.z - b.z) <= tolerance;
+}
+
+static bool Equal(const SimulationState& a, const SimulationState& b, float tolerance = 0.0f)
+{
+    return std::abs(a.time - b.time) <= tolerance && std::abs(a.planeSpeed - b.planeSpeed) <= tolerance &&
+        std::abs(a.sunStrength - b.sunStrength) <= tolerance &&
+        Equal(a.planePosition, b.planePosition, tolerance) && Equal(a.planeForward, b.planeForward, tolerance) &&
+        Equal(a.planeUp, b.planeUp, tolerance) && Equal(a.planeRight, b.planeRight, tolerance) &&
+        Equal(a.sunPosition, b.sunPosition, tolerance) && Equal(a.moonPosition, b.moonPosition, tolerance) &&
+        Equal(a.seaPosition, b.seaPosition, tolerance);
+}
+
+static void TestDeterminism()
+{
+    const unsigned int ticks = 480;
+    Simulation stepped((SimulationState()));
+    for (unsigned int tick = 0; tick < ticks; tick++)
+        stepped.step(ScriptedInput(tick));
+    CHECK(std::abs(stepped.getCurrentState().time - ticks * TICK) < 1e-3f);
+
+    // 120 and 60 frames per second, one and two ticks a frame; the input stays the same within a frame
+    for (unsigned int ticksPerFrame = 1; ticksPerFrame <= 2; ticksPerFrame++)
+    {
+        Simulation advanced((SimulationState()));
+        unsigned int ran = 0;
+        bool evenFrames = true;
+        while (ran < ticks)
+        {
+            const unsigned int frameTicks = advanced.advance(ScriptedInput(ran), ticksPerFrame * TICK);
+            evenFrames = evenFrames && frameTicks == ticksPerFrame;
+            ran += frameTicks;
+        }
+        CHECK(evenFrames);
+        CHECK(ran == ticks);
+        CHECK(Equal(advanced.getCurrentState(), stepped.getCurrentState()));
+    }
+
+    // frames of varying length run the same ticks, only the leftover differs
+    Simulation uneven((SimulationState()));
+    const float frames[] = { 0.004f, 0.013f, 0.031f, 0.0075f, 0.021f };
+    unsigned int ran = 0;
+    for (unsigned int frame = 0; frame < 200; frame++)
+        ran += uneven.advance(PlaneInput(), frames[frame % 5]);
+    Simulation reference((SimulationState()));
+    for (unsigned int tick = 0; tick < ran; tick++)
+        reference.step(PlaneInput());
+    CHECK(Equal(uneven.getCurrentState(), reference.getCurrentState()));
+    CHECK(uneven.getAlpha() >= 0.0f && uneven.getAlpha() < 1.0f);
+}
+
+static void TestFrameTimeClamp()
+{
+    // a one second hitch runs the ticks of a quarter second, 30 at 120 Hz, and doesn't carry the rest over
+    Simulation hitch((SimulationState()));
+    Simulation clamped((SimulationState()));
+    const unsigned int hitchTicks = hitch.advance(PlaneInput(), 1.0f);
+    CHECK(hitchTicks == clamped.advance(PlaneInput(), Simulation::MAX_FRAME_TIME));
+    CHECK(hitchTicks >= 29 && hitchTicks <= 30);
+    CHECK(std::abs((hitchTicks + hitch.getAlpha()) * TICK - Simulation::MAX_FRAME_TIME) < 1e-5f);
+    CHECK(Equal(hitch.getCurrentState(), clamped.getCurrentState()));
+    CHECK(hitch.advance(PlaneInput(), 0.0f) == 0);
+
+    // a negative frame time runs nothing
+    Simulation backwards((SimulationState()));
+    CHECK(backwards.advance(PlaneInput(), -1.0f) == 0);
+    CHECK(backwards.getAlpha() == 0.0f);
+}
+
+static void TestInterpolation()
+{
+    // quarter second ticks so every frame time below is exact
+    const float tick = 0.25f;
+    Simulation simulation(SimulationState(), SimulationSettings(), tick);
+    PlaneInput turn;
+    turn.pitchUp = true;
+    turn.rollRight = true;
+    turn.accelerate = true;
+    simulation.advance(turn, tick);
+    const SimulationState previous = simulation.getCurrentState();
+    CHECK(simulation.advance(turn, tick) == 1);
+    const SimulationState current = simulation.getCurrentState();
+
+    // alpha 0 is the previous tick
+    CHECK(simulation.getAlpha() == 0.0f);
+    CHECK(Equal(simulation.getInterpolatedState(), previous, 1e-5f));
+
+    // half way
+    CHECK(simulation.advance(turn, tick * 0.5f) == 0);
+    CHECK(simulation.getAlpha() == 0.5f);
+    const SimulationState half = simulation.getInterpolatedState();
+    CHECK(Equal(half.planePosition, (previous.planePosition + current.planePosition) * 0.5f, 1e-4f));
+    CHECK(std::abs(glm::length(half.planeForward) - 1.0f) < 1e-5f);
+    CHECK(std::abs(glm::dot(half.planeForward, half.planeUp)) < 1e-5f);
+
+    // alpha 1 is the current tick, the accumulator gets as close to it as it can without running the next one
+    CHECK(simulation.advance(turn, tick * 0.5f - tick / 65536.0f) == 0);
+    CHECK(simulation.getAlpha() < 1.0f && simulation.getAlpha() > 0.9999f);
+    CHECK(Equal(simulation.getInterpolatedState(), current, 1e-2f));
+}
+
+static void TestReset()
+{
+    const glm::vec3 resetPosition(10.0f, 200.0f, -30.0f);
+    Simulation simulation((SimulationState()));
+    simulation.setResetPosition(resetPosition);
+    for (int tick = 0; tick < 12; tick++)
+        simulation.step(PlaneInput());
+    PlaneInput reset;
+    reset.reset = true;
+
+    // the teleport isn't interpolated across, alpha 0 already shows the plane at the reset position
+    CHECK(simulation.advance(reset, TICK) == 1);
+    CHECK(Equal(simulation.getInterpolatedState().planePosition, resetPosition));
+    const SimulationState& current = simulation.getCurrentState();
+    CHECK(Equal(current.planePosition, resetPosition + current.planeForward * current.planeSpeed * TICK, 1e-4f));
+
+    // reset is an edge, a frame of several ticks applies it only in the first one
+    CHECK(simulation.advance(reset, 4 * TICK) == 4);
+    const float travelled = glm::length(simulation.getCurrentState().planePosition - resetPosition);
+    CHECK(std::abs(travelled - 4 * simulation.getCurrentState().planeSpeed * TICK) < 0.05f);
+}
+
+int main()
+{
+    TestDeterminism();
+    TestFrameTimeClamp();
+    TestInterpolation();
+    TestReset();
+    return TestResult("simulation_test");
+}
@@ -0,0 +1,86 @@
+#include <glad/glad.h>
+#include <learnopengl/skinning.h>
+
+#include "benchmark.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <random>
+#include <thread>
+#include <vector>
+
+// CpuSkinner throughput on 200k vertices with one to four influences out of 60 bones, in vertices per second: the
+// shader's formula on the Vertex array as a baseline, the scalar kernel, the SIMD kernel at the width this build
+// picked (compile with -mavx2 for eight lanes), and the SIMD kernel on a JobSystem, for both skinning modes.
+
+int main()
+{
+    const size_t vertexCount = 200000;
+    const int boneCount = 60;
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+    std::vector<Vertex> vertices(vertexCount);
+    for (size_t i = 0; i < vertexCount; i++)
+    {
+        Vertex& vertex = vertices[i];
+        vertex.Position = glm::vec3(value(rng), value(rng), value(rng)) * 50.0f;
+        vertex.Normal = glm::normalize(glm::vec3(value(rng), value(rng), value(rng)));
+        const int influences = 1 + int(i % MAX_BONE_INFLUENCE);
+        float total = 0.0f;
+        for (int k = 0; k < MAX_BONE_INFLUENCE; k++)
+        {
+            vertex.m_BoneIDs[k] = k < influences ? int((i / 7 + k * 13) % boneCount) : -1;
+            vertex.m_Weights[k] = k < influences ? std::abs(value(rng)) + 0.1f : 0.0f;
+            total += vertex.m_Weights[k];
+        }
+        for (int k = 0; k < influences; k++)
+            vertex.m_Weights[k] /= total;
+    }
+    std::vector<glm::mat4> bones(boneCount);
+    for (glm::mat4& bone : bones)
+    {
+        const glm::quat rotation = glm::normalize(glm::quat(value(rng), value(rng), value(rng), value(rng)));
+        bone = glm::translate(glm::mat4(1.0f), glm::vec3(value(rng), value(rng), value(rng)) * 10.0f) * glm::mat4_cast(rotation);
+    }
+
+    const unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+    JobSystem jobs(cores);
+    CpuSkinner skinner(vertices);
+    const double megavertices = vertexCount / 1.0e6;
+    Section(std::to_string(vertexCount) + " vertices, " + std::to_string(boneCount) + " bones, " + std::to_string(SKINNING_LANES) + " SIMD lanes");
+
+    // what the vertex shader computes, one vertex at a time on the interleaved vertices
+    std::vector<glm::vec3> positions(vertexCount), normals(vertexCount);
+    const double shaderSeconds = BestOf(5, [&] {
+        for (size_t i = 0; i < vertexCount; i++)
+        {
+            const Vertex& vertex = vertices[i];
+            glm::mat4 skin(0.0f);
+            for (int k = 0; k < MAX_BONE_INFLUENCE; k++)
+                if (vertex.m_BoneIDs[k] >= 0)
+                    skin += bones[vertex.m_BoneIDs[k]] * vertex.m_Weights[k];
+            positions[i] = glm::vec3(skin * glm::vec4(vertex.Position, 1.0f));
+            normals[i] = glm::normalize(glm::mat3(skin) * vertex.Normal);
+        }
+        Consume(size_t(positions[vertexCount / 2].x != 0.0f));
+    });
+    Report("linear, shader formula per Vertex", megavertices / shaderSeconds, "MVertex/s");
+
+    const SkinningMode modes[] = { SkinningMode::Linear, SkinningMode::DualQuaternion };
+    const char* modeNames[] = { "linear", "dual quaternion" };
+    for (int m = 0; m < 2; m++)
+    {
+        const std::string mode = modeNames[m];
+        const double scalarSeconds = BestOf(5, [&] { skinner.SkinScalar(bones.data(), bones.size(), modes[m]); });
+        const double simdSeconds = BestOf(5, [&] { skinner.Skin(bones.data(), bones.size(), modes[m]); });
+        Report(mode + ", scalar kernel", megavertices / scalarSeconds, "MVertex/s");
+        Report(mode + ", SIMD kernel", megavertices / simdSeconds, "MVertex/s");
+        Report(mode + ", SIMD over scalar", scalarSeconds / simdSeconds, "x");
+        if (cores > 1)
+        {
+            const double parallelSeconds = BestOf(5, [&] { skinner.Skin(bones.data(), bones.size(), modes[m], &jobs); });
+            Report(mode + ", SIMD kernel on " + std::to_string(cores) + " threads", megavertices / parallelSeconds, "MVertex/s");
+        }
+    }
+    return 0;
+}
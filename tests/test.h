@@ -0,0 +1,30 @@
+#ifndef TESTS_TEST_H
+#define TESTS_TEST_H
+
+#include <cstdio>
+
+// Checks for the headless tests. A failed CHECK prints the file, line and condition and the test carries on,
+// main returns TestResult so ctest sees the failure.
+
+static int g_TestFailures = 0;
+
+#define CHECK(condition)                                                                        \
+    do                                                                                          \
+    {                                                                                           \
+        if (!(condition))                                                                       \
+        {                                                                                       \
+            std::printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #condition);           \
+            g_TestFailures++;                                                                   \
+        }                                                                                       \
+    } while (0)
+
+inline int TestResult(const char* name)
+{
+    if (g_TestFailures == 0)
+        std::printf("%s: passed\n", name);
+    else
+        std::printf("%s: %d checks failed\n", name, g_TestFailures);
+    return g_TestFailures == 0 ? 0 : 1;
+}
+
+#endif
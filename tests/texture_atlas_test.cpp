@@ -0,0 +1,169 @@
+#include <learnopengl/texture_atlas.h>
+
+#include "test.h"
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+// SkylinePacker must keep every rectangle it accepts inside the atlas and never let two of them overlap.
+// MaterialAtlas::Build has to give every material a rectangle of its texture's size with room for the padding around
+// it, fill the padding with the border texels and missing textures with the layer's default color, and RemapUV has
+// to move a texture coordinate onto the atlas texel that holds the source texel it sampled.
+
+static bool Overlap(const AtlasRect& a, const AtlasRect& b)
+{
+    return a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height && b.y < a.y + a.height;
+}
+
+static void TestPacker(int atlasWidth, int atlasHeight, int maxSize, unsigned int seed)
+{
+    std::mt19937 rng(seed);
+    SkylinePacker packer(atlasWidth, atlasHeight);
+    std::vector<AtlasRect> placed;
+    int rejected = 0;
+    size_t area = 0;
+    for (int i = 0; i < 2000 && rejected < 50; i++)
+    {
+        int width = 1 + rng() % maxSize;
+        int height = 1 + rng() % maxSize;
+        AtlasRect rect;
+        if (!packer.Insert(width, height, rect))
+        {
+            rejected++;
+            continue;
+        }
+        CHECK(rect.width == width && rect.height == height);
+        CHECK(rect.x >= 0 && rect.y >= 0 && rect.x + rect.width <= atlasWidth && rect.y + rect.height <= atlasHeight);
+        placed.push_back(rect);
+        area += size_t(width) * height;
+    }
+    CHECK(!placed.empty());
+
+    int overlaps = 0;
+    for (size_t a = 0; a < placed.size(); a++)
+        for (size_t b = a + 1; b < placed.size(); b++)
+            overlaps += Overlap(placed[a], placed[b]);
+    CHECK(overlaps == 0);
+    CHECK(packer.Occupancy() == float(area) / (float(atlasWidth) * float(atlasHeight)));
+}
+
+static void TestExactFit()
+{
+    // four quarters fill the atlas, nothing else fits after them
+    SkylinePacker packer(256, 256);
+    AtlasRect rect;
+    for (int i = 0; i < 4; i++)
+        CHECK(packer.Insert(128, 128, rect));
+    CHECK(!packer.Insert(1, 1, rect));
+    CHECK(packer.Occupancy() == 1.0f);
+
+    SkylinePacker small(64, 64);
+    CHECK(!small.Insert(65, 1, rect));
+    CHECK(!small.Insert(1, 65, rect));
+}
+
+// every texel a different color, so a sample tells where it came from
+static AtlasImage PatternImage(int width, int height, unsigned char material)
+{
+    std::vector<unsigned char> data;
+    for (int y = 0; y < height; y++)
+        for (int x = 0; x < width; x++)
+            data.insert(data.end(), { static_cast<unsigned char>(x), static_cast<unsigned char>(y), material, static_cast<unsigned char>(x ^ y) });
+    return AtlasImage::FromPixels(data.data(), width, height, 4);
+}
+
+static const unsigned char* AtlasTexel(const MaterialAtlas& atlas, size_t layer, int x, int y)
+{
+    return &atlas.layerPixels[layer][(size_t(y) * atlas.width + x) * 4];
+}
+
+static void TestMaterialAtlas()
+{
+    // two layers, the second one missing for every third material
+    std::mt19937 rng(4);
+    std::vector<AtlasMaterial> materials(12);
+    for (size_t m = 0; m < materials.size(); m++)
+    {
+        const int width = 8 + rng() % 120, height = 8 + rng() % 120;
+        materials[m].images.push_back(PatternImage(width, height, static_cast<unsigned char>(m)));
+        materials[m].images.push_back(m % 3 == 0 ? AtlasImage() : PatternImage(width, height, static_cast<unsigned char>(100 + m)));
+    }
+    // larger than maxMaterialSize, scaled down
+    materials.push_back(AtlasMaterial{ { AtlasImage::Solid(512, 256, std::vector<unsigned char>{ 1, 2, 3, 4 }.data()), AtlasImage() } });
+    const std::vector<glm::u8vec4> defaultColors = { glm::u8vec4(255, 255, 255, 255), glm::u8vec4(0, 0, 0, 255) };
+    const int padding = 4;
+
+    MaterialAtlas atlas;
+    CHECK(atlas.Build(materials, defaultColors, 256, padding));
+    CHECK(atlas.rects.size() == materials.size() && atlas.layerPixels.size() == 2);
+    CHECK(atlas.layerPixels[0].size() == size_t(atlas.width) * atlas.height * 4);
+
+    // rectangles of the texture size, disjoint and inside the atlas with their padding
+    size_t area = 0;
+    bool sized = true, inside = true;
+    for (size_t m = 0; m < materials.size(); m++)
+    {
+        const AtlasRect& rect = atlas.rects[m];
+        const bool scaled = m + 1 == materials.size();
+        sized = sized && rect.width == (scaled ? 256 : materials[m].images[0].width) && rect.height == (scaled ? 128 : materials[m].images[0].height);
+        inside = inside && rect.x >= padding && rect.y >= padding && rect.x + rect.width + padding <= atlas.width && rect.y + rect.height + padding <= atlas.height;
+        area += size_t(rect.width) * rect.height;
+    }
+    CHECK(sized);
+    CHECK(inside);
+    int overlaps = 0;
+    for (size_t a = 0; a < atlas.rects.size(); a++)
+        for (size_t b = a + 1; b < atlas.rects.size(); b++)
+        {
+            AtlasRect padded[2] = { atlas.rects[a], atlas.rects[b] };
+            for (AtlasRect& rect : padded)
+                rect = { rect.x - padding, rect.y - padding, rect.width + 2 * padding, rect.height + 2 * padding };
+            overlaps += Overlap(padded[0], padded[1]);
+        }
+    CHECK(overlaps == 0);
+    CHECK(atlas.Density() == float(area) / (float(atlas.width) * float(atlas.height)));
+    CHECK(atlas.Density() > 0.25f && atlas.Density() <= 1.0f);
+
+    // the padding repeats the border texels, a missing texture is the layer's default color
+    const AtlasRect& first = atlas.rects[0];
+    CHECK(std::memcmp(AtlasTexel(atlas, 0, first.x - padding, first.y - 1), AtlasTexel(atlas, 0, first.x, first.y), 4) == 0);
+    CHECK(std::memcmp(AtlasTexel(atlas, 0, first.x + first.width + padding - 1, first.y + first.height),
+        AtlasTexel(atlas, 0, first.x + first.width - 1, first.y + first.height - 1), 4) == 0);
+    CHECK(std::memcmp(AtlasTexel(atlas, 1, first.x + 3, first.y + 5), &defaultColors[1][0], 4) == 0);
+
+    // the center of every source texel remaps onto the atlas texel holding it
+    bool remapped = true;
+    for (size_t m = 0; m + 1 < materials.size(); m++)
+    {
+        const AtlasImage& image = materials[m].images[0];
+        for (int y = 0; y < image.height; y++)
+            for (int x = 0; x < image.width; x++)
+            {
+                const glm::vec2 uv = atlas.RemapUV(glm::vec2((x + 0.5f) / image.width, (y + 0.5f) / image.height), m);
+                const unsigned char* texel = AtlasTexel(atlas, 0, int(uv.x * atlas.width), int(uv.y * atlas.height));
+                remapped = remapped && std::memcmp(texel, &image.pixels[(size_t(y) * image.width + x) * 4], 4) == 0;
+            }
+    }
+    CHECK(remapped);
+
+    // the corners of [0, 1] are the corners of the rectangle, coordinates outside are clamped to it
+    const glm::vec2 atlasSize(atlas.width, atlas.height);
+    CHECK(atlas.RemapUV(glm::vec2(0.0f), 1) * atlasSize == glm::vec2(atlas.rects[1].x, atlas.rects[1].y));
+    CHECK(atlas.RemapUV(glm::vec2(1.0f), 1) * atlasSize == glm::vec2(atlas.rects[1].x + atlas.rects[1].width, atlas.rects[1].y + atlas.rects[1].height));
+    CHECK(atlas.RemapUV(glm::vec2(-0.5f, 1.5f), 1) == atlas.RemapUV(glm::vec2(0.0f, 1.0f), 1));
+    const glm::vec2 uvs[] = { glm::vec2(0.0f), glm::vec2(1.0f, 0.5f), glm::vec2(1.0005f, -0.0005f) };
+    CHECK(MaterialAtlas::CanRemap(uvs, 3));
+    const glm::vec2 repeating[] = { glm::vec2(0.5f), glm::vec2(2.0f, 0.5f) };
+    CHECK(!MaterialAtlas::CanRemap(repeating, 2));
+}
+
+int main()
+{
+    TestPacker(1024, 1024, 128, 1);
+    TestPacker(512, 2048, 300, 2);
+    TestPacker(256, 256, 16, 3);
+    TestExactFit();
+    TestMaterialAtlas();
+    return TestResult("texture_atlas_test");
+}
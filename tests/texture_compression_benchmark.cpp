@@ -0,0 +1,62 @@
+#include <learnopengl/filesystem.h>
+#include <learnopengl/texture_compress.h>
+#include <stb_image.h>
+
+#include "benchmark.h"
+
+#include <filesystem>
+#include <thread>
+
+// DXT compression of the images in resources/: encoder throughput on one and on all cores, GPU memory of the mip
+// chain against plain RGBA8 with mips, and what a warm DDS cache saves over decoding the PNG or JPEG again.
+
+int main()
+{
+    const char* images[] = {
+        "resources/textures/container.jpg",
+        "resources/textures/container2.png",
+        "resources/textures/brickwall.jpg",
+        "resources/objects/nanosuit/body_dif.png",
+    };
+    const std::string ddsPath = (std::filesystem::temp_directory_path() / "texture_compression_benchmark.dds").string();
+    const unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+
+    for (const char* image : images)
+    {
+        const std::string path = FileSystem::getPath(image);
+        int width = 0, height = 0, channels = 0;
+        double decodeSeconds = BestOf(3, [&] {
+            unsigned char* pixels = stbi_load(path.c_str(), &width, &height, &channels, 0);
+            stbi_image_free(pixels);
+        });
+        unsigned char* pixels = stbi_load(path.c_str(), &width, &height, &channels, 0);
+        if (!pixels)
+        {
+            std::printf("\n%s: not found\n", image);
+            continue;
+        }
+        Section(std::string(image) + " (" + std::to_string(width) + "x" + std::to_string(height) + ", " + std::to_string(channels) + " channels)");
+        const double megapixels = width * height / 1.0e6;
+
+        CompressedTexture texture;
+        const double singleSeconds = BestOf(3, [&] { texture = TextureCompressor::Compress(pixels, width, height, channels, 1); });
+        const double multiSeconds = BestOf(3, [&] { texture = TextureCompressor::Compress(pixels, width, height, channels, cores); });
+        Report("compress with mips, 1 thread", megapixels / singleSeconds, "MPixel/s");
+        if (cores > 1)
+            Report("compress with mips, " + std::to_string(cores) + " threads", megapixels / multiSeconds, "MPixel/s");
+        Report(texture.hasAlpha ? "DXT5 mip chain" : "DXT1 mip chain", texture.Size() / 1024.0, "KiB");
+        Report("RGBA8 mip chain", texture.UncompressedSize() / 1024.0, "KiB");
+        Report("compression ratio", double(texture.UncompressedSize()) / texture.Size(), ":1");
+
+        // the cache: read the DDS instead of decoding and compressing again
+        TextureCompressor::SaveDDS(ddsPath, texture);
+        CompressedTexture loaded;
+        const double loadSeconds = BestOf(5, [&] { TextureCompressor::LoadDDS(ddsPath, loaded); });
+        Report("decode " + std::filesystem::path(image).extension().string(), decodeSeconds * 1000.0, "ms");
+        Report("load DDS", loadSeconds * 1000.0, "ms");
+        Report("first load (decode and compress)", (decodeSeconds + multiSeconds) * 1000.0, "ms");
+        stbi_image_free(pixels);
+    }
+    std::filesystem::remove(ddsPath);
+    return 0;
+}
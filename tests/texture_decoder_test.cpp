@@ -0,0 +1,141 @@
+#include <learnopengl/filesystem.h>
+#include <learnopengl/texture_decoder.h>
+
+#include "test.h"
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ConcurrentQueue hands items over in order and lets WaitPop return once it is closed and drained. TextureDecodePool
+// decodes the fixture images of resources/ on its workers: every submitted file comes back from TryPopReady exactly
+// once with its texture id, size and channel count, and a file that can't be read comes back as a failed image.
+
+static void TestQueue()
+{
+    ConcurrentQueue<int> queue;
+    int value = 0;
+    CHECK(!queue.TryPop(value));
+    for (int i = 0; i < 5; i++)
+        queue.Push(i);
+    CHECK(queue.Size() == 5);
+    bool ordered = true;
+    for (int i = 0; i < 5; i++)
+        ordered = ordered && queue.TryPop(value) && value == i;
+    CHECK(ordered);
+    CHECK(queue.Size() == 0);
+
+    // four producers and a consumer blocking in WaitPop, everything pushed before Close arrives
+    const int producers = 4, perProducer = 1000;
+    long long sum = 0;
+    int count = 0;
+    std::thread consumer([&] {
+        int item;
+        while (queue.WaitPop(item))
+        {
+            sum += item;
+            count++;
+        }
+    });
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++)
+        threads.emplace_back([&queue, p] {
+            for (int i = 0; i < perProducer; i++)
+                queue.Push(p * perProducer + i);
+        });
+    for (std::thread& thread : threads)
+        thread.join();
+    queue.Close();
+    consumer.join();
+    const long long total = producers * perProducer;
+    CHECK(count == total);
+    CHECK(sum == total * (total - 1) / 2);
+    CHECK(!queue.WaitPop(value));
+}
+
+struct Fixture
+{
+    const char* path;
+    int width;
+    int height;
+    int components;
+};
+
+static void TestPool()
+{
+    const Fixture fixtures[] = {
+        { "resources/textures/awesomeface.png", 476, 476, 4 },
+        { "resources/textures/container.jpg", 512, 512, 3 },
+        { "resources/textures/block.png", 128, 128, 3 },
+        { "resources/textures/window.png", 256, 256, 4 },
+        { "resources/textures/does_not_exist.png", 0, 0, 0 },
+    };
+    const unsigned int count = sizeof(fixtures) / sizeof(fixtures[0]);
+
+    TextureDecodePool pool(2);
+    CHECK(pool.ThreadCount() == 2);
+    for (unsigned int i = 0; i < count; i++)
+        pool.Submit(FileSystem::getPath(fixtures[i].path), 100 + i, i % 2 == 0);
+    CHECK(pool.Pending() == count);
+
+    // drain the ready queue the way AsyncTextureLoader does once per frame
+    std::map<unsigned int, DecodedImage> decoded;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    while (pool.Pending() > 0 && std::chrono::steady_clock::now() < deadline)
+    {
+        DecodedImage image;
+        while (pool.TryPopReady(image))
+        {
+            CHECK(decoded.count(image.textureID) == 0);
+            decoded[image.textureID] = image;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    CHECK(pool.Pending() == 0);
+    CHECK(decoded.size() == count);
+
+    for (unsigned int i = 0; i < count; i++)
+    {
+        DecodedImage& image = decoded[100 + i];
+        CHECK(image.path == FileSystem::getPath(fixtures[i].path));
+        CHECK(image.gamma == (i % 2 == 0));
+        if (fixtures[i].width == 0)
+        {
+            CHECK(!image.Valid());
+            CHECK(image.data == nullptr);
+            continue;
+        }
+        CHECK(image.Valid());
+        CHECK(image.width == fixtures[i].width && image.height == fixtures[i].height);
+        CHECK(image.components == fixtures[i].components);
+        CHECK(!image.compressed.Valid());
+        image.Free();
+        CHECK(image.data == nullptr);
+    }
+
+    // nothing left behind
+    DecodedImage image;
+    CHECK(!pool.TryPopReady(image));
+}
+
+static void TestDecode()
+{
+    // the decode step on the calling thread gives what the workers give
+    DecodedImage image = TextureDecodePool::Decode(FileSystem::getPath("resources/textures/container.jpg"), 7, false, true);
+    CHECK(image.Valid() && image.textureID == 7 && image.gamma);
+    CHECK(image.width == 512 && image.height == 512 && image.components == 3);
+    image.Free();
+
+    DecodedImage missing = TextureDecodePool::Decode(FileSystem::getPath("resources/textures/does_not_exist.png"), 8);
+    CHECK(!missing.Valid());
+}
+
+int main()
+{
+    TestQueue();
+    TestPool();
+    TestDecode();
+    return TestResult("texture_decoder_test");
+}
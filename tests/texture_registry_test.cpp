@@ -0,0 +1,135 @@
+#include <learnopengl/texture_registry.h>
+
+#include "test.h"
+
+#include <set>
+#include <string>
+#include <vector>
+
+// TextureRegistry creates a texture once per path, gamma and compression, however often and under whichever spelling
+// of the path it is acquired. Handles count references and release them when reset or destroyed, CollectGarbage
+// evicts unreferenced textures oldest first and leaves those with an upload in flight alone. The create and destroy
+// callbacks only count here, no GL context is needed.
+
+static unsigned int g_NextID = 1;
+static std::set<unsigned int> g_Destroyed;
+
+static unsigned int CreateTexture()
+{
+    return g_NextID++;
+}
+
+static void TestSharing()
+{
+    TextureRegistry& registry = TextureRegistry::Instance();
+    const size_t creates = registry.CreateCount();
+
+    // N acquires of the same texture create it once
+    std::vector<TextureHandle> handles;
+    for (int i = 0; i < 10; i++)
+        handles.push_back(registry.Acquire("textures/shared.png", false, false, CreateTexture));
+    CHECK(registry.CreateCount() == creates + 1);
+    CHECK(handles.front().RefCount() == 10);
+    bool sameID = true;
+    for (const TextureHandle& handle : handles)
+        sameID = sameID && handle.ID() == handles.front().ID();
+    CHECK(sameID);
+
+    // another spelling of the path is the same file, other load parameters are another texture
+    TextureHandle respelled = registry.Acquire("textures/../textures/./shared.png", false, false, CreateTexture);
+    CHECK(respelled.ID() == handles.front().ID());
+    TextureHandle gamma = registry.Acquire("textures/shared.png", true, false, CreateTexture);
+    TextureHandle compressed = registry.Acquire("textures/shared.png", false, true, CreateTexture);
+    CHECK(gamma.ID() != handles.front().ID() && compressed.ID() != handles.front().ID() && gamma.ID() != compressed.ID());
+    CHECK(registry.CreateCount() == creates + 3);
+}
+
+static void TestHandles()
+{
+    TextureRegistry& registry = TextureRegistry::Instance();
+    TextureHandle first = registry.Acquire("textures/handles.png", false, false, CreateTexture);
+    CHECK(first.Valid() && first.RefCount() == 1);
+
+    {
+        TextureHandle copy = first;
+        CHECK(first.RefCount() == 2);
+        TextureHandle moved = std::move(copy);
+        CHECK(!copy.Valid() && copy.ID() == 0);
+        CHECK(first.RefCount() == 2);
+    }
+    // the copy went out of scope
+    CHECK(first.RefCount() == 1);
+
+    TextureHandle assigned;
+    assigned = first;
+    assigned = assigned;
+    CHECK(first.RefCount() == 2);
+    assigned.Reset();
+    CHECK(!assigned.Valid() && first.RefCount() == 1);
+    first.Reset();
+    CHECK(!first.Valid() && first.RefCount() == 0);
+}
+
+static void TestGarbageCollection()
+{
+    TextureRegistry& registry = TextureRegistry::Instance();
+    // start from an empty registry
+    registry.CollectGarbage();
+    CHECK(registry.Size() == 0);
+
+    unsigned int pendingID = 0;
+    bool uploading = true;
+    TextureHandle pending = registry.Acquire("textures/pending.png", false, false, CreateTexture,
+        [&](unsigned int id) { return uploading && id == pendingID; });
+    pendingID = pending.ID();
+    TextureHandle older = registry.Acquire("textures/older.png", false, false, CreateTexture);
+    TextureHandle newer = registry.Acquire("textures/newer.png", false, false, CreateTexture);
+    TextureHandle kept = registry.Acquire("textures/kept.png", false, false, CreateTexture);
+    const unsigned int olderID = older.ID(), newerID = newer.ID(), keptID = kept.ID();
+    CHECK(registry.Size() == 4);
+
+    // referenced textures stay
+    CHECK(registry.CollectGarbage() == 0);
+
+    // unreferenced but resident until collected, acquiring again brings the same texture back
+    older.Reset();
+    newer.Reset();
+    pending.Reset();
+    const size_t creates = registry.CreateCount();
+    TextureHandle again = registry.Acquire("textures/newer.png", false, false, CreateTexture);
+    CHECK(again.ID() == newerID && registry.CreateCount() == creates);
+    again.Reset();
+
+    // keepUnused spares the most recently released, the oldest goes first; the pending upload doesn't count
+    CHECK(registry.CollectGarbage(1) == 1);
+    CHECK(g_Destroyed.count(olderID) == 1 && g_Destroyed.count(newerID) == 0);
+    CHECK(g_Destroyed.count(pendingID) == 0);
+    CHECK(registry.Size() == 3);
+
+    CHECK(registry.CollectGarbage() == 1);
+    CHECK(g_Destroyed.count(newerID) == 1 && g_Destroyed.count(pendingID) == 0 && g_Destroyed.count(keptID) == 0);
+
+    // once the upload finished it can go as well
+    uploading = false;
+    CHECK(registry.CollectGarbage() == 1);
+    CHECK(g_Destroyed.count(pendingID) == 1);
+    CHECK(registry.Size() == 1);
+
+    // an evicted texture is created anew
+    TextureHandle reloaded = registry.Acquire("textures/older.png", false, false, CreateTexture);
+    CHECK(reloaded.ID() != olderID && registry.CreateCount() == creates + 1);
+
+    kept.Reset();
+    reloaded.Reset();
+    CHECK(registry.CollectGarbage() == 2);
+    CHECK(registry.Size() == 0);
+}
+
+int main()
+{
+    TextureRegistry::Instance().SetDestroyFunction([](unsigned int id) { g_Destroyed.insert(id); });
+    TestSharing();
+    TestHandles();
+    TestGarbageCollection();
+    return TestResult("texture_registry_test");
+}
@@ -0,0 +1,126 @@
+#include <glad/glad.h>
+#include <learnopengl/camera.h>
+#include <learnopengl/model.h>
+#include <learnopengl/entity.h>
+#include <learnopengl/transform_hierarchy.h>
+
+#include "benchmark.h"
+
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+// World matrix updates of TransformHierarchy against the pointer tree Entity walks, on trees of 10k, 100k and 1M nodes
+// with four children each: nodes per second when the root moves and everything is recomputed, the time per frame when
+// 1% of the nodes move, and the memory per node. The pointer tree nodes hold only what Entity's update touches, a
+// Transform and the links, so real Entities are slower and larger still.
+
+struct SceneNode
+{
+    Transform transform;
+    SceneNode* parent = nullptr;
+    std::vector<std::unique_ptr<SceneNode>> children;
+
+    // Entity::updateSelfAndChild and Entity::forceUpdateSelfAndChild
+    void updateSelfAndChild()
+    {
+        if (transform.isDirty())
+        {
+            forceUpdateSelfAndChild();
+            return;
+        }
+        for (auto&& child : children)
+            child->updateSelfAndChild();
+    }
+
+    void forceUpdateSelfAndChild()
+    {
+        if (parent)
+            transform.computeModelMatrix(parent->transform.getModelMatrix());
+        else
+            transform.computeModelMatrix();
+        for (auto&& child : children)
+            child->forceUpdateSelfAndChild();
+    }
+};
+
+static void Benchmark(size_t nodeCount, JobSystem& jobs, unsigned int cores)
+{
+    std::mt19937 rng(2);
+    std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+
+    // node i's parent is (i - 1) / 4 in both trees: created breadth first, TransformHierarchy lays it out depth first
+    SceneNode root;
+    std::vector<SceneNode*> nodes(nodeCount);
+    nodes[0] = &root;
+    TransformHierarchy hierarchy;
+    std::vector<TransformHierarchy::Handle> handles(nodeCount);
+    for (size_t i = 0; i < nodeCount; i++)
+    {
+        const glm::vec3 position = glm::vec3(value(rng), value(rng), value(rng)) * 3.0f, euler = glm::vec3(value(rng), value(rng), value(rng)) * 180.0f;
+        const glm::vec3 scale(1.0f + 0.05f * value(rng));
+        if (i > 0)
+        {
+            SceneNode* parent = nodes[(i - 1) / 4];
+            parent->children.push_back(std::unique_ptr<SceneNode>(new SceneNode()));
+            parent->children.back()->parent = parent;
+            nodes[i] = parent->children.back().get();
+        }
+        nodes[i]->transform.setLocalPosition(position);
+        nodes[i]->transform.setLocalRotation(euler);
+        nodes[i]->transform.setLocalScale(scale);
+        const glm::quat rotation = glm::quat(glm::radians(euler));
+        handles[i] = hierarchy.Create(i > 0 ? handles[(i - 1) / 4] : TransformHierarchy::Invalid, position, rotation, scale);
+    }
+    root.forceUpdateSelfAndChild();
+    hierarchy.Update();
+
+    Section(std::to_string(nodeCount) + " nodes");
+    const int runs = nodeCount >= 1000000 ? 3 : 10;
+    const double treeSeconds = BestOf(runs, [&] { root.forceUpdateSelfAndChild(); });
+    const double flatSeconds = BestOf(runs, [&] {
+        hierarchy.SetLocalPosition(handles[0], hierarchy.GetLocalPosition(handles[0]));
+        hierarchy.Update();
+    });
+    Report("root moved, Entity walk", nodeCount / treeSeconds / 1.0e6, "MNode/s");
+    Report("root moved, TransformHierarchy", nodeCount / flatSeconds / 1.0e6, "MNode/s");
+    if (cores > 1)
+    {
+        const double parallelSeconds = BestOf(runs, [&] {
+            hierarchy.SetLocalPosition(handles[0], hierarchy.GetLocalPosition(handles[0]));
+            hierarchy.Update(&jobs, 4096);
+        });
+        Report("root moved, TransformHierarchy on " + std::to_string(cores) + " threads", nodeCount / parallelSeconds / 1.0e6, "MNode/s");
+    }
+
+    std::vector<size_t> moved;
+    for (size_t i = 0; i < nodeCount / 100; i++)
+        moved.push_back(rng() % nodeCount);
+    const double treeMovedSeconds = BestOf(runs, [&] {
+        for (size_t i : moved)
+            nodes[i]->transform.setLocalPosition(nodes[i]->transform.getLocalPosition());
+        root.updateSelfAndChild();
+    });
+    const double flatMovedSeconds = BestOf(runs, [&] {
+        for (size_t i : moved)
+            hierarchy.SetLocalPosition(handles[i], hierarchy.GetLocalPosition(handles[i]));
+        hierarchy.Update();
+    });
+    Report("1% moved, Entity walk", treeMovedSeconds * 1000.0, "ms");
+    Report("1% moved, TransformHierarchy", flatMovedSeconds * 1000.0, "ms");
+
+    // a node and the unique_ptr its parent holds; the allocator's own overhead isn't counted
+    Report("memory, pointer tree", double(sizeof(SceneNode) + sizeof(std::unique_ptr<SceneNode>)), "bytes/node");
+    Report("memory, Entity without its bounding volume", double(sizeof(Entity) + sizeof(std::unique_ptr<Entity>)), "bytes/node");
+    Report("memory, TransformHierarchy", double(hierarchy.GetMemoryUsage()) / nodeCount, "bytes/node");
+}
+
+int main()
+{
+    const unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+    JobSystem jobs(cores);
+    for (size_t nodeCount : { 10000, 100000, 1000000 })
+        Benchmark(nodeCount, jobs, cores);
+    return 0;
+}
@@ -0,0 +1,81 @@
+#include <glad/glad.h>
+#include <learnopengl/mesh.h>
+
+#include "benchmark.h"
+
+#include <random>
+#include <vector>
+
+// VertexLayout on a mesh of random unit normals and tangents: bytes per vertex and buffer size of the layouts a model
+// can pick against the full Vertex struct, how fast Pack interleaves them, and what packing costs in precision.
+
+struct LayoutCase
+{
+    const char* name;
+    VertexLayout layout;
+};
+
+int main()
+{
+    const size_t vertexCount = 1000000;
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+    std::vector<Vertex> vertices(vertexCount);
+    for (Vertex& vertex : vertices)
+    {
+        vertex.Position = glm::vec3(value(rng), value(rng), value(rng)) * 10.0f;
+        vertex.Normal = glm::normalize(glm::vec3(value(rng), value(rng), value(rng)) + glm::vec3(0.0f, 0.0f, 1e-3f));
+        vertex.TexCoords = glm::vec2(value(rng), value(rng)) * 0.5f + 0.5f;
+        vertex.Tangent = glm::normalize(glm::cross(vertex.Normal, glm::vec3(0.0f, 1.0f, 0.0f)) + glm::vec3(1e-3f, 0.0f, 0.0f));
+        vertex.Bitangent = glm::cross(vertex.Normal, vertex.Tangent);
+        for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
+        {
+            vertex.m_BoneIDs[i] = i;
+            vertex.m_Weights[i] = 0.25f;
+        }
+    }
+
+    const unsigned int lit = VERTEX_ATTRIBUTE_BIT(VERTEX_ATTRIBUTE_NORMAL) | VERTEX_ATTRIBUTE_BIT(VERTEX_ATTRIBUTE_TEXCOORDS);
+    const LayoutCase cases[] = {
+        { "full (the Vertex struct)", VertexLayout::Full() },
+        { "static (normal mapped, no bones)", VertexLayout(VERTEX_ATTRIBUTES_STATIC) },
+        { "static, packed", VertexLayout(VERTEX_ATTRIBUTES_STATIC, true, true) },
+        { "position, normal and UV", VertexLayout(lit) },
+        { "position, normal and UV, packed", VertexLayout(lit, true, true) },
+        { "position only", VertexLayout(0) },
+    };
+
+    Section("layouts of " + std::to_string(vertexCount) + " vertices, sizeof(Vertex) = " + std::to_string(sizeof(Vertex)) + " bytes");
+    const double megavertices = vertexCount / 1.0e6;
+    for (const LayoutCase& layoutCase : cases)
+    {
+        std::vector<unsigned char> buffer;
+        const double seconds = BestOf(3, [&] { buffer = layoutCase.layout.Pack(vertices.data(), vertices.size()); });
+        Report(std::string(layoutCase.name) + ", bytes per vertex", layoutCase.layout.stride, "B");
+        Report(std::string(layoutCase.name) + ", buffer", buffer.size() / (1024.0 * 1024.0), "MiB");
+        Report(std::string(layoutCase.name) + ", pack", megavertices / seconds, "MVertex/s");
+    }
+    // what the upload did before the layouts: the Vertex array as it is
+    std::vector<unsigned char> copy(vertexCount * sizeof(Vertex));
+    const double copySeconds = BestOf(3, [&] { std::memcpy(copy.data(), vertices.data(), copy.size()); Consume(copy[copy.size() / 2]); });
+    Report("memcpy of the Vertex array", megavertices / copySeconds, "MVertex/s");
+
+    // precision lost by packing: angle between a normal and its 10:10:10:2 version, UV error of half floats
+    const VertexLayout packed(lit, true, true);
+    const std::vector<unsigned char> buffer = packed.Pack(vertices.data(), vertices.size());
+    double maxAngle = 0.0, maxUvError = 0.0;
+    for (size_t i = 0; i < vertexCount; i++)
+    {
+        uint32_t normalBits = 0, uvBits = 0;
+        std::memcpy(&normalBits, buffer.data() + i * packed.stride + packed.attributes[1].offset, 4);
+        std::memcpy(&uvBits, buffer.data() + i * packed.stride + packed.attributes[2].offset, 4);
+        const glm::vec3 normal = glm::normalize(glm::vec3(glm::unpackSnorm3x10_1x2(normalBits)));
+        maxAngle = std::max(maxAngle, double(std::acos(glm::clamp(glm::dot(normal, vertices[i].Normal), -1.0f, 1.0f))));
+        const glm::vec2 uv = glm::unpackHalf2x16(uvBits);
+        maxUvError = std::max(maxUvError, double(glm::length(uv - vertices[i].TexCoords)));
+    }
+    Section("precision of the packed formats");
+    Report("largest normal error, 10:10:10:2", glm::degrees(maxAngle), "degrees");
+    Report("largest UV error, half floats", maxUvError * 4096.0, "texels at 4096");
+    return 0;
+}